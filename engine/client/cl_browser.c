@@ -0,0 +1,767 @@
+/*
+cl_browser.c - paced server browser probes
+Copyright (C) 2026 FWGS
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+*/
+
+#include "common.h"
+#include "client.h"
+
+// hash table grows up to this size, keeping itself at most half full
+#if XASH_LOW_MEMORY == 0
+#define MAX_BROWSER_PROBES		65536
+#elif XASH_LOW_MEMORY == 1
+#define MAX_BROWSER_PROBES		16384
+#elif XASH_LOW_MEMORY == 2
+#define MAX_BROWSER_PROBES		4096
+#endif
+#define MIN_BROWSER_PROBES		1024
+#define BROWSER_BATCH_SIZE		64	// results handed to menu at once
+#define BROWSER_PROBE_TIMEOUT		3.0	// seconds before unanswered probe is dropped
+
+typedef enum
+{
+	PROBE_FREE = 0,
+	PROBE_QUEUED,	// waiting for a send token
+	PROBE_SENT,	// waiting for reply
+	PROBE_ANSWERED,	// got reply, further replies are duplicates
+	PROBE_TIMEDOUT,
+} probe_state_t;
+
+typedef struct
+{
+	netadr_t		adr;
+	probe_state_t	state;
+	double		sendtime;	// host.realtime, for timeouts
+	double		sendclock;	// Sys_DoubleTime, for rtt
+	float		rtt;
+} browser_probe_t;
+
+typedef struct
+{
+	netadr_t		adr;
+	char		info[MAX_INFO_STRING+8];	// same as in CL_ParseStatusMessage
+} browser_result_t;
+
+typedef void (*browser_send_t)( const netadr_t *adr );
+typedef void (*browser_deliver_t)( netadr_t adr, const char *info );
+
+static struct
+{
+	browser_probe_t	*probes;	// hashed by address
+	int		*order;	// probe indices in queue order
+	int		maxprobes;	// hash table size, power of two
+	int		numprobes;
+	int		next_send;	// first queued probe in order
+	int		next_timeout;	// oldest probe that may be still in flight
+
+	double		tokens;
+	double		lasttime;
+
+	int		answered;
+	int		timedout;
+	int		duplicates;
+	int		dropped;	// table couldn't grow anymore
+	int		rttsamples;
+	double		totalrtt;
+
+	browser_result_t	batch[BROWSER_BATCH_SIZE];	// replies waiting for menu
+	int		numbatch;
+	int		batches;
+
+	browser_send_t	send;
+	browser_deliver_t	deliver;
+} cl_browser;
+
+static CVAR_DEFINE_AUTO( cl_browser_rate, "200", FCVAR_ARCHIVE, "max server browser info probes per second, 0 to send all at once" );
+
+static uint CL_BrowserHashBytes( uint hash, const void *data, size_t size )
+{
+	const byte	*p = data;
+	size_t		i;
+
+	// FNV-1a
+	for( i = 0; i < size; i++ )
+		hash = ( hash ^ p[i] ) * 16777619U;
+
+	return hash;
+}
+
+/*
+=================
+CL_BrowserHashForAdr
+
+only fields compared by NET_CompareAdr are hashed,
+the rest of address may be left uninitialized
+=================
+*/
+static uint CL_BrowserHashForAdr( const netadr_t *adr )
+{
+	uint	hash = CL_BrowserHashBytes( 2166136261U, &adr->type6, sizeof( adr->type6 ));
+
+	if( adr->type == NA_IP )
+	{
+		hash = CL_BrowserHashBytes( hash, &adr->ip4, sizeof( adr->ip4 ));
+		hash = CL_BrowserHashBytes( hash, &adr->port, sizeof( adr->port ));
+	}
+	else if( adr->type6 == NA_IP6 )
+	{
+		hash = CL_BrowserHashBytes( hash, adr->ip6, sizeof( adr->ip6 ));
+		hash = CL_BrowserHashBytes( hash, &adr->port, sizeof( adr->port ));
+	}
+
+	return hash & ( cl_browser.maxprobes - 1 );
+}
+
+/*
+=================
+CL_BrowserFindProbe
+
+returns probe for given address or free slot where it should be placed
+=================
+*/
+static browser_probe_t *CL_BrowserFindProbe( const netadr_t *adr )
+{
+	uint	i = CL_BrowserHashForAdr( adr );
+
+	while( cl_browser.probes[i].state != PROBE_FREE )
+	{
+		if( NET_CompareAdr( cl_browser.probes[i].adr, *adr ))
+			break;
+
+		i = ( i + 1 ) & ( cl_browser.maxprobes - 1 );
+	}
+
+	return &cl_browser.probes[i];
+}
+
+/*
+=================
+CL_BrowserSendInfo
+=================
+*/
+static void CL_BrowserSendInfo( const netadr_t *adr )
+{
+	Netchan_OutOfBandPrint( NS_CLIENT, *adr, "info %i", PROTOCOL_VERSION );
+}
+
+/*
+=================
+CL_BrowserGrow
+
+doubles hash table, probe indices in queue order are remapped
+=================
+*/
+static qboolean CL_BrowserGrow( void )
+{
+	browser_probe_t	*oldprobes = cl_browser.probes;
+	int		newsize = cl_browser.maxprobes ? cl_browser.maxprobes * 2 : MIN_BROWSER_PROBES;
+	int		i;
+
+	if( newsize > MAX_BROWSER_PROBES )
+		return false;
+
+	cl_browser.probes = Z_Calloc( sizeof( *cl_browser.probes ) * newsize );
+	cl_browser.order = Z_Realloc( cl_browser.order, sizeof( *cl_browser.order ) * newsize / 2 );
+	cl_browser.maxprobes = newsize;
+
+	// every used slot is in order list, so rehash through it
+	for( i = 0; i < cl_browser.numprobes; i++ )
+	{
+		const browser_probe_t	*old = &oldprobes[cl_browser.order[i]];
+		browser_probe_t	*probe = CL_BrowserFindProbe( &old->adr );
+
+		*probe = *old;
+		cl_browser.order[i] = probe - cl_browser.probes;
+	}
+
+	if( oldprobes )
+		Mem_Free( oldprobes );
+
+	return true;
+}
+
+/*
+=================
+CL_BrowserReset
+
+forget all probes, called when new scan is started,
+table keeps its size so rescans don't reallocate
+=================
+*/
+void CL_BrowserReset( void )
+{
+	browser_probe_t	*probes = cl_browser.probes;
+	int		*order = cl_browser.order;
+	int		maxprobes = cl_browser.maxprobes;
+	browser_send_t	send = cl_browser.send;
+	browser_deliver_t	deliver = cl_browser.deliver;
+
+	if( probes )
+		memset( probes, 0, sizeof( *probes ) * maxprobes );
+
+	memset( &cl_browser, 0, sizeof( cl_browser ));
+	cl_browser.probes = probes;
+	cl_browser.order = order;
+	cl_browser.maxprobes = maxprobes;
+	cl_browser.send = send ? send : CL_BrowserSendInfo;
+	cl_browser.deliver = deliver ? deliver : UI_AddServerToList;
+	cl_browser.lasttime = host.realtime;
+
+	if( !cl_browser.probes )
+		CL_BrowserGrow();
+}
+
+/*
+=================
+CL_BrowserAddProbe
+=================
+*/
+static browser_probe_t *CL_BrowserAddProbe( const netadr_t *adr, probe_state_t state )
+{
+	browser_probe_t	*probe;
+
+	// keep hash table at most half full
+	if( cl_browser.numprobes >= cl_browser.maxprobes / 2 )
+	{
+		if( CL_BrowserFindProbe( adr )->state != PROBE_FREE )
+			return NULL; // already known, no need to grow
+
+		if( !CL_BrowserGrow( ))
+		{
+			cl_browser.dropped++;
+			return NULL;
+		}
+	}
+
+	probe = CL_BrowserFindProbe( adr );
+
+	if( probe->state != PROBE_FREE )
+		return NULL; // already known
+
+	probe->adr = *adr;
+	probe->state = state;
+	cl_browser.order[cl_browser.numprobes++] = probe - cl_browser.probes;
+
+	return probe;
+}
+
+/*
+=================
+CL_BrowserQueue
+
+schedule info probe for a server address from master server list
+=================
+*/
+void CL_BrowserQueue( netadr_t adr )
+{
+	if( !CL_BrowserAddProbe( &adr, PROBE_QUEUED ))
+		return;
+
+	// without rate limit, behave like before
+	if( cl_browser_rate.value <= 0.0f )
+		CL_BrowserFrame();
+}
+
+/*
+=================
+CL_BrowserFlush
+
+hand collected servers to menu
+=================
+*/
+static void CL_BrowserFlush( void )
+{
+	int	i;
+
+	if( !cl_browser.numbatch )
+		return;
+
+	for( i = 0; i < cl_browser.numbatch; i++ )
+		cl_browser.deliver( cl_browser.batch[i].adr, cl_browser.batch[i].info );
+
+	cl_browser.numbatch = 0;
+	cl_browser.batches++;
+}
+
+/*
+=================
+CL_BrowserAddServer
+
+server info reply that passed CL_BrowserReply,
+menu gets it on next browser frame
+=================
+*/
+void CL_BrowserAddServer( netadr_t adr, const char *info )
+{
+	browser_result_t	*result;
+
+	if( cl_browser.numbatch >= BROWSER_BATCH_SIZE )
+		CL_BrowserFlush();
+
+	result = &cl_browser.batch[cl_browser.numbatch++];
+	result->adr = adr;
+	Q_strncpy( result->info, info, sizeof( result->info ));
+}
+
+/*
+=================
+CL_BrowserFrame
+
+send queued probes within token budget, expire old ones
+and hand replies to menu
+=================
+*/
+void CL_BrowserFrame( void )
+{
+	double	now = host.realtime;
+	double	maxtokens;
+
+	if( cl_browser_rate.value > 0.0f )
+	{
+		// refill token bucket, allow small bursts to smooth out frame time jitter
+		maxtokens = Q_max( 1.0, cl_browser_rate.value * 0.1 );
+		cl_browser.tokens += ( now - cl_browser.lasttime ) * cl_browser_rate.value;
+		cl_browser.tokens = Q_min( cl_browser.tokens, maxtokens );
+	}
+	else cl_browser.tokens = cl_browser.numprobes;
+
+	cl_browser.lasttime = now;
+
+	if( cl_browser.next_send < cl_browser.numprobes )
+		NET_Config( true, false ); // allow remote
+
+	while( cl_browser.next_send < cl_browser.numprobes && cl_browser.tokens >= 1.0 )
+	{
+		browser_probe_t *probe = &cl_browser.probes[cl_browser.order[cl_browser.next_send++]];
+
+		if( probe->state != PROBE_QUEUED )
+			continue; // answered to broadcast already
+
+		probe->state = PROBE_SENT;
+		probe->sendtime = now;
+		probe->sendclock = Sys_DoubleTime();
+		cl_browser.send( &probe->adr );
+		cl_browser.tokens -= 1.0;
+	}
+
+	// probes are sent in order, so the oldest ones are always in front
+	while( cl_browser.next_timeout < cl_browser.next_send )
+	{
+		browser_probe_t *probe = &cl_browser.probes[cl_browser.order[cl_browser.next_timeout]];
+
+		if( probe->state == PROBE_SENT )
+		{
+			if( now - probe->sendtime < BROWSER_PROBE_TIMEOUT )
+				break;
+
+			probe->state = PROBE_TIMEDOUT;
+			cl_browser.timedout++;
+		}
+
+		cl_browser.next_timeout++;
+	}
+
+	CL_BrowserFlush();
+}
+
+/*
+=================
+CL_BrowserReply
+
+registers a reply from server, returns false for duplicates
+=================
+*/
+qboolean CL_BrowserReply( netadr_t from )
+{
+	browser_probe_t	*probe = CL_BrowserFindProbe( &from );
+
+	switch( probe->state )
+	{
+	case PROBE_FREE:
+		// broadcast reply or probe sent outside of browser, just remember it
+		CL_BrowserAddProbe( &from, PROBE_ANSWERED );
+		return true;
+	case PROBE_QUEUED:
+		// server answered before we have asked it
+		probe->state = PROBE_ANSWERED;
+		return true;
+	case PROBE_SENT:
+	case PROBE_TIMEDOUT:
+		// late replies are still good, but their rtt is meaningless
+		if( probe->state == PROBE_SENT )
+		{
+			probe->rtt = Sys_DoubleTime() - probe->sendclock;
+			cl_browser.totalrtt += probe->rtt;
+			cl_browser.rttsamples++;
+		}
+		else cl_browser.timedout--;
+
+		probe->state = PROBE_ANSWERED;
+		cl_browser.answered++;
+		return true;
+	case PROBE_ANSWERED:
+	default:
+		cl_browser.duplicates++;
+		return false;
+	}
+}
+
+/*
+=================
+CL_BrowserStatus_f
+=================
+*/
+static void CL_BrowserStatus_f( void )
+{
+	int	pending = 0, i;
+
+	for( i = cl_browser.next_timeout; i < cl_browser.next_send; i++ )
+	{
+		if( cl_browser.probes[cl_browser.order[i]].state == PROBE_SENT )
+			pending++;
+	}
+
+	Con_Printf( "probes: %d known, %d queued, %d in flight\n", cl_browser.numprobes, cl_browser.numprobes - cl_browser.next_send, pending );
+	Con_Printf( "replies: %d answered, %d timed out, %d duplicates\n", cl_browser.answered, cl_browser.timedout, cl_browser.duplicates );
+
+	if( cl_browser.dropped > 0 )
+		Con_Printf( "dropped: %d servers didn't fit into %d probes table\n", cl_browser.dropped, MAX_BROWSER_PROBES / 2 );
+
+	if( cl_browser.rttsamples > 0 )
+		Con_Printf( "average rtt: %.1f ms\n", cl_browser.totalrtt * 1000.0 / cl_browser.rttsamples );
+}
+
+/*
+=================
+CL_BrowserInit
+=================
+*/
+void CL_BrowserInit( void )
+{
+	Cvar_RegisterVariable( &cl_browser_rate );
+	Cmd_AddCommand( "browser_status", CL_BrowserStatus_f, "print server browser probe statistics" );
+	CL_BrowserReset();
+}
+
+#if XASH_ENGINE_TESTS
+#include "tests.h"
+
+#define TEST_FLEET_SIZE	3000
+#define TEST_FRAMETIME	0.01
+#define TEST_RATE		200.0f
+
+// fake responders on loopback, behaviour depends on server number
+enum
+{
+	RESPONDER_ANSWER = 0,	// answers as soon as probed
+	RESPONDER_NEXTFRAME,	// answer arrives on next frame
+	RESPONDER_TWICE,	// second answer is a duplicate
+	RESPONDER_SILENT,	// never answers until asked late
+	RESPONDER_BEHAVIOURS
+};
+
+static struct
+{
+	int	probed[TEST_FLEET_SIZE];
+	int	delivered[TEST_FLEET_SIZE];
+	int	pending[TEST_FLEET_SIZE];
+	int	numpending;
+	int	numsent;
+	int	numdelivered;
+	int	outsideframe;	// delivered not from CL_BrowserFrame
+	qboolean	inframe;
+} test_fleet;
+
+static void Test_Browser_MakeAdr( int n, netadr_t *adr )
+{
+	// nothing goes to the wire, so port byte order doesn't matter
+	memset( adr, 0, sizeof( *adr ));
+	adr->type = NA_IP;
+	adr->ip[0] = 127;
+	adr->ip[2] = ( n >> 8 ) & 0xff;
+	adr->ip[3] = n & 0xff;
+	adr->port = PORT_SERVER + n % 16;
+}
+
+static int Test_Browser_AdrNum( const netadr_t *adr )
+{
+	return ( adr->ip[2] << 8 ) | adr->ip[3];
+}
+
+static void Test_Browser_Answer( const netadr_t *adr )
+{
+	// what CL_ParseStatusMessage does
+	if( CL_BrowserReply( *adr ))
+		CL_BrowserAddServer( *adr, "\\gamedir\\valve" );
+}
+
+static void Test_Browser_Deliver( netadr_t adr, const char *info )
+{
+	int	n = Test_Browser_AdrNum( &adr );
+
+	if( n < TEST_FLEET_SIZE )
+		test_fleet.delivered[n]++;
+
+	if( !test_fleet.inframe )
+		test_fleet.outsideframe++;
+
+	test_fleet.numdelivered++;
+}
+
+static void Test_Browser_Send( const netadr_t *adr )
+{
+	int	n = Test_Browser_AdrNum( adr );
+
+	test_fleet.numsent++;
+
+	if( n >= TEST_FLEET_SIZE )
+		return;
+
+	test_fleet.probed[n]++;
+
+	switch( n % RESPONDER_BEHAVIOURS )
+	{
+	case RESPONDER_ANSWER:
+		Test_Browser_Answer( adr );
+		break;
+	case RESPONDER_NEXTFRAME:
+		test_fleet.pending[test_fleet.numpending++] = n;
+		break;
+	case RESPONDER_TWICE:
+		Test_Browser_Answer( adr );
+		Test_Browser_Answer( adr );
+		break;
+	}
+}
+
+static void Test_Browser_Frame( void )
+{
+	netadr_t	adr;
+	int	i;
+
+	host.realtime += TEST_FRAMETIME;
+
+	for( i = 0; i < test_fleet.numpending; i++ )
+	{
+		Test_Browser_MakeAdr( test_fleet.pending[i], &adr );
+		Test_Browser_Answer( &adr );
+	}
+
+	test_fleet.numpending = 0;
+
+	test_fleet.inframe = true;
+	CL_BrowserFrame();
+	test_fleet.inframe = false;
+}
+
+static void Test_Browser_Reset( float rate )
+{
+	CL_BrowserReset();
+	memset( &test_fleet, 0, sizeof( test_fleet ));
+	cl_browser.send = Test_Browser_Send;
+	cl_browser.deliver = Test_Browser_Deliver;
+	cl_browser_rate.value = rate;
+}
+
+static void Test_Browser_Fleet( void )
+{
+	int	silent = TEST_FLEET_SIZE / RESPONDER_BEHAVIOURS;
+	int	i, sent, maxburst = 0, wrong = 0;
+	double	start;
+	netadr_t	adr;
+
+	Test_Browser_Reset( TEST_RATE );
+
+	// fake master lists every server twice, like two masters would
+	for( i = 0; i < TEST_FLEET_SIZE * 2; i++ )
+	{
+		Test_Browser_MakeAdr( i % TEST_FLEET_SIZE, &adr );
+		CL_BrowserQueue( adr );
+	}
+
+	TASSERT_EQi( cl_browser.numprobes, TEST_FLEET_SIZE );
+	TASSERT_EQi( cl_browser.dropped, 0 );
+	TASSERT( cl_browser.maxprobes > MIN_BROWSER_PROBES );
+	TASSERT_EQi( test_fleet.numsent, 0 );
+
+	start = host.realtime;
+
+	for( i = 0; i < 100000 && cl_browser.next_send < cl_browser.numprobes; i++ )
+	{
+		sent = test_fleet.numsent;
+		Test_Browser_Frame();
+		maxburst = Q_max( maxburst, test_fleet.numsent - sent );
+	}
+
+	// paced by token bucket, neither faster nor noticeably slower than the rate
+	TASSERT_EQi( test_fleet.numsent, TEST_FLEET_SIZE );
+	TASSERT( maxburst <= TEST_RATE * 0.1f );
+	TASSERT( test_fleet.numsent <= ( host.realtime - start ) * TEST_RATE + 1 );
+	TASSERT( test_fleet.numsent >= ( host.realtime - start - 0.1 ) * TEST_RATE );
+
+	for( i = 0; i < TEST_FLEET_SIZE; i++ )
+	{
+		if( test_fleet.probed[i] != 1 )
+			wrong++;
+	}
+
+	TASSERT_EQi( wrong, 0 );
+
+	// let silent servers time out
+	for( i = 0; i < BROWSER_PROBE_TIMEOUT / TEST_FRAMETIME + 2; i++ )
+		Test_Browser_Frame();
+
+	TASSERT_EQi( cl_browser.next_timeout, cl_browser.numprobes );
+	TASSERT_EQi( cl_browser.timedout, silent );
+	TASSERT_EQi( cl_browser.answered, TEST_FLEET_SIZE - silent );
+	TASSERT_EQi( cl_browser.rttsamples, TEST_FLEET_SIZE - silent );
+	TASSERT_EQi( cl_browser.duplicates, TEST_FLEET_SIZE / RESPONDER_BEHAVIOURS );
+
+	// menu got every answered server once, from browser frame only
+	for( i = 0, wrong = 0; i < TEST_FLEET_SIZE; i++ )
+	{
+		if( test_fleet.delivered[i] != ( i % RESPONDER_BEHAVIOURS != RESPONDER_SILENT ))
+			wrong++;
+	}
+
+	TASSERT_EQi( wrong, 0 );
+	TASSERT_EQi( test_fleet.numdelivered, TEST_FLEET_SIZE - silent );
+	TASSERT_EQi( test_fleet.outsideframe, 0 );
+
+	// late reply is still good, but only once
+	Test_Browser_MakeAdr( RESPONDER_SILENT, &adr );
+	TASSERT( CL_BrowserReply( adr ));
+	TASSERT( !CL_BrowserReply( adr ));
+	TASSERT_EQi( cl_browser.timedout, silent - 1 );
+	TASSERT_EQi( cl_browser.answered, TEST_FLEET_SIZE - silent + 1 );
+	TASSERT_EQi( cl_browser.rttsamples, TEST_FLEET_SIZE - silent );
+}
+
+static void Test_Browser_Unpaced( void )
+{
+	netadr_t	adr;
+	int	i;
+
+	Test_Browser_Reset( 0.0f );
+
+	for( i = 0; i < 16; i++ )
+	{
+		Test_Browser_MakeAdr( i, &adr );
+		CL_BrowserQueue( adr );
+		TASSERT_EQi( test_fleet.numsent, i + 1 );
+	}
+}
+
+static void Test_Browser_Overflow( void )
+{
+	netadr_t	adr;
+	int	i;
+
+	Test_Browser_Reset( TEST_RATE );
+
+	for( i = 0; i < MAX_BROWSER_PROBES / 2 + 100; i++ )
+	{
+		Test_Browser_MakeAdr( i, &adr );
+		CL_BrowserQueue( adr );
+	}
+
+	TASSERT_EQi( cl_browser.maxprobes, MAX_BROWSER_PROBES );
+	TASSERT_EQi( cl_browser.numprobes, MAX_BROWSER_PROBES / 2 );
+	TASSERT_EQi( cl_browser.dropped, 100 );
+
+	// servers that are already known aren't dropped
+	Test_Browser_MakeAdr( 0, &adr );
+	CL_BrowserQueue( adr );
+	TASSERT_EQi( cl_browser.dropped, 100 );
+
+	// rescan keeps grown table
+	CL_BrowserReset();
+	TASSERT_EQi( cl_browser.maxprobes, MAX_BROWSER_PROBES );
+	TASSERT_EQi( cl_browser.numprobes, 0 );
+	TASSERT_EQi( cl_browser.dropped, 0 );
+}
+
+static void Test_Browser_Garbage( void )
+{
+	netadr_t	probe, reply;
+
+	Test_Browser_Reset( 0.0f );
+
+	// probe and reply addresses come with random bytes after used fields
+	memset( &probe, 0xcc, sizeof( probe ));
+	memset( &reply, 0x33, sizeof( reply ));
+	probe.type = reply.type = NA_IP;
+	probe.port = reply.port = PORT_SERVER;
+
+	// outside of fleet, so nobody answers
+	probe.ip[0] = reply.ip[0] = 127;
+	probe.ip[1] = reply.ip[1] = 0;
+	probe.ip[2] = reply.ip[2] = 0xff;
+	probe.ip[3] = reply.ip[3] = 0xff;
+
+	CL_BrowserQueue( probe );
+	TASSERT_EQi( test_fleet.numsent, 1 );
+	TASSERT_EQi( cl_browser.numprobes, 1 );
+
+	TASSERT( CL_BrowserReply( reply ));
+	TASSERT( !CL_BrowserReply( probe ));
+	TASSERT_EQi( cl_browser.numprobes, 1 );
+	TASSERT_EQi( cl_browser.answered, 1 );
+	TASSERT_EQi( cl_browser.duplicates, 1 );
+}
+
+static void Test_Browser_Batch( void )
+{
+	netadr_t	adr;
+	int	i;
+
+	Test_Browser_Reset( TEST_RATE );
+
+	for( i = 0; i < BROWSER_BATCH_SIZE * 2 + 10; i++ )
+	{
+		Test_Browser_MakeAdr( i, &adr );
+		CL_BrowserAddServer( adr, "\\gamedir\\valve" );
+	}
+
+	// full batches are handed over at once, the rest waits for frame
+	TASSERT_EQi( test_fleet.numdelivered, BROWSER_BATCH_SIZE * 2 );
+	TASSERT_EQi( cl_browser.batches, 2 );
+
+	Test_Browser_Frame();
+	TASSERT_EQi( test_fleet.numdelivered, BROWSER_BATCH_SIZE * 2 + 10 );
+	TASSERT_EQi( cl_browser.batches, 3 );
+
+	// nothing new, nothing to hand over
+	Test_Browser_Frame();
+	TASSERT_EQi( cl_browser.batches, 3 );
+}
+
+void Test_RunBrowser( void )
+{
+	double	realtime = host.realtime;
+	float	rate = cl_browser_rate.value;
+
+	TRUN( Test_Browser_Fleet() );
+	TRUN( Test_Browser_Unpaced() );
+	TRUN( Test_Browser_Overflow() );
+	TRUN( Test_Browser_Garbage() );
+	TRUN( Test_Browser_Batch() );
+
+	host.realtime = realtime;
+	cl_browser_rate.value = rate;
+	cl_browser.send = CL_BrowserSendInfo;
+	cl_browser.deliver = UI_AddServerToList;
+	CL_BrowserReset();
+}
+
+#endif /* XASH_ENGINE_TESTS */
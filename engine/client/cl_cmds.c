@@ -337,8 +337,9 @@ void CL_DeleteDemo_f( void )
 		return;
 	}
 
-	// delete demo
+	// delete demo and its keyframe index
 	FS_Delete( va( "%s.dem", Cmd_Argv( 1 )));
+	FS_Delete( va( "%s.dki", Cmd_Argv( 1 )));
 }
 
 /*
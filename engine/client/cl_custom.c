@@ -116,6 +116,35 @@ void CL_RemoveFromResourceList( resource_t *pResource )
 	pResource->pNext = NULL;
 }
 
+/*
+==============
+CL_PrefetchResource
+
+resource is present locally now, start reading
+it while the rest of signon goes on
+==============
+*/
+static void CL_PrefetchResource( const resource_t *pResource )
+{
+	if( FBitSet( pResource->ucFlags, RES_WASMISSING|RES_PRECACHED ))
+		return;
+
+	switch( pResource->type )
+	{
+	case t_sound:
+		// sentences and streams aren't loaded during precache
+		if( pResource->szFileName[0] != '!' && pResource->szFileName[0] != '*' )
+			FS_Prefetch( va( DEFAULT_SOUNDPATH "%s", pResource->szFileName ));
+		break;
+	case t_model:
+		if( pResource->szFileName[0] != '*' )
+			FS_Prefetch( pResource->szFileName );
+		break;
+	default:
+		break;
+	}
+}
+
 void CL_MoveToOnHandList( resource_t *pResource )
 {
 	if( !pResource )
@@ -126,6 +155,7 @@ void CL_MoveToOnHandList( resource_t *pResource )
 
 	CL_RemoveFromResourceList( pResource );
 	CL_AddToResourceList( pResource, &cl.resourcesonhand );
+	CL_PrefetchResource( pResource );
 }
 
 static void CL_ClearResourceList( resource_t *pList )
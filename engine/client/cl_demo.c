@@ -42,6 +42,13 @@ GNU General Public License for more details.
 
 #define PROTOCOL_GOLDSRC_VERSION_DEMO (PROTOCOL_GOLDSRC_VERSION | (BIT( 7 ))) // should be 48, only to differentiate it from PROTOCOL_LEGACY_VERSION
 
+#define IDEMOINDEXHEADER	(('X'<<24)+('D'<<16)+('K'<<8)+'I') // little-endian "IKDX"
+#define DEMO_INDEX_VERSION	2
+#define DEMO_MAX_KEYFRAMES	16384
+#define DEMO_MAX_SNAPSHOT	0x80000	// string tables and entity state snapshot limit
+#define DEMO_SNAPSHOT_PAD	4	// bit reader may fetch a whole dword at the end
+#define DEMO_STATE_END	0xffff	// end of baselines in entity state snapshot
+
 const char *demo_cmd[dem_lastcmd+1] =
 {
 	"dem_unknown",
@@ -84,6 +91,35 @@ typedef struct
 	int32_t		numentries;	// number of tracks
 } demodirectory_t;
 
+// sidecar keyframe index, <demoname>.dki
+#pragma pack( push, 1 )
+typedef struct
+{
+	int		id;		// should be IKDX
+	int		version;		// should be DEMO_INDEX_VERSION
+	int		demosize;		// size of indexed demo, to detect stale index
+	int		numkeyframes;
+} demoindexheader_t;
+
+typedef struct
+{
+	int		offset;		// file offset of message, playback restarts from it
+	float		timestamp;	// demo time of this message
+	int		entryIndex;	// directory entry it belongs to
+	int		servercount;	// level it belongs to
+	int		tablesize;	// size of string tables snapshot following keyframe
+	int		statesize;	// size of entity state snapshot following string tables
+} demokeyframe_t;
+#pragma pack( pop )
+
+typedef struct
+{
+	demokeyframe_t	*keyframes;	// sorted by file offset
+	byte		**snapshots;	// string tables followed by entity state
+	int		numkeyframes;
+	qboolean		dirty;		// extended during playback, must be saved
+} demoindex_t;
+
 // add angles
 typedef struct
 {
@@ -107,6 +143,12 @@ struct
 	// interpolation stuff
 	demoangle_t	cmds[ANGLE_BACKUP];
 	int		angle_position;
+
+	// seeking stuff
+	demoindex_t	index;
+	int		msgpos;		// file offset of last read message
+	float		seektime;		// fast-forward target, negative if not seeking
+	int		deltafrom;	// oldest frame the message is delta compressed against, or -1
 } demo;
 
 static qboolean CL_NextDemo( void );
@@ -142,83 +184,714 @@ static connprotocol_t CL_GetProtocolFromDemo( int net_protocol )
 		return PROTO_GOLDSRC;
 	}
 
-	return PROTO_CURRENT;
+	return PROTO_CURRENT;
+}
+
+/*
+====================
+CL_StartupDemoHeader
+
+spooling demo header in case
+we record a demo on this level
+====================
+*/
+void CL_StartupDemoHeader( void )
+{
+	CL_CloseDemoHeader();
+
+	cls.demoheader = FS_Open( "demoheader.tmp", "w+b", true );
+
+	if( !cls.demoheader )
+	{
+		Con_DPrintf( S_ERROR "couldn't open temporary header file.\n" );
+		return;
+	}
+
+	Con_Printf( "Spooling demo header.\n" );
+}
+
+/*
+====================
+CL_CloseDemoHeader
+
+close demoheader file on engine shutdown
+====================
+*/
+void CL_CloseDemoHeader( void )
+{
+	if( !cls.demoheader )
+		return;
+
+	FS_Close( cls.demoheader );
+}
+
+/*
+====================
+CL_GetDemoRecordClock
+
+write time while demo is recording
+====================
+*/
+static float CL_GetDemoRecordClock( void )
+{
+	return cl.mtime[0];
+}
+
+/*
+====================
+CL_GetDemoPlaybackClock
+
+overwrite host.realtime
+====================
+*/
+static float CL_GetDemoPlaybackClock( void )
+{
+	return host.realtime + host.frametime;
+}
+
+/*
+====================
+CL_GetDemoFramerate
+
+overwrite host.frametime
+====================
+*/
+double CL_GetDemoFramerate( void )
+{
+	if( cls.timedemo )
+		return 0.0;
+	return bound( MIN_FPS, demo.header.host_fps, MAX_FPS );
+}
+
+/*
+=======================================================================
+
+DEMO KEYFRAME INDEX
+
+=======================================================================
+*/
+/*
+====================
+CL_DemoFreeIndex
+====================
+*/
+static void CL_DemoFreeIndex( void )
+{
+	int	i;
+
+	for( i = 0; i < demo.index.numkeyframes; i++ )
+	{
+		if( demo.index.snapshots[i] )
+			Mem_Free( demo.index.snapshots[i] );
+	}
+
+	if( demo.index.keyframes )
+		Mem_Free( demo.index.keyframes );
+	if( demo.index.snapshots )
+		Mem_Free( demo.index.snapshots );
+
+	memset( &demo.index, 0, sizeof( demo.index ));
+}
+
+/*
+====================
+CL_DemoWriteTables
+
+string tables are not delta compressed against
+entity baselines, so keyframe must carry them itself
+====================
+*/
+static int CL_DemoWriteTables( byte *data, int size )
+{
+	sizebuf_t	buf;
+	int	i;
+
+	MSG_Init( &buf, "DemoTables", data, size );
+
+	for( i = 0; i < MAX_LIGHTSTYLES; i++ )
+	{
+		if( !COM_CheckStringEmpty( cl.lightstyles[i].pattern ))
+			continue;
+
+		MSG_WriteByte( &buf, svc_lightstyle );
+		MSG_WriteByte( &buf, i );
+		MSG_WriteString( &buf, cl.lightstyles[i].pattern );
+		MSG_WriteFloat( &buf, cl.lightstyles[i].time );
+	}
+
+	for( i = 0; i < cl.maxclients; i++ )
+	{
+		player_info_t	*player = &cl.players[i];
+
+		MSG_WriteByte( &buf, svc_updateuserinfo );
+		MSG_WriteUBitLong( &buf, i, MAX_CLIENT_BITS );
+		MSG_WriteLong( &buf, player->userid );
+
+		if( COM_CheckStringEmpty( player->userinfo ))
+		{
+			MSG_WriteOneBit( &buf, 1 );
+			MSG_WriteString( &buf, player->userinfo );
+			MSG_WriteBytes( &buf, player->hashedcdkey, sizeof( player->hashedcdkey ));
+		}
+		else MSG_WriteOneBit( &buf, 0 );
+	}
+
+	if( MSG_CheckOverflow( &buf ))
+		return -1;
+
+	return MSG_GetNumBytesWritten( &buf );
+}
+
+/*
+====================
+CL_DemoReadTables
+====================
+*/
+static void CL_DemoReadTables( const byte *data, int size )
+{
+	sizebuf_t	buf;
+
+	MSG_Init( &buf, "DemoTables", (byte *)data, size );
+
+	while( !MSG_CheckOverflow( &buf ) && MSG_GetNumBytesLeft( &buf ) > 0 )
+	{
+		switch( MSG_ReadByte( &buf ))
+		{
+		case svc_lightstyle:
+			CL_ParseLightStyle( &buf, PROTO_CURRENT );
+			break;
+		case svc_updateuserinfo:
+			CL_UpdateUserinfo( &buf, PROTO_CURRENT );
+			break;
+		default:
+			Con_Printf( S_ERROR "%s: bad keyframe tables\n", __func__ );
+			return;
+		}
+	}
+}
+
+/*
+====================
+CL_DemoWriteDelta
+
+byte-wise difference of two copies of a structure: runs of
+changed bytes, each prefixed with count of unchanged bytes
+before it and its length, zero length ends the list.
+network delta encoding is lossy, this one restores exact copy
+====================
+*/
+static void CL_DemoWriteDelta( sizebuf_t *buf, const void *from, const void *to, int size )
+{
+	const byte	*in = from, *out = to;
+	int		i = 0, pos = 0, start, same;
+
+	Assert( size < 0x10000 );
+
+	while( i < size )
+	{
+		if( in[i] == out[i] )
+		{
+			i++;
+			continue;
+		}
+
+		// don't split the run on gaps shorter than run header
+		for( start = i; i < size; i += same )
+		{
+			for( ; i < size && in[i] != out[i]; i++ );
+			for( same = 0; i + same < size && same < 4 && in[i + same] == out[i + same]; same++ );
+
+			if( same == 4 || i + same == size )
+				break;
+		}
+
+		MSG_WriteWord( buf, start - pos );
+		MSG_WriteWord( buf, i - start );
+		MSG_WriteBytes( buf, out + start, i - start );
+		pos = i;
+	}
+
+	MSG_WriteWord( buf, 0 );
+	MSG_WriteWord( buf, 0 );
+}
+
+/*
+====================
+CL_DemoReadDelta
+
+from and to may be same structure
+====================
+*/
+static qboolean CL_DemoReadDelta( sizebuf_t *buf, const void *from, void *to, int size )
+{
+	byte	*out = to;
+	int	pos = 0, skip, len;
+
+	if( from != to )
+		memcpy( to, from, size );
+
+	while( 1 )
+	{
+		skip = MSG_ReadWord( buf );
+		len = MSG_ReadWord( buf );
+
+		if( MSG_CheckOverflow( buf ))
+			return false;
+
+		if( !len )
+			return true;
+
+		pos += skip;
+		if( pos + len > size )
+			return false;
+
+		MSG_ReadBytes( buf, out + pos, len );
+		pos += len;
+	}
+}
+
+/*
+====================
+CL_DemoWriteState
+
+baselines and frames that the parsed message was delta compressed
+against, those that follow it too, as server never goes back to
+older frames. message itself is parsed again after restoring
+====================
+*/
+static int CL_DemoWriteState( byte *data, int size )
+{
+	static const entity_state_t	nullstate;
+	static const frame_t	nullframe;
+	const frame_t		*prev = &nullframe;
+	int			i, j, first, last, count = 0;
+	sizebuf_t			buf;
+
+	MSG_Init( &buf, "DemoState", data, size );
+
+	for( i = 0; i < clgame.maxEntities; i++ )
+	{
+		const entity_state_t *baseline = &clgame.entities[i].baseline;
+
+		if( !memcmp( baseline, &nullstate, sizeof( nullstate )))
+			continue;
+
+		MSG_WriteWord( &buf, i );
+		CL_DemoWriteDelta( &buf, &nullstate, baseline, sizeof( nullstate ));
+	}
+
+	MSG_WriteWord( &buf, DEMO_STATE_END );
+	MSG_WriteByte( &buf, cl.instanced_baseline_count );
+
+	for( i = 0; i < cl.instanced_baseline_count; i++ )
+		CL_DemoWriteDelta( &buf, &nullstate, &cl.instanced_baseline[i], sizeof( nullstate ));
+
+	// message always refers to one of recent frames
+	last = cls.netchan.incoming_sequence - 1;
+	first = ( demo.deltafrom != -1 ) ? Q_max( demo.deltafrom, last - CL_UPDATE_MASK + 2 ) : last + 1;
+
+	for( i = first; i <= last; i++ )
+	{
+		if( cl.frames[i & CL_UPDATE_MASK].valid )
+			count++;
+	}
+
+	MSG_WriteByte( &buf, count );
+
+	for( i = first; i <= last; i++ )
+	{
+		const frame_t *frame = &cl.frames[i & CL_UPDATE_MASK];
+
+		if( !frame->valid )
+			continue;
+
+		MSG_WriteLong( &buf, i );
+		CL_DemoWriteDelta( &buf, prev, frame, sizeof( *frame ));
+		prev = frame;
+
+		for( j = 0; j < frame->num_entities; j++ )
+		{
+			const entity_state_t *state = &cls.packet_entities[( frame->first_entity + j ) % cls.num_client_entities];
+
+			MSG_WriteWord( &buf, state->number );
+			CL_DemoWriteDelta( &buf, &CL_EDICT_NUM( state->number )->baseline, state, sizeof( *state ));
+		}
+	}
+
+	if( MSG_CheckOverflow( &buf ))
+		return -1;
+
+	return MSG_GetNumBytesWritten( &buf );
+}
+
+/*
+====================
+CL_DemoReadState
+====================
+*/
+static qboolean CL_DemoReadState( const byte *data, int size )
+{
+	static frame_t	prev;
+	int		i, j, num, count, sequence;
+	sizebuf_t		buf;
+
+	MSG_Init( &buf, "DemoState", (byte *)data, size );
+
+	for( i = 0; i < clgame.maxEntities; i++ )
+		memset( &clgame.entities[i].baseline, 0, sizeof( entity_state_t ));
+
+	while(( num = MSG_ReadWord( &buf )) != DEMO_STATE_END )
+	{
+		if( num < 0 || num >= clgame.maxEntities )
+			return false;
+
+		if( !CL_DemoReadDelta( &buf, &clgame.entities[num].baseline, &clgame.entities[num].baseline, sizeof( entity_state_t )))
+			return false;
+	}
+
+	cl.instanced_baseline_count = MSG_ReadByte( &buf );
+	if( cl.instanced_baseline_count > MAX_CUSTOM_BASELINES )
+		return false;
+
+	for( i = 0; i < cl.instanced_baseline_count; i++ )
+	{
+		memset( &cl.instanced_baseline[i], 0, sizeof( entity_state_t ));
+
+		if( !CL_DemoReadDelta( &buf, &cl.instanced_baseline[i], &cl.instanced_baseline[i], sizeof( entity_state_t )))
+			return false;
+	}
+
+	// frames in history don't belong to the new position
+	for( i = 0; i < CL_UPDATE_BACKUP; i++ )
+		cl.frames[i].valid = false;
+
+	memset( &prev, 0, sizeof( prev ));
+	count = MSG_ReadByte( &buf );
+
+	for( i = 0; i < count; i++ )
+	{
+		frame_t *frame;
+
+		sequence = MSG_ReadLong( &buf );
+		frame = &cl.frames[sequence & CL_UPDATE_MASK];
+
+		if( !CL_DemoReadDelta( &buf, &prev, frame, sizeof( *frame )))
+			return false;
+
+		// entities are stored to the current end of packet entities
+		prev = *frame;
+		frame->first_entity = cls.next_client_entities;
+
+		if( frame->num_entities < 0 || frame->num_entities > NUM_PACKET_ENTITIES )
+		{
+			frame->valid = false;
+			return false;
+		}
+
+		for( j = 0; j < frame->num_entities; j++ )
+		{
+			entity_state_t *state = &cls.packet_entities[cls.next_client_entities % cls.num_client_entities];
+
+			num = MSG_ReadWord( &buf );
+
+			if( num < 0 || num >= clgame.maxEntities || !CL_DemoReadDelta( &buf, &clgame.entities[num].baseline, state, sizeof( *state )))
+			{
+				frame->valid = false;
+				return false;
+			}
+
+			cls.next_client_entities++;
+		}
+	}
+
+	return !MSG_CheckOverflow( &buf );
+}
+
+/*
+====================
+CL_DemoAddKeyframe
+
+offsets are growing, so index stays sorted, and
+keyframes seen again after seeking back are ignored
+====================
+*/
+static void CL_DemoAddKeyframe( int offset, float timestamp, int entryIndex )
+{
+	static byte	data[DEMO_MAX_SNAPSHOT];
+	demokeyframe_t	*kf;
+	int		n = demo.index.numkeyframes;
+	int		tablesize, statesize;
+
+	if( n > 0 && demo.index.keyframes[n - 1].offset >= offset )
+		return;
+
+	if( n >= DEMO_MAX_KEYFRAMES )
+		return;
+
+	tablesize = CL_DemoWriteTables( data, sizeof( data ));
+	statesize = ( tablesize < 0 ) ? -1 : CL_DemoWriteState( data + tablesize, sizeof( data ) - tablesize );
+
+	if( statesize < 0 )
+	{
+		Con_DPrintf( S_WARN "%s: keyframe snapshot is too big\n", __func__ );
+		return;
+	}
+
+	demo.index.keyframes = Mem_Realloc( cls.mempool, demo.index.keyframes, sizeof( *demo.index.keyframes ) * ( n + 1 ));
+	demo.index.snapshots = Mem_Realloc( cls.mempool, demo.index.snapshots, sizeof( *demo.index.snapshots ) * ( n + 1 ));
+
+	kf = &demo.index.keyframes[n];
+	kf->offset = offset;
+	kf->timestamp = timestamp;
+	kf->entryIndex = entryIndex;
+	kf->servercount = cl.servercount;
+	kf->tablesize = tablesize;
+	kf->statesize = statesize;
+
+	demo.index.snapshots[n] = Mem_Calloc( cls.mempool, tablesize + statesize + DEMO_SNAPSHOT_PAD );
+	memcpy( demo.index.snapshots[n], data, tablesize + statesize );
+
+	demo.index.numkeyframes++;
+	demo.index.dirty = true;
+}
+
+/*
+====================
+CL_DemoKeyframeDue
+
+one keyframe per demo_keyframes seconds of each level
+====================
+*/
+static qboolean CL_DemoKeyframeDue( float timestamp, int entryIndex )
+{
+	const demokeyframe_t *kf;
+
+	if( demo_keyframes.value <= 0.0f )
+		return false;
+
+	if( !demo.index.numkeyframes )
+		return true;
+
+	kf = &demo.index.keyframes[demo.index.numkeyframes - 1];
+
+	if( kf->servercount != cl.servercount || kf->entryIndex != entryIndex )
+		return true;
+
+	return timestamp - kf->timestamp >= demo_keyframes.value;
+}
+
+/*
+====================
+CL_DemoCheckKeyframe
+
+called after every parsed message
+====================
+*/
+static void CL_DemoCheckKeyframe( int offset, float timestamp, int entryIndex )
+{
+	if( cls.state == ca_active && cl.validsequence && CL_DemoKeyframeDue( timestamp, entryIndex ))
+		CL_DemoAddKeyframe( offset, timestamp, entryIndex );
+
+	demo.deltafrom = -1;
+}
+
+/*
+====================
+CL_DemoFindKeyframe
+
+returns latest keyframe of the level that is not after time
+====================
+*/
+static int CL_DemoFindKeyframe( int servercount, int entryIndex, float time )
+{
+	int	i, best = -1;
+
+	for( i = 0; i < demo.index.numkeyframes; i++ )
+	{
+		const demokeyframe_t *kf = &demo.index.keyframes[i];
+
+		if( kf->servercount != servercount || kf->entryIndex != entryIndex )
+			continue;
+
+		if( kf->timestamp > time )
+			continue;
+
+		if( best == -1 || kf->timestamp >= demo.index.keyframes[best].timestamp )
+			best = i;
+	}
+
+	return best;
+}
+
+/*
+====================
+CL_DemoRestoreKeyframe
+
+restore string tables, baselines and frame history,
+the keyframe message must be parsed again after this
+====================
+*/
+static qboolean CL_DemoRestoreKeyframe( int kf )
+{
+	const byte *data = demo.index.snapshots[kf];
+
+	// only non-empty lightstyles are stored, so
+	// ones set after the keyframe must be cleared
+	memset( cl.lightstyles, 0, sizeof( cl.lightstyles ));
+	CL_DemoReadTables( data, demo.index.keyframes[kf].tablesize );
+
+	if( !CL_DemoReadState( data + demo.index.keyframes[kf].tablesize, demo.index.keyframes[kf].statesize ))
+	{
+		Con_Printf( S_ERROR "%s: bad keyframe entity state\n", __func__ );
+		return false;
+	}
+
+	demo.deltafrom = -1;
+
+	return true;
 }
 
 /*
 ====================
-CL_StartupDemoHeader
-
-spooling demo header in case
-we record a demo on this level
+CL_DemoSaveIndex
 ====================
 */
-void CL_StartupDemoHeader( void )
+static qboolean CL_DemoSaveIndex( const char *filename, int demosize )
 {
-	CL_CloseDemoHeader();
+	demoindexheader_t	hdr;
+	file_t		*f;
+	int		i;
 
-	cls.demoheader = FS_Open( "demoheader.tmp", "w+b", true );
+	if( !( f = FS_Open( filename, "wb", false )))
+	{
+		Con_DPrintf( S_ERROR "couldn't write %s\n", filename );
+		return false;
+	}
 
-	if( !cls.demoheader )
+	hdr.id = IDEMOINDEXHEADER;
+	hdr.version = DEMO_INDEX_VERSION;
+	hdr.demosize = demosize;
+	hdr.numkeyframes = demo.index.numkeyframes;
+	FS_Write( f, &hdr, sizeof( hdr ));
+
+	for( i = 0; i < demo.index.numkeyframes; i++ )
 	{
-		Con_DPrintf( S_ERROR "couldn't open temporary header file.\n" );
-		return;
+		const demokeyframe_t *kf = &demo.index.keyframes[i];
+
+		FS_Write( f, kf, sizeof( *kf ));
+		FS_Write( f, demo.index.snapshots[i], kf->tablesize + kf->statesize );
 	}
 
-	Con_Printf( "Spooling demo header.\n" );
+	FS_Close( f );
+	demo.index.dirty = false;
+
+	return true;
 }
 
 /*
 ====================
-CL_CloseDemoHeader
-
-close demoheader file on engine shutdown
+CL_DemoReadIndex
 ====================
 */
-void CL_CloseDemoHeader( void )
+static qboolean CL_DemoReadIndex( file_t *f, int demosize )
 {
-	if( !cls.demoheader )
-		return;
+	demoindexheader_t	hdr;
+	int		i;
 
-	FS_Close( cls.demoheader );
+	CL_DemoFreeIndex();
+
+	if( FS_Read( f, &hdr, sizeof( hdr )) != sizeof( hdr ) || hdr.id != IDEMOINDEXHEADER
+		|| hdr.version != DEMO_INDEX_VERSION || hdr.demosize != demosize
+		|| hdr.numkeyframes < 0 || hdr.numkeyframes > DEMO_MAX_KEYFRAMES )
+		return false;
+
+	demo.index.keyframes = Mem_Calloc( cls.mempool, sizeof( *demo.index.keyframes ) * Q_max( hdr.numkeyframes, 1 ));
+	demo.index.snapshots = Mem_Calloc( cls.mempool, sizeof( *demo.index.snapshots ) * Q_max( hdr.numkeyframes, 1 ));
+
+	for( i = 0; i < hdr.numkeyframes; i++ )
+	{
+		demokeyframe_t	*kf = &demo.index.keyframes[i];
+		int		size;
+
+		if( FS_Read( f, kf, sizeof( *kf )) != sizeof( *kf ) || kf->offset < 0 || kf->offset >= demosize
+			|| ( i > 0 && kf->offset <= kf[-1].offset ))
+			break;
+
+		if( kf->tablesize < 0 || kf->statesize < 0 || kf->tablesize > DEMO_MAX_SNAPSHOT - kf->statesize )
+			break;
+
+		size = kf->tablesize + kf->statesize;
+		demo.index.snapshots[i] = Mem_Calloc( cls.mempool, size + DEMO_SNAPSHOT_PAD );
+		demo.index.numkeyframes++;
+
+		if( FS_Read( f, demo.index.snapshots[i], size ) != size )
+			break;
+	}
+
+	if( demo.index.numkeyframes != hdr.numkeyframes )
+	{
+		CL_DemoFreeIndex();
+		return false;
+	}
+
+	return true;
 }
 
 /*
 ====================
-CL_GetDemoRecordClock
+CL_DemoLoadIndex
 
-write time while demo is recording
+missing or outdated index is not an error, it
+will be rebuilt while the demo is playing
 ====================
 */
-static float CL_GetDemoRecordClock( void )
+static qboolean CL_DemoLoadIndex( const char *filename, int demosize )
 {
-	return cl.mtime[0];
+	qboolean	result;
+	file_t	*f;
+
+	if( !( f = FS_Open( filename, "rb", true )))
+	{
+		CL_DemoFreeIndex();
+		return false;
+	}
+
+	if( !( result = CL_DemoReadIndex( f, demosize )))
+		Con_DPrintf( S_WARN "%s: %s is outdated or corrupted\n", __func__, filename );
+
+	FS_Close( f );
+
+	return result;
 }
 
 /*
 ====================
-CL_GetDemoPlaybackClock
+CL_DemoMarkDelta
 
-overwrite host.realtime
+called by parser for every frame referenced by
+delta compressed packet entities and clientdata
 ====================
 */
-static float CL_GetDemoPlaybackClock( void )
+void CL_DemoMarkDelta( int oldpacket )
 {
-	return host.realtime + host.frametime;
+	// only low byte of sequence is sent
+	int	sequence = cls.netchan.incoming_sequence - (( cls.netchan.incoming_sequence - oldpacket ) & 0xFF );
+
+	if( demo.deltafrom == -1 || sequence < demo.deltafrom )
+		demo.deltafrom = sequence;
 }
 
 /*
 ====================
-CL_GetDemoFramerate
+CL_DemoIndexMessage
 
-overwrite host.frametime
+extends the index while the demo is playing
 ====================
 */
-double CL_GetDemoFramerate( void )
+void CL_DemoIndexMessage( void )
 {
-	if( cls.timedemo )
-		return 0.0;
-	return bound( MIN_FPS, demo.header.host_fps, MAX_FPS );
+	if( cls.demoplayback == DEMO_XASH3D )
+		CL_DemoCheckKeyframe( demo.msgpos, demo.timestamp, demo.entryIndex );
 }
 
 /*
@@ -337,6 +1010,9 @@ void CL_WriteDemoMessage( qboolean startup, int start, sizebuf_t *msg )
 	// demo playback should read this as an incoming message.
 	c = (cls.state != ca_active) ? dem_norewind : dem_read;
 
+	if( !startup && c == dem_read )
+		CL_DemoCheckKeyframe( FS_Tell( file ), (float)(CL_GetDemoRecordClock() - demo.starttime), demo.entry - demo.directory.entries );
+
 	CL_WriteDemoCmdHeader( c, file );
 	CL_WriteDemoSequence( file );
 
@@ -397,6 +1073,9 @@ static void CL_WriteDemoHeader( const char *name )
 	cls.demorecording = true;
 	cls.demowaiting = true;	// don't start saving messages until a non-delta compressed message is received
 
+	CL_DemoFreeIndex();
+	demo.deltafrom = -1;
+
 	memset( &demo.header, 0, sizeof( demo.header ));
 
 	demo.header.id = IDEMOHEADER;
@@ -469,7 +1148,7 @@ finish recording demo
 */
 static void CL_StopRecord( void )
 {
-	int	i, curpos;
+	int	i, curpos, demosize;
 	float	stoptime;
 	int	frames;
 
@@ -494,6 +1173,7 @@ static void CL_StopRecord( void )
 
 	Mem_Free( demo.directory.entries );
 	demo.directory.numentries = 0;
+	demosize = FS_Tell( cls.demofile );
 
 	demo.header.directory_offset = curpos;
 	FS_Seek( cls.demofile, 0, SEEK_SET );
@@ -501,6 +1181,9 @@ static void CL_StopRecord( void )
 
 	FS_Close( cls.demofile );
 	cls.demofile = NULL;
+
+	CL_DemoSaveIndex( va( "%s.dki", cls.demoname ), demosize );
+	CL_DemoFreeIndex();
 	cls.demorecording = false;
 	cls.demoname[0] = '\0';
 	cls.td_lastframe = host.framecount;
@@ -673,6 +1356,28 @@ static void CL_ReadDemoSequence( qboolean discard )
 	cls.netchan.last_reliable_sequence = last_reliable_sequence;
 }
 
+/*
+=================
+CL_DemoStopSeek
+
+finish fast-forward, optionally moving
+playback clock to the current message
+=================
+*/
+static void CL_DemoStopSeek( qboolean realign )
+{
+	if( demo.seektime < 0.0f )
+		return;
+
+	demo.seektime = -1.0f;
+
+	if( realign )
+		demo.starttime = CL_GetDemoPlaybackClock() - demo.timestamp;
+
+	// drop sounds started by skipped messages
+	S_StopAllSounds( false );
+}
+
 /*
 =================
 CL_DemoStartPlayback
@@ -713,6 +1418,9 @@ static void CL_DemoStartPlayback( int mode )
 	memset( demo.cmds, 0, sizeof( demo.cmds ));
 	demo.angle_position = 1;
 	demo.framecount = 0;
+	demo.msgpos = 0;
+	demo.seektime = -1.0f;
+	demo.deltafrom = -1;
 	cls.lastoutgoingcommand = -1;
  	cls.nextcmdtime = host.realtime;
 	cl.last_command_ack = -1;
@@ -945,7 +1653,8 @@ qboolean CL_DemoReadMessage( byte *buffer, size_t *length )
 		return false;
 	}
 
-	if(( !cl.background && ( cl.paused || cls.key_dest != key_game )) || cls.key_dest == key_console )
+	// seeking don't wait for console to close
+	if( demo.seektime < 0.0f && (( !cl.background && ( cl.paused || cls.key_dest != key_game )) || cls.key_dest == key_console ))
 	{
 		demo.starttime += host.frametime;
 		return false; // paused
@@ -964,8 +1673,12 @@ qboolean CL_DemoReadMessage( byte *buffer, size_t *length )
 		if( !CL_ReadDemoCmdHeader( &cmd, &demo.timestamp ))
 			return false;
 
+		// reached seek target, this message is due right now
+		if( demo.seektime >= 0.0f && cmd == dem_read && demo.timestamp >= demo.seektime )
+			CL_DemoStopSeek( true );
+
 		fElapsedTime = CL_GetDemoPlaybackClock() - demo.starttime;
-		if( !cls.timedemo ) bSkipMessage = ((demo.timestamp - cl_serverframetime()) >= fElapsedTime) ? true : false;
+		if( !cls.timedemo && demo.seektime < 0.0f ) bSkipMessage = ((demo.timestamp - cl_serverframetime()) >= fElapsedTime) ? true : false;
 		if( cls.changelevel ) demo.framecount = 1;
 
 		// changelevel issues
@@ -995,9 +1708,11 @@ qboolean CL_DemoReadMessage( byte *buffer, size_t *length )
 		switch( cmd )
 		{
 		case dem_jumptime:
+			CL_DemoStopSeek( false ); // can't seek beyond the level
 			demo.starttime = CL_GetDemoPlaybackClock();
 			return false; // time is changed, skip frame
 		case dem_stop:
+			CL_DemoStopSeek( false );
 			CL_DemoMoveToNextSection();
 			return false; // header is ended, skip frame
 		case dem_userdata:
@@ -1022,7 +1737,7 @@ qboolean CL_DemoReadMessage( byte *buffer, size_t *length )
 
 	// If we are playing back a timedemo, and we've already passed on a
 	//  frame update for this host_frame tag, then we'll just skip this message.
-	if( cls.timedemo && ( tdlastdemoframe == host.framecount ))
+	if( cls.timedemo && demo.seektime < 0.0f && ( tdlastdemoframe == host.framecount ))
 	{
 		FS_Seek( cls.demofile, FS_Tell ( cls.demofile ) - 5, SEEK_SET );
 		return false;
@@ -1046,6 +1761,7 @@ qboolean CL_DemoReadMessage( byte *buffer, size_t *length )
 	}
 
 	demo.framecount++;
+	demo.msgpos = curpos;
 	CL_ReadDemoSequence( false );
 
 	return CL_ReadRawNetworkData( buffer, length );
@@ -1178,6 +1894,12 @@ void CL_StopPlayback( void )
 {
 	if( !cls.demoplayback ) return;
 
+	// index was extended while playing, keep it for next time
+	if( cls.demoplayback == DEMO_XASH3D && demo.index.dirty )
+		CL_DemoSaveIndex( va( "%s.dki", cls.demoname ), FS_FileLength( cls.demofile ));
+	CL_DemoFreeIndex();
+	demo.seektime = -1.0f;
+
 	// release demofile
 	FS_Close( cls.demofile );
 	cls.demoplayback = false;
@@ -1603,6 +2325,9 @@ void CL_PlayDemo_f( void )
 	// must be after DemoStartPlayback, as CL_Disconnect_f resets the protocol
 	cls.legacymode = CL_GetProtocolFromDemo( demo.header.net_protocol );
 
+	// seek targets, missing ones are collected during playback
+	CL_DemoLoadIndex( va( "%s.dki", demoname ), FS_FileLength( cls.demofile ));
+
 	// g-cont. is this need?
 	Q_strncpy( cls.servername, demoname, sizeof( cls.servername ));
 
@@ -1779,3 +2504,494 @@ void CL_ListDemo_f( void )
 
 	FS_Close( f );
 }
+
+/*
+====================
+CL_DemoSeek_f
+
+demo_seek <time>, or demo_seek +/-<seconds>
+relative to current demo time
+====================
+*/
+void CL_DemoSeek_f( void )
+{
+	const char	*arg;
+	float		target;
+	int		kf;
+
+	if( Cmd_Argc() != 2 )
+	{
+		Con_Printf( S_USAGE "demo_seek <time>\n" );
+		return;
+	}
+
+	if( cls.demoplayback != DEMO_XASH3D || !cls.demofile )
+	{
+		Con_Printf( "Not playing a demo.\n" );
+		return;
+	}
+
+	if( cls.state != ca_active )
+	{
+		Con_Printf( "Can't seek while demo is loading.\n" );
+		return;
+	}
+
+	arg = Cmd_Argv( 1 );
+	target = Q_atof( arg );
+
+	if( arg[0] == '+' || arg[0] == '-' )
+		target += demo.timestamp;
+
+	target = Q_max( target, 0.0f );
+	kf = CL_DemoFindKeyframe( cl.servercount, demo.entryIndex, target );
+
+	// no closer keyframe ahead, fast-forward from here
+	if( target >= demo.timestamp && ( kf == -1 || demo.index.keyframes[kf].offset <= demo.msgpos ))
+	{
+		demo.seektime = target;
+		return;
+	}
+
+	if( kf == -1 )
+	{
+		Con_Printf( S_ERROR "no keyframe before %.2f, play the demo further to index it\n", target );
+		return;
+	}
+
+	if( !CL_DemoRestoreKeyframe( kf ))
+		return;
+
+	FS_Seek( cls.demofile, demo.index.keyframes[kf].offset, SEEK_SET );
+	demo.seektime = target;
+	S_StopAllSounds( false );
+}
+
+#if XASH_ENGINE_TESTS
+#include "tests.h"
+
+static void Test_DemoIndex_Keyframes( void )
+{
+	int	servercount = cl.servercount;
+
+	CL_DemoFreeIndex();
+
+	CL_DemoAddKeyframe( 100, 0.0f, 1 );
+	CL_DemoAddKeyframe( 2000, 10.0f, 1 );
+	CL_DemoAddKeyframe( 1500, 5.0f, 1 ); // seen again after seeking back
+	CL_DemoAddKeyframe( 4000, 20.0f, 1 );
+
+	TASSERT_EQi( demo.index.numkeyframes, 3 );
+	TASSERT( demo.index.dirty );
+
+	TASSERT_EQi( CL_DemoFindKeyframe( servercount, 1, 0.0f ), 0 );
+	TASSERT_EQi( CL_DemoFindKeyframe( servercount, 1, 15.0f ), 1 );
+	TASSERT_EQi( CL_DemoFindKeyframe( servercount, 1, 25.0f ), 2 );
+	TASSERT_EQi( CL_DemoFindKeyframe( servercount, 1, -1.0f ), -1 );
+	TASSERT_EQi( CL_DemoFindKeyframe( servercount, 2, 15.0f ), -1 );
+	TASSERT_EQi( CL_DemoFindKeyframe( servercount + 1, 1, 15.0f ), -1 );
+}
+
+static void Test_DemoIndex_SaveLoad( void )
+{
+	const char	*filename = "test_demoindex.dki";
+	int		statesize = demo.index.numkeyframes > 1 ? demo.index.keyframes[1].statesize : -1;
+	file_t		*f;
+
+	TASSERT( CL_DemoSaveIndex( filename, 8000 ));
+	TASSERT( !demo.index.dirty );
+	CL_DemoFreeIndex();
+
+	// tests run before game directory is mounted
+	f = FS_Open( filename, "rb", false );
+	TASSERT( f != NULL );
+	if( !f )
+		return;
+
+	// stale index must not be used
+	TASSERT( !CL_DemoReadIndex( f, 9000 ));
+	TASSERT_EQi( demo.index.numkeyframes, 0 );
+
+	FS_Seek( f, 0, SEEK_SET );
+	TASSERT( CL_DemoReadIndex( f, 8000 ));
+	TASSERT_EQi( demo.index.numkeyframes, 3 );
+	FS_Close( f );
+
+	if( demo.index.numkeyframes == 3 )
+	{
+		TASSERT_EQi( demo.index.keyframes[1].offset, 2000 );
+		TASSERT_EQi( demo.index.keyframes[1].statesize, statesize );
+		TASSERT( demo.index.keyframes[2].timestamp == 20.0f );
+		TASSERT_EQi( demo.index.keyframes[2].entryIndex, 1 );
+	}
+
+	TASSERT( !demo.index.dirty );
+
+	FS_Delete( filename );
+}
+
+static void Test_DemoIndex_Tables( void )
+{
+	player_info_t	*player = &cl.players[1];
+	byte		data[0x1000];
+	int		size;
+
+	cl.maxclients = 2;
+	CL_SetLightstyle( 3, "abcba", 1.5f );
+	Q_strncpy( player->userinfo, "\\name\\seeker\\model\\gordon", sizeof( player->userinfo ));
+	player->userid = 42;
+
+	size = CL_DemoWriteTables( data, sizeof( data ));
+	TASSERT( size > 0 );
+
+	// state after seeking back to keyframe
+	memset( cl.lightstyles, 0, sizeof( cl.lightstyles ));
+	memset( cl.players, 0, sizeof( cl.players ));
+	CL_DemoReadTables( data, size );
+
+	TASSERT_STR( cl.lightstyles[3].pattern, "abcba" );
+	TASSERT( cl.lightstyles[3].time == 1.5f );
+	TASSERT( !COM_CheckStringEmpty( cl.lightstyles[0].pattern ));
+	TASSERT_STR( player->userinfo, "\\name\\seeker\\model\\gordon" );
+	TASSERT_STR( player->name, "seeker" );
+	TASSERT_EQi( player->userid, 42 );
+	TASSERT( !COM_CheckStringEmpty( cl.players[0].userinfo ));
+
+	memset( cl.lightstyles, 0, sizeof( cl.lightstyles ));
+	memset( cl.players, 0, sizeof( cl.players ));
+	cl.maxclients = 0;
+}
+
+static void Test_DemoIndex_Delta( void )
+{
+	byte	from[300], to[300], out[300], data[1024];
+	uint	seed = 1;
+	sizebuf_t	buf;
+	int	i, j;
+
+	for( i = 0; i < 64; i++ )
+	{
+		for( j = 0; j < sizeof( from ); j++ )
+		{
+			seed = seed * 1103515245 + 12345;
+			from[j] = seed >> 16;
+
+			// sparse, clustered and trailing changes
+			if(( seed >> 8 ) % 64 < i || ( i & 1 && j == sizeof( from ) - 1 ))
+				to[j] = from[j] ^ ( 1 + j % 255 );
+			else to[j] = from[j];
+		}
+
+		MSG_Init( &buf, "DeltaTest", data, sizeof( data ));
+		CL_DemoWriteDelta( &buf, from, to, sizeof( from ));
+		TASSERT( !MSG_CheckOverflow( &buf ));
+
+		memset( out, 0xcc, sizeof( out ));
+		MSG_Init( &buf, "DeltaTest", data, MSG_GetNumBytesWritten( &buf ));
+		TASSERT( CL_DemoReadDelta( &buf, from, out, sizeof( out )));
+		TASSERT( !memcmp( out, to, sizeof( to )));
+		TASSERT_EQi( MSG_GetNumBytesLeft( &buf ), 0 );
+
+		// in place
+		MSG_SeekToBit( &buf, 0, SEEK_SET );
+		memcpy( out, from, sizeof( out ));
+		TASSERT( CL_DemoReadDelta( &buf, out, out, sizeof( out )));
+		TASSERT( !memcmp( out, to, sizeof( to )));
+	}
+
+	// no changes is just the terminator
+	MSG_Init( &buf, "DeltaTest", data, sizeof( data ));
+	CL_DemoWriteDelta( &buf, from, from, sizeof( from ));
+	TASSERT_EQi( MSG_GetNumBytesWritten( &buf ), 4 );
+
+	// run past the end of structure
+	MSG_Init( &buf, "DeltaTest", data, sizeof( data ));
+	MSG_WriteWord( &buf, 250 );
+	MSG_WriteWord( &buf, 100 );
+	MSG_WriteBytes( &buf, to, 100 );
+	MSG_Init( &buf, "DeltaTest", data, MSG_GetNumBytesWritten( &buf ));
+	TASSERT( !CL_DemoReadDelta( &buf, from, out, sizeof( out )));
+}
+
+#define TEST_SEEK_MESSAGES	40
+#define TEST_SEEK_INTERVAL	4.0f	// eight messages between keyframes
+#define TEST_SEEK_FULL	16	// messages between non-delta updates
+#define TEST_SEEK_CLIENTS	4
+#define TEST_SEEK_ENTITIES	12
+
+static void Test_DemoSeek_WriteMessage( sizebuf_t *msg, int i )
+{
+	MSG_WriteByte( msg, svc_lightstyle );
+	MSG_WriteByte( msg, ( i * 7 ) % 12 );
+	MSG_WriteString( msg, va( "%c%cz", 'a' + i % 26, 'm' + i % 7 ));
+	MSG_WriteFloat( msg, i * 0.25f );
+
+	if( i % 3 )
+		return;
+
+	MSG_WriteByte( msg, svc_updateuserinfo );
+	MSG_WriteUBitLong( msg, i % TEST_SEEK_CLIENTS, MAX_CLIENT_BITS );
+	MSG_WriteLong( msg, 100 + i );
+
+	// players leave sometimes
+	if( i % 5 != 4 )
+	{
+		MSG_WriteOneBit( msg, 1 );
+		MSG_WriteString( msg, va( "\\name\\player%d\\model\\m%d", i, i % 4 ));
+		MSG_WriteBytes( msg, "0123456789abcdef0123456789abcdef", sizeof( cl.players[0].hashedcdkey ));
+	}
+	else MSG_WriteOneBit( msg, 0 );
+}
+
+/*
+server deltas against last frame acknowledged
+by client, it never goes back and it starts
+from scratch after non-delta update
+*/
+static int Test_DemoSeek_DeltaFrom( int i )
+{
+	if( !( i % TEST_SEEK_FULL ))
+		return -1;
+
+	return Q_max( i - 1 - ( i / 2 ) % 3, i - i % TEST_SEEK_FULL );
+}
+
+static void Test_DemoSeek_Parse( int i )
+{
+	frame_t		*frame = &cl.frames[i & CL_UPDATE_MASK];
+	frame_t		*oldframe = NULL;
+	int		j, k, deltafrom;
+	byte		data[1024];
+	sizebuf_t		msg;
+
+	cls.netchan.incoming_sequence = i;
+	frame->valid = false;
+
+	MSG_Init( &msg, "DemoSeekTest", data, sizeof( data ));
+	Test_DemoSeek_WriteMessage( &msg, i );
+	CL_DemoReadTables( data, MSG_GetNumBytesWritten( &msg ));
+
+	// baseline is updated in game sometimes, like in legacy protocol
+	if( i % 5 == 2 )
+	{
+		entity_state_t *baseline = &CL_EDICT_NUM( 1 + i % TEST_SEEK_ENTITIES )->baseline;
+
+		baseline->modelindex = 1 + i % 7;
+		baseline->origin[2] = i;
+	}
+
+	if(( deltafrom = Test_DemoSeek_DeltaFrom( i )) != -1 )
+	{
+		CL_DemoMarkDelta( deltafrom & 0xFF );
+		oldframe = &cl.frames[deltafrom & CL_UPDATE_MASK];
+
+		if( !oldframe->valid )
+			return; // rejected by CL_ValidateDeltaPacket
+	}
+
+	if( oldframe )
+	{
+		frame->clientdata = oldframe->clientdata;
+		memcpy( frame->weapondata, oldframe->weapondata, sizeof( frame->weapondata ));
+		memcpy( frame->playerstate, oldframe->playerstate, sizeof( frame->playerstate ));
+	}
+	else
+	{
+		memset( &frame->clientdata, 0, sizeof( frame->clientdata ));
+		memset( frame->weapondata, 0, sizeof( frame->weapondata ));
+		memset( frame->playerstate, 0, sizeof( frame->playerstate ));
+	}
+
+	frame->time = i * 0.5;
+	frame->clientdata.health += 1 + i % 3;
+	frame->clientdata.origin[0] += i;
+	frame->weapondata[i % 8].m_iClip += i;
+	frame->playerstate[i % TEST_SEEK_CLIENTS].origin[1] += i;
+
+	frame->first_entity = cls.next_client_entities;
+	frame->num_entities = 0;
+
+	for( j = 1; j <= TEST_SEEK_ENTITIES; j++ )
+	{
+		const entity_state_t	*from = &CL_EDICT_NUM( j )->baseline;
+		entity_state_t	*state;
+
+		// out of PVS
+		if(( i + j ) % 9 == 0 )
+			continue;
+
+		for( k = 0; oldframe && k < oldframe->num_entities; k++ )
+		{
+			const entity_state_t *old = &cls.packet_entities[( oldframe->first_entity + k ) % cls.num_client_entities];
+
+			if( old->number == j )
+				from = old;
+		}
+
+		state = &cls.packet_entities[cls.next_client_entities % cls.num_client_entities];
+		*state = *from;
+		state->number = j;
+		state->origin[0] += j;
+		state->angles[1] += i * j;
+		state->frame = i;
+
+		cls.next_client_entities++;
+		frame->num_entities++;
+	}
+
+	frame->valid = true;
+}
+
+static void Test_DemoSeek_Play( int from, int to, qboolean index )
+{
+	int	i;
+
+	for( i = from; i < to; i++ )
+	{
+		Test_DemoSeek_Parse( i );
+
+		// message offset is its number, two messages per second
+		if( index && CL_DemoKeyframeDue( i * 0.5f, 1 ))
+			CL_DemoAddKeyframe( i, i * 0.5f, 1 );
+
+		demo.deltafrom = -1;
+	}
+}
+
+static void Test_DemoSeek_Reset( void )
+{
+	memset( cl.lightstyles, 0, sizeof( cl.lightstyles ));
+	memset( cl.players, 0, sizeof( cl.players ));
+	memset( cl.frames, 0, sizeof( cl.frames ));
+	memset( clgame.entities, 0, sizeof( *clgame.entities ) * clgame.maxEntities );
+	cls.next_client_entities = 0;
+}
+
+typedef struct
+{
+	lightstyle_t	lightstyles[MAX_LIGHTSTYLES];
+	player_info_t	players[TEST_SEEK_CLIENTS];
+	entity_state_t	baselines[TEST_SEEK_ENTITIES + 1];
+	frame_t		frames[4];
+	entity_state_t	entities[4][TEST_SEEK_ENTITIES];
+} test_seekstate_t;
+
+/*
+everything next messages may depend on: string tables,
+baselines and frames they can be delta compressed against
+*/
+static void Test_DemoSeek_Save( test_seekstate_t *st, int i )
+{
+	int	j, k, first = Test_DemoSeek_DeltaFrom( i );
+
+	memset( st, 0, sizeof( *st ));
+	memcpy( st->lightstyles, cl.lightstyles, sizeof( st->lightstyles ));
+	memcpy( st->players, cl.players, sizeof( st->players ));
+
+	for( j = 0; j <= TEST_SEEK_ENTITIES; j++ )
+		st->baselines[j] = clgame.entities[j].baseline;
+
+	if( first == -1 )
+		first = i;
+
+	for( j = 0; j <= i - first; j++ )
+	{
+		frame_t *frame = &st->frames[j];
+
+		*frame = cl.frames[( first + j ) & CL_UPDATE_MASK];
+
+		for( k = 0; k < frame->num_entities; k++ )
+			st->entities[j][k] = cls.packet_entities[( frame->first_entity + k ) % cls.num_client_entities];
+
+		// position in packet entities isn't a state
+		frame->first_entity = 0;
+	}
+}
+
+static void Test_DemoIndex_Seek( void )
+{
+	static test_seekstate_t	sequential, seek;
+	cl_entity_t		*oldentities = clgame.entities;
+	entity_state_t		*oldpacket = cls.packet_entities;
+	int			oldmaxentities = clgame.maxEntities;
+	int			oldnumclient = cls.num_client_entities;
+	int			oldnextclient = cls.next_client_entities;
+	int			oldsequence = cls.netchan.incoming_sequence;
+	float			oldinterval = demo_keyframes.value;
+	int			i, kf;
+
+	clgame.maxEntities = TEST_SEEK_ENTITIES + 1;
+	clgame.entities = Mem_Calloc( cls.mempool, sizeof( *clgame.entities ) * clgame.maxEntities );
+	cls.num_client_entities = CL_UPDATE_BACKUP * NUM_PACKET_ENTITIES;
+	cls.packet_entities = Mem_Calloc( cls.mempool, sizeof( *cls.packet_entities ) * cls.num_client_entities );
+	cl.maxclients = TEST_SEEK_CLIENTS;
+	demo_keyframes.value = TEST_SEEK_INTERVAL;
+	demo.deltafrom = -1;
+
+	// index the demo while playing it through
+	CL_DemoFreeIndex();
+	Test_DemoSeek_Reset();
+	Test_DemoSeek_Play( 0, TEST_SEEK_MESSAGES, true );
+	TASSERT_EQi( demo.index.numkeyframes, TEST_SEEK_MESSAGES / 8 );
+
+	for( i = 0; i < TEST_SEEK_MESSAGES; i++ )
+	{
+		// sequential playback up to message
+		Test_DemoSeek_Reset();
+		Test_DemoSeek_Play( 0, i + 1, false );
+		Test_DemoSeek_Save( &sequential, i );
+
+		// seek back from the end of demo, keyframe
+		// message is due, so it's parsed again
+		Test_DemoSeek_Play( i + 1, TEST_SEEK_MESSAGES, false );
+		kf = CL_DemoFindKeyframe( cl.servercount, 1, i * 0.5f );
+		TASSERT( kf != -1 );
+		if( kf == -1 )
+			continue;
+
+		TASSERT( CL_DemoRestoreKeyframe( kf ));
+		Test_DemoSeek_Play( demo.index.keyframes[kf].offset, i + 1, false );
+		Test_DemoSeek_Save( &seek, i );
+
+		TASSERT( !memcmp( &seek, &sequential, sizeof( seek )));
+	}
+
+	Test_DemoSeek_Reset();
+	Mem_Free( clgame.entities );
+	Mem_Free( cls.packet_entities );
+	clgame.entities = oldentities;
+	clgame.maxEntities = oldmaxentities;
+	cls.packet_entities = oldpacket;
+	cls.num_client_entities = oldnumclient;
+	cls.next_client_entities = oldnextclient;
+	cls.netchan.incoming_sequence = oldsequence;
+	demo_keyframes.value = oldinterval;
+	cl.maxclients = 0;
+}
+
+void Test_RunDemoIndex( void )
+{
+	poolhandle_t oldpool = cls.mempool;
+
+	// tests run before client is initialized
+	if( !cls.mempool )
+		cls.mempool = Mem_AllocPool( "Demo Index Test" );
+
+	demo.deltafrom = -1;
+
+	TRUN( Test_DemoIndex_Keyframes() );
+	TRUN( Test_DemoIndex_SaveLoad() );
+	TRUN( Test_DemoIndex_Tables() );
+	TRUN( Test_DemoIndex_Delta() );
+	TRUN( Test_DemoIndex_Seek() );
+
+	CL_DemoFreeIndex();
+
+	if( cls.mempool != oldpool )
+	{
+		Mem_FreePool( &cls.mempool );
+		cls.mempool = oldpool;
+	}
+}
+
+#endif /* XASH_ENGINE_TESTS */
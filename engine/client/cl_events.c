@@ -19,6 +19,30 @@ GNU General Public License for more details.
 #include "net_encode.h"
 #include "con_nprint.h"
 
+/*
+===============
+CL_EventSlotForMask
+
+returns lowest set bit in non-empty slots mask
+===============
+*/
+static int CL_EventSlotForMask( uint64_t mask )
+{
+#if defined( __GNUC__ )
+	return __builtin_ctzll( mask );
+#else
+	int	slot = 0;
+
+	while( !FBitSet( mask, 1 ))
+	{
+		mask >>= 1;
+		slot++;
+	}
+
+	return slot;
+#endif
+}
+
 /*
 ===============
 CL_ResetEvent
@@ -27,6 +51,15 @@ CL_ResetEvent
 */
 void CL_ResetEvent( event_info_t *ei )
 {
+	event_state_t	*es = &cl.events;
+	uint64_t		bit = 1ULL << ( ei - es->ei );
+
+	if( FBitSet( es->used, bit ))
+	{
+		ClearBits( es->used, bit );
+		es->count--;
+	}
+
 	ei->index = 0;
 	memset( &ei->args, 0, sizeof( ei->args ));
 	ei->fire_time = 0.0;
@@ -263,16 +296,21 @@ void CL_FireEvents( void )
 {
 	event_state_t	*es;
 	event_info_t	*ei;
+	uint64_t		pending;
 	int		i;
 
 	es = &cl.events;
 
+	// walk occupied slots only, in slot order
 	for( i = 0; i < MAX_EVENT_QUEUE; i++ )
 	{
-		ei = &es->ei[i];
+		pending = es->used >> i;
 
-		if( ei->index == 0 )
-			continue;
+		if( !pending )
+			break;
+
+		i += CL_EventSlotForMask( pending );
+		ei = &es->ei[i];
 
 		// delayed event!
 		if( ei->fire_time && ( ei->fire_time > cl.time ))
@@ -294,23 +332,14 @@ find first empty event
 */
 static event_info_t *CL_FindEmptyEvent( void )
 {
-	int		i;
-	event_state_t	*es;
-	event_info_t	*ei;
-
-	es = &cl.events;
-
-	// look for first slot where index is != 0
-	for( i = 0; i < MAX_EVENT_QUEUE; i++ )
-	{
-		ei = &es->ei[i];
-		if( ei->index != 0 )
-			continue;
-		return ei;
-	}
+	event_state_t	*es = &cl.events;
 
 	// no slots available
-	return NULL;
+	if( es->count >= MAX_EVENT_QUEUE )
+		return NULL;
+
+	// first slot where index is 0
+	return &es->ei[CL_EventSlotForMask( ~es->used )];
 }
 
 /*
@@ -367,6 +396,12 @@ static void CL_QueueEvent( int flags, int index, float delay, event_args_t *args
 		if( !ei ) return;
 	}
 
+	if( !FBitSet( cl.events.used, 1ULL << ( ei - cl.events.ei )))
+	{
+		SetBits( cl.events.used, 1ULL << ( ei - cl.events.ei ));
+		cl.events.count++;
+	}
+
 	ei->index	= index;
 	ei->packet_index = 0;
 	ei->fire_time = delay ? (cl.time + delay) : 0.0f;
@@ -18,6 +18,32 @@ GNU General Public License for more details.
 #include "client.h"
 #include "qfont.h"
 
+#define GLYPH_CACHE_SIZE	256	// must be power of two
+#define GLYPH_CACHE_MAXLEN	256	// longer strings are laid out on each draw
+
+typedef struct glyph_run_s
+{
+	// key
+	const cl_font_t	*font;
+	int		texnum;
+	int		flags;
+	float		x;	// tab stops depend on it
+	rgba_t		color;
+	uint		hash;
+	char		text[GLYPH_CACHE_MAXLEN];
+
+	// laid out glyphs, relative to string origin
+	ref_glyph_t	*glyphs;
+	int		numglyphs;
+	int		maxglyphs;
+	int		width;	// width of the last line, CL_DrawString returns it
+	int		lasty;	// offset of the last line
+} glyph_run_t;
+
+static glyph_run_t	cl_glyphcache[GLYPH_CACHE_SIZE];
+static glyph_run_t	cl_glyphscratch;
+static poolhandle_t	cl_glyphpool;
+
 qboolean CL_FixedFont( cl_font_t *font )
 {
 	return font && font->valid && font->type == FONT_FIXED;
@@ -152,11 +178,29 @@ qboolean Con_LoadVariableWidthFont( const char *fontname, cl_font_t *font, float
 	return true;
 }
 
+/*
+==============
+CL_ClearGlyphCache
+
+fonts are reloaded on charset change, so
+this also drops runs laid out in previous charset
+==============
+*/
+void CL_ClearGlyphCache( void )
+{
+	if( cl_glyphpool )
+		Mem_EmptyPool( cl_glyphpool );
+
+	memset( cl_glyphcache, 0, sizeof( cl_glyphcache ));
+	memset( &cl_glyphscratch, 0, sizeof( cl_glyphscratch ));
+}
+
 void CL_FreeFont( cl_font_t *font )
 {
 	if( !font || !font->valid )
 		return;
 
+	CL_ClearGlyphCache();
 	ref.dllFuncs.GL_FreeTexture( font->hFontTexture );
 	memset( font, 0, sizeof( *font ));
 }
@@ -231,24 +275,57 @@ int CL_DrawCharacter( float x, float y, int number, rgba_t color, cl_font_t *fon
 	return font->charWidths[number];
 }
 
-int CL_DrawString( float x, float y, const char *s, rgba_t color, cl_font_t *font, int flags )
+static ref_glyph_t *CL_AllocGlyph( glyph_run_t *run )
+{
+	if( run->numglyphs == run->maxglyphs )
+	{
+		if( !cl_glyphpool )
+			cl_glyphpool = Mem_AllocPool( "Glyph Cache" );
+
+		run->maxglyphs = Q_max( run->maxglyphs * 2, 64 );
+		run->glyphs = Mem_Realloc( cl_glyphpool, run->glyphs, run->maxglyphs * sizeof( *run->glyphs ));
+	}
+
+	return &run->glyphs[run->numglyphs++];
+}
+
+/*
+==============
+CL_LayoutString
+
+same rules as CL_DrawCharacter, but glyphs are collected
+into run instead of being drawn one by one
+==============
+*/
+static void CL_LayoutString( glyph_run_t *run, float x, float y, const char *s, const rgba_t color, const cl_font_t *font, int flags )
 {
 	rgba_t current_color;
-	int draw_len = 0;
+	int draw_len = 0, line = 0;
+	float half = 0.5f;
+	qboolean colored;
+	int texw, texh;
 
-	if( !font || !font->valid )
-		return 0;
+	R_GetTextureParms( &texw, &texh, font->hFontTexture );
+
+	if( font->scale <= 1.f || !REF_GET_PARM( PARM_TEX_FILTERING, font->hFontTexture ))
+		half = 0;
+
+	// don't apply color to fixed fonts it's already colored
+	colored = font->type != FONT_FIXED || REF_GET_PARM( PARM_TEX_GLFORMAT, font->hFontTexture ) == 0x8045; // GL_LUMINANCE8_ALPHA8
 
 	if( FBitSet( flags, FONT_DRAW_UTF8 ))
 		Con_UtfProcessChar( 0 ); // clear utf state
 
-	if( !FBitSet( flags, FONT_DRAW_NORENDERMODE ))
-		CL_SetFontRendermode( font );
-
 	Vector4Copy( color, current_color );
+	run->numglyphs = 0;
 
 	while( *s )
 	{
+		const wrect_t *rc;
+		ref_glyph_t *glyph;
+		float gx, gy, w, h;
+		int number;
+
 		if( *s == '\n' )
 		{
 			s++;
@@ -260,7 +337,7 @@ int CL_DrawString( float x, float y, const char *s, rgba_t color, cl_font_t *fon
 			if( !FBitSet( flags, FONT_DRAW_NOLF ))
 			{
 				draw_len = 0;
-				y += font->charHeight;
+				line += font->charHeight;
 			}
 
 			if( FBitSet( flags, FONT_DRAW_RESETCOLORONLF ))
@@ -278,13 +355,144 @@ int CL_DrawString( float x, float y, const char *s, rgba_t color, cl_font_t *fon
 			continue;
 		}
 
-		// skip setting rendermode, it was changed for this string already
-		draw_len += CL_DrawCharacter( x + draw_len, y, (byte)*s, current_color, font, flags | FONT_DRAW_NORENDERMODE );
+		number = (byte)*s++;
 
-		s++;
+		// check if printable
+		if( number <= 32 )
+		{
+			if( number == ' ' )
+				draw_len += font->charWidths[' '];
+			else if( number == '\t' )
+				draw_len += CL_CalcTabStop( font, x + draw_len );
+			continue;
+		}
+
+		if( FBitSet( flags, FONT_DRAW_UTF8 ))
+			number = Con_UtfProcessChar( number );
+
+		if( !number || !font->charWidths[number] )
+			continue;
+
+		if( texw && texh )
+		{
+			rc = &font->fontRc[number];
+			gx = x + draw_len;
+			gy = y + line;
+			w = ( rc->right - rc->left ) * font->scale;
+			h = ( rc->bottom - rc->top ) * font->scale;
+
+			if( FBitSet( flags, FONT_DRAW_HUD ))
+				SPR_AdjustSize( &gx, &gy, &w, &h );
+
+			glyph = CL_AllocGlyph( run );
+			glyph->x = gx - x;
+			glyph->y = gy - y;
+			glyph->w = w;
+			glyph->h = h;
+			glyph->s1 = ((float)rc->left + half ) / texw;
+			glyph->t1 = ((float)rc->top + half ) / texh;
+			glyph->s2 = ((float)rc->right - half ) / texw;
+			glyph->t2 = ((float)rc->bottom - half ) / texh;
+
+			if( colored )
+				Vector4Copy( current_color, glyph->color );
+			else Vector4Set( glyph->color, 255, 255, 255, current_color[3] );
+		}
+
+		draw_len += font->charWidths[number];
+	}
+
+	run->width = draw_len;
+	run->lasty = line;
+}
+
+static uint CL_HashGlyphRun( const char *s, size_t *len, float x, const rgba_t color, const cl_font_t *font, int flags )
+{
+	const char *p;
+	uint hash = 2166136261u, col;
+
+	for( p = s; *p; p++ )
+		hash = ( hash ^ (byte)*p ) * 16777619u;
+
+	memcpy( &col, color, sizeof( col ));
+	hash = ( hash ^ col ) * 16777619u;
+	hash = ( hash ^ (uint)(int)x ) * 16777619u;
+	hash = ( hash ^ (uint)flags ) * 16777619u;
+	hash = ( hash ^ (uint)font->hFontTexture ) * 16777619u;
+
+	*len = p - s;
+	return hash;
+}
+
+/*
+==============
+CL_FindGlyphRun
+
+HUD positions are scaled in screen space, so
+these runs are never cached
+==============
+*/
+static glyph_run_t *CL_FindGlyphRun( float x, float y, const char *s, const rgba_t color, const cl_font_t *font, int flags )
+{
+	glyph_run_t *run;
+	size_t len;
+	uint hash;
+
+	if( FBitSet( flags, FONT_DRAW_HUD ))
+	{
+		CL_LayoutString( &cl_glyphscratch, x, y, s, color, font, flags );
+		return &cl_glyphscratch;
 	}
 
-	return draw_len;
+	hash = CL_HashGlyphRun( s, &len, x, color, font, flags );
+
+	if( len >= GLYPH_CACHE_MAXLEN )
+	{
+		CL_LayoutString( &cl_glyphscratch, x, y, s, color, font, flags );
+		return &cl_glyphscratch;
+	}
+
+	run = &cl_glyphcache[hash & ( GLYPH_CACHE_SIZE - 1 )];
+
+	if( run->hash == hash && run->font == font && run->texnum == font->hFontTexture && run->flags == flags
+		&& run->x == x && !memcmp( run->color, color, sizeof( rgba_t )) && !Q_strcmp( run->text, s ))
+		return run;
+
+	run->hash = hash;
+	run->font = font;
+	run->texnum = font->hFontTexture;
+	run->flags = flags;
+	run->x = x;
+	Vector4Copy( color, run->color );
+	memcpy( run->text, s, len + 1 );
+	CL_LayoutString( run, x, y, s, color, font, flags );
+
+	return run;
+}
+
+int CL_DrawString( float x, float y, const char *s, rgba_t color, cl_font_t *font, int flags )
+{
+	const glyph_run_t *run;
+	int rendermode = -1;
+
+	if( !font || !font->valid )
+		return 0;
+
+	run = CL_FindGlyphRun( x, y, s, color, font, flags );
+
+	if( !FBitSet( flags, FONT_DRAW_NORENDERMODE ))
+		rendermode = CL_FontRenderMode( font->rendermode );
+
+	if( run->numglyphs )
+		ref.dllFuncs.R_DrawGlyphRun( run->glyphs, run->numglyphs, x, y, font->hFontTexture, rendermode );
+	else if( rendermode >= 0 )
+		ref.dllFuncs.GL_SetRenderMode( rendermode );
+
+	// last line is above the screen
+	if( y + run->lasty < -font->charHeight )
+		return 0;
+
+	return run->width;
 }
 
 int CL_DrawStringf( cl_font_t *font, float x, float y, rgba_t color, int flags, const char *fmt, ... )
@@ -740,6 +740,13 @@ qboolean CL_ValidateDeltaPacket( uint oldpacket, frame_t *oldframe )
 		return false;
 	}
 
+	// frame history was dropped by demo seeking
+	if( !oldframe->valid )
+	{
+		Con_NPrintf( 2, "^3Warning:^1 delta frame is invalid^7\n" );
+		return false;
+	}
+
 	return true;
 }
 
@@ -860,6 +867,7 @@ int CL_ParsePacketEntities( sizebuf_t *msg, qboolean delta, connprotocol_t proto
 	{
 		uint oldpacket = MSG_ReadByte( msg );
 		oldframe = &cl.frames[oldpacket & CL_UPDATE_MASK];
+		CL_DemoMarkDelta( oldpacket );
 
 		if( !CL_ValidateDeltaPacket( oldpacket, oldframe ))
 		{
@@ -51,6 +51,7 @@ static CVAR_DEFINE_AUTO( rcon_address, "", FCVAR_PRIVILEGED, "remote control add
 CVAR_DEFINE_AUTO( cl_timeout, "60", 0, "connect timeout (in-seconds)" );
 CVAR_DEFINE_AUTO( cl_nopred, "0", FCVAR_ARCHIVE|FCVAR_USERINFO, "disable client movement prediction" );
 static CVAR_DEFINE_AUTO( cl_nodelta, "0", 0, "disable delta-compression for server messages" );
+CVAR_DEFINE_AUTO( demo_keyframes, "5", FCVAR_ARCHIVE, "seconds between keyframes in demo seek index, 0 to disable" );
 CVAR_DEFINE( cl_crosshair, "crosshair", "1", FCVAR_ARCHIVE, "show weapon chrosshair" );
 static CVAR_DEFINE_AUTO( cl_cmdbackup, "10", FCVAR_ARCHIVE, "how many additional history commands are sent" );
 CVAR_DEFINE_AUTO( cl_showerror, "0", FCVAR_ARCHIVE, "show prediction error" );
@@ -80,6 +81,7 @@ CVAR_DEFINE_AUTO( cl_trace_stufftext, "0", FCVAR_ARCHIVE, "enable stufftext (ser
 CVAR_DEFINE_AUTO( cl_trace_messages, "0", FCVAR_ARCHIVE|FCVAR_CHEAT, "enable message names tracing (good for developers)" );
 CVAR_DEFINE_AUTO( cl_trace_events, "0", FCVAR_ARCHIVE|FCVAR_CHEAT, "enable events tracing (good for developers)" );
 static CVAR_DEFINE_AUTO( cl_nat, "0", 0, "show servers running under NAT" );
+static CVAR_DEFINE_AUTO( cl_precache_slice, "30", FCVAR_ARCHIVE, "milliseconds per frame spent on loading resources during signon, 0 to load everything at once" );
 CVAR_DEFINE_AUTO( hud_utf8, "0", FCVAR_ARCHIVE, "Use utf-8 encoding for hud text" );
 CVAR_DEFINE_AUTO( ui_renderworld, "0", FCVAR_ARCHIVE, "render world when UI is visible" );
 static CVAR_DEFINE_AUTO( cl_maxframetime, "0", 0, "set deadline timer for client rendering to catch freezes" );
@@ -236,6 +238,12 @@ void CL_SignonReply( connprotocol_t proto )
 			Mem_PrintStats();
 		break;
 	case 2:
+		if( cls.dl.signontime != 0.0 )
+		{
+			Con_Reportf( "%s: %.1f ms from resource list to spawn, %.1f ms of it precaching\n", __func__,
+				( Sys_DoubleTime() - cls.dl.signontime ) * 1000.0, cls.dl.precachetime * 1000.0 );
+			cls.dl.signontime = 0.0;
+		}
 		SCR_EndLoadingPlaque();
 		if( cl.proxy_redirect && !cls.spectator )
 			CL_Disconnect();
@@ -1461,6 +1469,8 @@ void CL_ClearState( void )
 	int	i;
 
 	CL_ClearResourceLists();
+	FS_PrefetchFlush();
+	cls.dl.precaching = false;
 
 	for( i = 0; i < MAX_CLIENTS; i++ )
 		COM_ClearCustomizationList( &cl.players[i].customdata, false );
@@ -1685,6 +1695,7 @@ static void CL_LocalServers_f( void )
 
 	Con_Printf( "Scanning for servers on the local network area...\n" );
 	NET_Config( true, true ); // allow remote
+	CL_BrowserReset();
 
 	// send a broadcast packet
 	adr.type = NA_BROADCAST;
@@ -1772,6 +1783,7 @@ static void CL_InternetServers_f( void )
 	Con_Printf( "Scanning for servers on the internet area...\n" );
 
 	NET_Config( true, true ); // allow remote
+	CL_BrowserReset();
 
 	CL_SendMasterServerScanRequest();
 }
@@ -1898,6 +1910,10 @@ static void CL_ParseStatusMessage( netadr_t from, sizebuf_t *msg )
 		return;
 	}
 
+	// master servers may list same server twice, don't flood the menu
+	if( !CL_BrowserReply( from ))
+		return;
+
 	if( !Info_IsValid( s ))
 	{
 		Con_Printf( "^1Server^7: %s, invalid infostring\n", NET_AdrToString( from ));
@@ -1923,7 +1939,7 @@ static void CL_ParseStatusMessage( netadr_t from, sizebuf_t *msg )
 		Con_Printf( "^2Server^7: %s, Game: %s\n", NET_AdrToString( from ), Info_ValueForKey( infostring, "gamedir" ));
 	}
 
-	UI_AddServerToList( from, infostring );
+	CL_BrowserAddServer( from, infostring );
 }
 
 /*
@@ -2381,8 +2397,8 @@ static void CL_ConnectionlessPacket( netadr_t from, sizebuf_t *msg )
 			if( !servadr.port )
 				break;
 
-			NET_Config( true, false ); // allow remote
-			Netchan_OutOfBandPrint( NS_CLIENT, servadr, "info %i", PROTOCOL_VERSION );
+			// probes are paced by CL_BrowserFrame
+			CL_BrowserQueue( servadr );
 		}
 
 		if( cls.internetservers_pending )
@@ -2440,6 +2456,7 @@ static void CL_ParseNetMessage( sizebuf_t *msg, void (*parsefn)( sizebuf_t * ))
 		if( cls.demorecording && !cls.demowaiting )
 			CL_WriteDemoMessage( false, cls.starting_count, msg );
 	}
+	else CL_DemoIndexMessage();
 }
 
 
@@ -2553,6 +2570,31 @@ static void CL_ReadNetMessage( void )
 	CL_ProcessNetRequests();
 }
 
+/*
+=================
+CL_PrecacheAndRegister
+
+precaches what's on hand and requests spawn
+when it's done, may take several frames
+=================
+*/
+static void CL_PrecacheAndRegister( void )
+{
+	byte	msg_buf[MAX_INIT_MSG];
+	sizebuf_t	msg;
+
+	MSG_Init( &msg, "Resource Registration", msg_buf, sizeof( msg_buf ));
+
+	if( CL_PrecacheResources( ))
+		CL_RegisterResources( &msg, cls.legacymode );
+
+	if( MSG_GetNumBytesWritten( &msg ) > 0 )
+	{
+		Netchan_CreateFragments( &cls.netchan, &msg );
+		Netchan_FragSend( &cls.netchan );
+	}
+}
+
 /*
 =================
 CL_ReadPackets
@@ -2575,6 +2617,10 @@ static void CL_ReadPackets( void )
 
 	CL_ReadNetMessage();
 
+	// continue sliced signon precache
+	if( cls.dl.precaching && cls.state != ca_disconnected && cls.state != ca_active )
+		CL_PrecacheAndRegister();
+
 	CL_ApplyAddAngle();
 #if 0
 	// keep cheat cvars are unchanged
@@ -2780,21 +2826,7 @@ void CL_ProcessFile( qboolean successfully_received, const char *filename )
 			host.downloadcount++;
 
 		if( cl.resourcesneeded.pNext == &cl.resourcesneeded )
-		{
-			byte	msg_buf[MAX_INIT_MSG];
-			sizebuf_t msg;
-
-			MSG_Init( &msg, "Resource Registration", msg_buf, sizeof( msg_buf ));
-
-			if( CL_PrecacheResources( ))
-				CL_RegisterResources( &msg, cls.legacymode );
-
-			if( MSG_GetNumBytesWritten( &msg ) > 0 )
-			{
-				Netchan_CreateFragments( &cls.netchan, &msg );
-				Netchan_FragSend( &cls.netchan );
-			}
-		}
+			CL_PrecacheAndRegister();
 
 		if( cls.netchan.tempbuffer )
 		{
@@ -2939,9 +2971,27 @@ static qboolean CL_ShouldRescanFilesystem( void )
 	return retval;
 }
 
+/*
+==================
+CL_PrecacheResources
+
+during signon remaining resources are registered in
+cl_precache_slice chunks, returns false until everything
+is done or if precache has failed
+==================
+*/
 qboolean CL_PrecacheResources( void )
 {
 	resource_t	*pRes;
+	double		start = Sys_DoubleTime(), deadline = 0.0;
+
+	// nothing else may touch the models until signon is done, so it's
+	// only safe to spread loading over frames before client is active
+	if( cl_precache_slice.value > 0.0f && cls.state != ca_active && !cls.demoplayback && !cls.timedemo )
+		deadline = start + cl_precache_slice.value * 0.001;
+
+	if( cls.dl.precaching )
+		goto resume;
 
 	// if we downloaded new WAD files or any other archives they must be added to searchpath
 	if( CL_ShouldRescanFilesystem( ))
@@ -2990,12 +3040,22 @@ qboolean CL_PrecacheResources( void )
 	if( cls.state != ca_active )
 		S_BeginRegistration();
 
+	cls.dl.precaching = true;
+
+resume:
 	// precache all the remaining resources where order is doesn't matter
 	for( pRes = cl.resourcesonhand.pNext; pRes && pRes != &cl.resourcesonhand; pRes = pRes->pNext )
 	{
 		if( FBitSet( pRes->ucFlags, RES_PRECACHED ))
 			continue;
 
+		// let the frame go, continue from here next time
+		if( deadline != 0.0 && Sys_DoubleTime() > deadline )
+		{
+			cls.dl.precachetime += Sys_DoubleTime() - start;
+			return false;
+		}
+
 		switch( pRes->type )
 		{
 		case t_sound:
@@ -3016,7 +3076,7 @@ qboolean CL_PrecacheResources( void )
 					{
 						if( FBitSet( pRes->ucFlags, RES_FATALIFMISSING ))
 						{
-							S_EndRegistration();
+							S_EndRegistration( 0.0 );
 							CL_Disconnect_f();
 							return false;
 						}
@@ -3043,7 +3103,7 @@ qboolean CL_PrecacheResources( void )
 					{
 						if( FBitSet( pRes->ucFlags, RES_FATALIFMISSING ))
 						{
-							S_EndRegistration();
+							S_EndRegistration( 0.0 );
 							CL_Disconnect_f();
 							return false;
 						}
@@ -3078,8 +3138,18 @@ qboolean CL_PrecacheResources( void )
 	cl.nummodels = bound( 0, cl.nummodels, MAX_MODELS );
 	cl.numfiles = bound( 0, cl.numfiles, MAX_CUSTOM );
 
-	if( cls.state != ca_active )
-		S_EndRegistration();
+	// sounds are loaded in slices too
+	if( cls.state != ca_active && !S_EndRegistration( deadline ))
+	{
+		cls.dl.precachetime += Sys_DoubleTime() - start;
+		return false;
+	}
+
+	cls.dl.precaching = false;
+	cls.dl.precachetime += Sys_DoubleTime() - start;
+
+	// whatever wasn't loaded through prefetch won't be anymore
+	FS_PrefetchFlush();
 
 	return true;
 }
@@ -3143,6 +3213,7 @@ static void CL_InitLocal( void )
 	Cvar_RegisterVariable( &cl_allow_upload );
 	Cvar_RegisterVariable( &cl_allow_download );
 	Cvar_RegisterVariable( &cl_download_ingame );
+	Cvar_RegisterVariable( &cl_precache_slice );
 	Cvar_RegisterVariable( &cl_logofile );
 	Cvar_RegisterVariable( &cl_logocolor );
 	Cvar_RegisterVariable( &cl_logoext );
@@ -3155,6 +3226,7 @@ static void CL_InitLocal( void )
 	// register our variables
 	Cvar_RegisterVariable( &cl_crosshair );
 	Cvar_RegisterVariable( &cl_nodelta );
+	Cvar_RegisterVariable( &demo_keyframes );
 	Cvar_RegisterVariable( &cl_idealpitchscale );
 	Cvar_RegisterVariable( &cl_solid_players );
 	Cvar_RegisterVariable( &cl_interp );
@@ -3232,6 +3304,7 @@ static void CL_InitLocal( void )
 	Cmd_AddCommand ("pause", NULL, "pause the game (if the server allows pausing)" );
 	Cmd_AddCommand ("localservers", CL_LocalServers_f, "collect info about local servers" );
 	Cmd_AddCommand ("internetservers", CL_InternetServers_f, "collect info about internet servers" );
+	CL_BrowserInit();
 	Cmd_AddCommand ("cd", CL_PlayCDTrack_f, "Play cd-track (not real cd-player of course)" );
 	Cmd_AddCommand ("mp3", CL_PlayCDTrack_f, "Play mp3-track (based on virtual cd-player)" );
 	Cmd_AddCommand ("waveplaylen", CL_WavePlayLen_f, "Get approximate length of wave file");
@@ -3249,6 +3322,7 @@ static void CL_InitLocal( void )
 	Cmd_AddCommand ("movie", CL_PlayVideo_f, "play a movie" );
 	Cmd_AddCommand ("stop", CL_Stop_f, "stop playing or recording a demo" );
 	Cmd_AddCommand( "listdemo", CL_ListDemo_f, "list demo entries" );
+	Cmd_AddCommand( "demo_seek", CL_DemoSeek_f, "jump to specified time of current level in playing demo" );
 	Cmd_AddCommand ("info", NULL, "collect info about local servers with specified protocol" );
 	Cmd_AddCommand ("escape", CL_Escape_f, "escape from game to menu" );
 	Cmd_AddCommand ("togglemenu", CL_Escape_f, "toggle between game and menu" );
@@ -3375,6 +3449,9 @@ void Host_ClientFrame( void )
 	// in case we lost connection
 	CL_CheckForResend ();
 
+	// send paced server browser probes
+	CL_BrowserFrame ();
+
 	// procssing resources on handle
 	while( CL_RequestMissingResources( ));
 
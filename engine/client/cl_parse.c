@@ -1179,6 +1179,7 @@ void CL_ParseClientData( sizebuf_t *msg, connprotocol_t proto )
 	{
 		int	delta_sequence = MSG_ReadByte( msg );
 
+		CL_DemoMarkDelta( delta_sequence );
 		from_cd = &cl.frames[delta_sequence & CL_UPDATE_MASK].clientdata;
 		from_wd = cl.frames[delta_sequence & CL_UPDATE_MASK].weapondata;
 	}
@@ -1892,6 +1893,9 @@ void CL_ParseResourceList( sizebuf_t *msg, connprotocol_t proto )
 
 	total = MSG_ReadUBitLong( msg, proto == PROTO_GOLDSRC ? MAX_GOLDSRC_RESOURCE_BITS : MAX_RESOURCE_BITS );
 
+	cls.dl.signontime = Sys_DoubleTime();
+	cls.dl.precachetime = 0.0;
+
 	for( i = 0; i < total; i++ )
 	{
 		pResource = Mem_Calloc( cls.mempool, sizeof( resource_t ));
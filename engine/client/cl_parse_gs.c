@@ -287,6 +287,7 @@ static int CL_ParsePacketEntitiesGS( sizebuf_t *msg, qboolean delta )
 	{
 		uint oldpacket = MSG_ReadByte( msg );
 		oldframe = &cl.frames[oldpacket & CL_UPDATE_MASK];
+		CL_DemoMarkDelta( oldpacket );
 
 		if( !CL_ValidateDeltaPacket( oldpacket, oldframe ))
 		{
@@ -167,6 +167,9 @@ typedef struct
 	int		nRemainingToTransfer;
 	float		fLastStatusUpdate;
 	qboolean		custom;
+	qboolean		precaching;	// signon precache is spread over frames
+	double		signontime;	// when resource list has arrived
+	double		precachetime;	// spent in CL_PrecacheResources since then
 } incomingtransfer_t;
 
 // the client_t structure is wiped completely
@@ -658,6 +661,7 @@ extern convar_t	mp_decals;
 extern convar_t	cl_logomaxdim;
 extern convar_t	cl_allow_download;
 extern convar_t	cl_download_ingame;
+extern convar_t	demo_keyframes;
 extern convar_t	cl_nopred;
 extern convar_t	cl_timeout;
 extern convar_t	cl_interp;
@@ -721,6 +725,16 @@ void CL_SetSky_f( void );
 void SCR_Viewpos_f( void );
 void CL_WavePlayLen_f( void );
 
+//
+// cl_browser.c
+//
+void CL_BrowserInit( void );
+void CL_BrowserReset( void );
+void CL_BrowserQueue( netadr_t adr );
+void CL_BrowserFrame( void );
+qboolean CL_BrowserReply( netadr_t from );
+void CL_BrowserAddServer( netadr_t adr, const char *info );
+
 //
 // cl_custom.c
 //
@@ -779,6 +793,9 @@ void CL_DeleteDemo_f( void );
 void CL_Record_f( void );
 void CL_Stop_f( void );
 void CL_ListDemo_f( void );
+void CL_DemoSeek_f( void );
+void CL_DemoMarkDelta( int oldpacket );
+void CL_DemoIndexMessage( void );
 int CL_GetDemoComment( const char *demoname, char *comment );
 
 //
@@ -800,6 +817,7 @@ void CL_FireEvents( void );
 qboolean CL_FixedFont( cl_font_t *font );
 qboolean Con_LoadFixedWidthFont( const char *fontname, cl_font_t *font, float scale, convar_t *rendermode, uint texFlags );
 qboolean Con_LoadVariableWidthFont( const char *fontname, cl_font_t *font, float scale, convar_t *rendermode, uint texFlags );
+void CL_ClearGlyphCache( void );
 void CL_FreeFont( cl_font_t *font );
 void CL_SetFontRendermode( cl_font_t *font );
 int CL_DrawCharacter( float x, float y, int number, rgba_t color, cl_font_t *font, int flags );
@@ -1087,7 +1105,7 @@ void S_StartStreaming( void );
 void S_StopStreaming( void );
 void S_BeginRegistration( void );
 sound_t S_RegisterSound( const char *sample );
-void S_EndRegistration( void );
+qboolean S_EndRegistration( double deadline );
 void S_RestoreSound( const vec3_t pos, int ent, int chan, sound_t handle, float fvol, float attn, int pitch, int flags, double sample, double end, int wordIndex );
 void S_StartSound( const vec3_t pos, int ent, int chan, sound_t sfx, float vol, float attn, int pitch, int flags );
 void S_AmbientSound( const vec3_t pos, int ent, sound_t handle, float fvol, float attn, int pitch, int flags );
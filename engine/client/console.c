@@ -296,6 +296,102 @@ static void Con_SetTimes_f( void )
 	con.num_times = bound( CON_TIMES, newtimes, CON_MAX_TIMES );
 }
 
+/*
+================
+Con_TextBench_f
+
+draws full screen of console text with per glyph calls,
+then with glyph runs being laid out each frame and cached
+================
+*/
+static void Con_TextBench_f( void )
+{
+	const char *modes[] = { "per glyph", "glyph run", "cached run" };
+	char text[8][MAX_VA_STRING];
+	int glyphs[8];
+	int i, j, mode, frames, numlines, numglyphs = 0;
+
+	if( !con.curFont || !con.curFont->valid )
+	{
+		Con_Printf( "No console font loaded\n" );
+		return;
+	}
+
+	frames = Cmd_Argc() > 1 ? Q_max( Q_atoi( Cmd_Argv( 1 )), 1 ) : 100;
+	numlines = refState.height / con.curFont->charHeight;
+
+	// few different colored lines, wide enough to fill the screen
+	for( i = 0; i < ARRAYSIZE( text ); i++ )
+	{
+		int len = 0, width = 0;
+
+		glyphs[i] = 0;
+
+		while( len < sizeof( text[i] ) - 4 && width < refState.width )
+		{
+			if( glyphs[i] % 24 == 0 )
+			{
+				text[i][len++] = '^';
+				text[i][len++] = '1' + ( glyphs[i] / 24 + i ) % 7;
+			}
+
+			text[i][len] = 'a' + ( glyphs[i] * 7 + i ) % 26;
+			width += con.curFont->charWidths[(byte)text[i][len]];
+			glyphs[i]++;
+			len++;
+		}
+
+		text[i][len] = '\0';
+	}
+
+	for( j = 0; j < numlines; j++ )
+		numglyphs += glyphs[j % ARRAYSIZE( text )];
+
+	for( mode = 0; mode < ARRAYSIZE( modes ); mode++ )
+	{
+		double start = Sys_DoubleTime(), end;
+
+		for( i = 0; i < frames; i++ )
+		{
+			ref.dllFuncs.R_BeginFrame( false );
+			ref.dllFuncs.R_Set2DMode( true );
+
+			if( mode == 1 )
+				CL_ClearGlyphCache();
+
+			for( j = 0; j < numlines; j++ )
+			{
+				const char *s = text[j % ARRAYSIZE( text )];
+				int y = j * con.curFont->charHeight;
+
+				if( mode == 0 )
+				{
+					rgba_t color;
+					int x = 0;
+
+					Vector4Copy( g_color_table[7], color );
+					CL_SetFontRendermode( con.curFont );
+
+					for( ; *s; s++ )
+					{
+						if( IsColorString( s ))
+							VectorCopy( g_color_table[ColorIndex( *++s )], color );
+						else x += CL_DrawCharacter( x, y, (byte)*s, color, con.curFont, FONT_DRAW_NORENDERMODE );
+					}
+				}
+				else CL_DrawString( 0, y, s, g_color_table[7], con.curFont, 0 );
+			}
+
+			ref.dllFuncs.R_EndFrame();
+		}
+
+		end = Sys_DoubleTime();
+		Con_Printf( "%s: %d frames, %.3f ms per frame\n", modes[mode], frames, ( end - start ) * 1000.0 / frames );
+	}
+
+	Con_Printf( "%d lines, %d glyphs per frame\n", numlines, numglyphs );
+}
+
 /*
 ================
 Con_FixTimes
@@ -807,6 +903,7 @@ void Con_Init( void )
 	Cmd_AddCommand( "messagemode", Con_MessageMode_f, "enable message mode \"say\"" );
 	Cmd_AddCommand( "messagemode2", Con_MessageMode2_f, "enable message mode \"say_team\"" );
 	Cmd_AddCommand( "contimes", Con_SetTimes_f, "change number of console overlay lines (4-64)" );
+	Cmd_AddCommand( "con_textbench", Con_TextBench_f, "measure console text drawing speed, optionally takes number of frames" );
 	con.initialized = true;
 
 	Con_Printf( "Console initialized.\n" );
@@ -29,6 +29,7 @@ static sfx_t	s_knownSfx[MAX_SFX];
 static sfx_t	*s_sfxHashList[MAX_SFX_HASH];
 static string	s_sentenceImmediateName;	// keep dummy sentence name
 qboolean		s_registering = false;
+static int	s_registerload = -1;	// next sound to load, -1 if unused ones aren't freed yet
 
 /*
 =================
@@ -289,40 +290,57 @@ void S_BeginRegistration( void )
 	}
 
 	s_registering = true;
+	s_registerload = -1;
 }
 
 /*
 =====================
 S_EndRegistration
 
+frees sounds not used by this registration sequence and
+loads the rest. With non-zero deadline returns false when
+time is out, next call continues where this one stopped
 =====================
 */
-void S_EndRegistration( void )
+qboolean S_EndRegistration( double deadline )
 {
 	sfx_t	*sfx;
 	int	i;
 
 	if( !s_registering || !dma.initialized )
-		return;
+		return true;
 
-	// free any sounds not from this registration sequence
-	for( i = 0, sfx = s_knownSfx; i < s_numSfx; i++, sfx++ )
+	if( s_registerload < 0 )
 	{
-		if( !sfx->name[0] || !Q_stricmp( sfx->name, "*default" ))
-			continue; // don't release default sound
+		// free any sounds not from this registration sequence
+		for( i = 0, sfx = s_knownSfx; i < s_numSfx; i++, sfx++ )
+		{
+			if( !sfx->name[0] || !Q_stricmp( sfx->name, "*default" ))
+				continue; // don't release default sound
+
+			if( sfx->servercount != cl.servercount )
+				S_FreeSound( sfx ); // don't need this sound
+		}
 
-		if( sfx->servercount != cl.servercount )
-			S_FreeSound( sfx ); // don't need this sound
+		s_registerload = 0;
 	}
 
 	// load everything in
-	for( i = 0, sfx = s_knownSfx; i < s_numSfx; i++, sfx++ )
+	for( ; s_registerload < s_numSfx; s_registerload++ )
 	{
+		sfx = &s_knownSfx[s_registerload];
+
 		if( !sfx->name[0] )
 			continue;
+
+		if( deadline != 0.0 && Sys_DoubleTime() > deadline )
+			return false;
+
 		S_LoadSound( sfx );
 	}
+
 	s_registering = false;
+	return true;
 }
 
 /*
@@ -35,6 +35,13 @@ int		total_channels;
 int		soundtime;	// sample PAIRS
 int   		paintedtime; 	// sample PAIRS
 
+// time spent in mixer, for s_info
+static struct
+{
+	double	time;
+	int	painted;
+} s_mixstats;
+
 static CVAR_DEFINE( s_volume, "volume", "0.7", FCVAR_ARCHIVE|FCVAR_FILTERABLE, "sound volume" );
 CVAR_DEFINE( s_musicvolume, "MP3Volume", "1.0", FCVAR_ARCHIVE|FCVAR_FILTERABLE, "background music volume" );
 static CVAR_DEFINE( s_mixahead, "_snd_mixahead", "0.12", FCVAR_FILTERABLE, "how much sound to mix ahead of time" );
@@ -114,6 +121,10 @@ S_FreeChannel
 */
 void S_FreeChannel( channel_t *ch )
 {
+	// words left in stopped sentence were prefetched, release them
+	if( ch->isSentence )
+		VOX_FreeWords( ch, ch->wordIndex, CVOXWORDMAX );
+
 	ch->sfx = NULL;
 	ch->name[0] = '\0';
 	ch->use_loop = false;
@@ -723,6 +734,7 @@ void S_RestoreSound( const vec3_t pos, int ent, int chan, sound_t handle, float
 		if( wordIndex != 0 )
 		{
 			VOX_FreeWord( target_chan );		// release first loaded word
+			VOX_FreeWords( target_chan, 1, wordIndex );	// and skipped prefetched ones
 			target_chan->wordIndex = wordIndex;	// restore current word
 			VOX_LoadWord( target_chan );
 
@@ -1411,6 +1423,32 @@ static void S_FreeRawChannels( void )
 
 //=============================================================================
 
+/*
+==================
+S_BeginPainting
+
+virtual device replaces hardware backend when enabled
+==================
+*/
+static void S_BeginPainting( void )
+{
+	if( SNDVIRT_Active( ))
+		SNDVIRT_BeginPainting();
+	else SNDDMA_BeginPainting();
+}
+
+/*
+==================
+S_Submit
+==================
+*/
+static void S_Submit( void )
+{
+	if( SNDVIRT_Active( ))
+		SNDVIRT_Submit();
+	else SNDDMA_Submit();
+}
+
 /*
 ==================
 S_ClearBuffer
@@ -1420,9 +1458,9 @@ static void S_ClearBuffer( void )
 {
 	S_ClearRawChannels();
 
-	SNDDMA_BeginPainting ();
+	S_BeginPainting ();
 	if( dma.buffer ) memset( dma.buffer, 0, dma.samples * 2 );
-	SNDDMA_Submit ();
+	S_Submit ();
 
 	MIX_ClearAllPaintBuffers( PAINTBUFFER_SIZE, true );
 }
@@ -1518,9 +1556,10 @@ static int S_GetSoundtime( void )
 static void S_UpdateChannels( void )
 {
 	uint	endtime;
-	int	samps;
+	int	samps, oldpainted;
+	double	start;
 
-	SNDDMA_BeginPainting();
+	S_BeginPainting();
 
 	if( !dma.buffer ) return;
 
@@ -1543,9 +1582,15 @@ static void S_UpdateChannels( void )
 		endtime -= ( endtime - paintedtime ) & 0x3;
 	}
 
+	start = Sys_DoubleTime();
+	oldpainted = paintedtime;
+
 	MIX_PaintChannels( endtime );
 
-	SNDDMA_Submit();
+	s_mixstats.time += Sys_DoubleTime() - start;
+	s_mixstats.painted += paintedtime - oldpainted;
+
+	S_Submit();
 }
 
 /*
@@ -1884,6 +1929,12 @@ void S_SoundInfo_f( void )
 	Con_Printf( "%5d bytes/sec\n", SOUND_DMA_SPEED );
 	Con_Printf( "%5d total_channels\n", total_channels );
 
+	if( s_mixstats.painted > 0 )
+	{
+		Con_Printf( "%.3f ms mixing per second of audio, %.1f seconds mixed\n",
+			s_mixstats.time * 1000.0 * SOUND_DMA_SPEED / s_mixstats.painted, (double)s_mixstats.painted / SOUND_DMA_SPEED );
+	}
+
 	S_PrintBackgroundTrackState ();
 }
 
@@ -1954,7 +2005,7 @@ qboolean S_Init( void )
 	Cmd_AddCommand( "speak", S_Say_f, "playing a specified sententce" );
 
 	dma.backendName = "None";
-	if( !SNDDMA_Init( ) )
+	if( Sys_CheckParm( "-virtualsound" ) ? !SNDVIRT_Init( ) : !SNDDMA_Init( ))
 	{
 		Con_Printf( "Audio: sound system can't be initialized\n" );
 		return false;
@@ -1963,6 +2014,7 @@ qboolean S_Init( void )
 	sndpool = Mem_AllocPool( "Sound Zone" );
 	soundtime = 0;
 	paintedtime = 0;
+	memset( &s_mixstats, 0, sizeof( s_mixstats ));
 
 	// clear ambient sounds
 	memset( ambient_sfx, 0, sizeof( ambient_sfx ));
@@ -2002,7 +2054,9 @@ void S_Shutdown( void )
 	VOX_Shutdown ();
 	SX_Free ();
 
-	SNDDMA_Shutdown ();
+	if( SNDVIRT_Active( ))
+		SNDVIRT_Shutdown ();
+	else SNDDMA_Shutdown ();
 	MIX_FreeAllPaintbuffers ();
 	Mem_FreePool( &sndpool );
 }
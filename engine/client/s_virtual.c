@@ -0,0 +1,691 @@
+/*
+s_virtual.c - clocked virtual audio device
+Copyright (C) 2026 FWGS
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+*/
+
+#include "common.h"
+#include "client.h"
+#include "sound.h"
+
+/*
+===============================================================================
+
+VIRTUAL DMA
+
+replaces hardware backend for machines without audio: the mixer
+paints into a memory ring and the play position is driven either
+by the wall clock or, in fast mode, by the mixer itself, so the
+whole pipeline runs as fast as host frames go
+
+-virtualsound [-sndfast] [-sndbuffer frames] [-sndwav file.wav]
+              [-sndrate 44100|22050|11025] [-sndchannels 1|2]
+
+mixer works at SOUND_DMA_SPEED in 16-bit stereo, rate and
+channels only change the format of consumed output
+===============================================================================
+*/
+
+#define VSND_DEFAULT_FRAMES	0x8000
+#define VSND_MIN_FRAMES	0x2000
+#define VSND_MAX_FRAMES	0x80000
+#define VSND_WAV_HEADER	44
+#define VSND_OUT_BATCH	2048
+
+typedef struct
+{
+	qboolean	active;
+	qboolean	fast;		// play position follows the mixer
+	double	starttime;
+	int	captured;		// paintedtime already consumed from the ring
+
+	// consumed output format
+	int	rate;
+	int	channels;
+	int	decimate;
+	int	pcount;
+	int	pacc[2];
+
+	FILE	*wav;
+	uint	wavbytes;
+
+	qboolean	hashing;
+	uint32_t	crc;
+} vsnd_t;
+
+static vsnd_t vsnd;
+
+static void S_MixTest_f( void );
+
+static void SNDVIRT_PutShort( byte *p, int val )
+{
+	p[0] = val & 0xFF;
+	p[1] = ( val >> 8 ) & 0xFF;
+}
+
+static void SNDVIRT_PutLong( byte *p, uint val )
+{
+	p[0] = val & 0xFF;
+	p[1] = ( val >> 8 ) & 0xFF;
+	p[2] = ( val >> 16 ) & 0xFF;
+	p[3] = ( val >> 24 ) & 0xFF;
+}
+
+/*
+==============
+SNDVIRT_WriteWAVHeader
+
+canonical 44 byte PCM header, sizes are
+patched again when file is closed
+==============
+*/
+static void SNDVIRT_WriteWAVHeader( void )
+{
+	byte	hdr[VSND_WAV_HEADER];
+	int	align = vsnd.channels * 2;
+
+	memcpy( hdr + 0, "RIFF", 4 );
+	SNDVIRT_PutLong( hdr + 4, 36 + vsnd.wavbytes );
+	memcpy( hdr + 8, "WAVE", 4 );
+	memcpy( hdr + 12, "fmt ", 4 );
+	SNDVIRT_PutLong( hdr + 16, 16 );
+	SNDVIRT_PutShort( hdr + 20, 1 ); // PCM
+	SNDVIRT_PutShort( hdr + 22, vsnd.channels );
+	SNDVIRT_PutLong( hdr + 24, vsnd.rate );
+	SNDVIRT_PutLong( hdr + 28, vsnd.rate * align );
+	SNDVIRT_PutShort( hdr + 32, align );
+	SNDVIRT_PutShort( hdr + 34, 16 );
+	memcpy( hdr + 36, "data", 4 );
+	SNDVIRT_PutLong( hdr + 40, vsnd.wavbytes );
+
+	fseek( vsnd.wav, 0, SEEK_SET );
+	fwrite( hdr, 1, sizeof( hdr ), vsnd.wav );
+	fseek( vsnd.wav, 0, SEEK_END );
+}
+
+/*
+==============
+SNDVIRT_Consume
+
+takes count painted stereo frames out of the ring:
+hashes them and appends to WAV in requested format
+==============
+*/
+static void SNDVIRT_Consume( const short *data, int count )
+{
+	byte	out[VSND_OUT_BATCH * 4];
+	int	i, j, len = 0;
+
+	if( vsnd.hashing )
+	{
+		// hash little endian bytes, so checksums are portable
+		for( i = 0; i < count; i += VSND_OUT_BATCH )
+		{
+			int num = Q_min( count - i, VSND_OUT_BATCH );
+
+			for( j = 0; j < num * 2; j++ )
+				SNDVIRT_PutShort( out + j * 2, data[i * 2 + j] );
+
+			CRC32_ProcessBuffer( &vsnd.crc, out, num * 4 );
+		}
+	}
+
+	if( !vsnd.wav )
+		return;
+
+	for( i = 0; i < count; i++ )
+	{
+		vsnd.pacc[0] += data[i * 2 + 0];
+		vsnd.pacc[1] += data[i * 2 + 1];
+
+		if( ++vsnd.pcount < vsnd.decimate )
+			continue;
+
+		// box filter is enough for integer decimation of already band limited mix
+		vsnd.pacc[0] /= vsnd.decimate;
+		vsnd.pacc[1] /= vsnd.decimate;
+
+		if( vsnd.channels == 1 )
+		{
+			SNDVIRT_PutShort( out + len, ( vsnd.pacc[0] + vsnd.pacc[1] ) / 2 );
+			len += 2;
+		}
+		else
+		{
+			SNDVIRT_PutShort( out + len + 0, vsnd.pacc[0] );
+			SNDVIRT_PutShort( out + len + 2, vsnd.pacc[1] );
+			len += 4;
+		}
+
+		vsnd.pacc[0] = vsnd.pacc[1] = vsnd.pcount = 0;
+
+		if( len == sizeof( out ))
+		{
+			vsnd.wavbytes += fwrite( out, 1, len, vsnd.wav );
+			len = 0;
+		}
+	}
+
+	if( len )
+		vsnd.wavbytes += fwrite( out, 1, len, vsnd.wav );
+}
+
+/*
+==============
+SNDVIRT_Capture
+
+consume everything mixer has painted since last call
+==============
+*/
+static void SNDVIRT_Capture( void )
+{
+	const short	*ring = (const short *)dma.buffer;
+	int		frames = dma.samples >> 1;
+
+	// painted clock was reset or mixer outran the ring
+	if( paintedtime < vsnd.captured || paintedtime - vsnd.captured > frames )
+		vsnd.captured = paintedtime;
+
+	while( vsnd.captured < paintedtime )
+	{
+		int	pos = vsnd.captured & ( frames - 1 );
+		int	count = Q_min( paintedtime - vsnd.captured, frames - pos );
+
+		SNDVIRT_Consume( ring + pos * 2, count );
+		vsnd.captured += count;
+	}
+}
+
+/*
+==============
+SNDVIRT_Active
+==============
+*/
+qboolean SNDVIRT_Active( void )
+{
+	return vsnd.active;
+}
+
+/*
+==============
+SNDVIRT_Init
+==============
+*/
+qboolean SNDVIRT_Init( void )
+{
+	string	value;
+	int	frames = VSND_DEFAULT_FRAMES;
+
+	memset( &vsnd, 0, sizeof( vsnd ));
+
+	if( Sys_GetParmFromCmdLine( "-sndbuffer", value ))
+	{
+		int	req = bound( VSND_MIN_FRAMES, Q_atoi( value ), VSND_MAX_FRAMES );
+
+		// mixer masks ring position, so it must be power of two
+		for( frames = VSND_MIN_FRAMES; frames < req; frames <<= 1 );
+	}
+
+	vsnd.rate = SOUND_DMA_SPEED;
+	if( Sys_GetParmFromCmdLine( "-sndrate", value ))
+	{
+		vsnd.rate = Q_atoi( value );
+
+		if( vsnd.rate <= 0 || vsnd.rate > SOUND_DMA_SPEED || SOUND_DMA_SPEED % vsnd.rate )
+		{
+			Con_Printf( S_WARN "%s: rate %s doesn't divide %d, using %d\n", __func__, value, SOUND_DMA_SPEED, SOUND_DMA_SPEED );
+			vsnd.rate = SOUND_DMA_SPEED;
+		}
+	}
+	vsnd.decimate = SOUND_DMA_SPEED / vsnd.rate;
+
+	vsnd.channels = 2;
+	if( Sys_GetParmFromCmdLine( "-sndchannels", value ))
+		vsnd.channels = bound( 1, Q_atoi( value ), 2 );
+
+	if( Sys_GetParmFromCmdLine( "-sndwav", value ))
+	{
+		if(( vsnd.wav = fopen( value, "wb" )) != NULL )
+			SNDVIRT_WriteWAVHeader();
+		else Con_Printf( S_ERROR "%s: couldn't write %s\n", __func__, value );
+	}
+
+	vsnd.fast = Sys_CheckParm( "-sndfast" );
+	vsnd.starttime = Sys_DoubleTime();
+	vsnd.active = true;
+
+	dma.format.speed = SOUND_DMA_SPEED;
+	dma.format.width = 2;
+	dma.format.channels = 2;
+	dma.samples = frames * 2;
+	dma.samplepos = 0;
+	dma.buffer = Z_Calloc( dma.samples * 2 );
+	dma.backendName = "Virtual";
+	dma.initialized = true;
+
+	Cmd_AddCommand( "s_mixtest", S_MixTest_f, "mix scripted sound scene and compare checksum against golden file" );
+
+	Con_Printf( "Audio: virtual device, %d frames ring, %s clock, output %d Hz %d channel(s)\n",
+		frames, vsnd.fast ? "fast" : "realtime", vsnd.rate, vsnd.channels );
+
+	return true;
+}
+
+/*
+==============
+SNDVIRT_BeginPainting
+
+advances play position
+==============
+*/
+void SNDVIRT_BeginPainting( void )
+{
+	int	frames = dma.samples >> 1;
+
+	if( vsnd.fast )
+	{
+		int	target = paintedtime;
+
+		// everything painted counts as played, but never step over
+		// half of the ring, so S_GetSoundtime still sees every wrap
+		if( target - soundtime > frames / 2 )
+			target = soundtime + frames / 2;
+
+		dma.samplepos = ( target << 1 ) & ( dma.samples - 1 );
+	}
+	else
+	{
+		int64_t	played = (int64_t)(( Sys_DoubleTime() - vsnd.starttime ) * SOUND_DMA_SPEED );
+
+		dma.samplepos = (int)(( played << 1 ) & ( dma.samples - 1 ));
+	}
+}
+
+/*
+==============
+SNDVIRT_Submit
+==============
+*/
+void SNDVIRT_Submit( void )
+{
+	SNDVIRT_Capture();
+}
+
+/*
+==============
+SNDVIRT_Shutdown
+==============
+*/
+void SNDVIRT_Shutdown( void )
+{
+	Con_Printf( "Shutting down virtual audio.\n" );
+
+	Cmd_RemoveCommand( "s_mixtest" );
+
+	if( vsnd.wav )
+	{
+		SNDVIRT_WriteWAVHeader();
+		fclose( vsnd.wav );
+	}
+
+	if( dma.buffer )
+		Z_Free( dma.buffer );
+
+	dma.buffer = NULL;
+	dma.initialized = false;
+	memset( &vsnd, 0, sizeof( vsnd ));
+}
+
+/*
+===============================================================================
+
+SCRIPTED MIX TEST
+
+sounds are synthesized with integer math only and scene is
+painted in fixed steps, so the checksum doesn't depend on
+host framerate or output format. Spatialization and DSP still
+use floats, golden file is only valid for x86-64 builds
+
+xash -virtualsound +s_mixtest 10 engine/client/tests/mixtest.crc +quit
+xash -virtualsound +s_mixtest 10 mixtest.crc record +quit
+
+===============================================================================
+*/
+
+#define MIXTEST_STEP	1024	// frames per paint, multiple of 4
+#define MIXTEST_CYCLE	1500	// script repeats every N msecs
+#define MIXTEST_ENT		1	// listener entity, plays without spatialization
+
+typedef enum
+{
+	MIXTEST_HUM = 0,	// 22k 16-bit looped triangle
+	MIXTEST_BEEP,	// 11k 8-bit square
+	MIXTEST_NOISE,	// 44k 16-bit decaying noise
+	MIXTEST_SAW,	// 22k 16-bit sawtooth
+	MIXTEST_SOUNDS
+} mixtest_sound_t;
+
+typedef struct
+{
+	int		msec;
+	mixtest_sound_t	sound;
+	int		ent;
+	int		chan;
+	vec3_t		origin;
+	float		vol;
+	float		attn;
+	int		pitch;
+} mixtest_event_t;
+
+static const mixtest_event_t mixtest_script[] =
+{
+{ 0,    MIXTEST_HUM,   0,            CHAN_STATIC, { 200, 0, 0 },     0.8f, ATTN_NORM,   100 },
+{ 100,  MIXTEST_BEEP,  MIXTEST_ENT, CHAN_WEAPON, { 0, 0, 0 },       1.0f, ATTN_NORM,   100 },
+{ 350,  MIXTEST_NOISE, 0,            CHAN_STATIC, { -300, 150, 0 },  1.0f, ATTN_IDLE,   90 },
+{ 600,  MIXTEST_SAW,   MIXTEST_ENT, CHAN_VOICE,  { 0, 0, 0 },       0.7f, ATTN_NORM,   130 },
+{ 900,  MIXTEST_BEEP,  MIXTEST_ENT, CHAN_WEAPON, { 0, 0, 0 },       1.0f, ATTN_NORM,   70 },
+{ 1200, MIXTEST_NOISE, 0,            CHAN_STATIC, { 50, -400, 0 },   0.6f, ATTN_STATIC, 100 },
+};
+
+static const char *mixtest_names[MIXTEST_SOUNDS] =
+{
+"mixtest/hum.wav",
+"mixtest/beep.wav",
+"mixtest/noise.wav",
+"mixtest/saw.wav",
+};
+
+static sound_t mixtest_handles[MIXTEST_SOUNDS];
+
+/*
+==============
+S_MixTestSynth
+==============
+*/
+static wavdata_t *S_MixTestSynth( mixtest_sound_t sound )
+{
+	wavdata_t	*sc = Mem_Calloc( sndpool, sizeof( wavdata_t ));
+	uint	i, seed = 0x1234567;
+
+	sc->channels = 1;
+
+	switch( sound )
+	{
+	case MIXTEST_HUM:
+		sc->rate = SOUND_22k;
+		sc->samples = SOUND_22k;
+		sc->flags = SOUND_LOOPED;
+		break;
+	case MIXTEST_BEEP:
+		sc->rate = SOUND_11k;
+		sc->samples = SOUND_11k * 3 / 10;
+		break;
+	case MIXTEST_NOISE:
+		sc->rate = SOUND_44k;
+		sc->samples = SOUND_44k / 2;
+		break;
+	default:
+		sc->rate = SOUND_22k;
+		sc->samples = SOUND_22k * 8 / 10;
+		break;
+	}
+
+	sc->width = ( sound == MIXTEST_BEEP ) ? 1 : 2;
+	sc->size = sc->samples * sc->width;
+	sc->buffer = Mem_Malloc( sndpool, sc->size );
+
+	for( i = 0; i < sc->samples; i++ )
+	{
+		int	val, phase;
+
+		switch( sound )
+		{
+		case MIXTEST_HUM:
+			// 105 Hz divides 22050, so loop is seamless
+			phase = i % 210;
+			val = ( phase < 105 ? phase : 210 - phase ) * 600 - 31500;
+			break;
+		case MIXTEST_BEEP:
+			val = ( i % 25 ) < 12 ? 100 : -100;
+			break;
+		case MIXTEST_NOISE:
+			seed = seed * 1103515245 + 12345;
+			val = (int)(( seed >> 16 ) & 0x7FFF ) - 0x4000;
+			val = val * (int)( sc->samples - i ) / (int)sc->samples * 2;
+			break;
+		default:
+			val = ( i % 90 ) * 700 - 31150;
+			break;
+		}
+
+		if( sc->width == 1 )
+			((signed char *)sc->buffer)[i] = val;
+		else ((short *)sc->buffer)[i] = val;
+	}
+
+	return sc;
+}
+
+
+/*
+==============
+S_MixTestRun
+
+paints the scene, returns checksum of painted output
+and accumulates time spent in mixer
+==============
+*/
+static uint32_t S_MixTestRun( int frames, double *mixtime )
+{
+	int	start, cycle = -1, next = 0;
+
+	S_StopAllSounds( false );
+
+	vsnd.captured = start = paintedtime;
+	vsnd.hashing = true;
+	CRC32_Init( &vsnd.crc );
+
+	while( paintedtime - start < frames )
+	{
+		int	msec = (int)((int64_t)( paintedtime - start ) * 1000 / SOUND_DMA_SPEED );
+		double	t0;
+
+		if( msec / MIXTEST_CYCLE != cycle )
+		{
+			// alternate dry and reverberated rooms each cycle
+			cycle = msec / MIXTEST_CYCLE;
+			Cvar_Set( "room_type", ( cycle & 1 ) ? "5" : "0" );
+			next = 0;
+		}
+
+		for( ; next < ARRAYSIZE( mixtest_script ); next++ )
+		{
+			const mixtest_event_t	*ev = &mixtest_script[next];
+
+			if( ev->msec > msec % MIXTEST_CYCLE )
+				break;
+
+			// looped sounds keep playing, start them once
+			if( cycle > 0 && FBitSet( S_GetSfxByHandle( mixtest_handles[ev->sound] )->cache->flags, SOUND_LOOPED ))
+				continue;
+
+			S_StartSound( ev->origin, ev->ent, ev->chan, mixtest_handles[ev->sound], ev->vol, ev->attn, ev->pitch, 0 );
+		}
+
+		t0 = Sys_DoubleTime();
+		MIX_PaintChannels( paintedtime + MIXTEST_STEP );
+		*mixtime += Sys_DoubleTime() - t0;
+
+		SNDVIRT_Capture();
+	}
+
+	vsnd.hashing = false;
+	S_StopAllSounds( false );
+
+	return CRC32_Final( vsnd.crc );
+}
+
+/*
+==============
+S_MixTestGolden
+
+returns false if checksum doesn't match the one stored
+in golden file, file is only written when recording
+==============
+*/
+static qboolean S_MixTestGolden( const char *path, uint32_t crc, int seconds, qboolean record )
+{
+	char	*text;
+	uint	golden;
+	int	goldensecs;
+	qboolean	parsed;
+	FILE	*f;
+
+	if( !record )
+	{
+		if(( text = (char *)FS_LoadDirectFile( path, NULL )) == NULL )
+		{
+			Con_Printf( S_ERROR "s_mixtest: golden file %s is missing\n", path );
+			return false;
+		}
+
+		parsed = sscanf( text, "%x %d", &golden, &goldensecs ) == 2;
+		Mem_Free( text );
+
+		if( !parsed )
+		{
+			Con_Printf( S_ERROR "s_mixtest: couldn't parse golden file %s\n", path );
+			return false;
+		}
+
+		if( goldensecs != seconds )
+		{
+			Con_Printf( S_ERROR "s_mixtest: golden file %s was recorded for %d seconds\n", path, goldensecs );
+			return false;
+		}
+
+		if( golden != crc )
+		{
+			Con_Printf( S_ERROR "s_mixtest: output %08x doesn't match golden %08x\n", crc, golden );
+			return false;
+		}
+
+		Con_Printf( "s_mixtest: output matches golden %s\n", path );
+		return true;
+	}
+
+	if(( f = fopen( path, "w" )) == NULL )
+	{
+		Con_Printf( S_ERROR "s_mixtest: couldn't write %s\n", path );
+		return false;
+	}
+
+	fprintf( f, "%08x %d\n", crc, seconds );
+	fclose( f );
+
+	Con_Printf( "s_mixtest: golden checksum written to %s\n", path );
+	return true;
+}
+
+/*
+==============
+S_MixTest_f
+
+s_mixtest [seconds] [golden file] [record]
+
+failure is reported through exit code, so it can
+be followed by +quit on command line
+==============
+*/
+static void S_MixTest_f( void )
+{
+	listener_t	oldlistener = s_listener;
+	keydest_t		oldkeydest = cls.key_dest;
+	string		oldvolume, oldroom, oldmute;
+	int		i, seconds, frames, oldpainted = paintedtime;
+	double		mixtime = 0.0, realtime;
+	uint32_t		crc[2];
+	qboolean		ok = true;
+	FILE		*wav;
+
+	if( Cmd_Argc() > 4 || ( Cmd_Argc() == 4 && Q_strcmp( Cmd_Argv( 3 ), "record" )))
+	{
+		Con_Printf( S_USAGE "s_mixtest [seconds] [golden file] [record]\n" );
+		return;
+	}
+
+	seconds = Cmd_Argc() > 1 ? bound( 1, Q_atoi( Cmd_Argv( 1 )), 600 ) : 10;
+	frames = seconds * SOUND_DMA_SPEED;
+
+	// output depends on these, pin them for the run
+	Q_strncpy( oldvolume, Cvar_VariableString( "volume" ), sizeof( oldvolume ));
+	Q_strncpy( oldroom, Cvar_VariableString( "room_type" ), sizeof( oldroom ));
+	Q_strncpy( oldmute, Cvar_VariableString( "snd_mute_losefocus" ), sizeof( oldmute ));
+	Cvar_Set( "volume", "1" );
+	Cvar_Set( "snd_mute_losefocus", "0" );
+
+	memset( &s_listener, 0, sizeof( s_listener ));
+	s_listener.forward[0] = 1.0f;
+	s_listener.right[1] = -1.0f;
+	s_listener.up[2] = 1.0f;
+	s_listener.entnum = MIXTEST_ENT;
+	s_listener.active = true;
+	cls.key_dest = key_game;
+
+	for( i = 0; i < MIXTEST_SOUNDS; i++ )
+	{
+		sfx_t	*sfx = S_FindName( mixtest_names[i], NULL );
+
+		if( sfx && !sfx->cache )
+			sfx->cache = S_MixTestSynth( i );
+
+		mixtest_handles[i] = S_RegisterSound( mixtest_names[i] );
+	}
+
+	realtime = Sys_DoubleTime();
+	crc[0] = S_MixTestRun( frames, &mixtime );
+	realtime = Sys_DoubleTime() - realtime;
+
+	// second pass catches state leaking between runs, keep it out of WAV
+	wav = vsnd.wav;
+	vsnd.wav = NULL;
+	crc[1] = S_MixTestRun( frames, &mixtime );
+	vsnd.wav = wav;
+
+	for( i = 0; i < MIXTEST_SOUNDS; i++ )
+		S_FreeSound( S_FindName( mixtest_names[i], NULL ));
+
+	// nothing is playing now, put the clock back where realtime device expects it
+	paintedtime = vsnd.captured = oldpainted;
+
+	cls.key_dest = oldkeydest;
+	s_listener = oldlistener;
+	Cvar_Set( "volume", oldvolume );
+	Cvar_Set( "room_type", oldroom );
+	Cvar_Set( "snd_mute_losefocus", oldmute );
+
+	Con_Printf( "s_mixtest: %d seconds mixed in %.2f ms, %.3f ms per second of audio, %.0fx realtime\n",
+		seconds, realtime * 1000.0, mixtime * 1000.0 / ( seconds * 2 ), seconds / Q_max( realtime, 1e-6 ));
+	Con_Printf( "s_mixtest: checksum %08x\n", crc[0] );
+
+	if( crc[0] != crc[1] )
+	{
+		Con_Printf( S_ERROR "s_mixtest: output isn't deterministic, second pass gave %08x\n", crc[1] );
+		ok = false;
+	}
+
+	if( Cmd_Argc() > 2 && !S_MixTestGolden( Cmd_Argv( 2 ), crc[0], seconds, Cmd_Argc() > 3 ))
+		ok = false;
+
+	if( !ok )
+		error_on_exit = EXIT_FAILURE;
+}
@@ -23,9 +23,25 @@ GNU General Public License for more details.
 #define TRIM_SAMPLES_BELOW_16 512 // 65k * 2 / 256
 
 #define CVOXFILESENTENCEMAX 4096
+#define VOX_HASH_SIZE 1024
+#define VOX_PATH_LENGTH 64
+
+// sentence from sentences.txt, parsed once at load time
+typedef struct voxsentence_s
+{
+	const char *name; // points to raw sentence
+	struct voxsentence_s *hashNext;
+	int index;
+	int numwords;     // -1 if sentence can't be parsed
+	voxword_t *words; // parameters only, sfx is resolved on start
+	const char **paths;
+} voxsentence_t;
 
 static int cszrawsentences = 0;
 static char *rgpszrawsentence[CVOXFILESENTENCEMAX];
+static int cszcompiledsentences = 0;
+static voxsentence_t *rgpcompiledsentence[CVOXFILESENTENCEMAX];
+static voxsentence_t *voxhash[VOX_HASH_SIZE];
 static const char *voxperiod = "_period", *voxcomma = "_comma";
 
 static qboolean S_ShouldTrimSample8( const int8_t *buf, int channels )
@@ -200,18 +216,66 @@ void VOX_LoadWord( channel_t *ch )
 void VOX_FreeWord( channel_t *ch )
 {
 	voxword_t *word = &ch->words[ch->wordIndex];
+	int i;
 
 	ch->currentWord = NULL;
 	memset( &ch->pMixer, 0, sizeof( ch->pMixer ));
 
-	if( !word->sfx && !word->fKeepCached )
+	if( !word->sfx || word->fKeepCached )
 		return;
 
+	// prefetched for repeated word later in this sentence
+	for( i = ch->wordIndex + 1; i < CVOXWORDMAX && ch->words[i].sfx; i++ )
+	{
+		if( ch->words[i].sfx == word->sfx )
+		{
+			word->sfx = NULL;
+			return;
+		}
+	}
+
 	FS_FreeSound( word->sfx->cache );
 	word->sfx->cache = NULL;
 	word->sfx = NULL;
 }
 
+/*
+================
+VOX_FreeWords
+
+release prefetched words in [first, last) which won't be played,
+e.g. channel was stopped or stolen in the middle of sentence,
+words needed later in sentence and ones cached before it are kept
+================
+*/
+void VOX_FreeWords( channel_t *ch, int first, int last )
+{
+	int i, j;
+
+	last = Q_min( last, CVOXWORDMAX );
+
+	for( i = first; i < last && ch->words[i].sfx; i++ )
+	{
+		sfx_t *sfx = ch->words[i].sfx;
+
+		// repeated words are freed once
+		if( ch->words[i].fKeepCached || !sfx->cache )
+			continue;
+
+		for( j = last; j < CVOXWORDMAX && ch->words[j].sfx; j++ )
+		{
+			if( ch->words[j].sfx == sfx )
+				break;
+		}
+
+		if( j < CVOXWORDMAX && ch->words[j].sfx )
+			continue;
+
+		FS_FreeSound( sfx->cache );
+		sfx->cache = NULL;
+	}
+}
+
 void VOX_SetChanVol( channel_t *ch )
 {
 	voxword_t *word;
@@ -271,17 +335,9 @@ static const char *VOX_GetDirectory( char *szpath, const char *psz, int nsize )
 	return p + 1;
 }
 
-static const char *VOX_LookupString( const char *pszin )
+static int VOX_SentenceIndex( const char *pszin )
 {
-	int i = -1, len;
-	const char *c;
-
-	// check if we are an immediate sentence
-	if( *pszin == '#' )
-	{
-		// immediate sentence, probably coming from "speak" command
-		return pszin + 1;
-	}
+	int i = -1;
 
 	// check if we received an index
 	if( Q_isdigit( pszin ))
@@ -292,28 +348,63 @@ static const char *VOX_LookupString( const char *pszin )
 			i = -1;
 	}
 
-	// last hope: find it in sentences array
-	if( i == -1 )
+	if( i != -1 )
+		return i;
+
+	// sentences file was compiled, use hash
+	if( cszcompiledsentences == cszrawsentences )
 	{
-		for( i = 0; i < cszrawsentences; i++ )
+		const voxsentence_t *sentence;
+
+		for( sentence = voxhash[COM_HashKey( pszin, VOX_HASH_SIZE )]; sentence; sentence = sentence->hashNext )
 		{
-			if( !Q_stricmp( pszin, rgpszrawsentence[i] ))
-				break;
+			if( !Q_stricmp( pszin, sentence->name ))
+				return sentence->index;
 		}
+
+		return -1;
 	}
 
-	// not found, exit
-	if( i == cszrawsentences )
-		return NULL;
+	// last hope: find it in sentences array
+	for( i = 0; i < cszrawsentences; i++ )
+	{
+		if( !Q_stricmp( pszin, rgpszrawsentence[i] ))
+			return i;
+	}
 
-	len = Q_strlen( rgpszrawsentence[i] );
+	return -1;
+}
+
+static const char *VOX_SentenceText( int i )
+{
+	int len = Q_strlen( rgpszrawsentence[i] );
+	const char *c = &rgpszrawsentence[i][len + 1];
 
-	c = &rgpszrawsentence[i][len + 1];
 	for( ; *c == ' ' || *c == '\t'; c++ );
 
 	return c;
 }
 
+static const char *VOX_LookupString( const char *pszin )
+{
+	int i;
+
+	// check if we are an immediate sentence
+	if( *pszin == '#' )
+	{
+		// immediate sentence, probably coming from "speak" command
+		return pszin + 1;
+	}
+
+	i = VOX_SentenceIndex( pszin );
+
+	// not found, exit
+	if( i == -1 )
+		return NULL;
+
+	return VOX_SentenceText( i );
+}
+
 static int VOX_ParseString( char *psz, char *rgpparseword[CVOXWORDMAX] )
 {
 	int i = 0;
@@ -450,63 +541,189 @@ static qboolean VOX_ParseWordParams( char *psz, voxword_t *pvoxword, qboolean fF
 	return true;
 }
 
-void VOX_LoadSound( channel_t *ch, const char *pszin )
+/*
+=================
+VOX_ParseSentence
+
+splits sentence text into words with their parameters
+and sound paths, returns number of words or -1
+=================
+*/
+static int VOX_ParseSentence( const char *pszin, const char *psz, voxword_t *words, char paths[CVOXWORDMAX][VOX_PATH_LENGTH] )
 {
-	char buffer[512], szpath[32], pathbuffer[64];
-	char *rgpparseword[CVOXWORDMAX];
-	const char *psz;
+	char buffer[512], szpath[32];
+	char *rgpparseword[CVOXWORDMAX + 1];
 	int i, j;
 
-	if( !pszin )
-		return;
-
 	memset( buffer, 0, sizeof( buffer ));
 	memset( rgpparseword, 0, sizeof( rgpparseword ));
 
-	psz = VOX_LookupString( pszin );
-
-	if( !psz )
-	{
-		Con_Printf( "%s: no sentence named %s\n", __func__, pszin );
-		return;
-	}
-
 	psz = VOX_GetDirectory( szpath, psz, sizeof( szpath ));
 
 	if( !psz )
 	{
 		Con_Printf( "%s: failed getting directory for %s\n", __func__, pszin );
-		return;
+		return -1;
 	}
 
 	if( Q_strlen( psz ) >= sizeof( buffer ) )
 	{
 		Con_Printf( "%s: sentence is too long %s", __func__, psz );
-		return;
+		return -1;
 	}
 
 	Q_strncpy( buffer, psz, sizeof( buffer ));
 	VOX_ParseString( buffer, rgpparseword );
 
-	j = 0;
-	for( i = 0; rgpparseword[i]; i++ )
+	// keep one slot for terminator
+	for( i = j = 0; rgpparseword[i] && j < CVOXWORDMAX - 1; i++ )
 	{
-		if( !VOX_ParseWordParams( rgpparseword[i], &ch->words[j], i == 0 ))
+		if( !VOX_ParseWordParams( rgpparseword[i], &words[j], i == 0 ))
 			continue;
 
-		Q_snprintf( pathbuffer, sizeof( pathbuffer ), "%s%s.wav", szpath, rgpparseword[i] );
+		Q_snprintf( paths[j], VOX_PATH_LENGTH, "%s%s.wav", szpath, rgpparseword[i] );
+		words[j].sfx = NULL;
+		j++;
+	}
 
-		ch->words[j].sfx = S_FindName( pathbuffer, &ch->words[j].fKeepCached );
+	return j;
+}
 
-		j++;
+/*
+=================
+VOX_CompileSentence
+
+packs parsed sentence into single allocation
+=================
+*/
+static voxsentence_t *VOX_CompileSentence( int index )
+{
+	voxword_t words[CVOXWORDMAX];
+	char paths[CVOXWORDMAX][VOX_PATH_LENGTH];
+	const char *name = rgpszrawsentence[index];
+	voxsentence_t *sentence;
+	size_t size;
+	char *p;
+	int i, numwords;
+
+	numwords = VOX_ParseSentence( name, VOX_SentenceText( index ), words, paths );
+
+	size = sizeof( *sentence );
+	for( i = 0; i < numwords; i++ )
+		size += sizeof( voxword_t ) + sizeof( char * ) + Q_strlen( paths[i] ) + 1;
+
+	sentence = Mem_Malloc( host.mempool, size );
+	sentence->name = name;
+	sentence->index = index;
+	sentence->numwords = numwords;
+	sentence->words = (voxword_t *)( sentence + 1 );
+	sentence->paths = (const char **)( sentence->words + Q_max( numwords, 0 ));
+	p = (char *)( sentence->paths + Q_max( numwords, 0 ));
+
+	for( i = 0; i < numwords; i++ )
+	{
+		size_t len = Q_strlen( paths[i] ) + 1;
+
+		sentence->words[i] = words[i];
+		sentence->paths[i] = p;
+		memcpy( p, paths[i], len );
+		p += len;
+	}
+
+	return sentence;
+}
+
+void VOX_LoadSound( channel_t *ch, const char *pszin )
+{
+	char paths[CVOXWORDMAX][VOX_PATH_LENGTH];
+	const voxsentence_t *sentence = NULL;
+	const char *psz;
+	int i, numwords;
+
+	if( !pszin )
+		return;
+
+	if( *pszin != '#' && cszcompiledsentences == cszrawsentences )
+	{
+		i = VOX_SentenceIndex( pszin );
+
+		if( i != -1 )
+			sentence = rgpcompiledsentence[i];
+	}
+
+	if( sentence )
+	{
+		numwords = sentence->numwords;
+
+		if( numwords > 0 )
+			memcpy( ch->words, sentence->words, sizeof( voxword_t ) * numwords );
+	}
+	else
+	{
+		// immediate sentence
+		psz = VOX_LookupString( pszin );
+
+		if( !psz )
+		{
+			Con_Printf( "%s: no sentence named %s\n", __func__, pszin );
+			return;
+		}
+
+		numwords = VOX_ParseSentence( pszin, psz, ch->words, paths );
 	}
 
-	ch->words[j].sfx = NULL;
+	if( numwords < 0 )
+		return;
+
+	for( i = 0; i < numwords; i++ )
+		ch->words[i].sfx = S_FindName( sentence ? sentence->paths[i] : paths[i], &ch->words[i].fKeepCached );
+
+	ch->words[numwords].sfx = NULL;
 	ch->sfx = ch->words[0].sfx;
 	ch->wordIndex = 0;
 	ch->isSentence = true;
 
 	VOX_LoadWord( ch );
+
+	// prefetch rest of words, so mixer won't wait for disk
+	for( i = 1; i < numwords; i++ )
+	{
+		if( ch->words[i].sfx )
+			S_LoadSound( ch->words[i].sfx );
+	}
+}
+
+/*
+=================
+VOX_CompileSentences
+
+parse all sentences once and link them into hash
+=================
+*/
+static void VOX_CompileSentences( void )
+{
+	int i;
+
+	for( i = cszcompiledsentences; i < cszrawsentences; i++ )
+	{
+		voxsentence_t *sentence = VOX_CompileSentence( i );
+		uint hash = COM_HashKey( sentence->name, VOX_HASH_SIZE );
+
+		// first sentence with the same name wins, like in linear search
+		sentence->hashNext = NULL;
+		if( voxhash[hash] )
+		{
+			voxsentence_t *last = voxhash[hash];
+
+			while( last->hashNext )
+				last = last->hashNext;
+			last->hashNext = sentence;
+		}
+		else voxhash[hash] = sentence;
+
+		rgpcompiledsentence[i] = sentence;
+		cszcompiledsentences = i + 1;
+	}
 }
 
 static void VOX_ReadSentenceFile_( byte *buf, fs_offset_t size )
@@ -554,6 +771,8 @@ static void VOX_ReadSentenceFile_( byte *buf, fs_offset_t size )
 			cszrawsentences++;
 		}
 	}
+
+	VOX_CompileSentences();
 }
 
 static void VOX_ReadSentenceFile( const char *path )
@@ -580,9 +799,14 @@ void VOX_Shutdown( void )
 {
 	int i;
 
+	for( i = 0; i < cszcompiledsentences; i++ )
+		Mem_Free( rgpcompiledsentence[i] );
+
 	for( i = 0; i < cszrawsentences; i++ )
 		Mem_Free( rgpszrawsentence[i] );
 
+	memset( voxhash, 0, sizeof( voxhash ));
+	cszcompiledsentences = 0;
 	cszrawsentences = 0;
 }
 
@@ -704,12 +928,93 @@ static void Test_VOX_ParseWordParams( void )
 	TASSERT( ret );
 }
 
+static void Test_VOX_CompileSentences( void )
+{
+	char file[] =
+		"// comment\n"
+		"TEST0 (p100) my ass is, heavy!(p80 t20) clik.\r\n"
+		"TEST1 barney/hello(v50) freeman\n"
+		"test0 duplicate\n";
+	const voxsentence_t *sentence;
+
+	VOX_Shutdown();
+	VOX_ReadSentenceFile_( (byte *)file, sizeof( file ) - 1 );
+
+	TASSERT_EQi( cszrawsentences, 3 );
+	TASSERT_EQi( cszcompiledsentences, 3 );
+
+	// hash lookup is case insensitive, first one wins
+	TASSERT_EQi( VOX_SentenceIndex( "test0" ), 0 );
+	TASSERT_EQi( VOX_SentenceIndex( "Test1" ), 1 );
+	TASSERT_EQi( VOX_SentenceIndex( "2" ), 2 );
+	TASSERT_EQi( VOX_SentenceIndex( "test2" ), -1 );
+	TASSERT_STR( VOX_LookupString( "TEST1" ), "barney/hello(v50) freeman" );
+
+	sentence = rgpcompiledsentence[0];
+	TASSERT_EQi( sentence->numwords, 6 );
+	TASSERT_STR( sentence->paths[0], "vox/my.wav" );
+	TASSERT_STR( sentence->paths[3], "vox/_comma.wav" );
+	TASSERT_STR( sentence->paths[4], "vox/heavy!.wav" );
+	TASSERT_EQi( sentence->words[0].pitch, 100 );
+	TASSERT_EQi( sentence->words[4].pitch, 80 );
+	TASSERT_EQi( sentence->words[4].timecompress, 20 );
+	TASSERT_EQi( sentence->words[5].pitch, 100 );
+
+	sentence = rgpcompiledsentence[1];
+	TASSERT_EQi( sentence->numwords, 2 );
+	TASSERT_STR( sentence->paths[0], "barney/hello.wav" );
+	TASSERT_STR( sentence->paths[1], "barney/freeman.wav" );
+	TASSERT_EQi( sentence->words[0].volume, 50 );
+	TASSERT_EQi( sentence->words[1].volume, 100 );
+
+	VOX_Shutdown();
+	TASSERT_EQi( VOX_SentenceIndex( "test0" ), -1 );
+}
+
+static void Test_VOX_FreeWords( void )
+{
+	sfx_t sfx[4];
+	channel_t ch;
+	int i;
+
+	memset( sfx, 0, sizeof( sfx ));
+	memset( &ch, 0, sizeof( ch ));
+
+	for( i = 0; i < sizeof( sfx ) / sizeof( sfx[0] ); i++ )
+		sfx[i].cache = Mem_Calloc( host.mempool, sizeof( wavdata_t ));
+
+	// "a b c a d", d was cached before the sentence
+	ch.isSentence = true;
+	ch.words[0].sfx = &sfx[0];
+	ch.words[1].sfx = &sfx[1];
+	ch.words[2].sfx = &sfx[2];
+	ch.words[3].sfx = &sfx[0];
+	ch.words[4].sfx = &sfx[3];
+	ch.words[4].fKeepCached = true;
+
+	// skipped words are released unless needed later
+	VOX_FreeWords( &ch, 0, 3 );
+	TASSERT( sfx[0].cache != NULL );
+	TASSERT( sfx[1].cache == NULL );
+	TASSERT( sfx[2].cache == NULL );
+	TASSERT( sfx[3].cache != NULL );
+
+	// stopped channel releases the rest
+	VOX_FreeWords( &ch, 3, CVOXWORDMAX );
+	TASSERT( sfx[0].cache == NULL );
+	TASSERT( sfx[3].cache != NULL );
+
+	Mem_Free( sfx[3].cache );
+}
+
 void Test_RunVOX( void )
 {
 	TRUN( Test_VOX_GetDirectory() );
 	TRUN( Test_VOX_LookupString() );
 	TRUN( Test_VOX_ParseString() );
 	TRUN( Test_VOX_ParseWordParams() );
+	TRUN( Test_VOX_CompileSentences() );
+	TRUN( Test_VOX_FreeWords() );
 }
 
 #endif /* XASH_ENGINE_TESTS */
@@ -223,6 +223,13 @@ sound_t S_RegisterSound( const char *name );
 void S_FreeSound( sfx_t *sfx );
 void S_InitSounds( void );
 
+// s_virtual.c
+qboolean SNDVIRT_Init( void );
+qboolean SNDVIRT_Active( void );
+void SNDVIRT_BeginPainting( void );
+void SNDVIRT_Submit( void );
+void SNDVIRT_Shutdown( void );
+
 // s_dsp.c
 void SX_Init( void );
 void SX_Free( void );
@@ -283,6 +290,7 @@ void VOX_Init( void );
 void VOX_Shutdown( void );
 void VOX_SetChanVol( channel_t *ch );
 void VOX_LoadSound( channel_t *pchan, const char *psz );
+void VOX_FreeWords( channel_t *ch, int first, int last );
 float VOX_ModifyPitch( channel_t *ch, float pitch );
 int VOX_MixDataToDevice( channel_t *pChannel, int sampleCount, int outputRate, int outputOffset );
 
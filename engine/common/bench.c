@@ -0,0 +1,313 @@
+/*
+bench.c - engine microbenchmark runner
+Copyright (C) 2026 FWGS
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+*/
+
+#include "common.h"
+#include "xash3d_mathlib.h"
+
+#if XASH_ENGINE_TESTS
+#include "tests.h"
+
+#define BENCH_MAX_RESULTS	64
+#define BENCH_MAX_SAMPLES	255
+#define BENCH_WARMUP	3
+
+typedef struct bench_result_s
+{
+	char	name[64];
+	int	count;
+	double	median; // nanoseconds per operation
+	double	p95;
+} bench_result_t;
+
+static bench_result_t bench_results[BENCH_MAX_RESULTS];
+static int bench_numresults;
+static int bench_samples = 31;
+static string bench_filter;
+
+volatile uint bench_sink;
+
+static int Bench_CompareSamples( const void *a, const void *b )
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return ( x > y ) - ( x < y );
+}
+
+/*
+===============
+Bench_Run
+
+times count calls of kernel per sample, after
+few warmup passes, results are per single call
+===============
+*/
+void Bench_Run( const char *name, bench_func_t func, void *data, int count )
+{
+	double samples[BENCH_MAX_SAMPLES];
+	bench_result_t *r;
+	int i;
+
+	if( COM_CheckStringEmpty( bench_filter ) && !Q_stristr( name, bench_filter ))
+		return;
+
+	if( bench_numresults >= BENCH_MAX_RESULTS )
+	{
+		Con_Printf( S_ERROR "%s: too many kernels, %s skipped\n", __func__, name );
+		return;
+	}
+
+	for( i = 0; i < BENCH_WARMUP; i++ )
+		func( data, count );
+
+	for( i = 0; i < bench_samples; i++ )
+	{
+		double start = Sys_DoubleTime();
+
+		func( data, count );
+		samples[i] = ( Sys_DoubleTime() - start ) * 1e9 / count;
+	}
+
+	qsort( samples, bench_samples, sizeof( samples[0] ), Bench_CompareSamples );
+
+	r = &bench_results[bench_numresults++];
+	Q_strncpy( r->name, name, sizeof( r->name ));
+	r->count = count;
+	r->median = samples[bench_samples / 2];
+	r->p95 = samples[( bench_samples * 95 + 99 ) / 100 - 1]; // nearest rank
+
+	Con_Printf( "%-28s %12.2f ns %12.2f ns\n", r->name, r->median, r->p95 );
+}
+
+#define BENCH_HASH_SIZE	0x10000
+
+static void Bench_CRC32( void *data, int count )
+{
+	int i;
+
+	for( i = 0; i < count; i++ )
+	{
+		uint32_t crc;
+
+		CRC32_Init( &crc );
+		CRC32_ProcessBuffer( &crc, data, BENCH_HASH_SIZE );
+		bench_sink += CRC32_Final( crc );
+	}
+}
+
+static void Bench_MD5( void *data, int count )
+{
+	int i;
+
+	for( i = 0; i < count; i++ )
+	{
+		MD5Context_t ctx;
+		byte digest[16];
+
+		MD5Init( &ctx );
+		MD5Update( &ctx, data, BENCH_HASH_SIZE );
+		MD5Final( digest, &ctx );
+		bench_sink += digest[0];
+	}
+}
+
+static void Bench_COM_ParseFile( void *data, int count )
+{
+	int i;
+
+	for( i = 0; i < count; i++ )
+	{
+		char token[MAX_TOKEN];
+		char *pfile = data;
+
+		while(( pfile = COM_ParseFile( pfile, token, sizeof( token ))))
+			bench_sink += token[0];
+	}
+}
+
+/*
+===============
+Bench_RunPublic
+
+kernels from public library, shared with game dlls
+===============
+*/
+void Bench_RunPublic( void )
+{
+	byte *buf = Mem_Malloc( host.mempool, BENCH_HASH_SIZE );
+	char *script = (char *)buf;
+	int i, len;
+
+	for( i = 0; i < BENCH_HASH_SIZE; i++ )
+		buf[i] = ( i * 2654435761u ) >> 24;
+
+	Bench_Run( "CRC32_ProcessBuffer", Bench_CRC32, buf, 10 );
+	Bench_Run( "MD5", Bench_MD5, buf, 10 );
+
+	// entity lump like text
+	for( i = len = 0; len < BENCH_HASH_SIZE - 256; i++ )
+	{
+		len += Q_snprintf( script + len, BENCH_HASH_SIZE - len,
+			"{\n\"classname\" \"func_door\"\n\"origin\" \"%d %d 64\"\n\"speed\" \"100\"\n\"targetname\" \"door%d\"\n}\n",
+			i * 16, -i * 8, i );
+	}
+
+	Bench_Run( "COM_ParseFile", Bench_COM_ParseFile, script, 5 );
+
+	Mem_Free( buf );
+}
+
+/*
+===============
+Bench_WriteJSON
+===============
+*/
+static void Bench_WriteJSON( FILE *f )
+{
+	int i;
+
+	fprintf( f, "{\n\t\"samples\": %d,\n\t\"kernels\": [\n", bench_samples );
+
+	for( i = 0; i < bench_numresults; i++ )
+	{
+		const bench_result_t *r = &bench_results[i];
+
+		fprintf( f, "\t\t{ \"name\": \"%s\", \"count\": %d, \"median_ns\": %.3f, \"p95_ns\": %.3f }%s\n",
+			r->name, r->count, r->median, r->p95, i == bench_numresults - 1 ? "" : "," );
+	}
+
+	fprintf( f, "\t]\n}\n" );
+}
+
+/*
+===============
+Bench_BaselineMedian
+
+looks up kernel median in JSON written by Bench_WriteJSON
+===============
+*/
+static qboolean Bench_BaselineMedian( const char *json, const char *name, double *median )
+{
+	const char *p, *end;
+	char key[80];
+
+	Q_snprintf( key, sizeof( key ), "\"name\": \"%s\"", name );
+
+	if( !( p = Q_strstr( json, key )))
+		return false;
+
+	// don't look into next kernel entry
+	end = Q_strchr( p, '}' );
+
+	if( !( p = Q_strstr( p, "\"median_ns\":" )) || ( end && p > end ))
+		return false;
+
+	*median = Q_atof( p + sizeof( "\"median_ns\":" ) - 1 );
+	return *median > 0.0;
+}
+
+/*
+===============
+Bench_CompareBaseline
+
+returns number of kernels that became slower than
+baseline by more than threshold percents
+===============
+*/
+static int Bench_CompareBaseline( const char *path, float threshold )
+{
+	char *json;
+	int i, regressions = 0;
+
+	if( !( json = (char *)FS_LoadDirectFile( path, NULL )))
+	{
+		Con_Printf( S_ERROR "couldn't load benchmark baseline %s\n", path );
+		return 1;
+	}
+
+	for( i = 0; i < bench_numresults; i++ )
+	{
+		const bench_result_t *r = &bench_results[i];
+		double base, diff;
+
+		if( !Bench_BaselineMedian( json, r->name, &base ))
+		{
+			Con_Printf( S_WARN "%s: no baseline\n", r->name );
+			continue;
+		}
+
+		diff = ( r->median - base ) * 100.0 / base;
+
+		if( diff > threshold )
+		{
+			Con_Printf( S_ERROR "%s regressed: %.2f ns -> %.2f ns (%+.1f%%, threshold %.1f%%)\n",
+				r->name, base, r->median, diff, threshold );
+			regressions++;
+		}
+		else Con_Printf( "%s: %.2f ns -> %.2f ns (%+.1f%%)\n", r->name, base, r->median, diff );
+	}
+
+	Mem_Free( json );
+	return regressions;
+}
+
+/*
+===============
+Bench_RunAll
+
+-runbench [-benchsamples N] [-benchfilter name] [-benchout file.json]
+          [-benchbaseline file.json] [-benchthreshold percents]
+===============
+*/
+int Bench_RunAll( void )
+{
+	string out, baseline, value;
+	float threshold = 10.0f;
+	int regressions = 0;
+
+	if( Sys_GetParmFromCmdLine( "-benchsamples", value ))
+		bench_samples = bound( 1, Q_atoi( value ), BENCH_MAX_SAMPLES );
+
+	if( Sys_GetParmFromCmdLine( "-benchthreshold", value ))
+		threshold = Q_atof( value );
+
+	if( !Sys_GetParmFromCmdLine( "-benchfilter", bench_filter ))
+		bench_filter[0] = '\0';
+
+	bench_numresults = 0;
+
+	Con_Printf( "%-28s %15s %15s\n", "kernel", "median", "p95" );
+	BENCH_LIST;
+
+	if( Sys_GetParmFromCmdLine( "-benchout", out ))
+	{
+		FILE *f = fopen( out, "w" );
+
+		if( f )
+		{
+			Bench_WriteJSON( f );
+			fclose( f );
+			Con_Printf( "benchmark results written to %s\n", out );
+		}
+		else Con_Printf( S_ERROR "couldn't write %s\n", out );
+	}
+	else Bench_WriteJSON( stdout );
+
+	if( Sys_GetParmFromCmdLine( "-benchbaseline", baseline ))
+		regressions = Bench_CompareBaseline( baseline, threshold );
+
+	return regressions;
+}
+
+#endif // XASH_ENGINE_TESTS
@@ -1073,4 +1073,82 @@ void Test_RunCommon( void )
 	TASSERT_EQi( COM_IsSafeFileToDownload( "not-a-virus-trust-me.bat" ), false );
 	TASSERT_EQi( COM_IsSafeFileToDownload( "a-texture.png" ), true );
 }
+
+#define BENCH_LZSS_SIZE	0x2000
+
+typedef struct bench_lzss_s
+{
+	byte	input[BENCH_LZSS_SIZE];
+	byte	output[BENCH_LZSS_SIZE];
+	byte	*compressed;
+} bench_lzss_t;
+
+static void Bench_LZSS_Compress( void *data, int count )
+{
+	bench_lzss_t *b = data;
+	int i;
+
+	for( i = 0; i < count; i++ )
+	{
+		uint size = 0;
+		byte *out = LZSS_Compress( b->input, sizeof( b->input ), &size );
+
+		bench_sink += size;
+		free( out );
+	}
+}
+
+static void Bench_LZSS_Decompress( void *data, int count )
+{
+	bench_lzss_t *b = data;
+	int i;
+
+	for( i = 0; i < count; i++ )
+		bench_sink += LZSS_Decompress( b->compressed, b->output );
+}
+
+static void Bench_Info_ValueForKey( void *data, int count )
+{
+	static const char *keys[] = { "name", "model", "topcolor", "bottomcolor", "rate", "cl_lw", "*hltv", "missing" };
+	int i;
+
+	for( i = 0; i < count; i++ )
+		bench_sink += *Info_ValueForKey( data, keys[i % ARRAYSIZE( keys )] );
+}
+
+void Bench_RunCommon( void )
+{
+	bench_lzss_t *b = Mem_Calloc( host.mempool, sizeof( *b ));
+	char userinfo[MAX_INFO_STRING] = "\\_cl_autowepswitch\\1\\bottomcolor\\6\\cl_dlmax\\512\\cl_lc\\1"
+		"\\cl_lw\\1\\cl_updaterate\\60\\model\\gordon\\topcolor\\30\\_vgui_menus\\1"
+		"\\rate\\30000\\name\\Player\\*hltv\\0";
+	uint size = 0;
+	int i, len;
+
+	// signon-like data, text mixed with binary deltas
+	for( i = len = 0; len < sizeof( b->input ); i++ )
+	{
+		byte chunk[64];
+		int n = Q_snprintf( (char *)chunk, sizeof( chunk ), "models/prop%d.mdl", i % 97 ) + 1;
+
+		chunk[n++] = i & 0xff;
+		chunk[n++] = ( i * 31 ) & 0xff;
+		n = Q_min( n, sizeof( b->input ) - len );
+
+		memcpy( &b->input[len], chunk, n );
+		len += n;
+	}
+
+	b->compressed = LZSS_Compress( b->input, sizeof( b->input ), &size );
+
+	Bench_Run( "LZSS_Compress", Bench_LZSS_Compress, b, 20 );
+
+	if( b->compressed )
+		Bench_Run( "LZSS_Decompress", Bench_LZSS_Decompress, b, 200 );
+
+	Bench_Run( "Info_ValueForKey", Bench_Info_ValueForKey, userinfo, 100000 );
+
+	free( b->compressed );
+	Mem_Free( b );
+}
 #endif
@@ -398,6 +398,7 @@ void Mem_PrintStats( void );
 //
 void FS_Init( const char *basedir );
 void FS_Shutdown( void );
+void FS_TraceMapLoad( const char *mapname );
 void *FS_GetNativeObject( const char *obj );
 int FS_Close( file_t *file );
 search_t *FS_Search( const char *pattern, int caseinsensitive, int gamedironly )
@@ -409,6 +410,15 @@ byte *FS_LoadFile( const char *path, fs_offset_t *filesizeptr, qboolean gamediro
 byte *FS_LoadDirectFile( const char *path, fs_offset_t *filesizeptr )
 	MALLOC_LIKE( _Mem_Free, 1 ) WARN_UNUSED_RESULT;
 
+//
+// fs_prefetch.c
+//
+void FS_PrefetchInit( void );
+void FS_PrefetchShutdown( void );
+void FS_Prefetch( const char *path );
+byte *FS_PrefetchTake( const char *path, fs_offset_t *filesizeptr );
+void FS_PrefetchFlush( void );
+
 //
 // cmd.c
 //
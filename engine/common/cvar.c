@@ -1425,4 +1425,38 @@ void Test_RunCvar( void )
 	TASSERT( hud_filtered->value      == 0.0f );
 	TASSERT( filtered2->value         == 0.0f );
 }
+
+#define BENCH_CVAR_NAMES	64
+
+static void Bench_Cvar_FindVar( void *data, int count )
+{
+	const char **names = data;
+	int i;
+
+	for( i = 0; i < count; i++ )
+		bench_sink += Cvar_FindVar( names[i % BENCH_CVAR_NAMES] ) != NULL;
+}
+
+void Bench_RunCvar( void )
+{
+	const char *names[BENCH_CVAR_NAMES];
+	convar_t *var = cvar_vars;
+	int i;
+
+	// registered variables from whole list and some misses, as
+	// game dlls look up cvars that engine doesn't have
+	for( i = 0; i < BENCH_CVAR_NAMES; i++ )
+	{
+		if( i % 4 == 3 || !var )
+		{
+			names[i] = "mp_missing_cvar";
+			continue;
+		}
+
+		names[i] = var->name;
+		var = var->next;
+	}
+
+	Bench_Run( "Cvar_FindVar", Bench_Cvar_FindVar, names, 10000 );
+}
 #endif
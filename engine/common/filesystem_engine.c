@@ -27,6 +27,8 @@ fs_globals_t *FI;
 static pfnCreateInterface_t fs_pfnCreateInterface;
 static HINSTANCE fs_hInstance;
 
+static CVAR_DEFINE_AUTO( fs_trace, "0", 0, "log file access order of every map load to traces/<mapname>.txt, used by xar to lay out archives" );
+
 search_t *FS_Search( const char *pattern, int caseinsensitive, int gamedironly )
 {
 	return g_fsapi.Search( pattern, caseinsensitive, gamedironly );
@@ -44,6 +46,12 @@ file_t *FS_Open( const char *filepath, const char *mode, qboolean gamedironly )
 
 byte *FS_LoadFile( const char *path, fs_offset_t *filesizeptr, qboolean gamedironly )
 {
+	byte *buf;
+
+	// traced loads must go through filesystem to be logged
+	if( !gamedironly && !fs_trace.value && ( buf = FS_PrefetchTake( path, filesizeptr )) != NULL )
+		return buf;
+
 	return g_fsapi.LoadFile( path, filesizeptr, gamedironly );
 }
 
@@ -272,6 +280,8 @@ void FS_Init( const char *basedir )
 	Cmd_AddRestrictedCommand( "fs_rescan", FS_Rescan_f, "rescan filesystem search pathes" );
 	Cmd_AddRestrictedCommand( "fs_path", FS_Path_f_, "show filesystem search pathes" );
 	Cmd_AddRestrictedCommand( "fs_clearpaths", FS_ClearPaths_f, "clear filesystem search pathes" );
+	Cvar_RegisterVariable( &fs_trace );
+	FS_PrefetchInit();
 
 	if( !Sys_GetParmFromCmdLine( "-dll", host.gamedll ))
 		host.gamedll[0] = 0;
@@ -280,6 +290,25 @@ void FS_Init( const char *basedir )
 		host.clientlib[0] = 0;
 }
 
+/*
+================
+FS_TraceMapLoad
+
+restart file access trace, it lasts until next map load
+================
+*/
+void FS_TraceMapLoad( const char *mapname )
+{
+	string path;
+
+	if( fs_trace.value )
+	{
+		Q_snprintf( path, sizeof( path ), "traces/%s.txt", mapname );
+		g_fsapi.SetAccessTrace( path );
+	}
+	else g_fsapi.SetAccessTrace( NULL );
+}
+
 /*
 ================
 FS_Shutdown
@@ -287,6 +316,8 @@ FS_Shutdown
 */
 void FS_Shutdown( void )
 {
+	FS_PrefetchShutdown();
+
 	if( g_fsapi.ShutdownStdio )
 		g_fsapi.ShutdownStdio();
 
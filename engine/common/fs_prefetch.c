@@ -0,0 +1,472 @@
+/*
+fs_prefetch.c - background read ahead of loose files
+Copyright (C) 2026 FWGS
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+*/
+
+#include "common.h"
+#include "xash3d_mathlib.h"
+
+/*
+===============================================================================
+
+FILE PREFETCH
+
+main thread queues files it's going to load soon, reader threads pull
+their contents into memory and FS_LoadFile hands the buffer out instead
+of going to disk. Only files lying in plain directories are prefetched:
+path is resolved on the main thread, so workers never touch filesystem
+state and only use stdio and malloc. Parsing stays on the main thread,
+model and sound loaders work on global state and engine mempools
+
+===============================================================================
+*/
+
+#if !XASH_EMSCRIPTEN && !XASH_DOS4GW && !defined XASH_NO_ASYNC_NS_RESOLVE
+#define CAN_PREFETCH
+#endif
+
+static CVAR_DEFINE_AUTO( fs_prefetch, "2", FCVAR_ARCHIVE, "number of threads reading precached resources ahead of loading, 0 to disable" );
+static CVAR_DEFINE_AUTO( fs_prefetch_budget, "64", FCVAR_ARCHIVE, "megabytes of file data prefetch may hold in memory" );
+
+#ifdef CAN_PREFETCH
+
+#if !XASH_WIN32
+#include <pthread.h>
+#define mutex_create( x )     pthread_mutex_init( &( x ), NULL )
+#define mutex_destroy( x )    pthread_mutex_destroy( &( x ))
+#define mutex_lock( x )       pthread_mutex_lock( &( x ))
+#define mutex_unlock( x )     pthread_mutex_unlock( &( x ))
+#define create_thread( thread, pfn ) !pthread_create( &( thread ), NULL, ( pfn ), NULL )
+#define detach_thread( x )    pthread_detach( x )
+typedef pthread_mutex_t mutex_t;
+typedef pthread_t thread_t;
+#else // WIN32
+#define mutex_create( x )   InitializeCriticalSection( &( x ))
+#define mutex_destroy( x )  DeleteCriticalSection( &( x ))
+#define mutex_lock( x )     EnterCriticalSection( &( x ))
+#define mutex_unlock( x )   LeaveCriticalSection( &( x ))
+#define create_thread( thread, pfn ) (( thread ) = CreateThread( NULL, 0, ( pfn ), NULL, 0, NULL ))
+#define detach_thread( x )   CloseHandle(( x ))
+typedef CRITICAL_SECTION mutex_t;
+typedef HANDLE thread_t;
+#endif // WIN32
+
+#define PREFETCH_MAX_FILES	2048
+#define PREFETCH_MAX_THREADS	8
+#define PREFETCH_HASH_SIZE	512
+
+typedef enum
+{
+	PF_QUEUED = 0,
+	PF_READING,
+	PF_DONE,
+	PF_FAILED,
+	PF_TAKEN,	// handed out or cancelled
+} pfstate_t;
+
+typedef struct prefetch_s
+{
+	char		name[MAX_QPATH];
+	char		diskpath[MAX_SYSPATH];
+	pfstate_t		state;
+	byte		*data;	// malloc'ed by reader
+	fs_offset_t	size;
+	struct prefetch_s	*hashNext;
+} prefetch_t;
+
+static struct
+{
+	qboolean		initialized;
+	mutex_t		lock;
+	poolhandle_t	mempool;
+
+	prefetch_t	*files;
+	prefetch_t	*hash[PREFETCH_HASH_SIZE];
+	int		numfiles;
+	int		next;	// first entry that wasn't picked by readers
+
+	size_t		bytes;	// held by finished entries
+	int		workers;	// running readers
+	qboolean		stop;
+
+	// statistics, reported on flush
+	int		hits;
+	int		misses;
+} pf;
+
+/*
+=================
+FS_PrefetchRead
+
+reads whole file with plain stdio, returns malloc'ed buffer
+=================
+*/
+static byte *FS_PrefetchRead( const char *diskpath, fs_offset_t *size )
+{
+	FILE	*f = fopen( diskpath, "rb" );
+	byte	*data = NULL;
+	long	len;
+
+	if( !f )
+		return NULL;
+
+	if( !fseek( f, 0, SEEK_END ) && ( len = ftell( f )) > 0 && !fseek( f, 0, SEEK_SET ))
+	{
+		// keep trailing zero like FS_LoadFile does
+		if(( data = malloc( len + 1 )) != NULL )
+		{
+			if( fread( data, 1, len, f ) == (size_t)len )
+			{
+				data[len] = 0;
+				*size = len;
+			}
+			else
+			{
+				free( data );
+				data = NULL;
+			}
+		}
+	}
+
+	fclose( f );
+	return data;
+}
+
+/*
+=================
+FS_PrefetchWorker
+
+takes queued entries until queue is empty or budget is used up
+=================
+*/
+static void FS_PrefetchWorker( void )
+{
+	size_t	budget = (size_t)fs_prefetch_budget.value << 20;
+
+	while( 1 )
+	{
+		prefetch_t	*p = NULL;
+		fs_offset_t	size = 0;
+		byte		*data;
+
+		mutex_lock( pf.lock );
+
+		if( !pf.stop && pf.bytes < budget )
+		{
+			for( ; pf.next < pf.numfiles; pf.next++ )
+			{
+				if( pf.files[pf.next].state == PF_QUEUED )
+				{
+					p = &pf.files[pf.next++];
+					p->state = PF_READING;
+					break;
+				}
+			}
+		}
+
+		if( !p )
+		{
+			pf.workers--;
+			mutex_unlock( pf.lock );
+			return;
+		}
+
+		mutex_unlock( pf.lock );
+
+		data = FS_PrefetchRead( p->diskpath, &size );
+
+		mutex_lock( pf.lock );
+		p->data = data;
+		p->size = size;
+		p->state = data ? PF_DONE : PF_FAILED;
+		pf.bytes += size;
+		mutex_unlock( pf.lock );
+	}
+}
+
+#if !XASH_WIN32
+static void *FS_PrefetchThread( void *unused )
+{
+	FS_PrefetchWorker();
+	return NULL;
+}
+#else
+static DWORD WINAPI FS_PrefetchThread( LPVOID unused )
+{
+	FS_PrefetchWorker();
+	ExitThread( 0 );
+	return 0;
+}
+#endif
+
+/*
+=================
+FS_PrefetchKick
+
+starts readers if there is a work for them, called with lock held
+=================
+*/
+static void FS_PrefetchKick( void )
+{
+	int	maxworkers = bound( 0, (int)fs_prefetch.value, PREFETCH_MAX_THREADS );
+
+	while( pf.workers < maxworkers && pf.workers < pf.numfiles - pf.next )
+	{
+		thread_t	thread;
+
+		if( !create_thread( thread, FS_PrefetchThread ))
+			break;
+
+		detach_thread( thread );
+		pf.workers++;
+	}
+}
+
+/*
+=================
+FS_PrefetchFind
+=================
+*/
+static prefetch_t *FS_PrefetchFind( const char *name, uint hash )
+{
+	prefetch_t	*p;
+
+	for( p = pf.hash[hash]; p; p = p->hashNext )
+	{
+		if( !Q_stricmp( p->name, name ))
+			return p;
+	}
+
+	return NULL;
+}
+
+/*
+=================
+FS_Prefetch
+
+queues file to be read in background
+=================
+*/
+void FS_Prefetch( const char *path )
+{
+	char		name[MAX_QPATH];
+	char		diskpath[MAX_SYSPATH];
+	prefetch_t	*p;
+	uint		hash;
+
+	if( !pf.initialized || fs_prefetch.value <= 0.0f || !COM_CheckString( path ))
+		return;
+
+	if( Q_strlen( path ) >= sizeof( name ))
+		return;
+
+	Q_strncpy( name, path, sizeof( name ));
+	COM_FixSlashes( name );
+	hash = COM_HashKey( name, PREFETCH_HASH_SIZE );
+
+	// archived files are read by filesystem itself
+	if( !g_fsapi.GetFullDiskPath( diskpath, sizeof( diskpath ), name, false ))
+		return;
+
+	mutex_lock( pf.lock );
+
+	if( !pf.files )
+		pf.files = Mem_Calloc( pf.mempool, sizeof( *pf.files ) * PREFETCH_MAX_FILES );
+
+	if( pf.numfiles < PREFETCH_MAX_FILES && !FS_PrefetchFind( name, hash ))
+	{
+		p = &pf.files[pf.numfiles++];
+		Q_strncpy( p->name, name, sizeof( p->name ));
+		Q_strncpy( p->diskpath, diskpath, sizeof( p->diskpath ));
+		p->state = PF_QUEUED;
+		p->hashNext = pf.hash[hash];
+		pf.hash[hash] = p;
+
+		FS_PrefetchKick();
+	}
+
+	mutex_unlock( pf.lock );
+}
+
+/*
+=================
+FS_PrefetchTake
+
+returns prefetched contents in FS_LoadFile manner or NULL
+if file wasn't prefetched, buffer must be freed with Mem_Free
+=================
+*/
+byte *FS_PrefetchTake( const char *path, fs_offset_t *filesizeptr )
+{
+	char		name[MAX_QPATH];
+	char		diskpath[MAX_SYSPATH];
+	prefetch_t	*p;
+	byte		*buf = NULL;
+
+	if( !pf.numfiles || Q_strlen( path ) >= sizeof( name ))
+		return NULL;
+
+	Q_strncpy( name, path, sizeof( name ));
+	COM_FixSlashes( name );
+
+	mutex_lock( pf.lock );
+
+	if( !( p = FS_PrefetchFind( name, COM_HashKey( name, PREFETCH_HASH_SIZE ))))
+	{
+		mutex_unlock( pf.lock );
+		return NULL;
+	}
+
+	// already handed out, next loads go through filesystem
+	if( p->state == PF_TAKEN )
+	{
+		mutex_unlock( pf.lock );
+		return NULL;
+	}
+
+	// file is on the way, it's still cheaper to wait for it
+	while( p->state == PF_READING )
+	{
+		mutex_unlock( pf.lock );
+		Sys_Sleep( 0 );
+		mutex_lock( pf.lock );
+	}
+
+	if( p->state == PF_DONE )
+	{
+		pf.bytes -= p->size;
+
+		// search paths could be changed since file was queued
+		if( g_fsapi.GetFullDiskPath( diskpath, sizeof( diskpath ), name, false ) && !Q_strcmp( diskpath, p->diskpath ))
+		{
+			buf = Mem_Malloc( pf.mempool, p->size + 1 );
+			memcpy( buf, p->data, p->size + 1 );
+			if( filesizeptr ) *filesizeptr = p->size;
+		}
+
+		free( p->data );
+		p->data = NULL;
+	}
+
+	if( buf ) pf.hits++;
+	else pf.misses++;
+
+	p->state = PF_TAKEN;
+
+	// memory was released, readers may continue
+	FS_PrefetchKick();
+	mutex_unlock( pf.lock );
+
+	return buf;
+}
+
+/*
+=================
+FS_PrefetchFlush
+
+drops everything that wasn't taken
+=================
+*/
+void FS_PrefetchFlush( void )
+{
+	int	i;
+
+	if( !pf.initialized || !pf.numfiles )
+		return;
+
+	mutex_lock( pf.lock );
+	pf.stop = true;
+
+	while( pf.workers > 0 )
+	{
+		mutex_unlock( pf.lock );
+		Sys_Sleep( 1 );
+		mutex_lock( pf.lock );
+	}
+
+	for( i = 0; i < pf.numfiles; i++ )
+	{
+		if( pf.files[i].data )
+			free( pf.files[i].data );
+	}
+
+	Con_Reportf( "%s: %d files queued, %d taken, %d missed\n", __func__, pf.numfiles, pf.hits, pf.misses );
+
+	memset( pf.files, 0, sizeof( *pf.files ) * PREFETCH_MAX_FILES );
+	memset( pf.hash, 0, sizeof( pf.hash ));
+	pf.numfiles = pf.next = 0;
+	pf.hits = pf.misses = 0;
+	pf.bytes = 0;
+	pf.stop = false;
+
+	mutex_unlock( pf.lock );
+}
+
+/*
+=================
+FS_PrefetchInit
+=================
+*/
+void FS_PrefetchInit( void )
+{
+	Cvar_RegisterVariable( &fs_prefetch );
+	Cvar_RegisterVariable( &fs_prefetch_budget );
+
+	mutex_create( pf.lock );
+	pf.mempool = Mem_AllocPool( "Prefetch" );
+	pf.initialized = true;
+}
+
+/*
+=================
+FS_PrefetchShutdown
+=================
+*/
+void FS_PrefetchShutdown( void )
+{
+	if( !pf.initialized )
+		return;
+
+	FS_PrefetchFlush();
+
+	// taken buffers may still be alive, so pool stays
+	mutex_destroy( pf.lock );
+	pf.initialized = false;
+}
+
+#else // !CAN_PREFETCH
+
+void FS_Prefetch( const char *path )
+{
+}
+
+byte *FS_PrefetchTake( const char *path, fs_offset_t *filesizeptr )
+{
+	return NULL;
+}
+
+void FS_PrefetchFlush( void )
+{
+}
+
+void FS_PrefetchInit( void )
+{
+	Cvar_RegisterVariable( &fs_prefetch );
+	Cvar_RegisterVariable( &fs_prefetch_budget );
+}
+
+void FS_PrefetchShutdown( void )
+{
+}
+
+#endif // !CAN_PREFETCH
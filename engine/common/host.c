@@ -912,6 +912,15 @@ static void Host_RunTests( int stage )
 		Sys_Quit();
 	}
 }
+
+static void Host_RunBench( void )
+{
+	int regressions = Bench_RunAll();
+
+	Msg( "Done! %d kernels regressed\n", regressions );
+	error_on_exit = regressions > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	Sys_Quit();
+}
 #endif
 
 static uint32_t Host_CheckBugcomp( void )
@@ -1039,6 +1048,8 @@ static void Host_InitCommon( int argc, char **argv, const char *progname, qboole
 		host.allow_console = true;
 		developer = DEV_EXTENDED;
 	}
+	else if( Sys_CheckParm( "-runbench" ))
+		host.allow_console = true;
 #endif
 
 	// always enable console for Quake and dedicated
@@ -1117,6 +1128,8 @@ static void Host_InitCommon( int argc, char **argv, const char *progname, qboole
 #if XASH_ENGINE_TESTS
 	if( Sys_CheckParm( "-runtests" ))
 		Host_RunTests( 1 );
+	else if( Sys_CheckParm( "-runbench" ))
+		Host_RunBench();
 #endif
 
 	FS_LoadGameInfo( NULL );
@@ -596,6 +596,38 @@ void Test_RunImagelib( void )
 	Z_Free( rgb.buffer );
 }
 
+static void Bench_Image_Resample( void *data, int count )
+{
+	qboolean resampled;
+	int i;
+
+	// typical non power of two texture upload
+	for( i = 0; i < count; i++ )
+		bench_sink += *Image_ResampleInternal( data, 256, 256, 320, 200, PF_RGBA_32, &resampled );
+}
+
+void Bench_RunImagelib( void )
+{
+	byte *buf = Z_Malloc( 256 * 256 * 4 );
+	uint i, j;
+
+	Image_Setup();
+
+	for( i = 0; i < 256; i++ )
+	{
+		for( j = 0; j < 256; j++ )
+			GeneratePixel( &buf[( i * 256 + j ) * 4], i, j, 256, 256, true );
+	}
+
+	Bench_Run( "Image_Resample", Bench_Image_Resample, buf, 10 );
+
+	Image_SetForceFlags( IL_USE_LERPING );
+	Bench_Run( "Image_Resample_lerp", Bench_Image_Resample, buf, 10 );
+	Image_ClearForceFlags();
+
+	Z_Free( buf );
+}
+
 #define IMPLEMENT_IMAGELIB_FUZZ_TARGET( export, target ) \
 int export( const uint8_t *Data, size_t Size ); \
 int EXPORT export( const uint8_t *Data, size_t Size ) \
@@ -29,6 +29,25 @@ GNU General Public License for more details.
 #endif // HAVE_OPENMP
 
 #define MIPTEX_CUSTOM_PALETTE_SIZE_BYTES ( sizeof( int16_t ) + 768 )
+#define WADTEX_HASH_SIZE	1024
+
+// miptex name to wad lump, resolved once per brush model textures
+typedef struct wadtexture_s
+{
+	char			name[16];
+	const void		*wad;	// filesystem handle
+	int			lump;
+	int			wadIndex;	// in world.wadlist
+	struct wadtexture_s		*hashNext;
+} wadtexture_t;
+
+typedef struct
+{
+	wadtexture_t		*textures;
+	wadtexture_t		*hash[WADTEX_HASH_SIZE];
+	int			numtextures;
+	int			maxtextures;
+} wadindex_t;
 
 typedef struct leaflist_s
 {
@@ -179,6 +198,7 @@ static loadstat_t		loadstat;
 static model_t		*worldmodel;
 static byte		g_visdata[(MAX_MAP_LEAFS+7)/8];	// intermediate buffer
 static mlumpstat_t		worldstats[HEADER_LUMPS+EXTRA_LUMPS];
+static wadindex_t		wadindex;
 static mlumpinfo_t		srclumps[HEADER_LUMPS] =
 {
 { LUMP_ENTITIES, 32, MAX_MAP_ENTSTRING, sizeof( byte ), -1, "entities", 0, (const void **)&srcmodel.entdata, &srcmodel.entdatasize },
@@ -224,31 +244,116 @@ static mip_t *Mod_GetMipTexForTexture( dbspmodel_t *bmod, int i )
 	return (mip_t *)((byte *)bmod->textures + bmod->textures->dataofs[i] );
 }
 
+static wadtexture_t *Mod_FindWadTexture( const char *name )
+{
+	wadtexture_t *tex;
+
+	for( tex = wadindex.hash[COM_HashKey( name, WADTEX_HASH_SIZE )]; tex; tex = tex->hashNext )
+	{
+		if( !Q_stricmp( tex->name, name ))
+			return tex;
+	}
+
+	return NULL;
+}
+
+static void Mod_AddWadTexture( void *context, const void *wad, int index, const char *name, signed char type )
+{
+	const int wadIndex = *(const int *)context;
+	wadtexture_t *tex;
+	uint hash;
+
+	if( type != TYP_MIPTEX )
+		return;
+
+	if(( tex = Mod_FindWadTexture( name )))
+	{
+		// later wad in the list wins, but if few wads have
+		// the same name filesystem would pick the first one
+		if( tex->wadIndex != wadIndex )
+		{
+			tex->wad = wad;
+			tex->lump = index;
+			tex->wadIndex = wadIndex;
+		}
+		return;
+	}
+
+	if( wadindex.numtextures >= wadindex.maxtextures )
+		return; // searchpaths can't change while enumerating
+
+	tex = &wadindex.textures[wadindex.numtextures++];
+	Q_strncpy( tex->name, name, sizeof( tex->name ));
+	tex->wad = wad;
+	tex->lump = index;
+	tex->wadIndex = wadIndex;
+
+	hash = COM_HashKey( name, WADTEX_HASH_SIZE );
+	tex->hashNext = wadindex.hash[hash];
+	wadindex.hash[hash] = tex;
+}
+
+static void Mod_FreeWadIndex( void )
+{
+	if( wadindex.textures )
+		Mem_Free( wadindex.textures );
+
+	memset( &wadindex, 0, sizeof( wadindex ));
+}
+
+/*
+==================
+Mod_CreateWadIndex
+
+looking up each texture with FS_FileExists walks all the searchpaths
+for every wad, so read lump tables of the map wads once instead
+==================
+*/
+static void Mod_CreateWadIndex( const wadlist_t *list )
+{
+	int i, count = 0;
+
+	Mod_FreeWadIndex();
+
+	for( i = 0; i < list->count; i++ )
+		count += g_fsapi.EnumWadLumps( list->wadnames[i], NULL, NULL );
+
+	if( count <= 0 )
+		return;
+
+	wadindex.textures = Mem_Malloc( host.mempool, count * sizeof( *wadindex.textures ));
+	wadindex.maxtextures = count;
+
+	for( i = 0; i < list->count; i++ )
+		g_fsapi.EnumWadLumps( list->wadnames[i], Mod_AddWadTexture, &i );
+}
+
 // Returns index of WAD that texture was found in, or -1 if not found.
 static int Mod_FindTextureInWadList( wadlist_t *list, const char *name, char *dst, size_t size )
 {
-	int i;
+	const wadtexture_t *tex;
 
 	if( !list || !COM_CheckString( name ))
 		return -1;
 
-	// check wads in reverse order
-	for( i = list->count - 1; i >= 0; i-- )
-	{
-		char path[MAX_VA_STRING];
+	if( !( tex = Mod_FindWadTexture( name )))
+		return -1;
 
-		Q_snprintf( path, sizeof( path ), "%s.wad/%s.mip", list->wadnames[i], name );
+	if( dst && size > 0 )
+		Q_snprintf( dst, size, "%s.wad/%s.mip", list->wadnames[tex->wadIndex], name );
 
-		if( FS_FileExists( path, false ))
-		{
-			if( dst && size > 0 )
-				Q_strncpy( dst, path, size );
+	return tex->wadIndex;
+}
 
-			return i;
-		}
-	}
+// Reads miptex from the wad it was resolved to, must be freed with Mem_Free.
+static byte *Mod_LoadWadTexture( const char *name, fs_offset_t *size )
+{
+	const wadtexture_t *tex = Mod_FindWadTexture( name );
+
+	if( !tex )
+		return NULL;
 
-	return -1;
+	return g_fsapi.LoadWadLump( tex->wad, tex->lump, size );
 }
 
 static fs_offset_t Mod_CalculateMipTexSize( mip_t *mt, qboolean palette )
@@ -320,7 +425,7 @@ static void Mod_CreateDefaultTexture( model_t *mod, texture_t **texture )
 	if( !texture || *texture != NULL )
 		return;
 
-	*texture = tex = Mem_Calloc( mod->mempool, sizeof( *tex ));
+	*texture = tex = Mem_Calloc( mod->mempool, sizeof( mtexture_t ));
 	Q_strncpy( tex->name, REF_DEFAULT_TEXTURE, sizeof( tex->name ));
 
 #if !XASH_DEDICATED
@@ -768,6 +873,18 @@ int Mod_FatPVS( const vec3_t org, float radius, byte *visbuffer, int visbytes, q
 		return bytes;
 	}
 
+	// precomputed fat PHS covers any point inside the leaf
+	if( phs && radius == FATPHS_RADIUS && world.compressed_fatphs && world.fatphsofs )
+	{
+		const byte *in = &world.compressed_fatphs[world.fatphsofs[leaf->cluster + 1]];
+
+		if( merge )
+			Q_memor( visbuffer, Mod_DecompressPVS( in, bytes ), bytes );
+		else Mod_DecompressPVSTo( visbuffer, in, bytes );
+
+		return bytes;
+	}
+
 	if( !merge ) memset( visbuffer, 0x00, bytes );
 
 	Mod_FatPVS_RecursiveBSPNode( org, radius, visbuffer, bytes, worldmodel->nodes, phs );
@@ -775,6 +892,85 @@ int Mod_FatPVS( const vec3_t org, float radius, byte *visbuffer, int visbytes, q
 	return bytes;
 }
 
+/*
+==================
+Mod_ValidateFatPHS_f
+
+Compares precomputed fat PHS against exact
+walk at random points in every leaf
+==================
+*/
+void Mod_ValidateFatPHS_f( void )
+{
+	int	samples = 16;
+	int	i, j, k;
+	int	tested = 0, failed = 0;
+	size_t	exactbits = 0, fatbits = 0;
+	byte	exact[(MAX_MAP_LEAFS+7)/8];
+	byte	*fat;
+
+	if( !worldmodel || !world.compressed_fatphs || !world.fatphsofs )
+	{
+		Con_Printf( "precomputed fat PHS is not available\n" );
+		return;
+	}
+
+	if( Cmd_Argc() > 1 )
+		samples = bound( 1, Q_atoi( Cmd_Argv( 1 )), 1024 );
+
+	for( i = 1; i < worldmodel->numleafs + 1; i++ )
+	{
+		mleaf_t	*leaf = &worldmodel->leafs[i];
+
+		if( leaf->cluster < 0 )
+			continue;
+
+		for( j = 0; j < samples; j++ )
+		{
+			vec3_t	point;
+
+			for( k = 0; k < 3; k++ )
+				point[k] = COM_RandomFloat( leaf->minmaxs[k], leaf->minmaxs[k+3] );
+
+			if( Mod_PointInLeaf( point, worldmodel->nodes ) != leaf )
+				continue;
+
+			memset( exact, 0, world.visbytes );
+			Mod_FatPVS_RecursiveBSPNode( point, FATPHS_RADIUS, exact, world.visbytes, worldmodel->nodes, true );
+
+			// exact walk uses the same shared buffer, so decompress after it
+			fat = Mod_DecompressPVS( &world.compressed_fatphs[world.fatphsofs[leaf->cluster + 1]], world.visbytes );
+
+			for( k = 0; k < worldmodel->numleafs; k++ )
+			{
+				if( CHECKVISBIT( exact, k ))
+				{
+					exactbits++;
+
+					if( !CHECKVISBIT( fat, k ))
+						break;
+				}
+
+				if( CHECKVISBIT( fat, k ))
+					fatbits++;
+			}
+
+			if( k < worldmodel->numleafs )
+			{
+				Con_Printf( S_ERROR "leaf %i: fat PHS misses leaf %i at (%g %g %g)\n", i, k + 1, point[0], point[1], point[2] );
+				failed++;
+			}
+
+			tested++;
+		}
+	}
+
+	Con_Printf( "%d points tested, %d failed\n", tested, failed );
+
+	if( exactbits )
+		Con_Printf( "fat PHS marks %.2f%% more leafs than exact walk\n", ( fatbits - exactbits ) * 100.0 / exactbits );
+}
+
 /*
 ======================================================================
 
@@ -2268,9 +2464,6 @@ static void Mod_LoadTextureData( model_t *mod, dbspmodel_t *bmod, int textureInd
 
 	// don't load texture data on dedicated server, as there is no renderer.
 	// but count the wadusage for automatic precache
-	//
-	// FIXME: for ENGINE_IMPROVED_LINETRACE we need to load textures on server too
-	// but there is no facility for this yet
 	texture = mod->textures[textureIndex];
 	mipTex = Mod_GetMipTexForTexture( bmod, textureIndex );
 	usesCustomPalette = Mod_CalcMipTexUsesCustomPalette( mod, bmod, textureIndex );
@@ -2282,9 +2475,6 @@ static void Mod_LoadTextureData( model_t *mod, dbspmodel_t *bmod, int textureInd
 		return;
 	}
 
-	if( FBitSet( host.features, ENGINE_IMPROVED_LINETRACE ) && mipTex->name[0] == '{' )
-		SetBits( txFlags, TF_KEEP_SOURCE ); // Paranoia2 texture alpha-tracing
-
 	// check if this is water to keep the source texture and expand it to RGBA (so ripple effect works)
 	if( Mod_LooksLikeWaterTexture( mipTex->name ))
 		SetBits( txFlags, TF_KEEP_SOURCE | TF_EXPAND_SOURCE );
@@ -2371,7 +2561,6 @@ static void Mod_LoadTextureData( model_t *mod, dbspmodel_t *bmod, int textureInd
 		}
 		else
 		{
-			char texpath[MAX_VA_STRING];
 			int wadIndex;
 			fs_offset_t srcSize = 0;
 			byte* src = NULL;
@@ -2380,11 +2569,11 @@ static void Mod_LoadTextureData( model_t *mod, dbspmodel_t *bmod, int textureInd
 			// doesn't exist there. The original texture is already loaded, but cannot be modified.
 			// Instead, load the original texture again and convert it to luma.
 
-			wadIndex = Mod_FindTextureInWadList( &world.wadlist, texture->name, texpath, sizeof( texpath ));
+			wadIndex = Mod_FindTextureInWadList( &world.wadlist, texture->name, NULL, 0 );
 
 			if( wadIndex >= 0 )
 			{
-				src = FS_LoadFile( texpath, &srcSize, false );
+				src = Mod_LoadWadTexture( texture->name, &srcSize );
 				world.wadlist.wadusage[wadIndex]++;
 			}
 
@@ -2398,6 +2587,72 @@ static void Mod_LoadTextureData( model_t *mod, dbspmodel_t *bmod, int textureInd
 #endif // !XASH_DEDICATED
 }
 
+/*
+=================
+Mod_BuildAlphaMask
+
+validate the miptex and pack its transparent texels into bits
+=================
+*/
+static void Mod_BuildAlphaMask( model_t *mod, mtexture_t *tex, const mip_t *mt, fs_offset_t size )
+{
+	const byte	*pixels;
+	byte		*mask;
+	uint		i, count;
+
+	if( size < (fs_offset_t)sizeof( *mt ) || mt->width != tex->base.width || mt->height != tex->base.height )
+		return;
+
+	count = mt->width * mt->height;
+
+	if( mt->offsets[0] <= 0 || mt->offsets[0] + count > size )
+		return;
+
+	pixels = (const byte *)mt + mt->offsets[0];
+	mask = Mem_Calloc( mod->mempool, ( count + 7 ) / 8 );
+
+	for( i = 0; i < count; i++ )
+	{
+		if( pixels[i] == 255 )
+			SetBits( mask[i >> 3], BIT( i & 7 ));
+	}
+
+	tex->alphamask = mask;
+}
+
+/*
+=================
+Mod_LoadAlphaMask
+
+traces through alpha-tested textures need only transparency,
+get it from the same mip renderer would load, so it works
+without renderer and original buffers
+=================
+*/
+static void Mod_LoadAlphaMask( model_t *mod, dbspmodel_t *bmod, int textureIndex )
+{
+	mtexture_t	*tex = (mtexture_t *)mod->textures[textureIndex];
+	mip_t		*mipTex = Mod_GetMipTexForTexture( bmod, textureIndex );
+	fs_offset_t	srcSize = 0;
+	byte		*src;
+
+	if( !FBitSet( host.features, ENGINE_IMPROVED_LINETRACE ) || mipTex->name[0] != '{' )
+		return;
+
+	if(( r_wadtextures.value && world.wadlist.count > 0 ) || mipTex->offsets[0] <= 0 )
+	{
+		if(( src = Mod_LoadWadTexture( mipTex->name, &srcSize )) != NULL )
+		{
+			Mod_BuildAlphaMask( mod, tex, (mip_t *)src, srcSize );
+			Mem_Free( src );
+			return;
+		}
+	}
+
+	if( mipTex->offsets[0] > 0 )
+		Mod_BuildAlphaMask( mod, tex, mipTex, Mod_CalculateMipTexSize( mipTex, Mod_CalcMipTexUsesCustomPalette( mod, bmod, textureIndex )));
+}
+
 static void Mod_LoadTexture( model_t *mod, dbspmodel_t *bmod, int textureIndex )
 {
 	texture_t *texture;
@@ -2419,7 +2674,7 @@ static void Mod_LoadTexture( model_t *mod, dbspmodel_t *bmod, int textureIndex )
 	if( mipTex->name[0] == '\0' )
 		Q_snprintf( mipTex->name, sizeof( mipTex->name ), "miptex_%i", textureIndex );
 
-	texture = (texture_t *)Mem_Calloc( mod->mempool, sizeof( *texture ));
+	texture = (texture_t *)Mem_Calloc( mod->mempool, sizeof( mtexture_t ));
 	mod->textures[textureIndex] = texture;
 
 	// Ensure texture name is lowercase.
@@ -2429,6 +2684,7 @@ static void Mod_LoadTexture( model_t *mod, dbspmodel_t *bmod, int textureIndex )
 	texture->height = mipTex->height;
 
 	Mod_LoadTextureData( mod, bmod, textureIndex );
+	Mod_LoadAlphaMask( mod, bmod, textureIndex );
 }
 
 static void Mod_LoadAllTextures( model_t *mod, dbspmodel_t *bmod )
@@ -2605,7 +2861,11 @@ static void Mod_LoadTextures( model_t *mod, dbspmodel_t *bmod )
 	mod->textures = (texture_t **)Mem_Calloc( mod->mempool, lump->nummiptex * sizeof( texture_t * ));
 	mod->numtextures = lump->nummiptex;
 
+	// searchpaths could be changed since the last model was loaded
+	Mod_CreateWadIndex( &world.wadlist );
 	Mod_LoadAllTextures( mod, bmod );
+	Mod_FreeWadIndex();
+
 	Mod_SequenceAllAnimatedTextures( mod );
 }
 
@@ -2971,6 +3231,133 @@ static void Mod_LoadLeafs( model_t *mod, dbspmodel_t *bmod )
 		SetBits( world.flags, FWORLD_WATERALPHA );
 }
 
+/*
+===========
+Mod_FatPHS_RecursiveBox
+
+accumulates PHS rows of all leafs touched by box
+===========
+*/
+static void Mod_FatPHS_RecursiveBox( const vec3_t mins, const vec3_t maxs, byte *dst, const byte *phs, size_t rowbytes, mnode_t *node )
+{
+	int	sides;
+
+	while( node->contents >= 0 )
+	{
+		sides = BOX_ON_PLANE_SIDE( mins, maxs, node->plane );
+
+		if( sides == 1 )
+			node = node->children[0];
+		else if( sides == 2 )
+			node = node->children[1];
+		else
+		{
+			// go down both sides
+			Mod_FatPHS_RecursiveBox( mins, maxs, dst, phs, rowbytes, node->children[0] );
+			node = node->children[1];
+		}
+	}
+
+	if(((mleaf_t *)node)->cluster >= 0 )
+		Q_memor( dst, &phs[rowbytes * ((mleaf_t *)node)->cluster + rowbytes], rowbytes );
+}
+
+/*
+===========
+Mod_CalcFatPHS
+
+Merges PHS rows of every leaf within FATPHS_RADIUS
+of any point in the leaf, so Mod_FatPVS don't have
+to walk the tree on each sound or event
+===========
+*/
+static void Mod_CalcFatPHS( model_t *mod, const byte *uncompressed_phs, size_t rowbytes, size_t count )
+{
+	size_t hashsize = 256;
+	size_t total_compressed_size = 0;
+	size_t unique = 0;
+	int *hashtable;
+	size_t *rowsizes;
+	byte *row;
+	double t1, t2;
+	int i;
+
+	t1 = Platform_DoubleTime();
+
+	// keep hash table at most half full
+	while( hashsize < count * 2 )
+		hashsize <<= 1;
+
+	row = Mem_Malloc( mod->mempool, rowbytes );
+	rowsizes = Mem_Malloc( mod->mempool, sizeof( *rowsizes ) * count );
+	hashtable = Mem_Malloc( mod->mempool, sizeof( *hashtable ) * hashsize );
+	memset( hashtable, 0xFF, sizeof( *hashtable ) * hashsize );
+
+	world.fatphsofs = Mem_Calloc( mod->mempool, sizeof( size_t ) * count );
+	world.compressed_fatphs = NULL;
+
+	for( i = 0; i < count; i++ )
+	{
+		byte temp_compressed_row[(MAX_MAP_LEAFS+1)/4];
+		const mleaf_t *leaf = &mod->leafs[i];
+		size_t compressed_size;
+		uint32_t hash;
+		vec3_t mins, maxs;
+		int j;
+
+		memcpy( row, &uncompressed_phs[rowbytes * i], rowbytes );
+
+		if( leaf->cluster >= 0 )
+		{
+			for( j = 0; j < 3; j++ )
+			{
+				mins[j] = leaf->minmaxs[j+0] - FATPHS_RADIUS;
+				maxs[j] = leaf->minmaxs[j+3] + FATPHS_RADIUS;
+			}
+
+			Mod_FatPHS_RecursiveBox( mins, maxs, row, uncompressed_phs, rowbytes, mod->nodes );
+		}
+
+		compressed_size = Mod_CompressPVS( temp_compressed_row, row, rowbytes );
+		CRC32_Init( &hash );
+		CRC32_ProcessBuffer( &hash, temp_compressed_row, compressed_size );
+		hash = CRC32_Final( hash );
+
+		// reuse identical row if we already have one
+		for( j = hash & ( hashsize - 1 ); hashtable[j] != -1; j = ( j + 1 ) & ( hashsize - 1 ))
+		{
+			int other = hashtable[j];
+
+			if( rowsizes[other] == compressed_size && !memcmp( &world.compressed_fatphs[world.fatphsofs[other]], temp_compressed_row, compressed_size ))
+				break;
+		}
+
+		if( hashtable[j] != -1 )
+		{
+			world.fatphsofs[i] = world.fatphsofs[hashtable[j]];
+			continue;
+		}
+
+		world.compressed_fatphs = Mem_Realloc( mod->mempool, world.compressed_fatphs, total_compressed_size + compressed_size );
+		memcpy( &world.compressed_fatphs[total_compressed_size], temp_compressed_row, compressed_size );
+		world.fatphsofs[i] = total_compressed_size;
+		rowsizes[i] = compressed_size;
+		hashtable[j] = i;
+
+		total_compressed_size += compressed_size;
+		unique++;
+	}
+
+	Mem_Free( hashtable );
+	Mem_Free( rowsizes );
+	Mem_Free( row );
+
+	t2 = Platform_DoubleTime();
+
+	Con_Reportf( "Compressed fat PHS size: %s, %zu unique rows of %zu\n", Q_memprint( total_compressed_size + sizeof( *world.fatphsofs ) * count ), unique, count );
+	Con_Reportf( "Fat PHS building time: %.2f ms\n", ( t2 - t1 ) * 1000.0f );
+}
+
 /*
 ===========
 Mod_CalcPHS
@@ -3112,6 +3499,8 @@ static void Mod_CalcPHS( model_t *mod )
 	// FS_WriteFile( "op4_bootcamp.pvs", uncompressed_pvs, rowbytes * count );
 	// FS_WriteFile( "op4_bootcamp.phs", uncompressed_phs, rowbytes * count );
 
+	Mod_CalcFatPHS( mod, uncompressed_phs, rowbytes, count );
+
 	// release uncompressed data
 	Mem_Free( uncompressed_pvs );
 
@@ -3831,3 +4220,112 @@ int GAME_EXPORT Mod_SaveLump( const char *filename, const int lump, void *lumpda
 	FS_Close( f );
 	return LUMP_SAVE_OK;
 }
+
+#if XASH_ENGINE_TESTS
+#include "tests.h"
+
+static void Test_Mod_BuildAlphaMask( void )
+{
+	struct
+	{
+		mip_t	mip;
+		byte	pixels[8 * 4];
+	} data;
+	model_t		mod;
+	mtexture_t	tex;
+	int		i;
+
+	memset( &data, 0, sizeof( data ));
+	memset( &mod, 0, sizeof( mod ));
+	memset( &tex, 0, sizeof( tex ));
+
+	mod.mempool = host.mempool;
+	tex.base.width = data.mip.width = 8;
+	tex.base.height = data.mip.height = 4;
+	data.mip.offsets[0] = sizeof( data.mip );
+	data.pixels[0] = data.pixels[9] = data.pixels[31] = 255;
+
+	// truncated lump
+	Mod_BuildAlphaMask( &mod, &tex, &data.mip, sizeof( data ) - 1 );
+	TASSERT( tex.alphamask == NULL );
+
+	// size differs from bsp
+	tex.base.height = 8;
+	Mod_BuildAlphaMask( &mod, &tex, &data.mip, sizeof( data ));
+	TASSERT( tex.alphamask == NULL );
+	tex.base.height = 4;
+
+	Mod_BuildAlphaMask( &mod, &tex, &data.mip, sizeof( data ));
+	TASSERT( tex.alphamask != NULL );
+
+	if( tex.alphamask )
+	{
+		TASSERT_EQi( tex.alphamask[0], 0x01 );
+		TASSERT_EQi( tex.alphamask[1], 0x02 );
+		TASSERT_EQi( tex.alphamask[2], 0x00 );
+		TASSERT_EQi( tex.alphamask[3], 0x80 );
+		Mem_Free( tex.alphamask );
+	}
+
+	for( i = 0; i < 3; i++ )
+		data.pixels[i] = 255;
+	data.mip.offsets[0] = 0;
+	tex.alphamask = NULL;
+	Mod_BuildAlphaMask( &mod, &tex, &data.mip, sizeof( data ));
+	TASSERT( tex.alphamask == NULL );
+}
+
+void Test_RunModel( void )
+{
+	TRUN( Test_Mod_BuildAlphaMask() );
+}
+
+#define BENCH_PVS_LEAFS	8192
+#define BENCH_PVS_ROWS	64
+
+typedef struct bench_pvs_s
+{
+	byte	*rows[BENCH_PVS_ROWS];
+	byte	data[BENCH_PVS_ROWS][BENCH_PVS_LEAFS / 8 * 2];
+} bench_pvs_t;
+
+static void Bench_Mod_DecompressPVS( void *data, int count )
+{
+	bench_pvs_t *b = data;
+	int i;
+
+	for( i = 0; i < count; i++ )
+		bench_sink += *Mod_DecompressPVS( b->rows[i % BENCH_PVS_ROWS], BENCH_PVS_LEAFS / 8 );
+}
+
+void Bench_RunModel( void )
+{
+	bench_pvs_t *b = Mem_Calloc( host.mempool, sizeof( *b ));
+	byte row[BENCH_PVS_LEAFS / 8];
+	uint seed = 0x7654321;
+	int i, j;
+
+	// large map rows, every leaf sees few runs of neighbour leafs
+	for( i = 0; i < BENCH_PVS_ROWS; i++ )
+	{
+		memset( row, 0, sizeof( row ));
+
+		for( j = 0; j < 6; j++ )
+		{
+			int start, len;
+
+			seed = seed * 1103515245 + 12345;
+			start = ( seed >> 8 ) % sizeof( row );
+			len = Q_min( 4 + ( seed >> 24 ) % 48, sizeof( row ) - start );
+			memset( &row[start], 0x5b ^ j, len );
+		}
+
+		Mod_CompressPVS( b->data[i], row, sizeof( row ));
+		b->rows[i] = b->data[i];
+	}
+
+	Bench_Run( "Mod_DecompressPVS", Bench_Mod_DecompressPVS, b, 1000 );
+
+	Mem_Free( b );
+}
+#endif // XASH_ENGINE_TESTS
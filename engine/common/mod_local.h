@@ -83,6 +83,14 @@ typedef struct
 	uint		num_polys;
 } hull_model_t;
 
+// brush textures are allocated with engine private data
+// following the texture_t that renderers and game dlls see
+typedef struct mtexture_s
+{
+	texture_t		base;
+	byte		*alphamask;	// bit per texel of '{' texture, set where it's transparent
+} mtexture_t;
+
 typedef struct wadlist_s
 {
 	char			wadnames[MAX_MAP_WADS][32];
@@ -126,6 +134,10 @@ typedef struct world_static_s
 	byte   *compressed_phs;
 	size_t *phsofs;
 
+	// PHS merged over FATPHS_RADIUS around each leaf, rows are shared
+	byte   *compressed_fatphs;
+	size_t *fatphsofs;
+
 	wadlist_t wadlist;
 } world_static_t;
 
@@ -176,6 +188,7 @@ int Mod_SaveLump( const char *filename, const int lump, void *lumpdata, int lump
 mleaf_t *Mod_PointInLeaf( const vec3_t p, mnode_t *node );
 int Mod_SampleSizeForFace( const msurface_t *surf );
 byte *Mod_GetPVSForPoint( const vec3_t p );
+void Mod_ValidateFatPHS_f( void );
 void Mod_UnloadBrushModel( model_t *mod );
 void Mod_PrintWorldStats_f( void );
 
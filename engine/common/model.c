@@ -119,6 +119,8 @@ void Mod_FreeModel( model_t *mod )
 		world.hull_models = NULL;
 		world.compressed_phs = NULL;
 		world.phsofs = NULL;
+		world.compressed_fatphs = NULL;
+		world.fatphsofs = NULL;
 	}
 
 	memset( mod, 0, sizeof( *mod ));
@@ -145,6 +147,7 @@ void Mod_Init( void )
 
 	Cmd_AddCommand( "mapstats", Mod_PrintWorldStats_f, "show stats for currently loaded map" );
 	Cmd_AddCommand( "modellist", Mod_Modellist_f, "display loaded models list" );
+	Cmd_AddCommand( "fatphs_validate", Mod_ValidateFatPHS_f, "compare precomputed fat PHS against exact tree walk, optionally takes samples per leaf count" );
 
 	Mod_ResetStudioAPI ();
 	Mod_InitStudioHull ();
@@ -160,6 +160,18 @@ void MSG_InitMasks( void )
 		ExtraMasks[maskBit] = (uint)BIT( maskBit ) - 1;
 }
 
+static inline uint64_t MSG_LoadQword( const byte *p )
+{
+	uint64_t v;
+	memcpy( &v, p, sizeof( v ));
+	return v;
+}
+
+static inline void MSG_StoreQword( byte *p, uint64_t v )
+{
+	memcpy( p, &v, sizeof( v ));
+}
+
 void MSG_WriteUBitLong( sizebuf_t *sb, uint curData, int numbits )
 {
 	Assert( numbits >= 0 && numbits <= 32 );
@@ -170,6 +182,18 @@ void MSG_WriteUBitLong( sizebuf_t *sb, uint curData, int numbits )
 		sb->bOverflow = true;
 		sb->iCurBit = sb->nDataBits;
 	}
+#if XASH_LITTLE_ENDIAN
+	else if( likely(( sb->iCurBit >> 3 ) + (int)sizeof( uint64_t ) <= MSG_GetMaxBytes( sb )))
+	{
+		// at most 39 bits touched, so one unaligned qword does it
+		byte	*p = sb->pData + ( sb->iCurBit >> 3 );
+		int	shift = sb->iCurBit & 7;
+		uint64_t	mask = (((uint64_t)1 << numbits ) - 1 ) << shift;
+
+		MSG_StoreQword( p, ( MSG_LoadQword( p ) & ~mask ) | ((uint64_t)curData << shift & mask ));
+		sb->iCurBit += numbits;
+	}
+#endif
 	else
 	{
 		int	nBitsLeft = numbits;
@@ -242,11 +266,166 @@ void MSG_WriteBitLong( sizebuf_t *sb, uint data, int numbits, qboolean bSigned )
 	else MSG_WriteUBitLong( sb, data, numbits );
 }
 
+#if XASH_LITTLE_ENDIAN
+/*
+=======================
+MSG_WriteBitsFast
+
+caller checks for room. Byte aligned cursor is plain memcpy,
+otherwise source words are shifted through 64-bit accumulator
+and only whole bytes are stored, first and last byte keep
+their bits outside of written range
+=======================
+*/
+static void MSG_WriteBitsFast( sizebuf_t *sb, const byte *pIn, int nBits )
+{
+	byte	*pOut = sb->pData + ( sb->iCurBit >> 3 );
+	int	shift = sb->iCurBit & 7;
+	int	nBytes = nBits >> 3, nTail = nBits & 7;
+	uint64_t	acc;
+	int	accbits;
+
+	sb->iCurBit += nBits;
+
+	if( !shift )
+	{
+		memcpy( pOut, pIn, nBytes );
+
+		if( nTail )
+			pOut[nBytes] = ( pOut[nBytes] & ~( BIT( nTail ) - 1 )) | ( pIn[nBytes] & ( BIT( nTail ) - 1 ));
+		return;
+	}
+
+	acc = *pOut & ( BIT( shift ) - 1 );
+	accbits = shift;
+
+	for( ; nBytes >= 4; nBytes -= 4, pIn += 4, pOut += 4 )
+	{
+		uint32_t w;
+
+		memcpy( &w, pIn, sizeof( w ));
+		acc |= (uint64_t)w << accbits;
+		memcpy( pOut, &acc, sizeof( w ));
+		acc >>= 32;
+	}
+
+	for( ; nBytes > 0; nBytes--, pIn++, pOut++ )
+	{
+		acc |= (uint64_t)*pIn << accbits;
+		*pOut = (byte)acc;
+		acc >>= 8;
+	}
+
+	if( nTail )
+	{
+		acc |= (uint64_t)( *pIn & ( BIT( nTail ) - 1 )) << accbits;
+		accbits += nTail;
+	}
+
+	// flush what's left, less than two bytes
+	if( accbits >= 8 )
+	{
+		*pOut++ = (byte)acc;
+		acc >>= 8;
+		accbits -= 8;
+	}
+
+	if( accbits )
+		*pOut = ( *pOut & ~( BIT( accbits ) - 1 )) | (byte)acc;
+}
+
+/*
+=======================
+MSG_ReadBitsFast
+
+caller checks for data, never reads past last byte
+of requested range. Partial last byte is zero extended
+=======================
+*/
+static void MSG_ReadBitsFast( sizebuf_t *sb, byte *pOut, int nBits )
+{
+	const byte	*pIn = sb->pData + ( sb->iCurBit >> 3 );
+	const byte	*pEnd = sb->pData + BitByte( sb->iCurBit + nBits );
+	int	shift = sb->iCurBit & 7;
+	int	nBytes = nBits >> 3, nTail = nBits & 7;
+	uint64_t	acc;
+	int	accbits;
+
+	sb->iCurBit += nBits;
+
+	if( !shift )
+	{
+		memcpy( pOut, pIn, nBytes );
+
+		if( nTail )
+			pOut[nBytes] = pIn[nBytes] & ( BIT( nTail ) - 1 );
+		return;
+	}
+
+	acc = *pIn++ >> shift;
+	accbits = 8 - shift;
+
+	for( ; nBytes >= 4; nBytes -= 4, pOut += 4 )
+	{
+		uint32_t w;
+
+		if( accbits < 32 && pIn + sizeof( w ) <= pEnd )
+		{
+			memcpy( &w, pIn, sizeof( w ));
+			acc |= (uint64_t)w << accbits;
+			accbits += 32;
+			pIn += sizeof( w );
+		}
+
+		// near the end refill by bytes, to not read past the range
+		while( accbits < 32 )
+		{
+			acc |= (uint64_t)*pIn++ << accbits;
+			accbits += 8;
+		}
+
+		w = (uint32_t)acc;
+		memcpy( pOut, &w, sizeof( w ));
+		acc >>= 32;
+		accbits -= 32;
+	}
+
+	for( ; nBytes > 0; nBytes--, pOut++ )
+	{
+		if( accbits < 8 )
+		{
+			acc |= (uint64_t)*pIn++ << accbits;
+			accbits += 8;
+		}
+
+		*pOut = (byte)acc;
+		acc >>= 8;
+		accbits -= 8;
+	}
+
+	if( nTail )
+	{
+		if( accbits < nTail )
+			acc |= (uint64_t)*pIn << accbits;
+
+		*pOut = acc & ( BIT( nTail ) - 1 );
+	}
+}
+#endif // XASH_LITTLE_ENDIAN
+
 qboolean MSG_WriteBits( sizebuf_t *sb, const void *pData, int nBits )
 {
 	byte	*pOut = (byte *)pData;
 	int	nBitsLeft = nBits;
 
+#if XASH_LITTLE_ENDIAN
+	if( nBits > 0 && sb->iCurBit + nBits <= sb->nDataBits )
+	{
+		MSG_WriteBitsFast( sb, pData, nBits );
+		return !sb->bOverflow;
+	}
+#endif
+
 	// get output dword-aligned.
 	while((( uint32_t )pOut & 3 ) != 0 && nBitsLeft >= 8 )
 	{
@@ -455,6 +634,17 @@ uint MSG_ReadUBitLong( sizebuf_t *sb, int numbits )
 
 	Assert( numbits > 0 && numbits <= 32 );
 
+#if XASH_LITTLE_ENDIAN
+	if( likely(( sb->iCurBit >> 3 ) + (int)sizeof( uint64_t ) <= MSG_GetMaxBytes( sb )))
+	{
+		uint64_t qword = MSG_LoadQword( sb->pData + ( sb->iCurBit >> 3 ));
+
+		ret = ( qword >> ( sb->iCurBit & 7 )) & ((((uint64_t)1 ) << numbits ) - 1 );
+		sb->iCurBit += numbits;
+		return ret;
+	}
+#endif
+
 	// Read the current dword.
 	idword1 = sb->iCurBit >> 5;
 	dword1 = ((uint *)sb->pData)[idword1];
@@ -486,6 +676,16 @@ qboolean MSG_ReadBits( sizebuf_t *sb, void *pOutData, int nBits )
 	byte	*pOut = (byte *)pOutData;
 	int	nBitsLeft = nBits;
 
+#if XASH_LITTLE_ENDIAN
+	// near the end of message the per byte reads have
+	// their own rules, leave it to them
+	if( nBits > 0 && sb->iCurBit + nBits <= sb->nDataBits )
+	{
+		MSG_ReadBitsFast( sb, pOut, nBits );
+		return !sb->bOverflow;
+	}
+#endif
+
 	// get output dword-aligned.
 	while((( uint32_t )pOut & 3) != 0 && nBitsLeft >= 8 )
 	{
@@ -868,14 +1068,258 @@ static void Test_Buffer_ExciseBits( void )
 	TASSERT_EQi( MSG_ReadUBitLong( &sb, 4 ), 0xa );
 }
 
+#define TEST_RANDOM_OPS	512
+
+typedef struct
+{
+	int	type; // 0 - bit long, 1 - bits, 2 - string
+	int	offset; // in test pool
+	int	numbits;
+	uint	value;
+} test_bufop_t;
+
+static uint Test_Buffer_Random( uint *seed )
+{
+	*seed = *seed * 1664525u + 1013904223u;
+	return *seed >> 8;
+}
+
+/*
+=======================
+Test_Buffer_RoundTrip
+
+random fields of random widths written by MSG functions
+and by bit per bit reference writer into same garbage,
+must give same bits and read back as they were written
+=======================
+*/
+static void Test_Buffer_RoundTrip( uint seed )
+{
+	static test_bufop_t ops[TEST_RANDOM_OPS];
+	byte pool[256], a[300], b[300], out[32];
+	sizebuf_t sa, sb, sr;
+	int i, j, numops;
+
+	for( i = 0; i < sizeof( pool ); i++ )
+		pool[i] = Test_Buffer_Random( &seed );
+
+	for( i = 0; i < sizeof( a ); i++ )
+		a[i] = b[i] = Test_Buffer_Random( &seed );
+
+	MSG_Init( &sa, __func__, a, sizeof( a ) - 4 );
+	MSG_Init( &sb, __func__, b, sizeof( b ) - 4 );
+
+	for( numops = 0; numops < TEST_RANDOM_OPS; numops++ )
+	{
+		test_bufop_t *op = &ops[numops];
+
+		op->type = Test_Buffer_Random( &seed ) % 3;
+
+		if( op->type == 0 )
+		{
+			op->numbits = Test_Buffer_Random( &seed ) % 32 + 1;
+			op->value = ( Test_Buffer_Random( &seed ) << 16 ) ^ Test_Buffer_Random( &seed );
+			if( op->numbits < 32 )
+				op->value &= BIT( op->numbits ) - 1;
+		}
+		else
+		{
+			op->numbits = Test_Buffer_Random( &seed ) % 200 + 1;
+			op->offset = Test_Buffer_Random( &seed ) % ( sizeof( pool ) - 32 );
+			if( op->type == 2 )
+				op->numbits = ( op->numbits % 24 + 1 ) << 3;
+		}
+
+		if( sa.iCurBit + op->numbits > sa.nDataBits )
+			break;
+
+		if( op->type == 0 )
+		{
+			MSG_WriteUBitLong( &sa, op->value, op->numbits );
+
+			for( j = 0; j < op->numbits; j++ )
+				MSG_WriteOneBit( &sb, ( op->value >> j ) & 1 );
+		}
+		else if( op->type == 1 )
+		{
+			MSG_WriteBits( &sa, pool + op->offset, op->numbits );
+
+			for( j = 0; j < op->numbits; j++ )
+				MSG_WriteOneBit( &sb, ( pool[op->offset + ( j >> 3 )] >> ( j & 7 )) & 1 );
+		}
+		else
+		{
+			char str[32];
+			int len = ( op->numbits >> 3 ) - 1;
+
+			for( j = 0; j < len; j++ )
+				str[j] = 'a' + pool[op->offset + j] % 26;
+			str[len] = 0;
+
+			MSG_WriteString( &sa, str );
+
+			for( j = 0; j < op->numbits; j++ )
+				MSG_WriteOneBit( &sb, ( str[j >> 3] >> ( j & 7 )) & 1 );
+		}
+	}
+
+	TASSERT_EQi( sa.bOverflow, false );
+	TASSERT_EQi( sa.iCurBit, sb.iCurBit );
+	TASSERT( !memcmp( a, b, sa.iCurBit >> 3 ));
+
+	if( sa.iCurBit & 7 )
+	{
+		TASSERT_EQi( a[sa.iCurBit >> 3] & ( BIT( sa.iCurBit & 7 ) - 1 ), b[sa.iCurBit >> 3] & ( BIT( sa.iCurBit & 7 ) - 1 ));
+	}
+
+	// bytes past last written dword are never touched
+	TASSERT( !memcmp( a + sizeof( a ) - 4, b + sizeof( b ) - 4, 4 ));
+
+	MSG_StartReading( &sr, a, -1, 0, sa.iCurBit );
+
+	for( i = 0; i < numops; i++ )
+	{
+		const test_bufop_t *op = &ops[i];
+
+		if( op->type == 0 )
+		{
+			TASSERT_EQi( MSG_ReadUBitLong( &sr, op->numbits ), op->value );
+		}
+		else if( op->type == 1 )
+		{
+			int tail = op->numbits & 7, len = op->numbits >> 3;
+
+			MSG_ReadBits( &sr, out, op->numbits );
+			TASSERT( !memcmp( out, pool + op->offset, len ));
+			if( tail )
+			{
+				TASSERT_EQi( out[len], pool[op->offset + len] & ( BIT( tail ) - 1 ));
+			}
+		}
+		else
+		{
+			const char *str = MSG_ReadString( &sr );
+
+			TASSERT_EQi( (int)Q_strlen( str ), ( op->numbits >> 3 ) - 1 );
+			TASSERT_EQi( str[0], 'a' + pool[op->offset] % 26 );
+		}
+	}
+
+	TASSERT_EQi( sr.bOverflow, false );
+	TASSERT_EQi( MSG_GetNumBitsLeft( &sr ), 0 );
+}
+
 void Test_RunBuffer( void )
 {
+	uint i;
+
 	MSG_InitMasks();
 
 	TRUN( Test_Buffer_BitByte( ));
 	TRUN( Test_Buffer_Write( ));
 	TRUN( Test_Buffer_Read( ));
 	TRUN( Test_Buffer_ExciseBits( ));
+
+	for( i = 1; i <= 8; i++ )
+		TRUN( Test_Buffer_RoundTrip( i * 0x9e3779b9u ));
+}
+
+#define BENCH_BUFFER_SIZE	0x4000
+
+static byte g_benchbuf[BENCH_BUFFER_SIZE];
+
+static void Bench_Buffer_WriteUBitLong( void *data, int count )
+{
+	sizebuf_t sb;
+	int i;
+
+	MSG_Init( &sb, __func__, g_benchbuf, sizeof( g_benchbuf ));
+
+	for( i = 0; i < count; i++ )
+	{
+		int bits = ( i % 32 ) + 1;
+		uint mask = bits == 32 ? ~0u : BIT( bits ) - 1;
+
+		// all widths at all alignments, as delta fields are written
+		if( sb.iCurBit + bits > sb.nDataBits )
+			MSG_SeekToBit( &sb, 0, SEEK_SET );
+
+		MSG_WriteUBitLong( &sb, ( i * 2654435761u ) & mask, bits );
+	}
+
+	bench_sink += sb.iCurBit;
+}
+
+static void Bench_Buffer_ReadUBitLong( void *data, int count )
+{
+	sizebuf_t sb;
+	uint sum = 0;
+	int i;
+
+	MSG_StartReading( &sb, g_benchbuf, sizeof( g_benchbuf ), 0, -1 );
+
+	for( i = 0; i < count; i++ )
+	{
+		int bits = ( i % 32 ) + 1;
+
+		if( sb.iCurBit + bits > sb.nDataBits )
+			MSG_SeekToBit( &sb, 0, SEEK_SET );
+
+		sum += MSG_ReadUBitLong( &sb, bits );
+	}
+
+	bench_sink += sum;
+}
+
+#define BENCH_BUFFER_BLOCK	1400	// typical datagram payload
+
+// unaligned splice of a datagram sized block, as multicast and user messages are
+static void Bench_Buffer_WriteBits( void *data, int count )
+{
+	sizebuf_t sb;
+	int i;
+
+	MSG_Init( &sb, __func__, g_benchbuf, sizeof( g_benchbuf ));
+
+	for( i = 0; i < count; i++ )
+	{
+		MSG_SeekToBit( &sb, ( i & 7 ) + 8, SEEK_SET );
+		MSG_WriteBits( &sb, data, BENCH_BUFFER_BLOCK << 3 );
+	}
+
+	bench_sink += sb.iCurBit;
+}
+
+static void Bench_Buffer_ReadBits( void *data, int count )
+{
+	sizebuf_t sb;
+	int i;
+
+	MSG_StartReading( &sb, g_benchbuf, sizeof( g_benchbuf ), 0, -1 );
+
+	for( i = 0; i < count; i++ )
+	{
+		MSG_SeekToBit( &sb, ( i & 7 ) + 8, SEEK_SET );
+		MSG_ReadBits( &sb, data, BENCH_BUFFER_BLOCK << 3 );
+	}
+
+	bench_sink += ((byte *)data)[0];
+}
+
+void Bench_RunBuffer( void )
+{
+	byte block[BENCH_BUFFER_BLOCK];
+	int i;
+
+	MSG_InitMasks();
+
+	for( i = 0; i < sizeof( block ); i++ )
+		block[i] = ( i * 2654435761u ) >> 24;
+
+	Bench_Run( "MSG_WriteUBitLong", Bench_Buffer_WriteUBitLong, NULL, 100000 );
+	Bench_Run( "MSG_ReadUBitLong", Bench_Buffer_ReadUBitLong, NULL, 100000 );
+	Bench_Run( "MSG_WriteBits 1400b", Bench_Buffer_WriteBits, block, 1000 );
+	Bench_Run( "MSG_ReadBits 1400b", Bench_Buffer_ReadBits, block, 1000 );
 }
 
 #endif // XASH_ENGINE_TESTS
@@ -1523,6 +1523,8 @@ void Netchan_TransmitBits( netchan_t *chan, int length, byte *data )
 	if( chan->incoming_acknowledged > chan->last_reliable_sequence && chan->incoming_reliable_acknowledged != chan->reliable_sequence )
 		send_reliable = true;
 
+	chan->last_resend = send_reliable;
+
 	// A packet can have "reliable payload + frag payload + unreliable payload
 	// frag payload can be a file chunk, if so, it needs to be parsed on the receiving end and reliable payload + unreliable payload need
 	// to be passed on to the message queue.  The processing routine needs to be able to handle the case where a message comes in and a file
@@ -1740,6 +1742,9 @@ void Netchan_TransmitBits( netchan_t *chan, int length, byte *data )
 		chan->last_reliable_sequence = chan->outgoing_sequence - 1;
 	}
 
+	chan->last_reliable_bytes = send_reliable ? BitByte( chan->reliable_length ) : 0;
+	chan->last_fragment = send_reliable && send_reliable_fragment;
+
 	if( length )
 	{
 		int maxsize = NET_MAX_MESSAGE;
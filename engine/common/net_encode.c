@@ -2334,4 +2334,146 @@ void Test_RunDelta( void )
 	Con_Printf( "from.dt_byte_unsigned = %i\n", from.dt_byte_unsigned );
 	Con_Printf( "to.dt_byte_unsigned   = %i\n", to.dt_byte_unsigned );
 }
+
+typedef struct bench_delta_s
+{
+	delta_info_t	*dt;
+	entity_state_t	from[16];
+	entity_state_t	to[16];
+	byte		buffer[0x4000];
+} bench_delta_t;
+
+/*
+=================
+Test_InitDeltaEntityState
+
+delta.lst isn't loaded in tests, use stock entity_state_t layout,
+returns true if table was set up here and must be shut down
+=================
+*/
+qboolean Test_InitDeltaEntityState( void )
+{
+	delta_info_t *dt = &dt_info[DT_ENTITY_STATE_T];
+
+	if( dt->bInitialized )
+		return false;
+
+	Delta_AddField( dt, "animtime", DT_TIMEWINDOW_8, 8, 1.0f, 1.0f );
+	Delta_AddField( dt, "frame", DT_FLOAT, 10, 4.0f, 1.0f );
+	Delta_AddField( dt, "origin[0]", DT_SIGNED | DT_FLOAT, 21, 8.0f, 1.0f );
+	Delta_AddField( dt, "origin[1]", DT_SIGNED | DT_FLOAT, 21, 8.0f, 1.0f );
+	Delta_AddField( dt, "origin[2]", DT_SIGNED | DT_FLOAT, 21, 8.0f, 1.0f );
+	Delta_AddField( dt, "angles[0]", DT_ANGLE, 16, 1.0f, 1.0f );
+	Delta_AddField( dt, "angles[1]", DT_ANGLE, 16, 1.0f, 1.0f );
+	Delta_AddField( dt, "angles[2]", DT_ANGLE, 16, 1.0f, 1.0f );
+	Delta_AddField( dt, "sequence", DT_INTEGER, 8, 1.0f, 1.0f );
+	Delta_AddField( dt, "modelindex", DT_INTEGER, 10, 1.0f, 1.0f );
+	Delta_AddField( dt, "movetype", DT_INTEGER, 4, 1.0f, 1.0f );
+	Delta_AddField( dt, "solid", DT_SHORT, 3, 1.0f, 1.0f );
+	Delta_AddField( dt, "skin", DT_SHORT | DT_SIGNED, 9, 1.0f, 1.0f );
+	Delta_AddField( dt, "effects", DT_INTEGER, 8, 1.0f, 1.0f );
+	Delta_AddField( dt, "body", DT_INTEGER, 8, 1.0f, 1.0f );
+	Delta_AddField( dt, "rendermode", DT_INTEGER, 8, 1.0f, 1.0f );
+	Delta_AddField( dt, "renderamt", DT_INTEGER, 8, 1.0f, 1.0f );
+	Delta_AddField( dt, "framerate", DT_SIGNED | DT_FLOAT, 8, 16.0f, 1.0f );
+	Delta_AddField( dt, "controller[0]", DT_BYTE, 8, 1.0f, 1.0f );
+	Delta_AddField( dt, "controller[1]", DT_BYTE, 8, 1.0f, 1.0f );
+	Delta_AddField( dt, "blending[0]", DT_BYTE, 8, 1.0f, 1.0f );
+	Delta_AddField( dt, "velocity[0]", DT_SIGNED | DT_FLOAT, 16, 8.0f, 1.0f );
+	Delta_AddField( dt, "velocity[1]", DT_SIGNED | DT_FLOAT, 16, 8.0f, 1.0f );
+	Delta_AddField( dt, "velocity[2]", DT_SIGNED | DT_FLOAT, 16, 8.0f, 1.0f );
+	Delta_AddField( dt, "scale", DT_FLOAT, 16, 256.0f, 1.0f );
+
+	dt->bInitialized = true;
+	return true;
+}
+
+static void Bench_Delta_InitEntities( bench_delta_t *b )
+{
+	int i;
+
+	Test_InitDeltaEntityState();
+	b->dt = &dt_info[DT_ENTITY_STATE_T];
+
+	// moving and animating entities, half of fields are changed
+	for( i = 0; i < ARRAYSIZE( b->from ); i++ )
+	{
+		entity_state_t *from = &b->from[i], *to = &b->to[i];
+
+		memset( from, 0, sizeof( *from ));
+		from->number = i + 1;
+		from->modelindex = 10 + i;
+		from->sequence = i & 7;
+		from->scale = 1.0f;
+		VectorSet( from->origin, 100.0f * i, -50.0f * i, 16.0f );
+		VectorSet( from->angles, 0.0f, 15.0f * i, 0.0f );
+
+		*to = *from;
+		to->animtime = 10.0f + i * 0.01f;
+		to->frame = ( i * 7 ) % 255;
+		to->origin[0] += 4.125f;
+		to->origin[1] -= 2.5f;
+		to->angles[1] += 2.8125f;
+		VectorSet( to->velocity, 250.0f, -120.0f, 0.0f );
+		to->controller[0] = i * 16;
+	}
+}
+
+static void Bench_Delta_Write( void *data, int count )
+{
+	bench_delta_t *b = data;
+	sizebuf_t msg;
+	int i, j;
+
+	for( i = 0; i < count; i++ )
+	{
+		const entity_state_t *from = &b->from[i % ARRAYSIZE( b->from )];
+		const entity_state_t *to = &b->to[i % ARRAYSIZE( b->to )];
+
+		MSG_Init( &msg, __func__, b->buffer, sizeof( b->buffer ));
+
+		for( j = 0; j < b->dt->numFields; j++ )
+			Delta_WriteField( &msg, &b->dt->pFields[j], from, to, 10.0 );
+	}
+
+	bench_sink += MSG_GetNumBitsWritten( &msg );
+}
+
+static void Bench_Delta_Read( void *data, int count )
+{
+	bench_delta_t *b = data;
+	const entity_state_t *from = &b->from[0];
+	entity_state_t to;
+	sizebuf_t msg;
+	int i, j;
+
+	// encode single update and decode it over and over
+	MSG_Init( &msg, __func__, b->buffer, sizeof( b->buffer ));
+
+	for( j = 0; j < b->dt->numFields; j++ )
+		Delta_WriteField( &msg, &b->dt->pFields[j], from, &b->to[0], 10.0 );
+
+	for( i = 0; i < count; i++ )
+	{
+		MSG_SeekToBit( &msg, 0, SEEK_SET );
+
+		for( j = 0; j < b->dt->numFields; j++ )
+			Delta_ReadField( &msg, &b->dt->pFields[j], from, &to, 10.0 );
+	}
+
+	bench_sink += to.modelindex;
+}
+
+void Bench_RunDelta( void )
+{
+	bench_delta_t *b = Mem_Calloc( host.mempool, sizeof( *b ));
+
+	MSG_InitMasks();
+	Bench_Delta_InitEntities( b );
+
+	Bench_Run( "Delta_WriteEntity", Bench_Delta_Write, b, 10000 );
+	Bench_Run( "Delta_ReadEntity", Bench_Delta_Read, b, 10000 );
+
+	Mem_Free( b );
+}
 #endif // XASH_ENGINE_TESTS
@@ -275,6 +275,11 @@ typedef struct netchan_s
 	// incoming and outgoing flow metrics
 	flow_t		flow[MAX_FLOWS];
 
+	// last transmitted packet, for server telemetry
+	int		last_reliable_bytes;	// reliable payload including fragments
+	qboolean		last_resend;		// reliable payload was resent because remote side dropped it
+	qboolean		last_fragment;		// reliable payload carried fragments
+
 	// added for net_speeds
 	size_t		total_sended;
 	size_t		total_received;
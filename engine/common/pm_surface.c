@@ -16,7 +16,7 @@ GNU General Public License for more details.
 #include "common.h"
 #include "xash3d_mathlib.h"
 #include "pm_local.h"
-#include "ref_common.h"
+#include "mod_local.h"
 
 #undef FRAC_EPSILON
 #define FRAC_EPSILON	(1.0f / 32.0f)
@@ -57,6 +57,8 @@ static int PM_SampleMiptex( const msurface_t *surf, const vec3_t point )
 	int		x, y;
 	mtexinfo_t	*tx;
 	texture_t		*mt;
+	const byte	*mask;
+	uint		texel;
 
 	// fill the default contents
 	if( fb ) contents = fb->contents;
@@ -71,33 +73,25 @@ static int PM_SampleMiptex( const msurface_t *surf, const vec3_t point )
 	if( mt->name[0] != '{' )
 		return contents;
 
-	// TODO: this won't work under dedicated
-	// should we bring up imagelib and keep original buffers?
-#if !XASH_DEDICATED
-	if( !Host_IsDedicated() )
-	{
-		const byte		*data;
-
-		data = ref.dllFuncs.R_GetTextureOriginalBuffer( mt->gl_texturenum );
+	// built at load time, see Mod_LoadAlphaMask
+	mask = ((mtexture_t *)mt)->alphamask;
 
-		if( !data ) return contents; // original doesn't kept
+	if( !mask ) return contents;
 
-		ds = DotProduct( point, tx->vecs[0] ) + tx->vecs[0][3];
-		dt = DotProduct( point, tx->vecs[1] ) + tx->vecs[1][3];
+	ds = DotProduct( point, tx->vecs[0] ) + tx->vecs[0][3];
+	dt = DotProduct( point, tx->vecs[1] ) + tx->vecs[1][3];
 
-		// convert ST to real pixels position
-		x = fix_coord( ds, mt->width - 1 );
-		y = fix_coord( dt, mt->height - 1 );
+	// convert ST to real pixels position
+	x = fix_coord( ds, mt->width - 1 );
+	y = fix_coord( dt, mt->height - 1 );
 
-		ASSERT( x >= 0 && y >= 0 );
+	ASSERT( x >= 0 && y >= 0 );
 
-		if( data[(mt->width * y) + x] == 255 )
-			return CONTENTS_EMPTY;
-		return CONTENTS_SOLID;
-	}
-#endif // !XASH_DEDICATED
+	texel = mt->width * y + x;
 
-	return contents;
+	if( FBitSet( mask[texel >> 3], BIT( texel & 7 )))
+		return CONTENTS_EMPTY;
+	return CONTENTS_SOLID;
 }
 
 /*
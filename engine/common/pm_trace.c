@@ -894,3 +894,99 @@ void PM_StuckTouch( playermove_t *pmove, int hitent, pmtrace_t *tr )
 
 	pmove->touchindex[pmove->numtouch++] = *tr;
 }
+
+#if XASH_ENGINE_TESTS
+#include "tests.h"
+
+#define BENCH_PM_GRID	8
+#define BENCH_PM_ROOM	1024.0f
+#define BENCH_PM_TRACES	256
+
+typedef struct bench_pmtrace_s
+{
+	playermove_t	pmove;
+	physent_t		ents[6 + BENCH_PM_GRID * BENCH_PM_GRID];
+	int		numents;
+	vec3_t		start[BENCH_PM_TRACES];
+	vec3_t		end[BENCH_PM_TRACES];
+} bench_pmtrace_t;
+
+static void Bench_PM_AddBox( bench_pmtrace_t *b, float x1, float y1, float z1, float x2, float y2, float z2 )
+{
+	physent_t *pe = &b->ents[b->numents];
+
+	Q_snprintf( pe->name, sizeof( pe->name ), "box%d", b->numents );
+	VectorSet( pe->mins, x1, y1, z1 );
+	VectorSet( pe->maxs, x2, y2, z2 );
+	pe->solid = SOLID_BBOX;
+	pe->info = b->numents++;
+}
+
+static void Bench_PM_PlayerTrace( void *data, int count )
+{
+	bench_pmtrace_t *b = data;
+	int i;
+
+	for( i = 0; i < count; i++ )
+	{
+		int j = i % BENCH_PM_TRACES;
+		pmtrace_t tr = PM_PlayerTraceExt( &b->pmove, b->start[j], b->end[j], 0, b->numents, b->ents, -1, NULL );
+
+		bench_sink += tr.ent;
+	}
+}
+
+/*
+===============
+Bench_RunPMTrace
+
+generated box map: closed room with
+grid of crates and random player moves
+===============
+*/
+void Bench_RunPMTrace( void )
+{
+	bench_pmtrace_t *b = Mem_Calloc( host.mempool, sizeof( *b ));
+	const float r = BENCH_PM_ROOM, h = 256.0f;
+	uint seed = 0x1234567;
+	int i, j;
+
+	Pmove_Init();
+	b->pmove.server = true;
+	b->pmove.usehull = 0;
+
+	// walls, floor and ceiling
+	Bench_PM_AddBox( b, -r - 16, -r - 16, -16, r + 16, r + 16, 0 );
+	Bench_PM_AddBox( b, -r - 16, -r - 16, h, r + 16, r + 16, h + 16 );
+	Bench_PM_AddBox( b, -r - 16, -r - 16, 0, -r, r + 16, h );
+	Bench_PM_AddBox( b, r, -r - 16, 0, r + 16, r + 16, h );
+	Bench_PM_AddBox( b, -r, -r - 16, 0, r, -r, h );
+	Bench_PM_AddBox( b, -r, r, 0, r, r + 16, h );
+
+	for( i = 0; i < BENCH_PM_GRID; i++ )
+	{
+		for( j = 0; j < BENCH_PM_GRID; j++ )
+		{
+			float x = -r + ( i + 0.5f ) * ( 2.0f * r / BENCH_PM_GRID );
+			float y = -r + ( j + 0.5f ) * ( 2.0f * r / BENCH_PM_GRID );
+
+			Bench_PM_AddBox( b, x - 32, y - 32, 0, x + 32, y + 32, 64 + ( i + j ) % 3 * 32 );
+		}
+	}
+
+	for( i = 0; i < BENCH_PM_TRACES; i++ )
+	{
+		for( j = 0; j < 3; j++ )
+		{
+			seed = seed * 1103515245 + 12345;
+			b->start[i][j] = j == 2 ? 36.0f + 128.0f : (( seed >> 8 ) % 2000 ) - 1000.0f;
+			seed = seed * 1103515245 + 12345;
+			b->end[i][j] = j == 2 ? 36.0f : b->start[i][j] + ((int)(( seed >> 8 ) % 512 ) - 256 );
+		}
+	}
+
+	Bench_Run( "PM_PlayerTrace", Bench_PM_PlayerTrace, b, 1000 );
+
+	Mem_Free( b );
+}
+#endif // XASH_ENGINE_TESTS
@@ -42,6 +42,17 @@ void Test_RunGamma( void );
 void Test_RunDelta( void );
 void Test_RunBuffer( void );
 void Test_RunMunge( void );
+void Test_RunNetStats( void );
+void Test_RunGroundCache( void );
+void Test_RunPhysics( void );
+void Test_RunLightGrid( void );
+void Test_RunModel( void );
+void Test_RunDemoIndex( void );
+void Test_RunBrowser( void );
+void Test_RunRelay( void );
+void Test_RunTriggers( void );
+
+qboolean Test_InitDeltaEntityState( void );
 
 #define TEST_LIST_0 \
 	Test_RunLibCommon(); \
@@ -51,17 +62,57 @@ void Test_RunMunge( void );
 	Test_RunIPFilter(); \
 	Test_RunBuffer(); \
 	Test_RunDelta(); \
-	Test_RunMunge();
+	Test_RunMunge(); \
+	Test_RunNetStats(); \
+	Test_RunGroundCache(); \
+	Test_RunLightGrid();
 
 #define TEST_LIST_0_CLIENT \
 	Test_RunCon(); \
-	Test_RunGamma();
+	Test_RunGamma(); \
+	Test_RunBrowser();
 
 #define TEST_LIST_1 \
-	Test_RunImagelib();
+	Test_RunImagelib(); \
+	Test_RunModel(); \
+	Test_RunPhysics(); \
+	Test_RunTriggers(); \
+	Test_RunRelay();
 
 #define TEST_LIST_1_CLIENT \
-	Test_RunVOX();
+	Test_RunVOX(); \
+	Test_RunDemoIndex();
+
+// microbenchmarks, run with -runbench after FS load
+typedef void (*bench_func_t)( void *data, int count );
+
+extern volatile uint bench_sink; // keeps kernel results alive
+
+void Bench_Run( const char *name, bench_func_t func, void *data, int count );
+int Bench_RunAll( void );
+
+void Bench_RunPublic( void );
+void Bench_RunCommon( void );
+void Bench_RunCvar( void );
+void Bench_RunBuffer( void );
+void Bench_RunDelta( void );
+void Bench_RunImagelib( void );
+void Bench_RunPMTrace( void );
+void Bench_RunModel( void );
+void Bench_RunPhysics( void );
+void Bench_RunTriggers( void );
+
+#define BENCH_LIST \
+	Bench_RunBuffer(); \
+	Bench_RunDelta(); \
+	Bench_RunCommon(); \
+	Bench_RunPublic(); \
+	Bench_RunCvar(); \
+	Bench_RunImagelib(); \
+	Bench_RunPMTrace(); \
+	Bench_RunModel(); \
+	Bench_RunPhysics(); \
+	Bench_RunTriggers();
 
 #endif
 
@@ -71,6 +71,8 @@ typedef struct event_info_s
 typedef struct event_state_s
 {
 	event_info_t	ei[MAX_EVENT_QUEUE];
+	int		count;		// number of occupied slots
+	uint64_t		used;		// occupied slots mask ( CLIENT ONLY )
 } event_state_t;
 
 #endif//WORLD_H
@@ -51,7 +51,8 @@ GNU General Public License for more details.
 //    PARM_SKY_SPHERE and PARM_SURF_SAMPLESIZE are now handled at engine side.
 //    VGUI rendering code is mostly moved back to engine.
 //    Implemented texture replacement.
-#define REF_API_VERSION 8
+// 9. Added R_DrawGlyphRun to draw text with one call per string.
+#define REF_API_VERSION 9
 
 #define TF_SKY		(TF_SKYSIDE|TF_NOMIPMAP|TF_ALLOW_NEAREST)
 #define TF_FONT		(TF_NOMIPMAP|TF_CLAMP|TF_ALLOW_NEAREST)
@@ -268,6 +269,13 @@ typedef struct remap_info_s
 	model_t		*model;		// for catch model changes
 } remap_info_t;
 
+typedef struct ref_glyph_s
+{
+	float		x, y, w, h;	// screen rectangle, relative to run origin
+	float		s1, t1, s2, t2;	// texture coords
+	rgba_t		color;
+} ref_glyph_t;
+
 typedef struct convar_s convar_t;
 struct con_nprint_s;
 struct engine_studio_api_s;
@@ -513,6 +521,7 @@ typedef struct ref_interface_s
 	void (*R_Set2DMode)( qboolean enable );
 	void (*R_DrawStretchRaw)( float x, float y, float w, float h, int cols, int rows, const byte *data, qboolean dirty );
 	void (*R_DrawStretchPic)( float x, float y, float w, float h, float s1, float t1, float s2, float t2, int texnum );
+	void (*R_DrawGlyphRun)( const ref_glyph_t *glyphs, int count, float x, float y, int texnum, int rendermode ); // rendermode < 0 keeps current
 	void (*R_DrawTileClear)( int texnum, int x, int y, int w, int h );
 	void (*FillRGBA)( float x, float y, float w, float h, int r, int g, int b, int a ); // in screen space
 	void (*FillRGBABlend)( float x, float y, float w, float h, int r, int g, int b, int a ); // in screen space
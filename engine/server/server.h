@@ -114,6 +114,8 @@ typedef struct
 	qboolean		net_log;
 	netadr_t		net_address;
 	file_t		*file;
+	qboolean		dirty;		// lines are written, but not flushed
+	double		flushtime;	// host.realtime of next flush
 } server_log_t;
 
 typedef struct server_s
@@ -200,6 +202,64 @@ typedef struct
 	int  		first_entity;		// into the circular sv_packet_entities[]
 } client_frame_t;
 
+#define NETSTATS_PACKETS	64	// must be power of two, packets waiting for ack
+#define NETSTATS_SECONDS	60	// length of rolling history
+
+typedef enum
+{
+	NETSTAT_ENTITIES = 0,	// svc_packetentities and svc_deltapacketentities
+	NETSTAT_EVENTS,		// svc_event
+	NETSTAT_VOICE,		// svc_voicedata
+	NETSTAT_RELIABLE,		// reliable payload and fragments
+	NETSTAT_OTHER,		// time, clientdata, pings, multicasts
+	NETSTAT_CLASSES
+} netstat_class_t;
+
+// single snapshot as it's being written
+typedef struct
+{
+	int		bytes[NETSTAT_CLASSES];
+	int		delta_ents;	// delta compressed against previous snapshot
+	int		baseline_ents;	// sent against baseline
+	qboolean		nodelta;		// client didn't have a valid snapshot to delta from
+} netstat_frame_t;
+
+typedef struct
+{
+	double		senttime;
+	uint		sequence;
+	qboolean		acked;
+} netstat_packet_t;
+
+// totals for one second of server time
+typedef struct
+{
+	int		second;
+	int		packets;
+	int		bytes[NETSTAT_CLASSES];
+	int		choked;
+	int		acked;
+	int		lost;		// not acknowledged when newer packet was
+	float		rtt_sum;
+	float		rtt_min;
+	float		rtt_max;
+	int		delta_ents;
+	int		baseline_ents;
+	int		full_updates;
+	int		resends;
+	int		fragments;
+	int		client_loss;	// sum of loss reported by client
+} netstat_bucket_t;
+
+typedef struct sv_netstats_s
+{
+	netstat_packet_t	packets[NETSTATS_PACKETS];
+	netstat_bucket_t	buckets[NETSTATS_SECONDS];
+	uint		last_acked;
+	int		voice_bytes;	// queued in client datagram
+	double		next_logtime;
+} sv_netstats_t;
+
 typedef struct sv_client_s
 {
 	cl_state_t	state;
@@ -265,6 +325,8 @@ typedef struct sv_client_s
 	double userinfo_next_changetime;
 	double userinfo_penalty;
 	int    userinfo_change_attempts;
+
+	sv_netstats_t *netstats; // only allocated when sv_netstats is enabled
 } sv_client_t;
 
 /*
@@ -304,6 +366,45 @@ typedef struct
 	int		fixangle;
 } sv_pushed_t;
 
+typedef struct
+{
+	int		pushes;		// pusher moves that looked for contacts
+	int		candidates;	// entities gathered for them
+	int		traces;		// position tests they had to run
+} sv_pushstats_t;
+
+typedef struct
+{
+	int		active;		// entities that ran physics last frame
+	int		idle;		// skipped because nothing could happen
+} sv_physstats_t;
+
+#define GROUND_CACHE_CHECKS	4	// remembered SV_CheckBottom verdicts per edict
+
+typedef struct
+{
+	vec3_t		origin;
+	vec3_t		mins;
+	vec3_t		maxs;
+	edict_t		*groundentity;
+	edict_t		*owner;
+	int		groupinfo;
+	float		stepsize;
+	uint		stamp;		// ground modification stamp when verdict was proven
+	byte		mode;
+	byte		monsterclip;
+	byte		result;
+	byte		valid;
+} sv_groundcheck_t;
+
+typedef struct
+{
+	sv_groundcheck_t	checks[GROUND_CACHE_CHECKS];
+	int		serialnumber;	// edict was reused, checks are stale
+	int		nextcheck;	// slot to replace
+	qboolean		support;		// linked as something monster can stand on
+} sv_groundcache_t;
+
 typedef struct
 {
 	qboolean		active;
@@ -347,6 +448,13 @@ typedef struct
 	sv_interp_t	interp[MAX_CLIENTS];	// interpolate clients
 	sv_pushed_t	pushed[MAX_PUSHED_ENTS];	// no reason to keep array for all edicts
 						// 256 it should be enough for any game situation
+	edict_t		**pushcandidates;		// [GI->max_edicts * 2] entities near moving pusher
+	edict_t		**pushloose;		// [GI->max_edicts] pushables area query can't find
+	int		numpushloose;
+	qboolean		pushloosevalid;		// pushloose is complete, else scan all edicts
+	byte		*triggernode;		// [GI->max_edicts] areanode index + 1 holding trigger link, 0 if none
+	sv_pushstats_t	pushstats;
+	sv_physstats_t	physstats;
 
 	globalvars_t	*globals;			// server globals
 
@@ -380,6 +488,7 @@ typedef struct
 	int		next_client_entities;	// next client_entity to use
 	entity_state_t	*packet_entities;		// [num_client_entities]
 	entity_state_t	*baselines;		// [GI->max_edicts]
+	sv_groundcache_t	*groundcache;		// [GI->max_edicts]
 	entity_state_t	*static_entities;		// [MAX_STATIC_ENTITIES];
 
 	challenge_t	challenges[MAX_CHALLENGES];	// to prevent invalid IPs from connecting
@@ -409,6 +518,12 @@ extern convar_t		sv_unlagpush;
 extern convar_t		sv_unlagsamples;
 extern convar_t		rcon_enable;
 extern convar_t		sv_instancedbaseline;
+extern convar_t		sv_relay;
+extern convar_t		sv_groundcache;
+extern convar_t		sv_pushquery;
+extern convar_t		sv_triggersweep;
+extern convar_t		sv_skipidle;
+extern convar_t		sv_lightgrid;
 extern convar_t		sv_background_freeze;
 extern convar_t		sv_minupdaterate;
 extern convar_t		sv_maxupdaterate;
@@ -454,6 +569,7 @@ extern convar_t		sv_nat;
 extern convar_t		sv_speedhack_kick;
 extern convar_t		sv_pausable;		// allows pause in multiplayer
 extern convar_t		sv_check_errors;
+extern convar_t		sv_touchcache_enable;
 extern convar_t		sv_lighting_modulate;
 extern convar_t		sv_novis;
 extern convar_t		sv_hostmap;
@@ -508,6 +624,8 @@ void SV_CheckVelocity( edict_t *ent );
 qboolean SV_PlayerRunThink( edict_t *ent, float frametime, double time );
 void SV_Impact( edict_t *e1, edict_t *e2, trace_t *trace );
 void SV_FreeOldEntities( void );
+void SV_AddLooseEdict( edict_t *ent );
+void SV_PushStats_f( void );
 
 //
 // sv_move.c
@@ -516,6 +634,8 @@ qboolean SV_MoveStep( edict_t *ent, vec3_t move, qboolean relink );
 qboolean SV_MoveTest( edict_t *ent, vec3_t move, qboolean relink );
 void SV_MoveToOrigin( edict_t *ed, const vec3_t goal, float dist, int iMode );
 qboolean SV_CheckBottom( edict_t *ent, int iMode );
+void SV_GroundSupportLinked( edict_t *ent, qboolean linked );
+void SV_ClearGroundCache( void );
 float SV_VecToYaw( const vec3_t src );
 void SV_WaterMove( edict_t *ent );
 
@@ -639,6 +759,7 @@ static inline edict_t *SV_EdictNum( int n )
 // sv_log.c
 //
 void Log_Close( void );
+void Log_Frame( void );
 void Log_Open( void );
 void Log_PrintServerVars( void );
 void SV_ServerLog_f( void );
@@ -679,6 +800,20 @@ int SV_TruePointContents( const vec3_t p );
 int SV_PointContents( const vec3_t p );
 void SV_SetLightStyle( int style, const char* s, float f );
 int SV_LightForEntity( edict_t *pEdict );
+void SV_InitLightGrid( void );
+void SV_FreeLightGrid( void );
+void SV_LightGridCheck_f( void );
+
+//
+// sv_netstats.c
+//
+void SV_InitNetStats( void );
+netstat_frame_t *SV_NetStatsBeginFrame( sv_client_t *cl, netstat_frame_t *frame );
+void SV_NetStatsEndFrame( sv_client_t *cl, const netstat_frame_t *frame, int unreliable_bytes );
+void SV_NetStatsChoke( sv_client_t *cl );
+void SV_NetStatsAck( sv_client_t *cl );
+void SV_NetStatsFree( sv_client_t *cl );
+void SV_NetStatsLog( void );
 
 //
 // sv_query.c
@@ -661,6 +661,8 @@ void SV_DropClient( sv_client_t *cl, qboolean crash )
 		Mem_Free( cl->frames ); // release delta
 	cl->frames = NULL;
 
+	SV_NetStatsFree( cl );
+
 	if( NET_CompareBaseAdr( cl->netchan.remote_address, host.rd.address ))
 		SV_EndRedirect( &host.rd );
 
@@ -3511,6 +3513,9 @@ static void SV_ParseVoiceData( sv_client_t *cl, sizebuf_t *msg )
 		MSG_WriteByte( &cur->datagram, frames );
 		MSG_WriteShort( &cur->datagram, length );
 		MSG_WriteBytes( &cur->datagram, received, length );
+
+		if( cur->netstats )
+			cur->netstats->voice_bytes += length + 5;
 	}
 }
 
@@ -3545,6 +3550,9 @@ void SV_ExecuteClientMessage( sv_client_t *cl, sizebuf_t *msg )
 	cl->latency = SV_CalcClientTime( cl );
 	cl->delta_sequence = -1; // no delta unless requested
 
+	if( cl->netstats )
+		SV_NetStatsAck( cl );
+
 	// read optional clientCommand strings
 	while( cl->state != cs_zombie )
 	{
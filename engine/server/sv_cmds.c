@@ -887,6 +887,7 @@ static void SV_EdictUsage_f( void )
 	Con_Printf( "%5i edicts is used\n", active );
 	Con_Printf( "%5i edicts is free\n", GI->max_edicts - active );
 	Con_Printf( "%5i total\n", GI->max_edicts );
+	Con_Printf( "%5i edicts ran physics last frame, %i were idle\n", svgame.physstats.active, svgame.physstats.idle );
 }
 
 /*
@@ -1008,6 +1009,8 @@ void SV_InitOperatorCommands( void )
 	Cmd_AddCommand( "logaddress", SV_SetLogAddress_f, "sets address and port for remote logging host" );
 	Cmd_AddCommand( "log", SV_ServerLog_f, "enables logging to file" );
 	Cmd_AddCommand( "str64stats", SV_PrintStr64Stats_f, "print engine pool string statistics" );
+	Cmd_AddCommand( "lightgrid_check", SV_LightGridCheck_f, "compare entity illumination grid against exact traces at random points" );
+	Cmd_AddCommand( "pushstats", SV_PushStats_f, "print moving brushes collision statistics and reset them" );
 
 	if( host.type == HOST_NORMAL )
 	{
@@ -1047,6 +1050,8 @@ void SV_KillOperatorCommands( void )
 	Cmd_RemoveCommand( "logaddress" );
 	Cmd_RemoveCommand( "log" );
 	Cmd_RemoveCommand( "str64stats" );
+	Cmd_RemoveCommand( "pushstats" );
+	Cmd_RemoveCommand( "lightgrid_check" );
 
 	if( host.type == HOST_NORMAL )
 	{
@@ -28,6 +28,39 @@ typedef struct
 int	c_fullsend;	// just a debug counter
 int	c_notsend;
 
+// entity number -> index in the client frame currently being built,
+// valid only where stamp matches sv_packetstamp
+static short	sv_packetslot[MAX_EDICTS];
+static int	sv_packetslotstamp[MAX_EDICTS];
+static int	sv_packetstamp;
+
+#define RELAY_PACKETS	4	// distinct delta sources encoded per frame
+
+// encoded packet entities body, shared by spectators that delta from the same snapshot
+typedef struct
+{
+	int		first_entity;	// snapshot it was delta'd from, -1 if uncompressed
+	int		num_entities;
+	int		delta_ents;
+	int		baseline_ents;
+	sizebuf_t		msg;
+	byte		buf[MAX_DATAGRAM];
+} relay_packet_t;
+
+// with sv_relay HLTV spectators all watch same snapshot, so
+// game dll and delta encoder run once per frame, not once per spectator
+static struct
+{
+	int		sendframe;	// incremented by SV_SendClientMessages
+	int		snapframe;	// sendframe the snapshot was built at
+	int		first_entity;	// into the circular sv_packet_entities[]
+	int		num_entities;
+	edict_t		*viewentity[MAX_VIEWENTS];
+	int		num_viewents;
+	relay_packet_t	packets[RELAY_PACKETS];
+	int		numpackets;
+} sv_relayframe;
+
 /*
 =======================
 SV_EntityNumbers
@@ -49,6 +82,16 @@ static int SV_EntityNumbers( const void *a, const void *b )
 	return 1;
 }
 
+/*
+=======================
+SV_IsRelayClient
+=======================
+*/
+static qboolean SV_IsRelayClient( const sv_client_t *cl )
+{
+	return sv_relay.value && FBitSet( cl->flags, FCL_HLTV_PROXY );
+}
+
 /*
 =============
 SV_AddEntitiesToPacket
@@ -257,7 +300,7 @@ SV_EmitPacketEntities
 Writes a delta update of an entity_state_t list to the message->
 =============
 */
-static void SV_EmitPacketEntities( sv_client_t *cl, client_frame_t *to, sizebuf_t *msg )
+static void SV_EmitPacketEntities( sv_client_t *cl, client_frame_t *to, sizebuf_t *msg, netstat_frame_t *stats )
 {
 	entity_state_t	*oldent, *newent;
 	int		oldindex, newindex;
@@ -265,6 +308,10 @@ static void SV_EmitPacketEntities( sv_client_t *cl, client_frame_t *to, sizebuf_
 	qboolean		player;
 	int		oldmax;
 	client_frame_t	*from;
+	relay_packet_t	*relay = NULL;
+	sizebuf_t		*out = msg;
+	int		delta_ents = 0;
+	int		baseline_ents = 0;
 
 	// this is the frame that we are going to delta update from
 	if( cl->delta_sequence != -1 )
@@ -298,6 +345,42 @@ static void SV_EmitPacketEntities( sv_client_t *cl, client_frame_t *to, sizebuf_
 		MSG_WriteUBitLong( msg, to->num_entities - 1, MAX_VISIBLE_PACKET_BITS );
 	}
 
+	if( stats && !from )
+		stats->nodelta = true;
+
+	if( SV_IsRelayClient( cl ))
+	{
+		int	first_entity = from ? from->first_entity : -1;
+
+		// same source and same snapshot, body is the same too
+		for( i = 0; i < sv_relayframe.numpackets; i++ )
+		{
+			relay = &sv_relayframe.packets[i];
+
+			if( relay->first_entity != first_entity || relay->num_entities != oldmax )
+				continue;
+
+			MSG_WriteBits( msg, MSG_GetData( &relay->msg ), MSG_GetNumBitsWritten( &relay->msg ));
+
+			if( stats )
+			{
+				stats->delta_ents += relay->delta_ents;
+				stats->baseline_ents += relay->baseline_ents;
+			}
+			return;
+		}
+
+		if( sv_relayframe.numpackets < RELAY_PACKETS )
+		{
+			relay = &sv_relayframe.packets[sv_relayframe.numpackets];
+			relay->first_entity = first_entity;
+			relay->num_entities = oldmax;
+			MSG_Init( &relay->msg, "RelayEntities", relay->buf, sizeof( relay->buf ));
+			out = &relay->msg;
+		}
+		else relay = NULL;
+	}
+
 	newent = NULL;
 	oldent = NULL;
 	newindex = 0;
@@ -332,9 +415,10 @@ static void SV_EmitPacketEntities( sv_client_t *cl, client_frame_t *to, sizebuf_
 			// delta update from old position
 			// because the force parm is false, this will not result
 			// in any bytes being emited if the entity has not changed at all
-			MSG_WriteDeltaEntity( oldent, newent, msg, false, player, sv.time, 0 );
+			MSG_WriteDeltaEntity( oldent, newent, out, false, player, sv.time, 0 );
 			oldindex++;
 			newindex++;
+			delta_ents++;
 			continue;
 		}
 
@@ -363,8 +447,9 @@ static void SV_EmitPacketEntities( sv_client_t *cl, client_frame_t *to, sizebuf_
 			}
 
 			// this is a new entity, send it from the baseline
-			MSG_WriteDeltaEntity( baseline, newent, msg, true, player, sv.time, offset );
+			MSG_WriteDeltaEntity( baseline, newent, out, true, player, sv.time, offset );
 			newindex++;
+			baseline_ents++;
 			continue;
 		}
 
@@ -378,13 +463,30 @@ static void SV_EmitPacketEntities( sv_client_t *cl, client_frame_t *to, sizebuf_
 				force = true;
 
 			// remove from message
-			MSG_WriteDeltaEntity( oldent, NULL, msg, force, false, sv.time, 0 );
+			MSG_WriteDeltaEntity( oldent, NULL, out, force, false, sv.time, 0 );
 			oldindex++;
 			continue;
 		}
 	}
 
-	MSG_WriteUBitLong( msg, LAST_EDICT, MAX_ENTITY_BITS ); // end of packetentities
+	MSG_WriteUBitLong( out, LAST_EDICT, MAX_ENTITY_BITS ); // end of packetentities
+
+	if( relay )
+	{
+		relay->delta_ents = delta_ents;
+		relay->baseline_ents = baseline_ents;
+		MSG_WriteBits( msg, MSG_GetData( &relay->msg ), MSG_GetNumBitsWritten( &relay->msg ));
+
+		// overflowed body must not be served to anyone else
+		if( !MSG_CheckOverflow( &relay->msg ))
+			sv_relayframe.numpackets++;
+	}
+
+	if( stats )
+	{
+		stats->delta_ents += delta_ents;
+		stats->baseline_ents += baseline_ents;
+	}
 }
 
 /*
@@ -397,46 +499,30 @@ static void SV_EmitEvents( sv_client_t *cl, client_frame_t *to, sizebuf_t *msg )
 {
 	event_state_t	*es;
 	event_info_t	*info;
-	entity_state_t	*state;
 	event_args_t	nullargs;
-	int		ev_count = 0;
+	int		ev_count;
 	int		count, ent_index;
-	int		i, j, ev;
+	int		i;
 
 	memset( &nullargs, 0, sizeof( nullargs ));
 	es = &cl->events;
 
-	// count events
-	for( ev = 0; ev < MAX_EVENT_QUEUE; ev++ )
-	{
-		if( es->ei[ev].index )
-			ev_count++;
-	}
-
 	// nothing to send
-	if( !ev_count ) return; // nothing to send
+	if( !es->count ) return;
+
+	ev_count = es->count;
 
 	if ( ev_count >= MAX_EVENT_QUEUE / 2 )
 		ev_count = ( MAX_EVENT_QUEUE / 2 ) - 1;
 
-	for( i = 0; i < MAX_EVENT_QUEUE; i++ )
+	for( i = 0; i < es->count; i++ )
 	{
 		info = &es->ei[i];
-		if( info->index == 0 )
-			continue;
-
 		ent_index = info->entity_index;
 
-		for( j = 0; j < to->num_entities; j++ )
+		if( ent_index >= 0 && ent_index < MAX_EDICTS && sv_packetslotstamp[ent_index] == sv_packetstamp )
 		{
-			state = &svs.packet_entities[(to->first_entity+j) % svs.num_client_entities];
-			if( state->number == ent_index )
-				break;
-		}
-
-		if( j < to->num_entities )
-		{
-			info->packet_index = j;
+			info->packet_index = sv_packetslot[ent_index];
 			info->args.ducking = 0;
 
 			if( !FBitSet( info->args.flags, FEVENT_ORIGIN ))
@@ -458,17 +544,10 @@ static void SV_EmitEvents( sv_client_t *cl, client_frame_t *to, sizebuf_t *msg )
 	MSG_BeginServerCmd( msg, svc_event );	// create message
 	MSG_WriteUBitLong( msg, ev_count, 5 );	// up to MAX_EVENT_QUEUE events
 
-	for( count = i = 0; i < MAX_EVENT_QUEUE; i++ )
+	for( count = i = 0; i < es->count; i++ )
 	{
 		info = &es->ei[i];
 
-		if( info->index == 0 )
-		{
-			info->packet_index = -1;
-			info->entity_index = -1;
-			continue;
-		}
-
 		// only send if there's room
 		if( count < ev_count )
 		{
@@ -507,6 +586,9 @@ static void SV_EmitEvents( sv_client_t *cl, client_frame_t *to, sizebuf_t *msg )
 		info->entity_index = -1;
 		count++;
 	}
+
+	// queue is always drained at once, so occupied slots stay contiguous
+	es->count = 0;
 }
 
 /*
@@ -587,6 +669,13 @@ static void SV_WriteClientdataToMessage( sv_client_t *cl, sizebuf_t *msg )
 
 	memset( &frame->clientdata, 0, sizeof( frame->clientdata ));
 
+	// spectators don't get clientdata anyway, don't ask game dll for it
+	if( SV_IsRelayClient( cl ))
+	{
+		MSG_BeginServerCmd( msg, svc_clientdata );
+		return;
+	}
+
 	// update clientdata_t
 	svgame.dllFuncs.pfnUpdateClientData( clent, FBitSet( cl->flags, FCL_LOCAL_WEAPONS ), &frame->clientdata );
 
@@ -630,19 +719,17 @@ static void SV_WriteClientdataToMessage( sv_client_t *cl, sizebuf_t *msg )
 
 /*
 ==================
-SV_WriteEntitiesToClient
+SV_BuildClientFrame
 
+collect entities visible to client and
+copy them into circular packet entities
 ==================
 */
-static void SV_WriteEntitiesToClient( sv_client_t *cl, sizebuf_t *msg )
+static void SV_BuildClientFrame( sv_client_t *cl, client_frame_t *frame )
 {
-	client_frame_t	*frame;
-	entity_state_t	*state;
 	static sv_ents_t	frame_ents;
-	int		i, send_pings;
-
-	frame = &cl->frames[cl->netchan.outgoing_sequence & SV_UPDATE_MASK];
-	send_pings = SV_ShouldUpdatePing( cl );
+	entity_state_t	*state;
+	int		i;
 
 	memset( frame_ents.sended, 0, sizeof( frame_ents.sended ));
 	ClearBits( sv.hostflags, SVF_MERGE_VISIBILITY );
@@ -688,9 +775,92 @@ static void SV_WriteEntitiesToClient( sv_client_t *cl, sizebuf_t *msg )
 		svs.next_client_entities++;
 		frame->num_entities++;
 	}
+}
+
+/*
+==================
+SV_BuildRelayFrame
+
+first spectator in frame builds the snapshot,
+the rest just point their frames at it
+==================
+*/
+static void SV_BuildRelayFrame( sv_client_t *cl, client_frame_t *frame )
+{
+	if( sv_relayframe.snapframe != sv_relayframe.sendframe )
+	{
+		SV_BuildClientFrame( cl, frame );
+
+		sv_relayframe.snapframe = sv_relayframe.sendframe;
+		sv_relayframe.first_entity = frame->first_entity;
+		sv_relayframe.num_entities = frame->num_entities;
+		sv_relayframe.num_viewents = cl->num_viewents;
+		memcpy( sv_relayframe.viewentity, cl->viewentity, sizeof( sv_relayframe.viewentity ));
+		sv_relayframe.numpackets = 0;
+		return;
+	}
+
+	frame->first_entity = sv_relayframe.first_entity;
+	frame->num_entities = sv_relayframe.num_entities;
+	cl->num_viewents = sv_relayframe.num_viewents;
+	memcpy( cl->viewentity, sv_relayframe.viewentity, sizeof( cl->viewentity ));
+}
+
+/*
+==================
+SV_WriteEntitiesToClient
+
+==================
+*/
+static void SV_WriteEntitiesToClient( sv_client_t *cl, sizebuf_t *msg, netstat_frame_t *stats )
+{
+	client_frame_t	*frame;
+	entity_state_t	*state;
+	int		i, send_pings;
+	int		bits = 0;
+
+	frame = &cl->frames[cl->netchan.outgoing_sequence & SV_UPDATE_MASK];
+	send_pings = SV_ShouldUpdatePing( cl );
+
+	if( SV_IsRelayClient( cl ))
+		SV_BuildRelayFrame( cl, frame );
+	else SV_BuildClientFrame( cl, frame );
+
+	// new stamp invalidates slots from the previous snapshot
+	if( ++sv_packetstamp <= 0 )
+	{
+		memset( sv_packetslotstamp, 0, sizeof( sv_packetslotstamp ));
+		sv_packetstamp = 1;
+	}
+
+	// remember where each entity was put for SV_EmitEvents
+	for( i = 0; i < frame->num_entities; i++ )
+	{
+		state = &svs.packet_entities[(frame->first_entity+i) % svs.num_client_entities];
+
+		if( sv_packetslotstamp[state->number] != sv_packetstamp )
+		{
+			sv_packetslot[state->number] = i;
+			sv_packetslotstamp[state->number] = sv_packetstamp;
+		}
+	}
+
+	if( stats )
+		bits = MSG_GetNumBitsWritten( msg );
+
+	SV_EmitPacketEntities( cl, frame, msg, stats );
+
+	if( stats )
+	{
+		stats->bytes[NETSTAT_ENTITIES] = BitByte( MSG_GetNumBitsWritten( msg ) - bits );
+		bits = MSG_GetNumBitsWritten( msg );
+	}
 
-	SV_EmitPacketEntities( cl, frame, msg );
 	SV_EmitEvents( cl, frame, msg );
+
+	if( stats )
+		stats->bytes[NETSTAT_EVENTS] = BitByte( MSG_GetNumBitsWritten( msg ) - bits );
+
 	if( send_pings ) SV_EmitPings( msg );
 }
 
@@ -710,7 +880,9 @@ static void SV_SendClientDatagram( sv_client_t *cl )
 {
 	byte	msg_buf[MAX_DATAGRAM];
 	sizebuf_t	msg;
+	netstat_frame_t	stats_buf, *stats;
 
+	stats = SV_NetStatsBeginFrame( cl, &stats_buf );
 	memset( msg_buf, 0, sizeof( msg_buf ));
 	MSG_Init( &msg, "Datagram", msg_buf, sizeof( msg_buf ));
 
@@ -719,7 +891,7 @@ static void SV_SendClientDatagram( sv_client_t *cl )
 	MSG_WriteFloat( &msg, sv.time );
 
 	SV_WriteClientdataToMessage( cl, &msg );
-	SV_WriteEntitiesToClient( cl, &msg );
+	SV_WriteEntitiesToClient( cl, &msg, stats );
 
 	// copy the accumulated multicast datagram
 	// for this client out to the message
@@ -730,12 +902,20 @@ static void SV_SendClientDatagram( sv_client_t *cl )
 	else
 	{
 		if( MSG_GetNumBytesWritten( &cl->datagram ) < MSG_GetNumBytesLeft( &msg ))
+		{
 			MSG_WriteBits( &msg, MSG_GetData( &cl->datagram ), MSG_GetNumBitsWritten( &cl->datagram ));
+
+			if( stats )
+				stats->bytes[NETSTAT_VOICE] = cl->netstats->voice_bytes;
+		}
 		else Con_DPrintf( S_WARN "Ignoring unreliable datagram for %s, would overflow on msg\n", cl->name );
 	}
 
 	MSG_Clear( &cl->datagram );
 
+	if( cl->netstats )
+		cl->netstats->voice_bytes = 0;
+
 	if( MSG_CheckOverflow( &msg ))
 	{
 		// must have room left for the packet header
@@ -745,6 +925,9 @@ static void SV_SendClientDatagram( sv_client_t *cl )
 
 	// send the datagram
 	Netchan_TransmitBits( &cl->netchan, MSG_GetNumBitsWritten( &msg ), MSG_GetData( &msg ));
+
+	if( stats )
+		SV_NetStatsEndFrame( cl, stats, MSG_GetNumBytesWritten( &msg ));
 }
 
 /*
@@ -849,6 +1032,9 @@ void SV_SendClientMessages( void )
 
 	SV_UpdateToReliableMessages ();
 
+	// spectators snapshot from previous frame is outdated
+	sv_relayframe.sendframe++;
+
 	// send a message to each connected client
 	for( i = 0, sv.current_client = svs.clients; i < svs.maxclients; i++, sv.current_client++ )
 	{
@@ -907,6 +1093,9 @@ void SV_SendClientMessages( void )
 			if( !Netchan_CanPacket( &cl->netchan, cl->state == cs_spawned ))
 			{
 				cl->chokecount++;
+
+				if( cl->netstats )
+					SV_NetStatsChoke( cl );
 				continue;
 			}
 
@@ -925,6 +1114,8 @@ void SV_SendClientMessages( void )
 
 	// reset current client
 	sv.current_client = NULL;
+
+	SV_NetStatsLog();
 }
 
 /*
@@ -996,3 +1187,166 @@ void SV_InactivateClients( void )
 		MSG_Clear( &cl->datagram );
 	}
 }
+
+#if XASH_ENGINE_TESTS
+#include "tests.h"
+
+#define TEST_RELAY_EDICTS	16
+#define TEST_RELAY_STATES	64
+
+static void Test_Relay_SetState( entity_state_t *state, int number, int step )
+{
+	memset( state, 0, sizeof( *state ));
+	state->number = number;
+	state->modelindex = 10 + number;
+	state->scale = 1.0f;
+	state->frame = ( number * 7 + step * 3 ) % 255;
+	VectorSet( state->origin, 64.0f * number + step * 4.125f, -32.0f * number, 16.0f );
+	VectorSet( state->angles, 0.0f, 15.0f * number + step * 2.8125f, 0.0f );
+}
+
+static void Test_Relay_Emit( sv_client_t *cl, client_frame_t *to, sizebuf_t *msg, byte *buf, netstat_frame_t *stats )
+{
+	memset( buf, 0, MAX_DATAGRAM );
+	memset( stats, 0, sizeof( *stats ));
+	MSG_Init( msg, "RelayTest", buf, MAX_DATAGRAM );
+
+	// body isn't byte aligned in real datagram
+	MSG_WriteUBitLong( msg, 5, 3 );
+	SV_EmitPacketEntities( cl, to, msg, stats );
+}
+
+static qboolean Test_Relay_Equal( sizebuf_t *a, sizebuf_t *b, const netstat_frame_t *sa, const netstat_frame_t *sb )
+{
+	if( MSG_CheckOverflow( a ) || MSG_CheckOverflow( b ))
+		return false;
+
+	if( MSG_GetNumBitsWritten( a ) != MSG_GetNumBitsWritten( b ))
+		return false;
+
+	if( memcmp( MSG_GetData( a ), MSG_GetData( b ), MSG_GetNumBytesWritten( a )))
+		return false;
+
+	return sa->delta_ents == sb->delta_ents && sa->baseline_ents == sb->baseline_ents;
+}
+
+/*
+==================
+Test_Relay_EmitPacketEntities
+
+same frame encoded per client and through shared
+relay body, both encoded and cached, must be bit exact
+==================
+*/
+static void Test_Relay_EmitPacketEntities( void )
+{
+	static gameinfo_t	gameinfo;
+	static entity_state_t	states[TEST_RELAY_STATES];
+	static entity_state_t	baselines[TEST_RELAY_EDICTS];
+	static byte	buf[3][MAX_DATAGRAM];
+	static sv_client_t	clients[2];
+	edict_t		ents[TEST_RELAY_EDICTS];
+	client_frame_t	frames[2][2], to;
+	sizebuf_t		msg[3];
+	netstat_frame_t	stats[3];
+	gameinfo_t	*oldgameinfo = GI;
+	edict_t		*oldedicts = svgame.edicts;
+	int		oldnumentities = svgame.numEntities;
+	entity_state_t	*oldpacket = svs.packet_entities;
+	entity_state_t	*oldbaselines = svs.baselines;
+	int		oldnumclient = svs.num_client_entities;
+	int		oldnextclient = svs.next_client_entities;
+	int		oldmaxclients = svs.maxclients;
+	float		oldrelay = sv_relay.value;
+	float		oldinstanced = sv_instancedbaseline.value;
+	double		oldtime = sv.time;
+	qboolean		delta = Test_InitDeltaEntityState();
+	int		i, n = 0, pass;
+
+	MSG_InitMasks();
+	memset( ents, 0, sizeof( ents ));
+	memset( frames, 0, sizeof( frames ));
+	memset( baselines, 0, sizeof( baselines ));
+	memset( clients, 0, sizeof( clients ));
+
+	// no game is loaded during tests, freed edicts
+	// don't need string pool for SV_ClassName
+	gameinfo.max_edicts = TEST_RELAY_EDICTS;
+	GI = &gameinfo;
+	svgame.edicts = ents;
+	svgame.numEntities = TEST_RELAY_EDICTS;
+	for( i = 0; i < TEST_RELAY_EDICTS; i++ )
+		ents[i].free = true;
+
+	svs.packet_entities = states;
+	svs.baselines = baselines;
+	svs.num_client_entities = TEST_RELAY_STATES;
+	svs.maxclients = 0;
+	sv_instancedbaseline.value = 0.0f;
+	sv.time = 1.0;
+
+	// old snapshot 2..9
+	frames[0][1].first_entity = n;
+	for( i = 2; i < 10; i++ )
+		Test_Relay_SetState( &states[n++], i, 0 );
+	frames[0][1].num_entities = n;
+	frames[1][1] = frames[0][1];
+
+	// new one moves 2..7, keeps 8, removes 9 and adds 10 and 11
+	to.first_entity = n;
+	for( i = 2; i < 12; i++ )
+	{
+		if( i != 9 )
+			Test_Relay_SetState( &states[n++], i, i < 8 ? 1 : 0 );
+	}
+	to.num_entities = n - to.first_entity;
+	svs.next_client_entities = n;
+
+	clients[0].frames = frames[0];
+	clients[1].frames = frames[1];
+	SetBits( clients[1].flags, FCL_HLTV_PROXY );
+
+	sv_relay.value = 1.0f;
+	sv_relayframe.numpackets = 0;
+
+	// delta compressed, then uncompressed
+	for( pass = 0; pass < 2; pass++ )
+	{
+		clients[0].delta_sequence = clients[1].delta_sequence = pass ? -1 : 1;
+
+		Test_Relay_Emit( &clients[0], &to, &msg[0], buf[0], &stats[0] );
+		Test_Relay_Emit( &clients[1], &to, &msg[1], buf[1], &stats[1] );
+		TASSERT_EQi( sv_relayframe.numpackets, pass + 1 );
+
+		// served from cache
+		Test_Relay_Emit( &clients[1], &to, &msg[2], buf[2], &stats[2] );
+		TASSERT_EQi( sv_relayframe.numpackets, pass + 1 );
+
+		TASSERT( Test_Relay_Equal( &msg[0], &msg[1], &stats[0], &stats[1] ));
+		TASSERT( Test_Relay_Equal( &msg[0], &msg[2], &stats[0], &stats[2] ));
+		TASSERT_EQi( stats[2].baseline_ents, pass ? to.num_entities : 2 );
+	}
+
+	sv_relayframe.numpackets = 0;
+	sv_relay.value = oldrelay;
+	sv_instancedbaseline.value = oldinstanced;
+	sv.time = oldtime;
+	svs.maxclients = oldmaxclients;
+	svs.next_client_entities = oldnextclient;
+	svs.num_client_entities = oldnumclient;
+	svs.baselines = oldbaselines;
+	svs.packet_entities = oldpacket;
+	svgame.numEntities = oldnumentities;
+	svgame.edicts = oldedicts;
+	GI = oldgameinfo;
+
+	if( delta )
+		Delta_Shutdown();
+}
+
+void Test_RunRelay( void )
+{
+	TRUN( Test_Relay_EmitPacketEntities() );
+}
+
+#endif // XASH_ENGINE_TESTS
@@ -4204,13 +4204,11 @@ void GAME_EXPORT SV_PlaybackEventFull( int flags, const edict_t *pInvoker, word
 		es = &cl->events;
 		bestslot = -1;
 
-		if( FBitSet( flags, FEV_UPDATE ))
+		if( FBitSet( flags, FEV_UPDATE ) && invokerIndex != -1 )
 		{
-			for( j = 0; j < MAX_EVENT_QUEUE; j++ )
+			for( j = 0; j < es->count; j++ )
 			{
-				ei = &es->ei[j];
-
-				if( ei->index == eventindex && invokerIndex != -1 && invokerIndex == ei->entity_index )
+				if( es->ei[j].index == eventindex && invokerIndex == es->ei[j].entity_index )
 				{
 					bestslot = j;
 					break;
@@ -4220,23 +4218,16 @@ void GAME_EXPORT SV_PlaybackEventFull( int flags, const edict_t *pInvoker, word
 
 		if( bestslot == -1 )
 		{
-			for( j = 0; j < MAX_EVENT_QUEUE; j++ )
-			{
-				ei = &es->ei[j];
+			// no slot found for this player, oh well
+			if( es->count >= MAX_EVENT_QUEUE )
+				continue;
 
-				if( ei->index == 0 )
-				{
-					// found an empty slot
-					bestslot = j;
-					break;
-				}
-			}
+			// queue is drained at once in SV_EmitEvents so first free slot is always at the end
+			bestslot = es->count++;
 		}
 
-		// no slot found for this player, oh well
-		if( bestslot == -1 ) continue;
-
 		// add event to queue
+		ei = &es->ei[bestslot];
 		ei->index = eventindex;
 		ei->fire_time = delay;
 		ei->entity_index = invokerIndex;
@@ -5137,6 +5128,9 @@ void SV_UnloadProgs( void )
 	Z_Free( svs.static_entities );
 	Z_Free( svs.baselines );
 	svs.baselines = NULL;
+	Z_Free( svs.groundcache );
+	svs.groundcache = NULL;
+	SV_FreeLightGrid();
 
 	// remove server cmds
 	SV_KillOperatorCommands();
@@ -5289,8 +5283,12 @@ qboolean SV_LoadProgs( const char *name )
 	svgame.globals->maxEntities = GI->max_edicts;
 	svgame.globals->maxClients = svs.maxclients;
 	svgame.edicts = Mem_Calloc( svgame.mempool, sizeof( edict_t ) * GI->max_edicts );
+	svgame.pushcandidates = Mem_Calloc( svgame.mempool, sizeof( edict_t * ) * GI->max_edicts * 2 );
+	svgame.pushloose = Mem_Calloc( svgame.mempool, sizeof( edict_t * ) * GI->max_edicts );
+	svgame.triggernode = Mem_Calloc( svgame.mempool, sizeof( byte ) * GI->max_edicts );
 	svs.static_entities = Z_Calloc( sizeof( entity_state_t ) * MAX_STATIC_ENTITIES );
 	svs.baselines = Z_Calloc( sizeof( entity_state_t ) * GI->max_edicts );
+	svs.groundcache = Z_Calloc( sizeof( sv_groundcache_t ) * GI->max_edicts );
 	svgame.numEntities = svs.maxclients + 1; // clients + world
 
 	for( i = 0, e = svgame.edicts; i < GI->max_edicts; i++, e++ )
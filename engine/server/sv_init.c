@@ -1035,6 +1035,7 @@ qboolean SV_SpawnServer( const char *mapname, const char *startspot, qboolean ba
 	Log_Open();
 	Log_Printf( "Loading map \"%s\"\n", mapname );
 	Log_PrintServerVars();
+	FS_TraceMapLoad( mapname );
 
 	svs.timestart = Sys_DoubleTime();
 	svs.spawncount++; // any partially connected client will be restarted
@@ -1073,6 +1074,7 @@ qboolean SV_SpawnServer( const char *mapname, const char *startspot, qboolean ba
 	// clearing all the baselines
 	memset( svs.static_entities, 0, sizeof( entity_state_t ) * MAX_STATIC_ENTITIES );
 	memset( svs.baselines, 0, sizeof( entity_state_t ) * GI->max_edicts );
+	SV_ClearGroundCache();
 
 	// make cvars consistant
 	if( coop.value ) Cvar_SetValue( "deathmatch", 0 );
@@ -16,6 +16,8 @@ GNU General Public License for more details.
 #include "common.h"
 #include "server.h"
 
+#define LOG_FLUSH_INTERVAL	1.0	// seconds between log file syncs
+
 void Log_Open( void )
 {
 	time_t		ltime;
@@ -88,6 +90,29 @@ void Log_Close( void )
 		FS_Close( svs.log.file );
 	}
 	svs.log.file = NULL;
+	svs.log.dirty = false;
+}
+
+/*
+==================
+Log_Frame
+
+log is tailed by server operators, don't let lines sit
+in write buffer for long. Flush syncs the file to disk,
+so it's done at most once per LOG_FLUSH_INTERVAL
+==================
+*/
+void Log_Frame( void )
+{
+	if( !svs.log.file || !svs.log.dirty )
+		return;
+
+	if( host.realtime < svs.log.flushtime )
+		return;
+
+	FS_Flush( svs.log.file );
+	svs.log.dirty = false;
+	svs.log.flushtime = host.realtime + LOG_FLUSH_INTERVAL;
 }
 
 /*
@@ -130,9 +155,12 @@ void Log_Printf( const char *fmt, ... )
 		if( mp_logecho.value )
 			Con_Printf( "%s", string );
 
-		// echo to log file
+		// echo to log file, Log_Frame will flush it
 		if( svs.log.file && mp_logfile.value )
+		{
 			FS_Printf( svs.log.file, "%s", string );
+			svs.log.dirty = true;
+		}
 	}
 }
 
@@ -33,6 +33,12 @@ CVAR_DEFINE_AUTO( rcon_enable, "1", FCVAR_PROTECTED, "enable accepting remote co
 // TODO: CVAR_DEFINE_AUTO( sv_filterban, "1", 0, "filter banned users" );
 CVAR_DEFINE_AUTO( sv_cheats, "0", FCVAR_SERVER, "allow cheats on server" );
 CVAR_DEFINE_AUTO( sv_instancedbaseline, "1", 0, "allow to use instanced baselines to saves network overhead" );
+CVAR_DEFINE_AUTO( sv_relay, "0", 0, "serve all HLTV spectators from one shared snapshot instead of building one per spectator" );
+CVAR_DEFINE_AUTO( sv_groundcache, "1", 0, "reuse monster ground checks until nearby brush entities move, 2 also verifies them with full traces" );
+CVAR_DEFINE_AUTO( sv_lightgrid, "16", 0, "max light difference between grid nodes to interpolate entity illumination instead of tracing, 0 disables grid" );
+CVAR_DEFINE_AUTO( sv_skipidle, "1", 0, "don't run physics for static entities which have nothing to do this frame" );
+CVAR_DEFINE_AUTO( sv_pushquery, "1", 0, "look up entities touched by moving brushes through areanodes instead of testing every edict" );
+CVAR_DEFINE_AUTO( sv_triggersweep, "1", 0, "look up triggers touched by moving entities through sorted per-areanode lists instead of testing every trigger" );
 static CVAR_DEFINE_AUTO( sv_contact, "", FCVAR_ARCHIVE|FCVAR_SERVER, "server techincal support contact address or web-page" );
 CVAR_DEFINE_AUTO( sv_minupdaterate, "25.0", FCVAR_ARCHIVE, "minimal value for 'cl_updaterate' window" );
 CVAR_DEFINE_AUTO( sv_maxupdaterate, "60.0", FCVAR_ARCHIVE, "maximal value for 'cl_updaterate' window" );
@@ -132,6 +138,7 @@ CVAR_DEFINE_AUTO( sv_novis, "0", 0, "force to ignore server visibility" );			//
 CVAR_DEFINE( sv_pausable, "pausable", "1", 0, "allow players to pause or not" );
 CVAR_DEFINE( sv_maxclients, "maxplayers", "1", FCVAR_LATCH, "server max capacity" );
 CVAR_DEFINE_AUTO( sv_check_errors, "0", FCVAR_ARCHIVE, "check edicts for errors" );
+CVAR_DEFINE( sv_touchcache_enable, "sv_touchcache", "1", 0, "cache brush trigger contacts for stationary entities, 2 to validate cache against full test" );
 CVAR_DEFINE_AUTO( sv_validate_changelevel, "0", 0, "test change level for level-designer errors" );
 CVAR_DEFINE( sv_hostmap, "hostmap", "", 0, "keep name of last entered map" );
 
@@ -705,6 +712,9 @@ void Host_ServerFrame( void )
 	// check timeouts
 	SV_CheckTimeouts ();
 
+	// write pending log lines
+	Log_Frame ();
+
 	// let everything in the world think and move
 	if( !SV_RunGameFrame ()) return;
 
@@ -912,6 +922,7 @@ void SV_Init( void )
 	Cvar_RegisterVariable( &sv_stopspeed );
 	Cvar_RegisterVariable( &sv_maxclients );
 	Cvar_RegisterVariable( &sv_check_errors );
+	Cvar_RegisterVariable( &sv_touchcache_enable );
 	Cvar_RegisterVariable( &public_server );
 	Cvar_RegisterVariable( &sv_failuretime );
 	Cvar_RegisterVariable( &sv_unlag );
@@ -926,6 +937,12 @@ void SV_Init( void )
 	Cvar_RegisterVariable( &sv_uploadmax );
 	Cvar_RegisterVariable( &sv_version );
 	Cvar_RegisterVariable( &sv_instancedbaseline );
+	Cvar_RegisterVariable( &sv_relay );
+	Cvar_RegisterVariable( &sv_groundcache );
+	Cvar_RegisterVariable( &sv_pushquery );
+	Cvar_RegisterVariable( &sv_triggersweep );
+	Cvar_RegisterVariable( &sv_skipidle );
+	Cvar_RegisterVariable( &sv_lightgrid );
 	Cvar_RegisterVariable( &sv_contact );
 	Cvar_RegisterVariable( &sv_consistency );
 	Cvar_RegisterVariable( &sv_downloadurl );
@@ -991,6 +1008,7 @@ void SV_Init( void )
 	Cvar_FullSet( "sv_version", versionString, FCVAR_READ_ONLY );
 
 	SV_InitFilter();
+	SV_InitNetStats();
 	SV_ClearGameState ();	// delete all temporary *.hl files
 	SV_InitGame();
 }
@@ -1054,11 +1072,16 @@ release server clients
 */
 static void SV_FreeClients( void )
 {
+	int	i;
+
 	if( svs.maxclients != 0 )
 	{
 		// free server static data
 		if( svs.clients )
 		{
+			for( i = 0; i < svs.maxclients; i++ )
+				SV_NetStatsFree( &svs.clients[i] );
+
 			Z_Free( svs.clients );
 			svs.clients = NULL;
 		}
@@ -22,16 +22,28 @@ GNU General Public License for more details.
 #define MOVE_NORMAL		0	// normal move in the direction monster is facing
 #define MOVE_STRAFE		1	// moves in direction specified, no matter which way monster is facing
 
+#define GROUND_HISTORY		64	// must be power of two
+
+typedef struct
+{
+	vec3_t		mins;
+	vec3_t		maxs;
+} groundchange_t;
+
+// boxes of the last linked and unlinked ground supports
+static groundchange_t	sv_groundchanges[GROUND_HISTORY];
+static uint		sv_groundstamp;
+
 /*
 =============
-SV_CheckBottom
+SV_CheckBottomFull
 
 Returns false if any part of the bottom of the entity is off an edge that
 is not a staircase.
 
 =============
 */
-qboolean SV_CheckBottom( edict_t *ent, int iMode )
+static qboolean SV_CheckBottomFull( edict_t *ent, int iMode )
 {
 	vec3_t	mins, maxs, start, stop;
 	float	mid, bottom;
@@ -103,6 +115,210 @@ qboolean SV_CheckBottom( edict_t *ent, int iMode )
 	return true;
 }
 
+/*
+=============
+SV_IsGroundSupport
+
+entities that MOVE_NOMONSTERS traces and
+point contents checks in SV_CheckBottom can hit
+=============
+*/
+static qboolean SV_IsGroundSupport( const edict_t *ent )
+{
+	if( ent->v.solid == SOLID_BSP || ent->v.solid == SOLID_CUSTOM )
+		return true;
+
+	// func_water and friends
+	if( ent->v.solid == SOLID_NOT )
+		return ent->v.skin < CONTENTS_EMPTY;
+
+	// pushables are not ignored by MOVE_NOMONSTERS
+	return ent->v.movetype == MOVETYPE_PUSHSTEP && ent->v.solid != SOLID_TRIGGER;
+}
+
+static void SV_RecordGroundChange( const vec3_t mins, const vec3_t maxs )
+{
+	groundchange_t *change = &sv_groundchanges[sv_groundstamp & ( GROUND_HISTORY - 1 )];
+
+	VectorCopy( mins, change->mins );
+	VectorCopy( maxs, change->maxs );
+	sv_groundstamp++;
+}
+
+/*
+=============
+SV_GroundSupportLinked
+
+called on every link and unlink, brush entity
+that was moved invalidates checks around it
+=============
+*/
+void SV_GroundSupportLinked( edict_t *ent, qboolean linked )
+{
+	sv_groundcache_t *gc;
+
+	if( !svs.groundcache )
+		return;
+
+	gc = &svs.groundcache[ent - svgame.edicts];
+
+	if( linked )
+	{
+		if( !SV_IsGroundSupport( ent ))
+			return;
+		gc->support = true;
+	}
+	else
+	{
+		// solid could be changed after linking
+		if( !gc->support )
+			return;
+		gc->support = false;
+	}
+
+	SV_RecordGroundChange( ent->v.absmin, ent->v.absmax );
+}
+
+/*
+=============
+SV_ClearGroundCache
+=============
+*/
+void SV_ClearGroundCache( void )
+{
+	if( svs.groundcache )
+		memset( svs.groundcache, 0, sizeof( sv_groundcache_t ) * GI->max_edicts );
+
+	sv_groundstamp = 0;
+}
+
+/*
+=============
+SV_GroundCheckValid
+
+verdict holds if no ground support was
+linked or unlinked inside probed volume since
+=============
+*/
+static qboolean SV_GroundCheckValid( const sv_groundcheck_t *check )
+{
+	vec3_t	mins, maxs;
+	uint	stamp;
+
+	if( sv_groundstamp - check->stamp > GROUND_HISTORY )
+		return false; // changes are lost
+
+	VectorAdd( check->origin, check->mins, mins );
+	VectorAdd( check->origin, check->maxs, maxs );
+	mins[2] -= check->stepsize * 2.0f + 1.0f;
+	maxs[2] = mins[2] + check->stepsize * 3.0f + 2.0f;
+
+	for( stamp = check->stamp; stamp != sv_groundstamp; stamp++ )
+	{
+		const groundchange_t *change = &sv_groundchanges[stamp & ( GROUND_HISTORY - 1 )];
+
+		if( BoundsIntersect( mins, maxs, change->mins, change->maxs ))
+			return false;
+	}
+
+	return true;
+}
+
+static qboolean SV_GroundCheckMatch( const sv_groundcheck_t *check, const edict_t *ent, int iMode, qboolean monsterClip )
+{
+	return check->valid
+		&& check->mode == iMode
+		&& check->monsterclip == monsterClip
+		&& check->groundentity == ent->v.groundentity
+		&& check->owner == ent->v.owner
+		&& check->groupinfo == ent->v.groupinfo
+		&& check->stepsize == svgame.movevars.stepsize
+		&& VectorCompare( check->origin, ent->v.origin )
+		&& VectorCompare( check->mins, ent->v.mins )
+		&& VectorCompare( check->maxs, ent->v.maxs );
+}
+
+/*
+=============
+SV_CheckBottom
+
+same as SV_CheckBottomFull, but monsters that keep
+retrying same spots reuse previous verdicts
+=============
+*/
+qboolean SV_CheckBottom( edict_t *ent, int iMode )
+{
+	qboolean		monsterClip = FBitSet( ent->v.flags, FL_MONSTERCLIP ) ? true : false;
+	sv_groundcheck_t	*check;
+	sv_groundcache_t	*gc;
+	qboolean		result;
+	int		i;
+
+	// user collision filter may change its mind any time
+	if( !sv_groundcache.value || !svs.groundcache || svgame.dllFuncs2.pfnShouldCollide )
+		return SV_CheckBottomFull( ent, iMode );
+
+	gc = &svs.groundcache[ent - svgame.edicts];
+
+	if( gc->serialnumber != ent->serialnumber )
+	{
+		memset( gc->checks, 0, sizeof( gc->checks ));
+		gc->serialnumber = ent->serialnumber;
+	}
+
+	for( i = 0; i < GROUND_CACHE_CHECKS; i++ )
+	{
+		check = &gc->checks[i];
+
+		if( !SV_GroundCheckMatch( check, ent, iMode, monsterClip ))
+			continue;
+
+		if( !SV_GroundCheckValid( check ))
+		{
+			check->valid = false;
+			continue;
+		}
+
+		// full check leaves it behind
+		svs.groupmask = ent->v.groupinfo;
+
+		if( sv_groundcache.value >= 2.0f )
+		{
+			result = SV_CheckBottomFull( ent, iMode );
+
+			if( result != check->result )
+			{
+				Con_Printf( S_ERROR "%s: stale verdict for %s at (%g %g %g)\n", __func__,
+					SV_ClassName( ent ), ent->v.origin[0], ent->v.origin[1], ent->v.origin[2] );
+				check->result = result;
+			}
+		}
+
+		check->stamp = sv_groundstamp;
+		return check->result;
+	}
+
+	result = SV_CheckBottomFull( ent, iMode );
+
+	check = &gc->checks[gc->nextcheck];
+	gc->nextcheck = ( gc->nextcheck + 1 ) % GROUND_CACHE_CHECKS;
+
+	VectorCopy( ent->v.origin, check->origin );
+	VectorCopy( ent->v.mins, check->mins );
+	VectorCopy( ent->v.maxs, check->maxs );
+	check->groundentity = ent->v.groundentity;
+	check->owner = ent->v.owner;
+	check->groupinfo = ent->v.groupinfo;
+	check->stepsize = svgame.movevars.stepsize;
+	check->stamp = sv_groundstamp;
+	check->mode = iMode;
+	check->monsterclip = monsterClip;
+	check->result = result;
+	check->valid = true;
+
+	return result;
+}
+
 void SV_WaterMove( edict_t *ent )
 {
 	float	drownlevel;
@@ -547,3 +763,87 @@ void SV_MoveToOrigin( edict_t *ent, const vec3_t pflGoal, float dist, int iMoveT
 		}
 	}
 }
+
+#if XASH_ENGINE_TESTS
+#include "tests.h"
+
+static void Test_GroundCache_Support( void )
+{
+	edict_t	ent;
+
+	memset( &ent, 0, sizeof( ent ));
+
+	ent.v.solid = SOLID_BSP;
+	TASSERT( SV_IsGroundSupport( &ent ));
+
+	ent.v.solid = SOLID_SLIDEBOX;
+	ent.v.movetype = MOVETYPE_STEP;
+	TASSERT( !SV_IsGroundSupport( &ent ));
+
+	ent.v.solid = SOLID_BBOX;
+	ent.v.movetype = MOVETYPE_PUSHSTEP;
+	TASSERT( SV_IsGroundSupport( &ent ));
+
+	ent.v.solid = SOLID_NOT;
+	ent.v.movetype = MOVETYPE_PUSH;
+	ent.v.skin = CONTENTS_WATER;
+	TASSERT( SV_IsGroundSupport( &ent ));
+
+	ent.v.skin = 0;
+	TASSERT( !SV_IsGroundSupport( &ent ));
+}
+
+static void Test_GroundCache_Changes( void )
+{
+	static const vec3_t far_mins = { 1000, 1000, 0 }, far_maxs = { 1100, 1100, 100 };
+	static const vec3_t step_mins = { -8, -8, -20 }, step_maxs = { 8, 8, -1 };
+	sv_groundcheck_t check;
+	int i;
+
+	memset( &check, 0, sizeof( check ));
+	VectorSet( check.mins, -16, -16, 0 );
+	VectorSet( check.maxs, 16, 16, 72 );
+	check.stepsize = 18.0f;
+
+	sv_groundstamp = 0;
+	check.stamp = sv_groundstamp;
+	TASSERT( SV_GroundCheckValid( &check ));
+
+	// mover far away
+	SV_RecordGroundChange( far_mins, far_maxs );
+	TASSERT( SV_GroundCheckValid( &check ));
+
+	// mover under feet
+	SV_RecordGroundChange( step_mins, step_maxs );
+	TASSERT( !SV_GroundCheckValid( &check ));
+
+	check.stamp = sv_groundstamp;
+	for( i = 0; i < GROUND_HISTORY; i++ )
+		SV_RecordGroundChange( far_mins, far_maxs );
+	TASSERT( SV_GroundCheckValid( &check ));
+
+	// too many changes to check them all
+	SV_RecordGroundChange( far_mins, far_maxs );
+	TASSERT( !SV_GroundCheckValid( &check ));
+
+	// stamp wraps around
+	sv_groundstamp = 0xfffffff0;
+	check.stamp = sv_groundstamp;
+	for( i = 0; i < 32; i++ )
+		SV_RecordGroundChange( far_mins, far_maxs );
+	TASSERT( sv_groundstamp == 16 );
+	TASSERT( SV_GroundCheckValid( &check ));
+
+	SV_RecordGroundChange( step_mins, step_maxs );
+	TASSERT( !SV_GroundCheckValid( &check ));
+
+	sv_groundstamp = 0;
+}
+
+void Test_RunGroundCache( void )
+{
+	TRUN( Test_GroundCache_Support() );
+	TRUN( Test_GroundCache_Changes() );
+}
+
+#endif // XASH_ENGINE_TESTS
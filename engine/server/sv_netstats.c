@@ -0,0 +1,474 @@
+/*
+sv_netstats.c - per-client network telemetry
+Copyright (C) 2026 FWGS
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+*/
+
+#include "common.h"
+#include "server.h"
+
+static CVAR_DEFINE_AUTO( sv_netstats, "0", 0, "record per-client network telemetry, see netstats command" );
+static CVAR_DEFINE_AUTO( sv_netstats_log, "0", 0, "interval in seconds to write per-client network telemetry to server log, 0 disables" );
+
+typedef struct
+{
+	double		duration;
+	int		packets;
+	float		bytes[NETSTAT_CLASSES];	// average per packet
+	float		kbps;
+	float		rtt_min;
+	float		rtt_avg;
+	float		rtt_max;
+	float		loss;			// percent of acknowledged packets lost
+	float		client_loss;		// as reported by client
+	float		choke;			// percent of send attempts suppressed by rate
+	float		delta;			// percent of entities delta compressed
+	int		full_updates;
+	int		resends;
+	int		fragments;
+} netstats_summary_t;
+
+static const char *netstat_names[NETSTAT_CLASSES] =
+{
+	"entities",
+	"events",
+	"voice",
+	"reliable",
+	"other",
+};
+
+static netstat_bucket_t *SV_NetStatsBucket( sv_netstats_t *ns )
+{
+	int		second = (int)host.realtime;
+	netstat_bucket_t	*b = &ns->buckets[second % NETSTATS_SECONDS];
+
+	if( b->second != second )
+	{
+		memset( b, 0, sizeof( *b ));
+		b->second = second;
+	}
+
+	return b;
+}
+
+/*
+==================
+SV_NetStatsBeginFrame
+
+returns NULL when telemetry is disabled, so
+callers don't have to do any accounting
+==================
+*/
+netstat_frame_t *SV_NetStatsBeginFrame( sv_client_t *cl, netstat_frame_t *frame )
+{
+	if( !sv_netstats.value )
+	{
+		if( cl->netstats )
+			SV_NetStatsFree( cl );
+		return NULL;
+	}
+
+	if( !cl->netstats )
+		cl->netstats = Z_Calloc( sizeof( *cl->netstats ));
+
+	memset( frame, 0, sizeof( *frame ));
+	return frame;
+}
+
+void SV_NetStatsEndFrame( sv_client_t *cl, const netstat_frame_t *frame, int unreliable_bytes )
+{
+	sv_netstats_t	*ns = cl->netstats;
+	netstat_bucket_t	*b = SV_NetStatsBucket( ns );
+	netstat_packet_t	*p;
+	int		i, other = unreliable_bytes;
+
+	// outgoing_sequence was already advanced by netchan
+	p = &ns->packets[( cl->netchan.outgoing_sequence - 1 ) & ( NETSTATS_PACKETS - 1 )];
+	p->sequence = cl->netchan.outgoing_sequence - 1;
+	p->senttime = host.realtime;
+	p->acked = false;
+
+	// message was dropped because of overflow
+	if( unreliable_bytes )
+	{
+		for( i = 0; i < NETSTAT_CLASSES; i++ )
+		{
+			b->bytes[i] += frame->bytes[i];
+			other -= frame->bytes[i];
+		}
+
+		b->bytes[NETSTAT_OTHER] += Q_max( other, 0 );
+	}
+
+	b->bytes[NETSTAT_RELIABLE] += cl->netchan.last_reliable_bytes;
+	b->packets++;
+	b->delta_ents += frame->delta_ents;
+	b->baseline_ents += frame->baseline_ents;
+	b->client_loss += cl->packet_loss;
+
+	if( frame->nodelta )
+		b->full_updates++;
+
+	if( cl->netchan.last_resend )
+	{
+		if( cl->netchan.last_fragment )
+			b->fragments++;
+		else b->resends++;
+	}
+}
+
+void SV_NetStatsChoke( sv_client_t *cl )
+{
+	SV_NetStatsBucket( cl->netstats )->choked++;
+}
+
+/*
+==================
+SV_NetStatsAck
+
+packets that were skipped by acknowledgement
+are counted as lost
+==================
+*/
+void SV_NetStatsAck( sv_client_t *cl )
+{
+	sv_netstats_t	*ns = cl->netstats;
+	uint		seq = cl->netchan.incoming_acknowledged;
+	netstat_bucket_t	*b;
+	netstat_packet_t	*p;
+	uint		i;
+
+	if( !ns || seq == ns->last_acked )
+		return;
+
+	b = SV_NetStatsBucket( ns );
+
+	i = seq - ns->last_acked > NETSTATS_PACKETS ? seq - NETSTATS_PACKETS : ns->last_acked + 1;
+
+	for( ; i != seq; i++ )
+	{
+		p = &ns->packets[i & ( NETSTATS_PACKETS - 1 )];
+
+		if( p->sequence == i && p->senttime && !p->acked )
+			b->lost++;
+	}
+
+	ns->last_acked = seq;
+	p = &ns->packets[seq & ( NETSTATS_PACKETS - 1 )];
+
+	if( p->sequence == seq && p->senttime && !p->acked )
+	{
+		float rtt = host.realtime - p->senttime;
+
+		p->acked = true;
+
+		if( !b->acked || rtt < b->rtt_min )
+			b->rtt_min = rtt;
+
+		if( !b->acked || rtt > b->rtt_max )
+			b->rtt_max = rtt;
+
+		b->rtt_sum += rtt;
+		b->acked++;
+	}
+}
+
+void SV_NetStatsFree( sv_client_t *cl )
+{
+	if( cl->netstats )
+		Mem_Free( cl->netstats );
+	cl->netstats = NULL;
+}
+
+/*
+==================
+SV_NetStatsSummarize
+
+folds buckets of last seconds into averages
+==================
+*/
+static void SV_NetStatsSummarize( const sv_netstats_t *ns, int seconds, netstats_summary_t *out )
+{
+	int	now = (int)host.realtime;
+	int	i, j, total = 0, acked = 0, lost = 0, choked = 0;
+	int	delta = 0, baseline = 0, client_loss = 0;
+	int	bytes[NETSTAT_CLASSES] = { 0 };
+	float	rtt_sum = 0.0f;
+
+	memset( out, 0, sizeof( *out ));
+	seconds = bound( 1, seconds, NETSTATS_SECONDS );
+
+	for( i = 0; i < NETSTATS_SECONDS; i++ )
+	{
+		const netstat_bucket_t *b = &ns->buckets[i];
+
+		if( !b->second || b->second > now || b->second <= now - seconds )
+			continue;
+
+		if( b->acked && ( !acked || b->rtt_min < out->rtt_min ))
+			out->rtt_min = b->rtt_min;
+
+		if( b->acked && ( !acked || b->rtt_max > out->rtt_max ))
+			out->rtt_max = b->rtt_max;
+
+		for( j = 0; j < NETSTAT_CLASSES; j++ )
+			bytes[j] += b->bytes[j];
+
+		out->packets += b->packets;
+		out->full_updates += b->full_updates;
+		out->resends += b->resends;
+		out->fragments += b->fragments;
+		acked += b->acked;
+		lost += b->lost;
+		choked += b->choked;
+		delta += b->delta_ents;
+		baseline += b->baseline_ents;
+		client_loss += b->client_loss;
+		rtt_sum += b->rtt_sum;
+	}
+
+	// current second isn't over yet
+	out->duration = Q_max( seconds - 1 + ( host.realtime - now ), 0.001 );
+
+	for( j = 0; j < NETSTAT_CLASSES; j++ )
+		total += bytes[j];
+
+	if( out->packets )
+	{
+		for( j = 0; j < NETSTAT_CLASSES; j++ )
+			out->bytes[j] = (float)bytes[j] / out->packets;
+
+		out->client_loss = (float)client_loss / out->packets;
+	}
+
+	if( acked )
+		out->rtt_avg = rtt_sum / acked;
+
+	if( acked + lost )
+		out->loss = lost * 100.0f / ( acked + lost );
+
+	if( out->packets + choked )
+		out->choke = choked * 100.0f / ( out->packets + choked );
+
+	if( delta + baseline )
+		out->delta = delta * 100.0f / ( delta + baseline );
+
+	out->kbps = total * 8.0f / 1000.0f / out->duration;
+}
+
+/*
+==================
+SV_NetStats_f
+
+prints rolling summary for every client
+==================
+*/
+static void SV_NetStats_f( void )
+{
+	sv_client_t	*cl, *only = NULL;
+	int		i, seconds = 10;
+
+	if( !svs.clients || sv.background )
+	{
+		Con_Printf( "^3no server running.\n" );
+		return;
+	}
+
+	if( !sv_netstats.value )
+	{
+		Con_Printf( "Network telemetry is disabled, set sv_netstats to 1\n" );
+		return;
+	}
+
+	if( Cmd_Argc() > 1 )
+		seconds = bound( 1, Q_atoi( Cmd_Argv( 1 )), NETSTATS_SECONDS );
+
+	if( Cmd_Argc() > 2 )
+	{
+		const char *param = Cmd_Argv( 2 );
+
+		if( *param == '#' && Q_isdigit( param + 1 ))
+			only = SV_ClientById( Q_atoi( param + 1 ));
+		else only = SV_ClientByName( param );
+
+		if( !only )
+		{
+			Con_Printf( "Client is not on the server\n" );
+			return;
+		}
+	}
+
+	Con_Printf( "last %i seconds, bytes are per packet\n", seconds );
+	Con_Printf( "num name            pkt/s   kbps  ents evnts voice  reli other  rtt min/avg/max  loss  choke delta full resend frag\n" );
+	Con_Printf( "--- --------------- ----- ------ ----- ----- ----- ----- ----- ---------------- ----- ----- ----- ---- ------ ----\n" );
+
+	for( i = 0, cl = svs.clients; i < svs.maxclients; i++, cl++ )
+	{
+		netstats_summary_t s;
+
+		if( cl->state != cs_spawned || !cl->netstats )
+			continue;
+
+		if( only && only != cl )
+			continue;
+
+		SV_NetStatsSummarize( cl->netstats, seconds, &s );
+
+		Con_Printf( "%3i %-15.15s %5.1f %6.1f %5.0f %5.0f %5.0f %5.0f %5.0f %4.0f/%4.0f/%4.0f ms %4.1f%% %4.1f%% %4.1f%% %4i %6i %4i\n",
+			i, cl->name, s.packets / s.duration, s.kbps,
+			s.bytes[NETSTAT_ENTITIES], s.bytes[NETSTAT_EVENTS], s.bytes[NETSTAT_VOICE], s.bytes[NETSTAT_RELIABLE], s.bytes[NETSTAT_OTHER],
+			s.rtt_min * 1000.0f, s.rtt_avg * 1000.0f, s.rtt_max * 1000.0f,
+			s.loss, s.choke, s.delta, s.full_updates, s.resends, s.fragments );
+	}
+}
+
+/*
+==================
+SV_NetStatsLog
+
+machine readable summaries go through server log,
+so they also reach logaddress when it's set
+==================
+*/
+void SV_NetStatsLog( void )
+{
+	sv_client_t	*cl;
+	int		i, j;
+
+	if( sv_netstats_log.value <= 0.0f || !svs.log.active )
+		return;
+
+	for( i = 0, cl = svs.clients; i < svs.maxclients; i++, cl++ )
+	{
+		int seconds = bound( 1, (int)sv_netstats_log.value, NETSTATS_SECONDS );
+		netstats_summary_t s;
+		string classes;
+		size_t len = 0;
+
+		if( cl->state != cs_spawned || !cl->netstats )
+			continue;
+
+		if( cl->netstats->next_logtime > host.realtime )
+			continue;
+
+		cl->netstats->next_logtime = host.realtime + seconds;
+		SV_NetStatsSummarize( cl->netstats, seconds, &s );
+
+		for( j = 0; j < NETSTAT_CLASSES; j++ )
+			len += Q_snprintf( classes + len, sizeof( classes ) - len, " (%s \"%.0f\")", netstat_names[j], s.bytes[j] );
+
+		Log_Printf( "\"%s<%i><%s><>\" netstats (packets \"%i\") (kbps \"%.1f\")%s (rtt \"%.0f\") (loss \"%.1f\") (clientloss \"%.1f\") (choke \"%.1f\") (delta \"%.1f\") (fullupdates \"%i\") (resends \"%i\") (fragments \"%i\")\n",
+			cl->name, cl->userid, SV_GetClientIDString( cl ), s.packets, s.kbps, classes, s.rtt_avg * 1000.0f,
+			s.loss, s.client_loss, s.choke, s.delta, s.full_updates, s.resends, s.fragments );
+	}
+}
+
+void SV_InitNetStats( void )
+{
+	Cvar_RegisterVariable( &sv_netstats );
+	Cvar_RegisterVariable( &sv_netstats_log );
+	Cmd_AddCommand( "netstats", SV_NetStats_f, "print per-client network telemetry, optionally takes number of seconds and #id or name" );
+}
+
+#if XASH_ENGINE_TESTS
+
+#include "tests.h"
+
+static void Test_NetStatsRecord( void )
+{
+	static sv_client_t cl;
+	netstat_frame_t frame, *stats;
+	netstats_summary_t s;
+	double realtime = host.realtime;
+	int i;
+
+	memset( &cl, 0, sizeof( cl ));
+	host.realtime = 100.25;
+	sv_netstats.value = 0.0f;
+
+	// disabled telemetry doesn't allocate anything
+	TASSERT( SV_NetStatsBeginFrame( &cl, &frame ) == NULL );
+	TASSERT( cl.netstats == NULL );
+
+	sv_netstats.value = 1.0f;
+	cl.netchan.outgoing_sequence = 1; // as after Netchan_Setup
+
+	for( i = 0; i < 10; i++ )
+	{
+		stats = SV_NetStatsBeginFrame( &cl, &frame );
+		TASSERT( stats != NULL );
+
+		stats->bytes[NETSTAT_ENTITIES] = 100;
+		stats->bytes[NETSTAT_EVENTS] = 10;
+		stats->delta_ents = 3;
+		stats->baseline_ents = 1;
+
+		cl.netchan.last_reliable_bytes = i == 0 ? 50 : 0;
+		cl.netchan.last_resend = i == 5;
+		cl.netchan.last_fragment = false;
+		cl.netchan.outgoing_sequence++;
+		SV_NetStatsEndFrame( &cl, stats, 130 );
+
+		if( i & 1 )
+			SV_NetStatsChoke( &cl );
+
+		host.realtime += 0.05;
+	}
+
+	// packets 1..10 are sent, ack 2, 3, 5, 9
+	cl.netchan.incoming_acknowledged = 2;
+	SV_NetStatsAck( &cl );
+	cl.netchan.incoming_acknowledged = 3;
+	SV_NetStatsAck( &cl );
+	SV_NetStatsAck( &cl ); // duplicate doesn't count
+	cl.netchan.incoming_acknowledged = 5;
+	SV_NetStatsAck( &cl );
+	cl.netchan.incoming_acknowledged = 9;
+	SV_NetStatsAck( &cl );
+
+	SV_NetStatsSummarize( cl.netstats, 10, &s );
+
+	TASSERT_EQi( s.packets, 10 );
+	TASSERT_EQi( s.resends, 1 );
+	TASSERT_EQi( (int)s.bytes[NETSTAT_ENTITIES], 100 );
+	TASSERT_EQi( (int)s.bytes[NETSTAT_EVENTS], 10 );
+	TASSERT_EQi( (int)s.bytes[NETSTAT_OTHER], 20 );
+	TASSERT_EQi( (int)( s.bytes[NETSTAT_RELIABLE] * 10 ), 50 );
+	TASSERT_EQi( (int)s.delta, 75 );
+
+	// 1, 4, 6, 7, 8 were skipped
+	TASSERT_EQi( (int)s.loss, 55 );
+
+	// 5 chokes for 10 packets
+	TASSERT_EQi( (int)( s.choke + 0.5f ), 33 );
+
+	// ack for 9 came 0.05 after 10th packet was sent
+	TASSERT_EQi( (int)( s.rtt_min * 1000.0f + 0.5f ), 100 );
+	TASSERT( s.rtt_max > s.rtt_min );
+
+	// everything is outside of one second window later
+	host.realtime += 5.0;
+	SV_NetStatsSummarize( cl.netstats, 1, &s );
+	TASSERT_EQi( s.packets, 0 );
+
+	SV_NetStatsFree( &cl );
+	TASSERT( cl.netstats == NULL );
+	sv_netstats.value = 0.0f;
+	host.realtime = realtime;
+}
+
+void Test_RunNetStats( void )
+{
+	Test_NetStatsRecord();
+}
+
+#endif // XASH_ENGINE_TESTS
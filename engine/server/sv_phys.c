@@ -42,6 +42,7 @@ solid_edge items only clip against bsp models.
 */
 #define MOVE_EPSILON	0.01f
 #define MAX_CLIP_PLANES	5
+#define PUSH_QUERY_EPSILON	2.0f	// riders rest on top of pusher bounds
 
 static const vec3_t current_table[] =
 {
@@ -183,6 +184,52 @@ void SV_UpdateBaseVelocity( edict_t *ent )
 	}
 }
 
+/*
+============
+SV_FixupClientHull
+
+to avoid falling through tracktrain update client mins\maxs here
+============
+*/
+static void SV_FixupClientHull( edict_t *ent )
+{
+	if( FBitSet( ent->v.flags, FL_DUCKING ))
+		SV_SetMinMaxSize( ent, host.player_mins[1], host.player_maxs[1], true );
+	else SV_SetMinMaxSize( ent, host.player_mins[0], host.player_maxs[0], true );
+}
+
+/*
+============
+SV_FixupClientHulls
+
+pushers gather and reject candidates by linked bounds,
+so client hulls must be up to date before that
+============
+*/
+static void SV_FixupClientHulls( void )
+{
+	edict_t	*ent;
+	int	i, hull;
+
+	for( i = 1; i <= svs.maxclients; i++ )
+	{
+		ent = EDICT_NUM( i );
+
+		if( !SV_IsValidEdict( ent ) || !ent->area.prev )
+			continue;
+
+		if( !FBitSet( ent->v.flags, FL_CLIENT|FL_FAKECLIENT ))
+			continue;
+
+		// don't relink clients that already have proper hull
+		hull = FBitSet( ent->v.flags, FL_DUCKING ) ? 1 : 0;
+		if( VectorCompare( ent->v.mins, host.player_mins[hull] ) && VectorCompare( ent->v.maxs, host.player_maxs[hull] ))
+			continue;
+
+		SV_FixupClientHull( ent );
+	}
+}
+
 /*
 ============
 SV_TestEntityPosition
@@ -196,12 +243,7 @@ static qboolean SV_TestEntityPosition( edict_t *ent, edict_t *blocker )
 	trace_t	trace;
 
 	if( FBitSet( ent->v.flags, FL_CLIENT|FL_FAKECLIENT ))
-	{
-		// to avoid falling through tracktrain update client mins\maxs here
-		if( FBitSet( ent->v.flags, FL_DUCKING ))
-			SV_SetMinMaxSize( ent, host.player_mins[1], host.player_maxs[1], true );
-		else SV_SetMinMaxSize( ent, host.player_mins[0], host.player_maxs[0], true );
-	}
+		SV_FixupClientHull( ent );
 
 	trace = SV_Move( ent->v.origin, ent->v.mins, ent->v.maxs, ent->v.origin, MOVE_NORMAL, ent, monsterClip );
 
@@ -889,6 +931,217 @@ static qboolean SV_CanBlock( edict_t *ent )
 	return true;
 }
 
+/*
+============
+SV_IsRider
+
+entity is standing on the pusher
+============
+*/
+static qboolean SV_IsRider( edict_t *ent, edict_t *pusher )
+{
+	return FBitSet( ent->v.flags, FL_ONGROUND ) && ent->v.groundentity == pusher;
+}
+
+/*
+============
+SV_AddLooseEdict
+
+pushable entity is not linked into areanodes,
+so pushers can't find it with area query
+============
+*/
+void SV_AddLooseEdict( edict_t *ent )
+{
+	if( !svgame.pushloosevalid || !SV_CanPushed( ent ))
+		return;
+
+	if( svgame.numpushloose >= GI->max_edicts )
+	{
+		// too many changes, scan all edicts until next frame
+		svgame.pushloosevalid = false;
+		return;
+	}
+
+	svgame.pushloose[svgame.numpushloose++] = ent;
+}
+
+/*
+============
+SV_IsMovingPusher
+
+world and resting pushers can't carry riders away
+============
+*/
+static qboolean SV_IsMovingPusher( edict_t *pusher )
+{
+	if( pusher == svgame.edicts || !SV_IsValidEdict( pusher ))
+		return false;
+
+	if( pusher->v.movetype != MOVETYPE_PUSH )
+		return false;
+
+	return !VectorIsNull( pusher->v.velocity ) || !VectorIsNull( pusher->v.avelocity );
+}
+
+/*
+============
+SV_BuildLooseEdicts
+
+collect pushables that area query may miss: unlinked
+ones and riders that were carried away from the pusher
+============
+*/
+static void SV_BuildLooseEdicts( void )
+{
+	edict_t	*ent;
+	int	i;
+
+	svgame.numpushloose = 0;
+	svgame.pushloosevalid = true;
+
+	for( i = 1; i < svgame.numEntities; i++ )
+	{
+		ent = EDICT_NUM( i );
+
+		if( !SV_IsValidEdict( ent ))
+			continue;
+
+		if( ent->area.prev && !( FBitSet( ent->v.flags, FL_ONGROUND ) && SV_IsMovingPusher( ent->v.groundentity )))
+			continue;
+
+		SV_AddLooseEdict( ent );
+	}
+}
+
+static void SV_AreaPushCandidates( link_t *head, const vec3_t mins, const vec3_t maxs, int *count )
+{
+	link_t	*l;
+	edict_t	*check;
+
+	for( l = head->next; l != head; l = l->next )
+	{
+		check = EDICT_FROM_AREA( l );
+
+		if( BoundsIntersect( mins, maxs, check->v.absmin, check->v.absmax ))
+			svgame.pushcandidates[(*count)++] = check;
+	}
+}
+
+/*
+============
+SV_AreaPushNode
+
+same walk as SV_TouchLinks but over all links
+============
+*/
+static void SV_AreaPushNode( areanode_t *node, const vec3_t mins, const vec3_t maxs, int *count )
+{
+	SV_AreaPushCandidates( &node->solid_edicts, mins, maxs, count );
+	SV_AreaPushCandidates( &node->trigger_edicts, mins, maxs, count );
+	SV_AreaPushCandidates( &node->portal_edicts, mins, maxs, count );
+
+	// recurse down both sides
+	if( node->axis == -1 ) return;
+
+	if( maxs[node->axis] > node->dist )
+		SV_AreaPushNode( node->children[0], mins, maxs, count );
+	if( mins[node->axis] < node->dist )
+		SV_AreaPushNode( node->children[1], mins, maxs, count );
+}
+
+static int SV_ComparePushCandidates( const void *a, const void *b )
+{
+	const edict_t *e1 = *(const edict_t **)a, *e2 = *(const edict_t **)b;
+
+	return ( e1 > e2 ) - ( e1 < e2 );
+}
+
+/*
+============
+SV_GatherPushCandidates
+
+entities pusher may touch while moving between old and new
+bounds, in edict order, so they are pushed in same order
+as full scan would do
+============
+*/
+static int SV_GatherPushCandidates( const vec3_t oldmins, const vec3_t oldmaxs, const vec3_t newmins, const vec3_t newmaxs )
+{
+	edict_t	**list = svgame.pushcandidates;
+	vec3_t	mins, maxs;
+	int	i, j, count = 0;
+
+	svgame.pushstats.pushes++;
+
+	if( !sv_pushquery.value || !svgame.pushloosevalid )
+	{
+		for( i = 1; i < svgame.numEntities; i++ )
+			list[count++] = EDICT_NUM( i );
+
+		svgame.pushstats.candidates += count;
+		return count;
+	}
+
+	// riders standing on top don't overlap pusher bounds, expand them
+	for( i = 0; i < 3; i++ )
+	{
+		mins[i] = Q_min( oldmins[i], newmins[i] ) - PUSH_QUERY_EPSILON;
+		maxs[i] = Q_max( oldmaxs[i], newmaxs[i] ) + PUSH_QUERY_EPSILON;
+	}
+
+	SV_AreaPushNode( sv_areanodes, mins, maxs, &count );
+
+	for( i = 0; i < svgame.numpushloose; i++ )
+		list[count++] = svgame.pushloose[i];
+
+	qsort( list, count, sizeof( *list ), SV_ComparePushCandidates );
+
+	// riders are often linked nearby too
+	for( i = j = 0; i < count; i++ )
+	{
+		if( j == 0 || list[j - 1] != list[i] )
+			list[j++] = list[i];
+	}
+
+	svgame.pushstats.candidates += j;
+	return j;
+}
+
+/*
+============
+SV_PushStats_f
+
+pushstats
+============
+*/
+void SV_PushStats_f( void )
+{
+	const sv_pushstats_t *stats = &svgame.pushstats;
+
+	if( stats->pushes > 0 )
+	{
+		Con_Printf( "%i pushes, %.1f candidates and %.1f traces per push\n", stats->pushes,
+			(float)stats->candidates / stats->pushes, (float)stats->traces / stats->pushes );
+	}
+	else Con_Printf( "no pushes\n" );
+
+	memset( &svgame.pushstats, 0, sizeof( svgame.pushstats ));
+}
+
+/*
+============
+SV_TestPushedPosition
+
+SV_TestEntityPosition for pushed entities, counted in pushstats
+============
+*/
+static qboolean SV_TestPushedPosition( edict_t *ent, edict_t *blocker )
+{
+	svgame.pushstats.traces++;
+	return SV_TestEntityPosition( ent, blocker );
+}
+
 /*
 ============
 SV_PushMove
@@ -898,10 +1151,12 @@ SV_PushMove
 static edict_t *SV_PushMove( edict_t *pusher, float movetime )
 {
 	int		i, e, block;
-	int		num_moved, oldsolid;
+	int		numcandidates, oldsolid;
 	vec3_t		mins, maxs, lmove;
+	vec3_t		oldmins, oldmaxs;
 	sv_pushed_t	*p, *pushed_p;
 	edict_t		*check;
+	qboolean		rider;
 
 	if( svgame.globals->changelevel || VectorIsNull( pusher->v.velocity ))
 	{
@@ -916,6 +1171,9 @@ static edict_t *SV_PushMove( edict_t *pusher, float movetime )
 		maxs[i] = pusher->v.absmax[i] + lmove[i];
 	}
 
+	VectorCopy( pusher->v.absmin, oldmins );
+	VectorCopy( pusher->v.absmax, oldmaxs );
+
 	pushed_p = svgame.pushed;
 
 	// save the pusher's original position
@@ -935,24 +1193,23 @@ static edict_t *SV_PushMove( edict_t *pusher, float movetime )
 		return NULL;
 
 	// see if any solid entities are inside the final position
-	num_moved = 0;
+	SV_FixupClientHulls();
+	numcandidates = SV_GatherPushCandidates( oldmins, oldmaxs, mins, maxs );
 
-	for( e = 1; e < svgame.numEntities; e++ )
+	for( e = 0; e < numcandidates; e++ )
 	{
-		check = EDICT_NUM( e );
+		check = svgame.pushcandidates[e];
 		if( !SV_IsValidEdict( check )) continue;
 
 		// filter movetypes to collide with
 		if( !SV_CanPushed( check ))
 			continue;
 
-		pusher->v.solid = SOLID_NOT;
-		block = SV_TestEntityPosition( check, pusher );
-		pusher->v.solid = oldsolid;
-		if( block ) continue;
-
 		// if the entity is standing on the pusher, it will definately be moved
-		if( !( FBitSet( check->v.flags, FL_ONGROUND ) && check->v.groundentity == pusher ))
+		rider = SV_IsRider( check, pusher );
+
+		// bounds rejection is cheap, do it before any trace
+		if( !rider )
 		{
 			if( check->v.absmin[0] >= maxs[0]
 			 || check->v.absmin[1] >= maxs[1]
@@ -961,12 +1218,17 @@ static edict_t *SV_PushMove( edict_t *pusher, float movetime )
 			 || check->v.absmax[1] <= mins[1]
 			 || check->v.absmax[2] <= mins[2] )
 				continue;
-
-			// see if the ent's bbox is inside the pusher's final position
-			if( !SV_TestEntityPosition( check, NULL ))
-				continue;
 		}
 
+		pusher->v.solid = SOLID_NOT;
+		block = SV_TestPushedPosition( check, pusher );
+		pusher->v.solid = oldsolid;
+		if( block ) continue;
+
+		// see if the ent's bbox is inside the pusher's final position
+		if( !rider && !SV_TestPushedPosition( check, NULL ))
+			continue;
+
 		// remove the onground flag for non-players
 		if( check->v.movetype != MOVETYPE_WALK )
 			check->v.flags &= ~FL_ONGROUND;
@@ -983,7 +1245,7 @@ static edict_t *SV_PushMove( edict_t *pusher, float movetime )
 		pusher->v.solid = oldsolid;
 
 		// if it is still inside the pusher, block
-		if( SV_TestEntityPosition( check, NULL ) && block )
+		if( SV_TestPushedPosition( check, NULL ) && block )
 		{
 			if( !SV_CanBlock( check ))
 				continue;
@@ -1015,11 +1277,14 @@ SV_PushRotate
 static edict_t *SV_PushRotate( edict_t *pusher, float movetime )
 {
 	int		i, e, block, oldsolid;
+	int		numcandidates;
 	matrix4x4		start_l, end_l;
 	vec3_t		lmove, amove;
+	vec3_t		oldmins, oldmaxs;
 	sv_pushed_t	*p, *pushed_p;
 	vec3_t		org, org2, temp;
 	edict_t		*check;
+	qboolean		rider;
 
 	if( svgame.globals->changelevel || VectorIsNull( pusher->v.avelocity ))
 	{
@@ -1041,6 +1306,9 @@ static edict_t *SV_PushRotate( edict_t *pusher, float movetime )
 	VectorCopy( pusher->v.angles, pushed_p->angles );
 	pushed_p++;
 
+	VectorCopy( pusher->v.absmin, oldmins );
+	VectorCopy( pusher->v.absmax, oldmaxs );
+
 	// move the pusher to it's final position
 	SV_AngularMove( pusher, movetime, pusher->v.friction );
 	SV_LinkEdict( pusher, false );
@@ -1055,9 +1323,12 @@ static edict_t *SV_PushRotate( edict_t *pusher, float movetime )
 	Matrix4x4_CreateFromEntity( end_l, pusher->v.angles, pusher->v.origin, 1.0f );
 
 	// see if any solid entities are inside the final position
-	for( e = 1; e < svgame.numEntities; e++ )
+	SV_FixupClientHulls();
+	numcandidates = SV_GatherPushCandidates( oldmins, oldmaxs, pusher->v.absmin, pusher->v.absmax );
+
+	for( e = 0; e < numcandidates; e++ )
 	{
-		check = EDICT_NUM( e );
+		check = svgame.pushcandidates[e];
 		if( !SV_IsValidEdict( check ))
 			continue;
 
@@ -1065,13 +1336,11 @@ static edict_t *SV_PushRotate( edict_t *pusher, float movetime )
 		if( !SV_CanPushed( check ))
 			continue;
 
-		pusher->v.solid = SOLID_NOT;
-		block = SV_TestEntityPosition( check, pusher );
-		pusher->v.solid = oldsolid;
-		if( block ) continue;
-
 		// if the entity is standing on the pusher, it will definately be moved
-		if( !(( check->v.flags & FL_ONGROUND ) && check->v.groundentity == pusher ))
+		rider = SV_IsRider( check, pusher );
+
+		// bounds rejection is cheap, do it before any trace
+		if( !rider )
 		{
 			if( check->v.absmin[0] >= pusher->v.absmax[0]
 			|| check->v.absmin[1] >= pusher->v.absmax[1]
@@ -1080,12 +1349,17 @@ static edict_t *SV_PushRotate( edict_t *pusher, float movetime )
 			|| check->v.absmax[1] <= pusher->v.absmin[1]
 			|| check->v.absmax[2] <= pusher->v.absmin[2] )
 				continue;
-
-			// see if the ent's bbox is inside the pusher's final position
-			if( !SV_TestEntityPosition( check, NULL ))
-				continue;
 		}
 
+		pusher->v.solid = SOLID_NOT;
+		block = SV_TestPushedPosition( check, pusher );
+		pusher->v.solid = oldsolid;
+		if( block ) continue;
+
+		// see if the ent's bbox is inside the pusher's final position
+		if( !rider && !SV_TestPushedPosition( check, NULL ))
+			continue;
+
 		// save original position of contacted entity
 		pushed_p->ent = check;
 		VectorCopy( check->v.origin, pushed_p->origin );
@@ -1120,7 +1394,7 @@ static edict_t *SV_PushRotate( edict_t *pusher, float movetime )
 			check->v.flags &= ~FL_ONGROUND;
 
 		// if it is still inside the pusher, block
-		if( SV_TestEntityPosition( check, NULL ) && block )
+		if( SV_TestPushedPosition( check, NULL ) && block )
 		{
 			if( !SV_CanBlock( check ))
 				continue;
@@ -1719,6 +1993,42 @@ static void SV_Physics_None( edict_t *ent )
 	SV_RunThink( ent );
 }
 
+/*
+================
+SV_IsIdleEntity
+
+physics would only find out that think isn't due yet,
+game dll writes entvars directly, so it can't be cached
+and have to be checked again every frame
+================
+*/
+static qboolean SV_IsIdleEntity( const edict_t *ent )
+{
+	float	thinktime = ent->v.nextthink;
+	edict_t	*groundentity;
+
+	if( ent->v.movetype != MOVETYPE_NONE )
+		return false;
+
+	if( FBitSet( ent->v.flags, FL_BASEVELOCITY|FL_KILLME ) || !VectorIsNull( ent->v.basevelocity ))
+		return false;
+
+	// same check as SV_RunThink does
+	if( thinktime > 0.0f && thinktime <= ( sv.time + sv.frametime ))
+		return false;
+
+	// standing on conveyor belt gets basevelocity
+	if( FBitSet( ent->v.flags, FL_ONGROUND ))
+	{
+		groundentity = ent->v.groundentity;
+
+		if( SV_IsValidEdict( groundentity ) && FBitSet( groundentity->v.flags, FL_CONVEYOR ))
+			return false;
+	}
+
+	return true;
+}
+
 //============================================================================
 static void SV_Physics_Entity( edict_t *ent )
 {
@@ -1804,23 +2114,17 @@ static void SV_RunLightStyles( void )
 
 /*
 ================
-SV_Physics
+SV_RunEntities
 
+treat each object in turn
 ================
 */
-void SV_Physics( void )
+static void SV_RunEntities( void )
 {
+	qboolean	skipidle = sv_skipidle.value && !svgame.physFuncs.SV_PhysicsEntity;
 	edict_t	*ent;
-	int    	i;
-
-	SV_CheckAllEnts ();
-
-	svgame.globals->time = sv.time;
+	int	i, active = 0, idle = 0;
 
-	// let the progs know that a new frame has started
-	svgame.dllFuncs.pfnStartFrame();
-
-	// treat each object in turn
 	for( i = 0; i < svgame.numEntities; i++ )
 	{
 		ent = EDICT_NUM( i );
@@ -1831,9 +2135,41 @@ void SV_Physics( void )
 		if( i > 0 && i <= svs.maxclients )
 			continue;
 
+		// thinking entity may ask to retouch everything
+		if( skipidle && svgame.globals->force_retouch == 0.0f && SV_IsIdleEntity( ent ))
+		{
+			idle++;
+			continue;
+		}
+
 		SV_Physics_Entity( ent );
+		active++;
 	}
 
+	svgame.physstats.active = active;
+	svgame.physstats.idle = idle;
+}
+
+/*
+================
+SV_Physics
+
+================
+*/
+void SV_Physics( void )
+{
+	SV_CheckAllEnts ();
+
+	svgame.globals->time = sv.time;
+
+	// let the progs know that a new frame has started
+	svgame.dllFuncs.pfnStartFrame();
+
+	// pushers look up the rest through areanodes
+	SV_BuildLooseEdicts();
+
+	SV_RunEntities();
+
 	if( svgame.globals->force_retouch != 0.0f )
 		svgame.globals->force_retouch--;
 
@@ -2161,3 +2497,253 @@ qboolean SV_InitPhysicsAPI( void )
 	Host_ValidateEngineFeatures( 0 );
 	return true;
 }
+
+#if XASH_ENGINE_TESTS
+#include "tests.h"
+
+static void Test_PushQuery_Link( edict_t *ent, link_t *head, float x, float y, float z, float size )
+{
+	VectorSet( ent->v.absmin, x, y, z );
+	VectorSet( ent->v.absmax, x + size, y + size, z + size );
+
+	ent->area.next = head;
+	ent->area.prev = head->prev;
+	ent->area.prev->next = &ent->area;
+	head->prev = &ent->area;
+}
+
+static void Test_PushQuery_Gather( void )
+{
+	static const vec3_t	mins = { 0, 0, 0 }, maxs = { 64, 64, 16 };
+	static gameinfo_t	gameinfo;
+	gameinfo_t	*oldgameinfo = GI;
+	edict_t	ents[10], *candidates[20], *loose[10];
+	edict_t	*oldedicts = svgame.edicts;
+	int	oldnumentities = svgame.numEntities;
+	float	oldquery = sv_pushquery.value;
+	areanode_t	*root = &sv_areanodes[0];
+	int	i, count;
+
+	memset( ents, 0, sizeof( ents ));
+	memset( sv_areanodes, 0, sizeof( *sv_areanodes ) * 3 );
+
+	// no game is loaded during tests
+	gameinfo.max_edicts = ARRAYSIZE( ents );
+	GI = &gameinfo;
+
+	svgame.edicts = ents;
+	svgame.numEntities = ARRAYSIZE( ents );
+	svgame.pushcandidates = candidates;
+	svgame.pushloose = loose;
+	sv_pushquery.value = 1.0f;
+
+	// split at x = 256
+	root->axis = 0;
+	root->dist = 256.0f;
+	root->children[0] = &sv_areanodes[1];
+	root->children[1] = &sv_areanodes[2];
+
+	for( i = 0; i < 3; i++ )
+	{
+		link_t *lists[3] = { &sv_areanodes[i].solid_edicts, &sv_areanodes[i].trigger_edicts, &sv_areanodes[i].portal_edicts };
+		int j;
+
+		if( i > 0 ) sv_areanodes[i].axis = -1;
+
+		for( j = 0; j < 3; j++ )
+			lists[j]->next = lists[j]->prev = lists[j];
+	}
+
+	for( i = 1; i < ARRAYSIZE( ents ); i++ )
+		ents[i].v.movetype = MOVETYPE_STEP;
+
+	// world is a pusher too, but never carries anything away
+	ents[0].v.movetype = MOVETYPE_PUSH;
+
+	// pusher
+	ents[1].v.movetype = MOVETYPE_PUSH;
+	ents[1].v.velocity[2] = 100.0f;
+	Test_PushQuery_Link( &ents[1], &sv_areanodes[2].solid_edicts, 0, 0, 0, 64 );
+	ents[1].v.absmax[2] = 16;
+
+	// rider carried away from the pusher
+	ents[2].v.movetype = MOVETYPE_WALK;
+	ents[2].v.flags = FL_ONGROUND;
+	ents[2].v.groundentity = &ents[1];
+	Test_PushQuery_Link( &ents[2], &sv_areanodes[1].solid_edicts, 500, 500, 500, 32 );
+
+	// item resting on top
+	Test_PushQuery_Link( &ents[3], &sv_areanodes[2].trigger_edicts, 10, 10, 17, 16 );
+
+	// far away, standing on world
+	ents[4].v.flags = FL_ONGROUND;
+	ents[4].v.groundentity = &ents[0];
+	Test_PushQuery_Link( &ents[4], &sv_areanodes[2].solid_edicts, -500, 0, 0, 32 );
+
+	// corpse isn't linked, ents[6] is static
+	ents[5].v.movetype = MOVETYPE_TOSS;
+	ents[6].v.movetype = MOVETYPE_NONE;
+	ents[7].free = true;
+
+	// rider of resting pusher, both far away
+	ents[8].v.movetype = MOVETYPE_PUSH;
+	Test_PushQuery_Link( &ents[8], &sv_areanodes[1].solid_edicts, 1000, 0, 0, 64 );
+	ents[9].v.flags = FL_ONGROUND;
+	ents[9].v.groundentity = &ents[8];
+	Test_PushQuery_Link( &ents[9], &sv_areanodes[1].solid_edicts, 1000, 0, 64, 32 );
+
+	SV_BuildLooseEdicts();
+	TASSERT_EQi( svgame.numpushloose, 2 );
+
+	count = SV_GatherPushCandidates( mins, maxs, mins, maxs );
+	TASSERT_EQi( count, 4 );
+	TASSERT( candidates[0] == &ents[1] );
+	TASSERT( candidates[1] == &ents[2] );
+	TASSERT( candidates[2] == &ents[3] );
+	TASSERT( candidates[3] == &ents[5] );
+
+	// entities unlinked during the frame are remembered
+	ents[4].area.prev->next = ents[4].area.next;
+	ents[4].area.next->prev = ents[4].area.prev;
+	ents[4].area.prev = ents[4].area.next = NULL;
+	SV_AddLooseEdict( &ents[4] );
+	SV_AddLooseEdict( &ents[6] );
+	TASSERT_EQi( SV_GatherPushCandidates( mins, maxs, mins, maxs ), 5 );
+
+	// otherwise every edict is checked
+	svgame.pushloosevalid = false;
+	TASSERT_EQi( SV_GatherPushCandidates( mins, maxs, mins, maxs ), (int)ARRAYSIZE( ents ) - 1 );
+
+	sv_pushquery.value = 0.0f;
+	svgame.pushloosevalid = true;
+	TASSERT_EQi( SV_GatherPushCandidates( mins, maxs, mins, maxs ), (int)ARRAYSIZE( ents ) - 1 );
+	TASSERT_EQi( svgame.pushstats.pushes, 4 );
+
+	memset( sv_areanodes, 0, sizeof( *sv_areanodes ) * 3 );
+	memset( &svgame.pushstats, 0, sizeof( svgame.pushstats ));
+	svgame.edicts = oldedicts;
+	svgame.numEntities = oldnumentities;
+	svgame.pushcandidates = svgame.pushloose = NULL;
+	svgame.numpushloose = 0;
+	svgame.pushloosevalid = false;
+	sv_pushquery.value = oldquery;
+	GI = oldgameinfo;
+}
+
+static void Test_Physics_Idle( void )
+{
+	edict_t	ent, conveyor;
+	double	oldtime = sv.time;
+	float	oldframetime = sv.frametime;
+
+	memset( &ent, 0, sizeof( ent ));
+	memset( &conveyor, 0, sizeof( conveyor ));
+	sv.time = 10.0;
+	sv.frametime = 0.1f;
+
+	TASSERT( SV_IsIdleEntity( &ent ));
+
+	ent.v.nextthink = 10.05f;
+	TASSERT( !SV_IsIdleEntity( &ent ));
+
+	ent.v.nextthink = 11.0f;
+	TASSERT( SV_IsIdleEntity( &ent ));
+
+	ent.v.basevelocity[2] = 1.0f;
+	TASSERT( !SV_IsIdleEntity( &ent ));
+	ent.v.basevelocity[2] = 0.0f;
+
+	ent.v.flags = FL_KILLME;
+	TASSERT( !SV_IsIdleEntity( &ent ));
+
+	ent.v.flags = 0;
+	ent.v.movetype = MOVETYPE_TOSS;
+	TASSERT( !SV_IsIdleEntity( &ent ));
+
+	sv.time = oldtime;
+	sv.frametime = oldframetime;
+}
+
+void Test_RunPhysics( void )
+{
+	TRUN( Test_PushQuery_Gather() );
+	TRUN( Test_Physics_Idle() );
+}
+
+#define BENCH_PHYS_EDICTS	20000
+
+typedef struct
+{
+	gameinfo_t	gameinfo;
+	globalvars_t	globals;
+	edict_t		edicts[BENCH_PHYS_EDICTS];
+} bench_physics_t;
+
+static void Bench_SV_RunEntities( void *data, int count )
+{
+	int i;
+
+	for( i = 0; i < count; i++ )
+	{
+		SV_RunEntities();
+		bench_sink += svgame.physstats.active;
+	}
+}
+
+/*
+===============
+Bench_RunPhysics
+
+map full of static props, one of 16 thinks
+some time later
+===============
+*/
+void Bench_RunPhysics( void )
+{
+	bench_physics_t	*b = Mem_Calloc( host.mempool, sizeof( *b ));
+	gameinfo_t	*oldgameinfo = GI;
+	globalvars_t	*oldglobals = svgame.globals;
+	edict_t		*oldedicts = svgame.edicts;
+	int		oldnumentities = svgame.numEntities;
+	int		oldmaxclients = svs.maxclients;
+	float		oldskipidle = sv_skipidle.value;
+	double		oldtime = sv.time;
+	float		oldframetime = sv.frametime;
+	int		i;
+
+	b->gameinfo.max_edicts = BENCH_PHYS_EDICTS;
+	GI = &b->gameinfo;
+	svgame.globals = &b->globals;
+	svgame.edicts = b->edicts;
+	svgame.numEntities = BENCH_PHYS_EDICTS;
+	svs.maxclients = 0;
+	sv.time = 1.0;
+	sv.frametime = 0.01f;
+
+	for( i = 1; i < BENCH_PHYS_EDICTS; i++ )
+	{
+		if(( i & 15 ) == 0 )
+			b->edicts[i].v.nextthink = 100.0f;
+	}
+
+	// world
+	b->edicts[0].v.movetype = MOVETYPE_PUSH;
+
+	sv_skipidle.value = 0.0f;
+	Bench_Run( "SV_RunEntities", Bench_SV_RunEntities, b, 10 );
+	sv_skipidle.value = 1.0f;
+	Bench_Run( "SV_RunEntities skipidle", Bench_SV_RunEntities, b, 10 );
+
+	sv_skipidle.value = oldskipidle;
+	sv.time = oldtime;
+	sv.frametime = oldframetime;
+	svs.maxclients = oldmaxclients;
+	svgame.numEntities = oldnumentities;
+	svgame.edicts = oldedicts;
+	svgame.globals = oldglobals;
+	memset( &svgame.physstats, 0, sizeof( svgame.physstats ));
+	GI = oldgameinfo;
+	Mem_Free( b );
+}
+
+#endif // XASH_ENGINE_TESTS
@@ -408,6 +408,271 @@ static void InsertLinkBefore( link_t *l, link_t *before )
 /*
 ===============================================================================
 
+TRIGGER CONTACT CACHE
+
+===============================================================================
+*/
+#define TOUCH_CACHE_SIZE	2048	// must be power of two
+
+typedef struct
+{
+	int		ent, trigger;	// edict numbers, zero means unused slot
+	int		entserial, triggerserial;
+	vec3_t		origin, mins, maxs;	// entity state when the hull was tested
+	vec3_t		torigin, tangles;	// trigger state when the hull was tested
+	int		modelindex;
+	qboolean		inside;
+} touchcache_t;
+
+static touchcache_t	sv_touchcache[TOUCH_CACHE_SIZE];
+
+/*
+====================
+SV_ClearTouchCache
+
+forget all cached trigger contacts
+====================
+*/
+static void SV_ClearTouchCache( void )
+{
+	memset( sv_touchcache, 0, sizeof( sv_touchcache ));
+}
+
+/*
+====================
+SV_TestTriggerHull
+
+precise test of entity origin against brush trigger hull
+====================
+*/
+static qboolean SV_TestTriggerHull( edict_t *ent, edict_t *touch, model_t *mod )
+{
+	hull_t	*hull;
+	vec3_t	test, offset;
+
+	// force to select bsp-hull
+	hull = SV_HullForBsp( touch, ent->v.mins, ent->v.maxs, offset );
+
+	// support for rotational triggers
+	if( FBitSet( mod->flags, MODEL_HAS_ORIGIN ) && !VectorIsNull( touch->v.angles ))
+	{
+		matrix4x4	matrix;
+		Matrix4x4_CreateFromEntity( matrix, touch->v.angles, offset, 1.0f );
+		Matrix4x4_VectorITransform( matrix, ent->v.origin, test );
+	}
+	else
+	{
+		// offset the test point appropriately for this hull.
+		VectorSubtract( ent->v.origin, offset, test );
+	}
+
+	// test hull for intersection with this model
+	return PM_HullPointContents( hull, hull->firstclipnode, test ) == CONTENTS_SOLID;
+}
+
+/*
+====================
+SV_TriggerContact
+
+cached version of SV_TestTriggerHull. Result is reused
+while neither entity nor trigger has moved since last test
+====================
+*/
+static qboolean SV_TriggerContact( edict_t *ent, edict_t *touch, model_t *mod )
+{
+	int		e1 = NUM_FOR_EDICT( ent );
+	int		e2 = NUM_FOR_EDICT( touch );
+	touchcache_t	*tc;
+	qboolean		inside;
+
+	// user dll may pick hulls by own rules, we can't predict them
+	if( !sv_touchcache_enable.value || svgame.physFuncs.SV_HullForBsp != NULL )
+		return SV_TestTriggerHull( ent, touch, mod );
+
+	tc = &sv_touchcache[(e1 * 31 + e2 * 7919) & ( TOUCH_CACHE_SIZE - 1 )];
+
+	if( tc->ent == e1 && tc->trigger == e2 && tc->entserial == ent->serialnumber
+	 && tc->triggerserial == touch->serialnumber && tc->modelindex == touch->v.modelindex
+	 && VectorCompare( tc->origin, ent->v.origin ) && VectorCompare( tc->mins, ent->v.mins )
+	 && VectorCompare( tc->maxs, ent->v.maxs ) && VectorCompare( tc->torigin, touch->v.origin )
+	 && VectorCompare( tc->tangles, touch->v.angles ))
+	{
+		if( sv_touchcache_enable.value >= 2.0f )
+		{
+			inside = SV_TestTriggerHull( ent, touch, mod );
+
+			if( inside != tc->inside )
+			{
+				Con_Printf( S_ERROR "%s: cached contact %s -> %s mismatch (%i != %i)\n", __func__,
+					SV_ClassName( ent ), SV_ClassName( touch ), tc->inside, inside );
+			}
+		}
+
+		return tc->inside;
+	}
+
+	inside = SV_TestTriggerHull( ent, touch, mod );
+
+	tc->ent = e1;
+	tc->trigger = e2;
+	tc->entserial = ent->serialnumber;
+	tc->triggerserial = touch->serialnumber;
+	tc->modelindex = touch->v.modelindex;
+	VectorCopy( ent->v.origin, tc->origin );
+	VectorCopy( ent->v.mins, tc->mins );
+	VectorCopy( ent->v.maxs, tc->maxs );
+	VectorCopy( touch->v.origin, tc->torigin );
+	VectorCopy( touch->v.angles, tc->tangles );
+	tc->inside = inside;
+
+	return inside;
+}
+
+/*
+===============================================================================
+
+TRIGGER SWEEP
+
+===============================================================================
+*/
+typedef struct
+{
+	vec3_t		absmin, absmax;	// trigger bounds when the list was built
+	int		order;		// position in node trigger list
+} triggersweep_t;
+
+typedef struct
+{
+	triggersweep_t	*sweep;		// sorted by absmin along axis
+	edict_t		**edicts;		// in node trigger list order
+	int		numtriggers;
+	int		maxtriggers;
+	int		axis;
+	float		maxsize;		// largest trigger along axis
+	qboolean		dirty;
+} triggernode_t;
+
+static triggernode_t	sv_triggernodes[AREA_NODES];
+static int		*sv_touchhits;
+static int		sv_maxtouchhits;
+static int		sv_sweepaxis;
+
+/*
+====================
+SV_ClearTriggerSweep
+
+lists are rebuilt on next query
+====================
+*/
+static void SV_ClearTriggerSweep( void )
+{
+	int	i;
+
+	for( i = 0; i < AREA_NODES; i++ )
+	{
+		sv_triggernodes[i].numtriggers = 0;
+		sv_triggernodes[i].dirty = true;
+	}
+
+	if( svgame.triggernode )
+		memset( svgame.triggernode, 0, sizeof( *svgame.triggernode ) * GI->max_edicts );
+}
+
+/*
+====================
+SV_TriggerSweepLinked
+
+remember areanode trigger list the entity was put to,
+NULL node means it was removed from any list
+====================
+*/
+static void SV_TriggerSweepLinked( edict_t *ent, areanode_t *node )
+{
+	int	num = ent - svgame.edicts;
+	int	index = node ? node - sv_areanodes + 1 : 0;
+
+	if( !svgame.triggernode )
+		return;
+
+	if( svgame.triggernode[num] )
+		sv_triggernodes[svgame.triggernode[num] - 1].dirty = true;
+
+	if( index )
+		sv_triggernodes[index - 1].dirty = true;
+
+	svgame.triggernode[num] = index;
+}
+
+static int SV_SortTriggerSweep( const void *a, const void *b )
+{
+	float	d = ((const triggersweep_t *)a)->absmin[sv_sweepaxis] - ((const triggersweep_t *)b)->absmin[sv_sweepaxis];
+
+	if( d < 0.0f ) return -1;
+	if( d > 0.0f ) return 1;
+	return ((const triggersweep_t *)a)->order - ((const triggersweep_t *)b)->order;
+}
+
+static int SV_SortTouchHits( const void *a, const void *b )
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+/*
+====================
+SV_BuildTriggerSweep
+
+triggers linked at the node are crossing the node plane,
+so they are sorted along the other axis
+====================
+*/
+static void SV_BuildTriggerSweep( areanode_t *node, triggernode_t *tn )
+{
+	triggersweep_t	*ts;
+	edict_t		*touch;
+	link_t		*l;
+	int		i, count = 0;
+
+	for( l = node->trigger_edicts.next; l != &node->trigger_edicts; l = l->next )
+		count++;
+
+	if( count > tn->maxtriggers )
+	{
+		tn->maxtriggers = count * 2;
+		tn->sweep = Mem_Realloc( host.mempool, tn->sweep, sizeof( *tn->sweep ) * tn->maxtriggers );
+		tn->edicts = Mem_Realloc( host.mempool, tn->edicts, sizeof( *tn->edicts ) * tn->maxtriggers );
+	}
+
+	if( count > sv_maxtouchhits )
+	{
+		sv_maxtouchhits = count * 2;
+		sv_touchhits = Mem_Realloc( host.mempool, sv_touchhits, sizeof( *sv_touchhits ) * sv_maxtouchhits );
+	}
+
+	tn->axis = ( node->axis == 0 ) ? 1 : 0;
+	tn->maxsize = 0.0f;
+
+	for( i = 0, l = node->trigger_edicts.next; l != &node->trigger_edicts; i++, l = l->next )
+	{
+		touch = EDICT_FROM_AREA( l );
+		ts = &tn->sweep[i];
+
+		VectorCopy( touch->v.absmin, ts->absmin );
+		VectorCopy( touch->v.absmax, ts->absmax );
+		ts->order = i;
+		tn->edicts[i] = touch;
+		tn->maxsize = Q_max( tn->maxsize, ts->absmax[tn->axis] - ts->absmin[tn->axis] );
+	}
+
+	tn->numtriggers = count;
+	tn->dirty = false;
+
+	sv_sweepaxis = tn->axis;
+	qsort( tn->sweep, count, sizeof( *tn->sweep ), SV_SortTriggerSweep );
+}
+
+/*
+===============================================================================
+
 ENTITY AREA CHECKING
 
 ===============================================================================
@@ -484,7 +749,18 @@ void SV_ClearWorld( void )
 	iTouchLinkSemaphore = 0;
 	sv_numareanodes = 0;
 
+	SV_ClearTouchCache();
+	SV_ClearTriggerSweep();
+
+	// gathered again on first physics frame
+	svgame.numpushloose = 0;
+	svgame.pushloosevalid = false;
+	memset( &svgame.pushstats, 0, sizeof( svgame.pushstats ));
+	memset( &svgame.physstats, 0, sizeof( svgame.physstats ));
+
 	SV_CreateAreaNode( 0, sv.worldmodel->mins, sv.worldmodel->maxs );
+
+	SV_InitLightGrid();
 }
 
 /*
@@ -497,6 +773,8 @@ void SV_UnlinkEdict( edict_t *ent )
 	// not linked in anywhere
 	if( !ent->area.prev ) return;
 
+	SV_GroundSupportLinked( ent, false );
+	SV_TriggerSweepLinked( ent, NULL );
 	RemoveLink( &ent->area );
 	ent->area.prev = NULL;
 	ent->area.next = NULL;
@@ -504,78 +782,133 @@ void SV_UnlinkEdict( edict_t *ent )
 
 /*
 ====================
-SV_TouchLinks
+SV_TouchTrigger
 ====================
 */
-static void SV_TouchLinks( edict_t *ent, areanode_t *node )
+static void SV_TouchTrigger( edict_t *ent, edict_t *touch )
 {
-	link_t	*l, *next;
-	edict_t	*touch;
-	hull_t	*hull;
-	vec3_t	test, offset;
 	model_t	*mod;
 
-	// touch linked edicts
-	for( l = node->trigger_edicts.next; l != &node->trigger_edicts; l = next )
+	if( svgame.physFuncs.SV_TriggerTouch != NULL )
 	{
-		next = l->next;
-		touch = EDICT_FROM_AREA( l );
+		// user dll can override trigger checking (Xash3D extension)
+		if( !svgame.physFuncs.SV_TriggerTouch( ent, touch ))
+			return;
+	}
+	else
+	{
+		if( touch == ent || touch->v.solid != SOLID_TRIGGER ) // disabled ?
+			return;
 
-		if( svgame.physFuncs.SV_TriggerTouch != NULL )
+		if( touch->v.groupinfo && ent->v.groupinfo )
 		{
-			// user dll can override trigger checking (Xash3D extension)
-			if( !svgame.physFuncs.SV_TriggerTouch( ent, touch ))
-				continue;
+			if( svs.groupop == GROUP_OP_AND && !FBitSet( touch->v.groupinfo, ent->v.groupinfo ))
+				return;
+
+			if( svs.groupop == GROUP_OP_NAND && FBitSet( touch->v.groupinfo, ent->v.groupinfo ))
+				return;
 		}
-		else
-		{
-			if( touch == ent || touch->v.solid != SOLID_TRIGGER ) // disabled ?
-				continue;
 
-			if( touch->v.groupinfo && ent->v.groupinfo )
-			{
-				if( svs.groupop == GROUP_OP_AND && !FBitSet( touch->v.groupinfo, ent->v.groupinfo ))
-					continue;
+		if( !BoundsIntersect( ent->v.absmin, ent->v.absmax, touch->v.absmin, touch->v.absmax ))
+			return;
 
-				if( svs.groupop == GROUP_OP_NAND && FBitSet( touch->v.groupinfo, ent->v.groupinfo ))
-					continue;
-			}
+		mod = SV_ModelHandle( touch->v.modelindex );
 
-			if( !BoundsIntersect( ent->v.absmin, ent->v.absmax, touch->v.absmin, touch->v.absmax ))
-				continue;
+		// check brush triggers accuracy
+		if( mod && mod->type == mod_brush && !SV_TriggerContact( ent, touch, mod ))
+			return;
+	}
 
-			mod = SV_ModelHandle( touch->v.modelindex );
+	// never touch the triggers when "playersonly" is active
+	if( !sv.playersonly )
+	{
+		svgame.globals->time = sv.time;
+		svgame.dllFuncs.pfnTouch( touch, ent );
+	}
+}
 
-			// check brush triggers accuracy
-			if( mod && mod->type == mod_brush )
-			{
-				// force to select bsp-hull
-				hull = SV_HullForBsp( touch, ent->v.mins, ent->v.maxs, offset );
+/*
+====================
+SV_TouchSweep
 
-				// support for rotational triggers
-				if( FBitSet( mod->flags, MODEL_HAS_ORIGIN ) && !VectorIsNull( touch->v.angles ))
-				{
-					matrix4x4	matrix;
-					Matrix4x4_CreateFromEntity( matrix, touch->v.angles, offset, 1.0f );
-					Matrix4x4_VectorITransform( matrix, ent->v.origin, test );
-				}
-				else
-				{
-					// offset the test point appropriately for this hull.
-					VectorSubtract( ent->v.origin, offset, test );
-				}
+same as walking node trigger list, but only triggers
+near the entity are visited. Touch order is kept
+====================
+*/
+static void SV_TouchSweep( edict_t *ent, areanode_t *node )
+{
+	triggernode_t	*tn = &sv_triggernodes[node - sv_areanodes];
+	int		index = node - sv_areanodes + 1;
+	int		lo, hi, mid, i, numhits = 0;
+	const triggersweep_t	*ts;
+	edict_t		*touch;
+	float		min, max;
 
-				// test hull for intersection with this model
-				if( PM_HullPointContents( hull, hull->firstclipnode, test ) != CONTENTS_SOLID )
-					continue;
-			}
-		}
+	if( tn->dirty )
+		SV_BuildTriggerSweep( node, tn );
+
+	if( !tn->numtriggers )
+		return;
+
+	// anything starting before can't reach the entity
+	min = ent->v.absmin[tn->axis] - tn->maxsize - 1.0f;
+	max = ent->v.absmax[tn->axis];
+
+	for( lo = 0, hi = tn->numtriggers; lo < hi; )
+	{
+		mid = ( lo + hi ) >> 1;
+		if( tn->sweep[mid].absmin[tn->axis] < min )
+			lo = mid + 1;
+		else hi = mid;
+	}
+
+	for( i = lo; i < tn->numtriggers; i++ )
+	{
+		ts = &tn->sweep[i];
+
+		if( ts->absmin[tn->axis] > max )
+			break;
+
+		if( BoundsIntersect( ent->v.absmin, ent->v.absmax, ts->absmin, ts->absmax ))
+			sv_touchhits[numhits++] = ts->order;
+	}
+
+	if( numhits > 1 )
+		qsort( sv_touchhits, numhits, sizeof( *sv_touchhits ), SV_SortTouchHits );
+
+	for( i = 0; i < numhits; i++ )
+	{
+		touch = tn->edicts[sv_touchhits[i]];
+
+		// unlinked or moved away by previous touch
+		if( svgame.triggernode[touch - svgame.edicts] != index )
+			continue;
+
+		SV_TouchTrigger( ent, touch );
+	}
+}
+
+/*
+====================
+SV_TouchLinks
+====================
+*/
+static void SV_TouchLinks( edict_t *ent, areanode_t *node )
+{
+	link_t	*l, *next;
 
-		// never touch the triggers when "playersonly" is active
-		if( !sv.playersonly )
+	// user dll may accept triggers regardless of bounds
+	if( sv_triggersweep.value && svgame.triggernode && svgame.physFuncs.SV_TriggerTouch == NULL )
+	{
+		SV_TouchSweep( ent, node );
+	}
+	else
+	{
+		// touch linked edicts
+		for( l = node->trigger_edicts.next; l != &node->trigger_edicts; l = next )
 		{
-			svgame.globals->time = sv.time;
-			svgame.dllFuncs.pfnTouch( touch, ent );
+			next = l->next;
+			SV_TouchTrigger( ent, EDICT_FROM_AREA( l ));
 		}
 	}
 
@@ -674,7 +1007,11 @@ void GAME_EXPORT SV_LinkEdict( edict_t *ent, qboolean touch_triggers )
 
 	// ignore non-solid bodies
 	if( ent->v.solid == SOLID_NOT && ent->v.skin >= CONTENTS_EMPTY )
+	{
+		// but pushers still have to find them
+		SV_AddLooseEdict( ent );
 		return;
+	}
 
 	// find the first node that the ent's box crosses
 	node = sv_areanodes;
@@ -691,11 +1028,16 @@ void GAME_EXPORT SV_LinkEdict( edict_t *ent, qboolean touch_triggers )
 
 	// link it in
 	if( ent->v.solid == SOLID_TRIGGER )
+	{
 		InsertLinkBefore( &ent->area, &node->trigger_edicts );
+		SV_TriggerSweepLinked( ent, node );
+	}
 	else if( ent->v.solid == SOLID_PORTAL )
 		InsertLinkBefore( &ent->area, &node->portal_edicts );
 	else InsertLinkBefore( &ent->area, &node->solid_edicts );
 
+	SV_GroundSupportLinked( ent, true );
+
 	if( touch_triggers && !iTouchLinkSemaphore )
 	{
 		iTouchLinkSemaphore = true;
@@ -1508,22 +1850,48 @@ trace_t SV_MoveToss( edict_t *tossent, edict_t *ignore )
 ===============================================================================
 */
 
-static vec3_t	sv_pointColor;
+#define LIGHTGRID_STEP	32.0f	// units between grid nodes
+#define LIGHTGRID_BLOCK	4	// nodes per block side, blocks are baked on first use
+#define LIGHTGRID_SOLID	BIT( 0 )	// node is inside solid
+#define LIGHTGRID_UNLIT	BIT( 1 )	// nothing lightmapped below, fullbright
+
+typedef struct
+{
+	const color24	*samples;	// luxel for first style, NULL if nothing lightmapped was hit
+	const byte	*styles;
+	int		size;		// distance between styles
+} sv_lightpoint_t;
+
+typedef struct
+{
+	byte		flags;
+	byte		styles[MAXLIGHTMAPS];
+	word		sums[MAXLIGHTMAPS];	// r + g + b of luxel for each style
+} sv_lightnode_t;
+
+typedef struct
+{
+	vec3_t		origin;		// position of first node
+	int		size[3];		// in blocks
+	sv_lightnode_t	**blocks;
+	int		numblocks;	// baked so far
+} sv_lightgrid_t;
+
+static sv_lightgrid_t	lightgrid;
 
 /*
 =================
 SV_RecursiveLightPoint
 =================
 */
-static qboolean SV_RecursiveLightPoint( model_t *model, mnode_t *node, const vec3_t start, const vec3_t end )
+static qboolean SV_RecursiveLightPoint( model_t *model, mnode_t *node, const vec3_t start, const vec3_t end, sv_lightpoint_t *lp )
 {
-	float		front, back, scale, frac;
-	int		i, map, side, size;
+	float		front, back, frac;
+	int		i, side;
 	float		ds, dt, s, t;
 	int		sample_size;
 	msurface_t	*surf;
 	mextrasurf_t	*info;
-	color24		*lm;
 	vec3_t		mid;
 
 	// didn't hit anything
@@ -1536,14 +1904,14 @@ static qboolean SV_RecursiveLightPoint( model_t *model, mnode_t *node, const vec
 
 	side = front < 0.0f;
 	if(( back < 0.0f ) == side )
-		return SV_RecursiveLightPoint( model, node->children[side], start, end );
+		return SV_RecursiveLightPoint( model, node->children[side], start, end, lp );
 
 	frac = front / ( front - back );
 
 	VectorLerp( start, frac, end, mid );
 
 	// co down front side
-	if( SV_RecursiveLightPoint( model, node->children[side], start, mid ))
+	if( SV_RecursiveLightPoint( model, node->children[side], start, mid, lp ))
 		return true; // hit something
 
 	if(( back < 0.0f ) == side )
@@ -1582,84 +1950,979 @@ static qboolean SV_RecursiveLightPoint( model_t *model, mnode_t *node, const vec
 		ds /= sample_size;
 		dt /= sample_size;
 
-		VectorClear( sv_pointColor );
-
-		lm = surf->samples + Q_rint( dt ) * smax + Q_rint( ds );
-		size = smax * tmax;
-
-		for( map = 0; map < MAXLIGHTMAPS && surf->styles[map] != 255; map++ )
-		{
-			scale = sv.lightstyles[surf->styles[map]].value;
-
-			sv_pointColor[0] += lm->r * scale;
-			sv_pointColor[1] += lm->g * scale;
-			sv_pointColor[2] += lm->b * scale;
-
-			lm += size; // skip to next lightmap
-		}
+		lp->samples = surf->samples + Q_rint( dt ) * smax + Q_rint( ds );
+		lp->styles = surf->styles;
+		lp->size = smax * tmax;
 		return true;
 	}
 
 	// go down back side
-	return SV_RecursiveLightPoint( model, node->children[!side], mid, end );
+	return SV_RecursiveLightPoint( model, node->children[!side], mid, end, lp );
 }
 
 /*
-==================
-SV_SetLightStyle
+=================
+SV_LightPointValue
 
-needs to get correct working SV_LightPoint
-==================
+apply current lightstyles to the lightmap sample
+=================
 */
-void SV_SetLightStyle( int style, const char* s, float f )
+static float SV_LightPointValue( const sv_lightpoint_t *lp )
 {
-	int	j, k;
+	const color24	*lm = lp->samples;
+	vec3_t		color;
+	float		scale;
+	int		map;
 
-	Q_strncpy( sv.lightstyles[style].pattern, s, sizeof( sv.lightstyles[0].pattern ));
-	sv.lightstyles[style].time = f;
+	if( !lm ) return 1.0f;
 
-	j = Q_strlen( s );
-	sv.lightstyles[style].length = j;
+	VectorClear( color );
 
-	for( k = 0; k < j; k++ )
-		sv.lightstyles[style].map[k] = (float)(s[k] - 'a');
+	for( map = 0; map < MAXLIGHTMAPS && lp->styles[map] != 255; map++ )
+	{
+		scale = sv.lightstyles[lp->styles[map]].value;
 
-	if( sv.state != ss_active ) return;
+		color[0] += lm->r * scale;
+		color[1] += lm->g * scale;
+		color[2] += lm->b * scale;
 
-	// tell the clients about changed lightstyle
-	MSG_BeginServerCmd( &sv.reliable_datagram, svc_lightstyle );
-	MSG_WriteByte( &sv.reliable_datagram, style );
-	MSG_WriteString( &sv.reliable_datagram, sv.lightstyles[style].pattern );
-	MSG_WriteFloat( &sv.reliable_datagram, sv.lightstyles[style].time );
+		lm += lp->size; // skip to next lightmap
+	}
+
+	return VectorAvg( color );
 }
 
 /*
-==================
-SV_LightForEntity
+=================
+SV_LightTrace
 
-grab the ambient lighting color for current point
-==================
+find lightmap sample below (or above) the point
+=================
 */
-int SV_LightForEntity( edict_t *pEdict )
+static void SV_LightTrace( const vec3_t origin, qboolean invlight, sv_lightpoint_t *lp )
 {
-	vec3_t	start, end;
+	vec3_t	end;
 
-	if( FBitSet( pEdict->v.effects, EF_FULLBRIGHT ) || !sv.worldmodel->lightdata )
-		return 255;
+	VectorCopy( origin, end );
 
-	// player has more precision light level that come from client-side
-	if( FBitSet( pEdict->v.flags, FL_CLIENT ))
-		return pEdict->v.light_level;
+	if( invlight )
+		end[2] = origin[2] + world.size[2];
+	else end[2] = origin[2] - world.size[2];
 
-	VectorCopy( pEdict->v.origin, start );
-	VectorCopy( pEdict->v.origin, end );
+	memset( lp, 0, sizeof( *lp ));
+	SV_RecursiveLightPoint( sv.worldmodel, sv.worldmodel->nodes, origin, end, lp );
+}
 
-	if( FBitSet( pEdict->v.effects, EF_INVLIGHT ))
-		end[2] = start[2] + world.size[2];
-	else end[2] = start[2] - world.size[2];
-	VectorSet( sv_pointColor, 1.0f, 1.0f, 1.0f );
+/*
+=================
+SV_FreeLightGrid
+=================
+*/
+void SV_FreeLightGrid( void )
+{
+	int	i;
 
-	SV_RecursiveLightPoint( sv.worldmodel, sv.worldmodel->nodes, start, end );
+	if( lightgrid.blocks )
+	{
+		for( i = 0; i < lightgrid.size[0] * lightgrid.size[1] * lightgrid.size[2]; i++ )
+			Z_Free( lightgrid.blocks[i] );
+		Z_Free( lightgrid.blocks );
+	}
 
-	return VectorAvg( sv_pointColor );
+	memset( &lightgrid, 0, sizeof( lightgrid ));
 }
+
+/*
+=================
+SV_InitLightGrid
+
+grid covers the world, blocks are
+baked only where entities ask for light
+=================
+*/
+void SV_InitLightGrid( void )
+{
+	int	i, nodes;
+
+	SV_FreeLightGrid();
+
+	if( !sv.worldmodel || !sv.worldmodel->lightdata )
+		return;
+
+	VectorCopy( sv.worldmodel->mins, lightgrid.origin );
+
+	for( i = 0; i < 3; i++ )
+	{
+		nodes = (int)ceil(( sv.worldmodel->maxs[i] - sv.worldmodel->mins[i] ) / LIGHTGRID_STEP ) + 1;
+		lightgrid.size[i] = ( nodes + LIGHTGRID_BLOCK - 1 ) / LIGHTGRID_BLOCK;
+	}
+
+	lightgrid.blocks = Z_Calloc( sizeof( *lightgrid.blocks ) * lightgrid.size[0] * lightgrid.size[1] * lightgrid.size[2] );
+}
+
+/*
+=================
+SV_BakeLightNode
+=================
+*/
+static void SV_BakeLightNode( sv_lightnode_t *node, const vec3_t pos )
+{
+	sv_lightpoint_t	lp;
+	const color24	*lm;
+	int		map;
+
+	memset( node, 0, sizeof( *node ));
+	memset( node->styles, 255, sizeof( node->styles ));
+
+	if( Mod_PointInLeaf( pos, sv.worldmodel->nodes )->contents == CONTENTS_SOLID )
+	{
+		node->flags = LIGHTGRID_SOLID;
+		return;
+	}
+
+	SV_LightTrace( pos, false, &lp );
+
+	if( !lp.samples )
+	{
+		node->flags = LIGHTGRID_UNLIT;
+		return;
+	}
+
+	for( map = 0, lm = lp.samples; map < MAXLIGHTMAPS && lp.styles[map] != 255; map++, lm += lp.size )
+	{
+		node->styles[map] = lp.styles[map];
+		node->sums[map] = lm->r + lm->g + lm->b;
+	}
+}
+
+/*
+=================
+SV_LightGridNode
+=================
+*/
+static const sv_lightnode_t *SV_LightGridNode( int x, int y, int z )
+{
+	int		bx = x / LIGHTGRID_BLOCK, by = y / LIGHTGRID_BLOCK, bz = z / LIGHTGRID_BLOCK;
+	int		i, j, k, num;
+	sv_lightnode_t	**block;
+	vec3_t		pos;
+
+	if( bx >= lightgrid.size[0] || by >= lightgrid.size[1] || bz >= lightgrid.size[2] )
+		return NULL;
+
+	block = &lightgrid.blocks[( bz * lightgrid.size[1] + by ) * lightgrid.size[0] + bx];
+
+	if( !*block )
+	{
+		*block = Z_Malloc( sizeof( sv_lightnode_t ) * LIGHTGRID_BLOCK * LIGHTGRID_BLOCK * LIGHTGRID_BLOCK );
+
+		for( k = num = 0; k < LIGHTGRID_BLOCK; k++ )
+		{
+			for( j = 0; j < LIGHTGRID_BLOCK; j++ )
+			{
+				for( i = 0; i < LIGHTGRID_BLOCK; i++, num++ )
+				{
+					pos[0] = lightgrid.origin[0] + ( bx * LIGHTGRID_BLOCK + i ) * LIGHTGRID_STEP;
+					pos[1] = lightgrid.origin[1] + ( by * LIGHTGRID_BLOCK + j ) * LIGHTGRID_STEP;
+					pos[2] = lightgrid.origin[2] + ( bz * LIGHTGRID_BLOCK + k ) * LIGHTGRID_STEP;
+					SV_BakeLightNode( &(*block)[num], pos );
+				}
+			}
+		}
+
+		lightgrid.numblocks++;
+	}
+
+	x %= LIGHTGRID_BLOCK;
+	y %= LIGHTGRID_BLOCK;
+	z %= LIGHTGRID_BLOCK;
+
+	return &(*block)[( z * LIGHTGRID_BLOCK + y ) * LIGHTGRID_BLOCK + x];
+}
+
+static float SV_LightNodeValue( const sv_lightnode_t *node )
+{
+	float	sum = 0.0f;
+	int	map;
+
+	if( FBitSet( node->flags, LIGHTGRID_UNLIT ))
+		return 1.0f;
+
+	for( map = 0; map < MAXLIGHTMAPS && node->styles[map] != 255; map++ )
+		sum += node->sums[map] * sv.lightstyles[node->styles[map]].value;
+
+	return sum / 3;
+}
+
+/*
+=================
+SV_LightGridSample
+
+trilinear filter between nodes around the point, if they
+differ too much (floor edge, shadow border) or some of them
+are in solid, caller must trace the exact value
+=================
+*/
+static qboolean SV_LightGridSample( const vec3_t origin, float *light )
+{
+	const sv_lightnode_t	*node;
+	float		frac[3], corner[8];
+	float		lo, hi, f;
+	int		i, base[3];
+
+	if( !lightgrid.blocks )
+		return false;
+
+	for( i = 0; i < 3; i++ )
+	{
+		f = ( origin[i] - lightgrid.origin[i] ) / LIGHTGRID_STEP;
+
+		if( f < 0.0f || f >= lightgrid.size[i] * LIGHTGRID_BLOCK - 1 )
+			return false;
+
+		base[i] = (int)f;
+		frac[i] = f - base[i];
+	}
+
+	lo = 99999.0f;
+	hi = -99999.0f;
+
+	for( i = 0; i < 8; i++ )
+	{
+		node = SV_LightGridNode( base[0] + ( i & 1 ), base[1] + (( i >> 1 ) & 1 ), base[2] + ( i >> 2 ));
+
+		if( !node || FBitSet( node->flags, LIGHTGRID_SOLID ))
+			return false;
+
+		corner[i] = SV_LightNodeValue( node );
+		lo = Q_min( lo, corner[i] );
+		hi = Q_max( hi, corner[i] );
+	}
+
+	if( hi - lo > sv_lightgrid.value )
+		return false;
+
+	for( i = 0; i < 4; i++ )
+		corner[i] = corner[i * 2] + ( corner[i * 2 + 1] - corner[i * 2] ) * frac[0];
+
+	for( i = 0; i < 2; i++ )
+		corner[i] = corner[i * 2] + ( corner[i * 2 + 1] - corner[i * 2] ) * frac[1];
+
+	*light = corner[0] + ( corner[1] - corner[0] ) * frac[2];
+	return true;
+}
+
+/*
+==================
+SV_SetLightStyle
+
+needs to get correct working SV_LightPoint
+==================
+*/
+void SV_SetLightStyle( int style, const char* s, float f )
+{
+	int	j, k;
+
+	Q_strncpy( sv.lightstyles[style].pattern, s, sizeof( sv.lightstyles[0].pattern ));
+	sv.lightstyles[style].time = f;
+
+	j = Q_strlen( s );
+	sv.lightstyles[style].length = j;
+
+	for( k = 0; k < j; k++ )
+		sv.lightstyles[style].map[k] = (float)(s[k] - 'a');
+
+	if( sv.state != ss_active ) return;
+
+	// tell the clients about changed lightstyle
+	MSG_BeginServerCmd( &sv.reliable_datagram, svc_lightstyle );
+	MSG_WriteByte( &sv.reliable_datagram, style );
+	MSG_WriteString( &sv.reliable_datagram, sv.lightstyles[style].pattern );
+	MSG_WriteFloat( &sv.reliable_datagram, sv.lightstyles[style].time );
+}
+
+/*
+==================
+SV_LightForEntity
+
+grab the ambient lighting color for current point
+==================
+*/
+int SV_LightForEntity( edict_t *pEdict )
+{
+	sv_lightpoint_t	lp;
+	float		light;
+
+	if( FBitSet( pEdict->v.effects, EF_FULLBRIGHT ) || !sv.worldmodel->lightdata )
+		return 255;
+
+	// player has more precision light level that come from client-side
+	if( FBitSet( pEdict->v.flags, FL_CLIENT ))
+		return pEdict->v.light_level;
+
+	if( sv_lightgrid.value > 0.0f && !FBitSet( pEdict->v.effects, EF_INVLIGHT ))
+	{
+		if( SV_LightGridSample( pEdict->v.origin, &light ))
+			return light;
+	}
+
+	SV_LightTrace( pEdict->v.origin, FBitSet( pEdict->v.effects, EF_INVLIGHT ), &lp );
+
+	return SV_LightPointValue( &lp );
+}
+
+/*
+==================
+SV_LightGridCheck_f
+
+lightgrid_check [points]
+==================
+*/
+void SV_LightGridCheck_f( void )
+{
+	int		i, tries, points, sampled = 0;
+	double		start, gridtime = 0.0, tracetime = 0.0;
+	float		light, exact, err, maxerr = 0.0f, sumerr = 0.0f;
+	sv_lightpoint_t	lp;
+	vec3_t		pos;
+
+	if( sv.state != ss_active || !sv.worldmodel->lightdata )
+	{
+		Con_Printf( "^3no server running or map has no lighting.\n" );
+		return;
+	}
+
+	points = Cmd_Argc() > 1 ? Q_max( 1, Q_atoi( Cmd_Argv( 1 ))) : 10000;
+
+	if( !lightgrid.blocks )
+		SV_InitLightGrid();
+
+	for( i = 0; i < points; i++ )
+	{
+		// random point in the air
+		for( tries = 0; tries < 64; tries++ )
+		{
+			pos[0] = COM_RandomFloat( sv.worldmodel->mins[0], sv.worldmodel->maxs[0] );
+			pos[1] = COM_RandomFloat( sv.worldmodel->mins[1], sv.worldmodel->maxs[1] );
+			pos[2] = COM_RandomFloat( sv.worldmodel->mins[2], sv.worldmodel->maxs[2] );
+
+			if( Mod_PointInLeaf( pos, sv.worldmodel->nodes )->contents != CONTENTS_SOLID )
+				break;
+		}
+
+		start = Sys_DoubleTime();
+		SV_LightTrace( pos, false, &lp );
+		exact = SV_LightPointValue( &lp );
+		tracetime += Sys_DoubleTime() - start;
+
+		// bake first, so timing shows the steady state
+		SV_LightGridSample( pos, &light );
+
+		start = Sys_DoubleTime();
+		if( !SV_LightGridSample( pos, &light ))
+			continue;
+		gridtime += Sys_DoubleTime() - start;
+
+		err = abs( (int)light - (int)exact );
+		maxerr = Q_max( maxerr, err );
+		sumerr += err;
+		sampled++;
+	}
+
+	Con_Printf( "%i points, %i (%.1f%%) from grid, %i fell back to trace\n", points, sampled, sampled * 100.0f / points, points - sampled );
+	if( sampled > 0 )
+	{
+		Con_Printf( "grid error: average %.2f, max %.0f\n", sumerr / sampled, maxerr );
+		Con_Printf( "grid %.3f us, trace %.3f us per point\n", gridtime * 1e6 / sampled, tracetime * 1e6 / points );
+	}
+	Con_Printf( "%i blocks baked, %s\n", lightgrid.numblocks, Q_memprint( lightgrid.numblocks * sizeof( sv_lightnode_t ) * LIGHTGRID_BLOCK * LIGHTGRID_BLOCK * LIGHTGRID_BLOCK ));
+}
+
+#if XASH_ENGINE_TESTS
+#include "tests.h"
+
+static void Test_LightGrid_Sample( void )
+{
+	static sv_lightnode_t	nodes[LIGHTGRID_BLOCK * LIGHTGRID_BLOCK * LIGHTGRID_BLOCK];
+	static const vec3_t	center = { 16, 16, 16 }, outside = { 200, 16, 16 }, below = { 16, 16, -1 };
+	sv_lightnode_t	*block = nodes;
+	sv_lightgrid_t	oldgrid = lightgrid;
+	float		oldstyle = sv.lightstyles[0].value;
+	float		oldvalue = sv_lightgrid.value;
+	float		light;
+	int		i;
+
+	memset( &lightgrid, 0, sizeof( lightgrid ));
+	VectorSet( lightgrid.size, 1, 1, 1 );
+	lightgrid.blocks = &block;
+	sv.lightstyles[0].value = 1.0f;
+	sv_lightgrid.value = 100.0f;
+
+	// gets 10 brighter along x every node
+	for( i = 0; i < ARRAYSIZE( nodes ); i++ )
+	{
+		memset( &nodes[i], 0, sizeof( nodes[i] ));
+		memset( nodes[i].styles, 255, sizeof( nodes[i].styles ));
+		nodes[i].styles[0] = 0;
+		nodes[i].sums[0] = ( i % LIGHTGRID_BLOCK ) * 30;
+	}
+
+	TASSERT( SV_LightGridSample( center, &light ));
+	TASSERT( light == 5.0f );
+
+	TASSERT( !SV_LightGridSample( outside, &light ));
+	TASSERT( !SV_LightGridSample( below, &light ));
+
+	// lightstyle is applied on lookup
+	sv.lightstyles[0].value = 2.0f;
+	TASSERT( SV_LightGridSample( center, &light ));
+	TASSERT( light == 10.0f );
+
+	// too much difference, must trace
+	sv_lightgrid.value = 15.0f;
+	TASSERT( !SV_LightGridSample( center, &light ));
+	sv_lightgrid.value = 100.0f;
+
+	nodes[( 1 * LIGHTGRID_BLOCK + 1 ) * LIGHTGRID_BLOCK + 1].flags = LIGHTGRID_SOLID;
+	TASSERT( !SV_LightGridSample( center, &light ));
+
+	for( i = 0; i < ARRAYSIZE( nodes ); i++ )
+		nodes[i].flags = LIGHTGRID_UNLIT;
+	TASSERT( SV_LightGridSample( center, &light ));
+	TASSERT( light == 1.0f );
+
+	lightgrid = oldgrid;
+	sv.lightstyles[0].value = oldstyle;
+	sv_lightgrid.value = oldvalue;
+}
+
+void Test_RunLightGrid( void )
+{
+	TRUN( Test_LightGrid_Sample() );
+}
+
+#define TEST_TRIGGER_EDICTS	256
+#define TEST_TRIGGER_MOVERS	64
+#define TEST_TRIGGER_LOG	256
+
+typedef struct
+{
+	gameinfo_t	gameinfo;
+	globalvars_t	globals;
+	edict_t		*edicts;
+	byte		*triggernode;
+	uint		seed;
+	int		touches;
+	int		numlog;
+	int		log[TEST_TRIGGER_LOG];
+
+	gameinfo_t	*oldgameinfo;
+	globalvars_t	*oldglobals;
+	edict_t		*oldedicts;
+	int		oldnumentities;
+	byte		*oldtriggernode;
+	sv_groundcache_t	*oldgroundcache;
+	DLL_FUNCTIONS	olddllfuncs;
+	float		oldsweep;
+} test_triggers_t;
+
+static test_triggers_t	*test_triggers;
+
+static void Test_Triggers_SetAbsBox( edict_t *ent )
+{
+	VectorAdd( ent->v.origin, ent->v.mins, ent->v.absmin );
+	VectorAdd( ent->v.origin, ent->v.maxs, ent->v.absmax );
+}
+
+static void Test_Triggers_Touch( edict_t *touch, edict_t *other )
+{
+	test_triggers_t *t = test_triggers;
+
+	if( t->numlog < TEST_TRIGGER_LOG )
+		t->log[t->numlog++] = ( touch - svgame.edicts ) << 16 | ( other - svgame.edicts );
+	t->touches++;
+}
+
+static float Test_Triggers_Random( test_triggers_t *t, float lo, float hi )
+{
+	t->seed = t->seed * 1103515245 + 12345;
+	return lo + ( hi - lo ) * (( t->seed >> 8 ) & 0xFFFF ) / 65535.0f;
+}
+
+/*
+===============
+Test_Triggers_Begin
+
+empty world with no game loaded, fake edicts and dll callbacks
+===============
+*/
+static test_triggers_t *Test_Triggers_Begin( int numedicts, float worldsize )
+{
+	test_triggers_t	*t = Mem_Calloc( host.mempool, sizeof( *t ));
+	vec3_t		mins, maxs;
+
+	t->edicts = Mem_Calloc( host.mempool, sizeof( *t->edicts ) * numedicts );
+	t->triggernode = Mem_Calloc( host.mempool, sizeof( *t->triggernode ) * numedicts );
+	t->seed = 1;
+
+	t->oldgameinfo = GI;
+	t->oldglobals = svgame.globals;
+	t->oldedicts = svgame.edicts;
+	t->oldnumentities = svgame.numEntities;
+	t->oldtriggernode = svgame.triggernode;
+	t->oldgroundcache = svs.groundcache;
+	t->olddllfuncs = svgame.dllFuncs;
+	t->oldsweep = sv_triggersweep.value;
+
+	t->gameinfo.max_edicts = numedicts;
+	GI = &t->gameinfo;
+	svgame.globals = &t->globals;
+	svgame.edicts = t->edicts;
+	svgame.numEntities = numedicts;
+	svgame.triggernode = t->triggernode;
+	svgame.dllFuncs.pfnSetAbsBox = Test_Triggers_SetAbsBox;
+	svgame.dllFuncs.pfnTouch = Test_Triggers_Touch;
+	svs.groundcache = NULL;
+	test_triggers = t;
+
+	VectorSet( mins, -worldsize, -worldsize, -512.0f );
+	VectorSet( maxs, worldsize, worldsize, 512.0f );
+	memset( sv_areanodes, 0, sizeof( sv_areanodes ));
+	sv_numareanodes = 0;
+	SV_CreateAreaNode( 0, mins, maxs );
+	SV_ClearTriggerSweep();
+	SV_ClearTouchCache();
+
+	return t;
+}
+
+static void Test_Triggers_End( test_triggers_t *t )
+{
+	SV_ClearTriggerSweep();
+	SV_ClearTouchCache();
+	memset( sv_areanodes, 0, sizeof( sv_areanodes ));
+	sv_numareanodes = 0;
+
+	GI = t->oldgameinfo;
+	svgame.globals = t->oldglobals;
+	svgame.edicts = t->oldedicts;
+	svgame.numEntities = t->oldnumentities;
+	svgame.triggernode = t->oldtriggernode;
+	svgame.dllFuncs = t->olddllfuncs;
+	svs.groundcache = t->oldgroundcache;
+	sv_triggersweep.value = t->oldsweep;
+	test_triggers = NULL;
+
+	Mem_Free( t->triggernode );
+	Mem_Free( t->edicts );
+	Mem_Free( t );
+}
+
+static void Test_Triggers_Place( test_triggers_t *t, edict_t *ent, float worldsize, float minsize, float maxsize )
+{
+	int	i;
+
+	for( i = 0; i < 3; i++ )
+	{
+		ent->v.maxs[i] = Test_Triggers_Random( t, minsize, maxsize ) * 0.5f;
+		ent->v.mins[i] = -ent->v.maxs[i];
+		ent->v.origin[i] = Test_Triggers_Random( t, -worldsize, worldsize );
+	}
+
+	ent->v.origin[2] *= 0.25f;
+	SV_LinkEdict( ent, false );
+}
+
+static void Test_Triggers_Move( test_triggers_t *t, edict_t *ent, float worldsize, float step )
+{
+	int	i;
+
+	for( i = 0; i < 2; i++ )
+	{
+		ent->v.origin[i] += Test_Triggers_Random( t, -step, step );
+		ent->v.origin[i] = bound( -worldsize, ent->v.origin[i], worldsize );
+	}
+}
+
+static void Test_TriggerSweep_Order( void )
+{
+	const int	firstmover = TEST_TRIGGER_EDICTS - TEST_TRIGGER_MOVERS;
+	const float	worldsize = 1024.0f;
+	test_triggers_t	*t = Test_Triggers_Begin( TEST_TRIGGER_EDICTS, worldsize );
+	int		reflog[TEST_TRIGGER_LOG];
+	int		i, step, numref, total = 0, mismatches = 0;
+	edict_t		*ent;
+
+	for( i = 1; i < TEST_TRIGGER_EDICTS; i++ )
+	{
+		ent = &t->edicts[i];
+
+		if( i < firstmover )
+		{
+			ent->v.solid = SOLID_TRIGGER;
+
+			// some are big enough to stay at the root node
+			if(( i & 15 ) == 0 )
+				Test_Triggers_Place( t, ent, worldsize, 256.0f, 1500.0f );
+			else Test_Triggers_Place( t, ent, worldsize, 16.0f, 256.0f );
+		}
+		else
+		{
+			// moving triggers touch others too
+			ent->v.solid = ( i & 3 ) ? SOLID_SLIDEBOX : SOLID_TRIGGER;
+			Test_Triggers_Place( t, ent, worldsize, 32.0f, 72.0f );
+		}
+	}
+
+	for( step = 0; step < 32; step++ )
+	{
+		// some triggers move between frames
+		if( step & 1 )
+		{
+			for( i = step; i < firstmover; i += 16 )
+				Test_Triggers_Place( t, &t->edicts[i], worldsize, 16.0f, 256.0f );
+		}
+
+		// disabled without relinking
+		if( step == 8 )
+			t->edicts[5].v.solid = SOLID_NOT;
+
+		if( step == 12 )
+		{
+			SV_UnlinkEdict( &t->edicts[6] );
+			t->edicts[6].free = true;
+		}
+
+		if( step == 16 )
+		{
+			t->edicts[5].v.solid = SOLID_TRIGGER;
+			SV_LinkEdict( &t->edicts[5], false );
+		}
+
+		for( i = firstmover; i < TEST_TRIGGER_EDICTS; i++ )
+		{
+			ent = &t->edicts[i];
+			Test_Triggers_Move( t, ent, worldsize, 128.0f );
+
+			sv_triggersweep.value = 0.0f;
+			t->numlog = 0;
+			SV_LinkEdict( ent, true );
+			numref = t->numlog;
+			memcpy( reflog, t->log, sizeof( *reflog ) * numref );
+
+			sv_triggersweep.value = 1.0f;
+			t->numlog = 0;
+			SV_LinkEdict( ent, true );
+
+			if( t->numlog != numref || memcmp( reflog, t->log, sizeof( *reflog ) * numref ))
+				mismatches++;
+			total += numref;
+		}
+	}
+
+	TASSERT_EQi( mismatches, 0 );
+	TASSERT( total > 1000 );
+
+	Test_Triggers_End( t );
+}
+
+#define TEST_TOUCH_TRIGGERS	48
+#define TEST_TOUCH_MOVERS	64
+#define TEST_TOUCH_WORLD	768.0f
+
+typedef struct
+{
+	model_t		model;
+	mplane_t		planes[MAX_MAP_HULLS][6];
+	mclipnode_t	clipnodes[MAX_MAP_HULLS][6];
+} test_touchmodel_t;
+
+typedef struct
+{
+	model_t		world;
+	mleaf_t		leaf;
+	test_touchmodel_t	models[3];	// box, bigger box, off-center bar with origin
+
+	model_t		*oldworld;
+	model_t		*oldmodels[4];
+	float		oldtouchcache;
+} test_touchcache_t;
+
+static const vec3_t test_touch_hulls[MAX_MAP_HULLS][2] =
+{
+{ { 0, 0, 0 }, { 0, 0, 0 } },
+{ { -16, -16, -36 }, { 16, 16, 36 } },
+{ { -32, -32, -32 }, { 32, 32, 32 } },
+{ { -16, -16, -18 }, { 16, 16, 18 } },
+};
+
+static const vec3_t test_touch_boxes[3][2] =
+{
+{ { -64, -64, -32 }, { 64, 64, 32 } },
+{ { -160, -96, -48 }, { 160, 96, 48 } },
+{ { -16, -48, -32 }, { 16, 192, 32 } },
+};
+
+// entity sizes picking every hull, last one has clip offset
+static const vec3_t test_touch_sizes[5] =
+{
+{ 0, 0, 0 },
+{ 16, 16, 36 },
+{ 32, 32, 32 },
+{ 16, 16, 18 },
+{ 12, 12, 12 },
+};
+
+/*
+===============
+Test_TouchCache_BoxModel
+
+brush model made of single box, every hull
+is the box expanded by hull size like bsp compiler does
+===============
+*/
+static void Test_TouchCache_BoxModel( test_touchmodel_t *m, const vec3_t mins, const vec3_t maxs, int flags )
+{
+	int	i, j, side;
+
+	m->model.type = mod_brush;
+	m->model.flags = flags;
+
+	for( i = 0; i < MAX_MAP_HULLS; i++ )
+	{
+		hull_t	*hull = &m->model.hulls[i];
+
+		hull->clipnodes = m->clipnodes[i];
+		hull->planes = m->planes[i];
+		hull->firstclipnode = 0;
+		hull->lastclipnode = 5;
+		VectorCopy( test_touch_hulls[i][0], hull->clip_mins );
+		VectorCopy( test_touch_hulls[i][1], hull->clip_maxs );
+
+		for( j = 0; j < 6; j++ )
+		{
+			side = j & 1;
+
+			m->clipnodes[i][j].planenum = j;
+			m->clipnodes[i][j].children[side] = CONTENTS_EMPTY;
+			m->clipnodes[i][j].children[side^1] = ( j != 5 ) ? j + 1 : CONTENTS_SOLID;
+
+			m->planes[i][j].type = j >> 1;
+			m->planes[i][j].normal[j >> 1] = 1.0f;
+			m->planes[i][j].dist = side ? mins[j >> 1] - hull->clip_maxs[j >> 1] : maxs[j >> 1] - hull->clip_mins[j >> 1];
+		}
+	}
+}
+
+static void Test_TouchCache_Resize( edict_t *ent, int size )
+{
+	VectorCopy( test_touch_sizes[size % ARRAYSIZE( test_touch_sizes )], ent->v.maxs );
+	VectorNegate( ent->v.maxs, ent->v.mins );
+}
+
+/*
+===============
+Test_TriggerContact_Cache
+
+stationary entities keep cached contacts while brush triggers
+around them are moved, rotated and swapped to bigger model,
+touches must be the same as with cache disabled
+===============
+*/
+static void Test_TriggerContact_Cache( void )
+{
+	const int	firstmover = TEST_TOUCH_TRIGGERS + 1;
+	const int	numedicts = firstmover + TEST_TOUCH_MOVERS;
+	test_triggers_t	*t = Test_Triggers_Begin( numedicts, TEST_TOUCH_WORLD );
+	test_touchcache_t	*tc = Mem_Calloc( host.mempool, sizeof( *tc ));
+	int		reflog[TEST_TRIGGER_LOG];
+	int		i, step, numref, total = 0, mismatches = 0;
+	edict_t		*ent;
+
+	tc->oldworld = sv.worldmodel;
+	memcpy( tc->oldmodels, sv.models, sizeof( tc->oldmodels ));
+	tc->oldtouchcache = sv_touchcache_enable.value;
+
+	// single empty leaf is enough to link brush entities
+	tc->leaf.contents = CONTENTS_EMPTY;
+	tc->world.nodes = (mnode_t *)&tc->leaf;
+	sv.worldmodel = &tc->world;
+
+	for( i = 0; i < ARRAYSIZE( tc->models ); i++ )
+	{
+		Test_TouchCache_BoxModel( &tc->models[i], test_touch_boxes[i][0], test_touch_boxes[i][1], ( i == 2 ) ? MODEL_HAS_ORIGIN : 0 );
+		sv.models[i + 1] = &tc->models[i].model;
+	}
+
+	for( i = 1; i < numedicts; i++ )
+	{
+		ent = &t->edicts[i];
+
+		if( i < firstmover )
+		{
+			// absbox covers any rotation, only hull decides
+			ent->v.solid = SOLID_TRIGGER;
+			ent->v.modelindex = 1 + i % 3;
+			VectorSet( ent->v.mins, -200, -200, -56 );
+			VectorSet( ent->v.maxs, 200, 200, 56 );
+		}
+		else
+		{
+			ent->v.solid = SOLID_SLIDEBOX;
+			Test_TouchCache_Resize( ent, i );
+		}
+
+		ent->v.origin[0] = Test_Triggers_Random( t, -TEST_TOUCH_WORLD, TEST_TOUCH_WORLD );
+		ent->v.origin[1] = Test_Triggers_Random( t, -TEST_TOUCH_WORLD, TEST_TOUCH_WORLD );
+		ent->v.origin[2] = Test_Triggers_Random( t, -48.0f, 48.0f );
+		SV_LinkEdict( ent, false );
+	}
+
+	for( step = 0; step < 32; step++ )
+	{
+		for( i = 1; i < firstmover; i++ )
+		{
+			ent = &t->edicts[i];
+
+			if(( i + step ) % 8 == 0 )
+			{
+				Test_Triggers_Move( t, ent, TEST_TOUCH_WORLD, 48.0f );
+				SV_LinkEdict( ent, false );
+			}
+
+			if( ent->v.modelindex == 3 )
+			{
+				// rotating doors don't relink while turning
+				if(( i + step ) % 3 == 0 )
+					ent->v.angles[1] = Test_Triggers_Random( t, 0.0f, 360.0f );
+				if(( i + step ) % 7 == 0 )
+					ent->v.angles[0] = Test_Triggers_Random( t, -30.0f, 30.0f );
+			}
+			else if(( i + step ) % 5 == 0 )
+			{
+				ent->v.modelindex = ( ent->v.modelindex == 1 ) ? 2 : 1;
+			}
+		}
+
+		for( i = firstmover; i < numedicts; i++ )
+		{
+			ent = &t->edicts[i];
+
+			if(( i + step ) % 4 == 0 )
+				Test_Triggers_Move( t, ent, TEST_TOUCH_WORLD, 24.0f );
+
+			if(( i + step ) % 9 == 0 )
+				Test_TouchCache_Resize( ent, i + step );
+
+			sv_touchcache_enable.value = 0.0f;
+			t->numlog = 0;
+			SV_LinkEdict( ent, true );
+			numref = t->numlog;
+			memcpy( reflog, t->log, sizeof( *reflog ) * numref );
+
+			sv_touchcache_enable.value = 1.0f;
+			t->numlog = 0;
+			SV_LinkEdict( ent, true );
+
+			if( t->numlog != numref || memcmp( reflog, t->log, sizeof( *reflog ) * numref ))
+				mismatches++;
+			total += numref;
+		}
+	}
+
+	TASSERT_EQi( mismatches, 0 );
+	TASSERT( total > 1000 );
+
+	sv.worldmodel = tc->oldworld;
+	memcpy( sv.models, tc->oldmodels, sizeof( tc->oldmodels ));
+	sv_touchcache_enable.value = tc->oldtouchcache;
+	Mem_Free( tc );
+
+	Test_Triggers_End( t );
+}
+
+void Test_RunTriggers( void )
+{
+	TRUN( Test_TriggerSweep_Order() );
+	TRUN( Test_TriggerContact_Cache() );
+}
+
+#define BENCH_TRIGGERS		4096
+#define BENCH_TRIGGER_BOTS	256
+#define BENCH_TRIGGER_WORLD	4096.0f
+
+typedef struct
+{
+	test_triggers_t	*t;
+	int		movetriggers;	// triggers relinked each frame
+} bench_triggers_t;
+
+static void Bench_SV_TouchLinks( void *data, int count )
+{
+	bench_triggers_t	*b = data;
+	test_triggers_t	*t = b->t;
+	edict_t		*ent;
+	int		i, j;
+
+	for( i = 0; i < count; i++ )
+	{
+		for( j = 0; j < b->movetriggers; j++ )
+		{
+			ent = &t->edicts[1 + ( i * b->movetriggers + j ) % BENCH_TRIGGERS];
+			Test_Triggers_Move( t, ent, BENCH_TRIGGER_WORLD, 32.0f );
+			SV_LinkEdict( ent, false );
+		}
+
+		for( j = BENCH_TRIGGERS + 1; j < BENCH_TRIGGERS + 1 + BENCH_TRIGGER_BOTS; j++ )
+		{
+			Test_Triggers_Move( t, &t->edicts[j], BENCH_TRIGGER_WORLD, 16.0f );
+			SV_LinkEdict( &t->edicts[j], true );
+		}
+
+		bench_sink += t->touches;
+	}
+}
+
+/*
+===============
+Bench_RunTriggers
+
+thousands of trigger volumes and hundreds of
+bots walking through them, one frame per iteration
+===============
+*/
+void Bench_RunTriggers( void )
+{
+	test_triggers_t	*t = Test_Triggers_Begin( BENCH_TRIGGERS + BENCH_TRIGGER_BOTS + 1, BENCH_TRIGGER_WORLD );
+	bench_triggers_t	b = { t, 0 };
+	int		i;
+
+	for( i = 1; i < BENCH_TRIGGERS + BENCH_TRIGGER_BOTS + 1; i++ )
+	{
+		if( i <= BENCH_TRIGGERS )
+		{
+			t->edicts[i].v.solid = SOLID_TRIGGER;
+			Test_Triggers_Place( t, &t->edicts[i], BENCH_TRIGGER_WORLD, 32.0f, ( i & 63 ) ? 256.0f : 1024.0f );
+		}
+		else
+		{
+			t->edicts[i].v.solid = SOLID_SLIDEBOX;
+			Test_Triggers_Place( t, &t->edicts[i], BENCH_TRIGGER_WORLD, 32.0f, 72.0f );
+		}
+	}
+
+	sv_triggersweep.value = 0.0f;
+	Bench_Run( "SV_TouchLinks", Bench_SV_TouchLinks, &b, 20 );
+	sv_triggersweep.value = 1.0f;
+	Bench_Run( "SV_TouchLinks sweep", Bench_SV_TouchLinks, &b, 20 );
+
+	b.movetriggers = 64;
+	sv_triggersweep.value = 0.0f;
+	Bench_Run( "SV_TouchLinks 64 triggers moving", Bench_SV_TouchLinks, &b, 20 );
+	sv_triggersweep.value = 1.0f;
+	Bench_Run( "SV_TouchLinks sweep 64 triggers moving", Bench_SV_TouchLinks, &b, 20 );
+
+	Test_Triggers_End( t );
+}
+
+#endif // XASH_ENGINE_TESTS
@@ -30,6 +30,9 @@ GNU General Public License for more details.
 #else
 #include <dirent.h>
 #endif
+#if HAVE_PREADV
+#include <sys/uio.h>
+#endif
 #include <stdio.h>
 #include <stdarg.h>
 #include "port.h"
@@ -55,6 +58,7 @@ searchpath_t *fs_writepath;
 static searchpath_t *fs_searchpaths = NULL;	// chain
 static char			fs_basedir[MAX_SYSPATH];	// base game directory
 static char			fs_gamedir[MAX_SYSPATH];	// game current directory
+static file_t			*fs_trace;	// file access order log, see FS_SetAccessTrace
 
 // add archives in specific order PAK -> PK3 -> WAD
 // so raw WADs takes precedence over WADs included into PAKs and PK3s
@@ -125,6 +129,79 @@ static void FS_BackupFileName( file_t *file, const char *path, uint options ) {}
 static void FS_InitMemory( void );
 static void FS_Purge( file_t* file );
 
+static fs_offset_t FS_SysPRead( int handle, void *buf, size_t count, fs_offset_t offset )
+{
+#if HAVE_PREAD
+	return pread( handle, buf, count, offset );
+#elif XASH_WIN32
+	// overlapped offset on synchronous handle, moves file pointer but it's never relied on
+	OVERLAPPED	ov = { 0 };
+	DWORD	nb;
+
+	ov.Offset = (DWORD)offset;
+	ov.OffsetHigh = (DWORD)((uint64_t)offset >> 32 );
+
+	if( !ReadFile( (HANDLE)_get_osfhandle( handle ), buf, (DWORD)count, &nb, &ov ))
+		return GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+
+	return nb;
+#else
+	// not thread-safe, but there is nothing better
+	if( lseek( handle, offset, SEEK_SET ) == -1 )
+		return -1;
+
+	return read( handle, buf, count );
+#endif
+}
+
+static fs_offset_t FS_SysPReadV( int handle, const fs_iovec_t *iov, int iovcnt, fs_offset_t offset )
+{
+	fs_offset_t	total = 0, nb;
+	int		i;
+#if HAVE_PREADV
+	struct iovec	sysiov[2];
+
+	if( iovcnt <= (int)( sizeof( sysiov ) / sizeof( sysiov[0] )))
+	{
+		for( i = 0; i < iovcnt; i++ )
+		{
+			sysiov[i].iov_base = iov[i].base;
+			sysiov[i].iov_len = iov[i].len;
+		}
+
+		return preadv( handle, sysiov, iovcnt, offset );
+	}
+#endif
+
+	for( i = 0; i < iovcnt; i++ )
+	{
+		nb = FS_SysPRead( handle, iov[i].base, iov[i].len, offset + total );
+
+		if( nb < 0 )
+			return total ? total : -1;
+
+		total += nb;
+
+		if( nb < (fs_offset_t)iov[i].len )
+			break;
+	}
+
+	return total;
+}
+
+static fs_offset_t FS_SysWrite( int handle, const void *buf, size_t count )
+{
+	return write( handle, buf, count );
+}
+
+static fs_offset_t FS_SysSeek( int handle, fs_offset_t offset, int whence )
+{
+	return lseek( handle, offset, whence );
+}
+
+static const fs_sysio_t fs_sysio_default = { FS_SysPRead, FS_SysPReadV, FS_SysWrite, FS_SysSeek };
+static const fs_sysio_t *fs_sysio = &fs_sysio_default;
+
 void _Mem_Free( void *data, const char *filename, int fileline )
 {
 	g_engfuncs._Mem_Free( data, filename, fileline );
@@ -1601,6 +1678,7 @@ void FS_ShutdownStdio( void )
 			Mem_Free( FI.games[i] );
 	}
 
+	FS_SetAccessTrace( NULL );
 	FS_ClearSearchPath(); // release all wad files too
 	Mem_FreePool( &fs_mempool );
 }
@@ -1740,7 +1818,11 @@ file_t *FS_SysOpen( const char *filepath, const char *mode )
 	//	return NULL;
 
 	// For files opened in append mode, we start at the end of the file
-	if( opt & O_APPEND )  file->position = file->real_length;
+	if( opt & O_APPEND )
+	{
+		file->position = file->real_length;
+		file->append = true;
+	}
 	else lseek( file->handle, 0, SEEK_SET );
 
 	return file;
@@ -1774,13 +1856,6 @@ file_t *FS_OpenHandle( searchpath_t *searchpath, int handle, fs_offset_t offset,
 		Mem_Free( file );
 		return NULL;
 	}
-
-	if( lseek( file->handle, offset, SEEK_SET ) == -1 )
-	{
-		Mem_Free( file );
-		return NULL;
-	}
-
 #else
 	file->backup_position = offset;
 	file->backup_path = copystring( syspath );
@@ -2000,6 +2075,49 @@ qboolean FS_FullPathToRelativePath( char *dst, const char *src, size_t size )
 }
 
 
+/*
+===========
+FS_SetAccessTrace
+
+Start logging names of opened and loaded files in the order they're accessed,
+used by xar to lay out archives. NULL stops the trace
+===========
+*/
+void FS_SetAccessTrace( const char *path )
+{
+	file_t *trace = fs_trace;
+
+	// don't log own file
+	fs_trace = NULL;
+
+	if( trace )
+		FS_Close( trace );
+
+	if( !COM_CheckString( path ))
+		return;
+
+	trace = FS_Open( path, "w", true );
+
+	if( !trace )
+	{
+		Con_Printf( S_ERROR "%s: can't open %s\n", __func__, path );
+		return;
+	}
+
+	fs_trace = trace;
+}
+
+/*
+===========
+FS_TraceAccess
+===========
+*/
+static void FS_TraceAccess( const char *filename )
+{
+	if( fs_trace )
+		FS_Printf( fs_trace, "%s\n", filename );
+}
+
 /*
 ===========
 FS_OpenReadFile
@@ -2019,6 +2137,8 @@ file_t *FS_OpenReadFile( const char *filename, const char *mode, qboolean gamedi
 	if( search == NULL )
 		return NULL;
 
+	FS_TraceAccess( filename );
+
 	return search->pfnOpenFile( search, netpath, mode, pack_ind );
 }
 
@@ -2069,6 +2189,64 @@ file_t *FS_Open( const char *filepath, const char *mode, qboolean gamedironly )
 	return FS_OpenReadFile( filepath, mode, gamedironly );
 }
 
+/*
+====================
+FS_SyncWritePosition
+
+Reads don't move the descriptor, put it at the start of pending data
+====================
+*/
+static qboolean FS_SyncWritePosition( file_t *file )
+{
+	if( !file->resync )
+		return true;
+
+	if( fs_sysio->seek( file->handle, file->offset + file->position - file->wbuff_len, SEEK_SET ) == -1 )
+		return false;
+
+	file->resync = false;
+	return true;
+}
+
+/*
+====================
+FS_FlushWriteBuffer
+
+Write out pending data
+====================
+*/
+static qboolean FS_FlushWriteBuffer( file_t *file )
+{
+	fs_offset_t	written = 0, result;
+
+	if( !file->wbuff_len )
+		return true;
+
+	if( !FS_SyncWritePosition( file ))
+	{
+		file->wbuff_len = 0;
+		return false;
+	}
+
+	while( written < file->wbuff_len )
+	{
+		result = fs_sysio->write( file->handle, &file->wbuff[written], file->wbuff_len - written );
+
+		if( result <= 0 )
+		{
+			// the rest is lost, get real position back
+			file->wbuff_len = 0;
+			file->position = fs_sysio->seek( file->handle, 0, SEEK_CUR ) - file->offset;
+			return false;
+		}
+
+		written += result;
+	}
+
+	file->wbuff_len = 0;
+	return true;
+}
+
 /*
 ====================
 FS_Close
@@ -2078,8 +2256,12 @@ Close a file
 */
 int FS_Close( file_t *file )
 {
+	qboolean	flushed;
+
 	if( !file ) return 0;
 
+	flushed = FS_FlushWriteBuffer( file );
+
 	FS_BackupFileName( file, NULL, 0 );
 
 	if( file->handle >= 0 )
@@ -2088,8 +2270,14 @@ int FS_Close( file_t *file )
 			return EOF;
 	}
 
+	if( file->wbuff )
+		Mem_Free( file->wbuff );
+
+	if( file->buff )
+		free( file->buff );
+
 	Mem_Free( file );
-	return 0;
+	return flushed ? 0 : EOF;
 }
 
 /*
@@ -2103,6 +2291,9 @@ int FS_Flush( file_t *file )
 {
 	if( !file ) return 0;
 
+	if( !FS_FlushWriteBuffer( file ))
+		return EOF;
+
 	// purge cached data
 	FS_Purge( file );
 
@@ -2131,25 +2322,92 @@ fs_offset_t FS_Write( file_t *file, const void *data, size_t datasize )
 
 	if( !file ) return 0;
 
-	// if necessary, seek to the exact file position we're supposed to be
+	// if necessary, go back to the exact file position we're supposed to be
 	if( file->buff_ind != file->buff_len )
-		lseek( file->handle, file->buff_ind - file->buff_len, SEEK_CUR );
+	{
+		file->position -= file->buff_len - file->buff_ind;
+		file->resync = true;
+	}
 
 	// purge cached data
 	FS_Purge( file );
 
-	// write the buffer and update the position
-	result = write( file->handle, data, datasize );
-	file->position = lseek( file->handle, 0, SEEK_CUR );
+	// system will put the data to the end anyway
+	if( file->append )
+		file->position = file->real_length;
+
+	if( file->wbuff_len + (fs_offset_t)datasize > file->wbuff_size )
+	{
+		if( !FS_FlushWriteBuffer( file ))
+			return 0;
+
+		// file is being written a lot, give it a bigger buffer
+		if( file->wbuff_size < FILE_WBUFF_MAX )
+		{
+			file->wbuff_size = file->wbuff_size ? file->wbuff_size * 2 : FILE_WBUFF_MIN;
+
+			if( file->wbuff )
+				Mem_Free( file->wbuff );
+			file->wbuff = (byte *)Mem_Malloc( fs_mempool, file->wbuff_size );
+		}
+	}
+
+	if( (fs_offset_t)datasize < file->wbuff_size )
+	{
+		memcpy( &file->wbuff[file->wbuff_len], data, datasize );
+		file->wbuff_len += datasize;
+		result = datasize;
+	}
+	else
+	{
+		// buffer is empty at this point, big blocks are written directly
+		if( !FS_SyncWritePosition( file ))
+			return 0;
+
+		result = fs_sysio->write( file->handle, data, datasize );
+
+		if( result < 0 )
+			return 0;
+	}
+
+	file->position += result;
 
 	if( file->real_length < file->position )
 		file->real_length = file->position;
 
-	if( result < 0 )
-		return 0;
 	return result;
 }
 
+/*
+====================
+FS_AllocReadBuffer
+
+Make read-ahead buffer fit current window. Files may be read
+from several threads and engine zone allocator isn't locked,
+so system allocator is used. Contents are kept, FS_Seek may
+still step back into them
+====================
+*/
+static void FS_AllocReadBuffer( file_t *file )
+{
+	byte	*buff;
+
+	if( file->buff_size >= file->readahead )
+		return;
+
+	buff = (byte *)realloc( file->buff, file->readahead );
+
+	if( !buff )
+	{
+		// keep reading through the old window
+		file->readahead = file->buff_size;
+		return;
+	}
+
+	file->buff = buff;
+	file->buff_size = file->readahead;
+}
+
 /*
 ====================
 FS_Read
@@ -2162,10 +2420,15 @@ fs_offset_t FS_Read( file_t *file, void *buffer, size_t buffersize )
 	fs_offset_t	done;
 	fs_offset_t	nb;
 	fs_offset_t	count;
+	qboolean	sequential;
 
 	// nothing to copy
 	if( buffersize == 0 ) return 1;
 
+	// read after write, pending data must be on disk
+	if( !FS_FlushWriteBuffer( file ))
+		return 0;
+
 	// Get rid of the ungetc character
 	if( file->ungetc != EOF )
 	{
@@ -2197,33 +2460,66 @@ fs_offset_t FS_Read( file_t *file, void *buffer, size_t buffersize )
 	// we must take care to not read after the end of the file
 	count = file->real_length - file->position;
 
+	// grow read-ahead window while file is being read sequentially
+	sequential = file->readahead && file->position == file->ahead_end;
+
+	if( !file->readahead )
+		file->readahead = FILE_BUFF_SIZE;
+	else if( sequential && file->readahead < FILE_BUFF_MAX )
+		file->readahead *= 2;
+
+	// reads are positional, so the descriptor can be shared
+	file->resync = true;
+
 	// if we have a lot of data to get, put them directly into "buffer"
-	if( buffersize > sizeof( file->buff ) / 2 )
+	if( (fs_offset_t)buffersize > file->readahead / 2 )
 	{
-		if( count > (fs_offset_t)buffersize )
-			count = (fs_offset_t)buffersize;
-		lseek( file->handle, file->offset + file->position, SEEK_SET );
-		nb = read( file->handle, &((byte *)buffer)[done], count );
+		fs_iovec_t	iov[2];
+		int		iovcnt = 1;
+
+		iov[0].base = &((byte *)buffer)[done];
+		iov[0].len = count > (fs_offset_t)buffersize ? buffersize : count;
+
+		// streaming through the file, fetch next chunk with the same call
+		if( sequential && count > (fs_offset_t)buffersize )
+		{
+			FS_AllocReadBuffer( file );
+			iov[1].base = file->buff;
+			iov[1].len = Q_min( count - (fs_offset_t)buffersize, file->readahead );
+			iovcnt = 2;
+		}
+
+		nb = fs_sysio->preadv( file->handle, iov, iovcnt, file->offset + file->position );
 
 		if( nb > 0 )
 		{
-			done += nb;
-			file->position += nb;
 			// purge cached data
 			FS_Purge( file );
+
+			if( nb > (fs_offset_t)iov[0].len )
+			{
+				file->buff_len = nb - iov[0].len;
+				nb = iov[0].len;
+			}
+
+			done += nb;
+			file->position += nb + file->buff_len;
+			file->ahead_end = file->position;
 		}
 	}
 	else
 	{
-		if( count > (fs_offset_t)sizeof( file->buff ))
-			count = (fs_offset_t)sizeof( file->buff );
-		lseek( file->handle, file->offset + file->position, SEEK_SET );
-		nb = read( file->handle, file->buff, count );
+		FS_AllocReadBuffer( file );
+
+		if( count > file->readahead )
+			count = file->readahead;
+		nb = fs_sysio->pread( file->handle, file->buff, count, file->offset + file->position );
 
 		if( nb > 0 )
 		{
 			file->buff_len = nb;
 			file->position += nb;
+			file->ahead_end = file->position;
 
 			// copy the requested data in "buffer" (as much as we can)
 			count = (fs_offset_t)buffersize > file->buff_len ? file->buff_len : (fs_offset_t)buffersize;
@@ -2294,7 +2590,7 @@ int FS_VPrintf( file_t *file, const char *format, va_list ap )
 		buff_size *= 2;
 	}
 
-	len = write( file->handle, tempbuff, len );
+	len = FS_Write( file, tempbuff, len );
 	Mem_Free( tempbuff );
 
 	return len;
@@ -2405,13 +2701,19 @@ int FS_Seek( file_t *file, fs_offset_t offset, int whence )
 		return 0;
 	}
 
-	FS_EnsureOpenFile( file );
+	if( !FS_FlushWriteBuffer( file ))
+		return -1;
+
 	// Purge cached data
 	FS_Purge( file );
 
-	if( lseek( file->handle, file->offset + offset, SEEK_SET ) == -1 )
-		return -1;
+	// reads are positional, descriptor is moved on next write
 	file->position = offset;
+	file->resync = true;
+
+	// random access, shrink read-ahead window
+	if( file->readahead > FILE_BUFF_SIZE )
+		file->readahead /= 2;
 
 	return 0;
 }
@@ -2500,6 +2802,8 @@ static byte *FS_LoadFile_( const char *path, fs_offset_t *filesizeptr, const qbo
 	if( !search )
 		return NULL;
 
+	FS_TraceAccess( path );
+
 	// custom load file function for compressed files
 	if( search->pfnLoadFile )
 		return search->pfnLoadFile( search, netpath, pack_ind, filesizeptr, pfnAlloc, pfnFree );
@@ -2537,6 +2841,62 @@ byte *FS_LoadFile( const char *path, fs_offset_t *filesizeptr, qboolean gamediro
 	return FS_LoadFile_( path, filesizeptr, gamedironly, true );
 }
 
+/*
+============
+FS_EnumWadLumps
+
+Walks lump tables of every mounted wad with given base name,
+in the same order FS_FindFile would look into them.
+Returns total number of lumps.
+============
+*/
+int FS_EnumWadLumps( const char *wadname, void (*pfnLump)( void *context, const void *wad, int index, const char *name, signed char type ), void *context )
+{
+	searchpath_t *search;
+	int count = 0;
+
+	if( !COM_CheckString( wadname ))
+		return 0;
+
+	for( search = fs_searchpaths; search; search = search->next )
+	{
+		string basename;
+
+		if( search->type != SEARCHPATH_WAD )
+			continue;
+
+		COM_FileBase( search->filename, basename, sizeof( basename ));
+
+		if( !Q_stricmp( basename, wadname ))
+			count += W_EnumLumps( search, pfnLump, context );
+	}
+
+	return count;
+}
+
+/*
+============
+FS_LoadWadLump
+
+Reads lump reported by FS_EnumWadLumps without searching for it.
+Buffer is freed with Mem_Free, no trailing zero byte.
+============
+*/
+byte *FS_LoadWadLump( const void *wad, int index, fs_offset_t *lumpsizeptr )
+{
+	searchpath_t *search;
+
+	// make sure it wasn't unmounted since
+	for( search = fs_searchpaths; search; search = search->next )
+	{
+		if( search == wad && search->type == SEARCHPATH_WAD )
+			return W_LoadLump( search, index, lumpsizeptr, FS_CustomAlloc, FS_CustomFree );
+	}
+
+	if( lumpsizeptr ) *lumpsizeptr = 0;
+	return NULL;
+}
+
 qboolean CRC32_File( dword *crcvalue, const char *filename )
 {
 	char	buffer[1024];
@@ -3095,8 +3455,19 @@ const fs_api_t g_api =
 	FS_LoadFileMalloc,
 
 	FS_IsArchiveExtensionSupported,
+
+	FS_SetAccessTrace,
+
+	FS_EnumWadLumps,
+	FS_LoadWadLump,
 };
 
+void EXPORT FS_SetSysIO( const fs_sysio_t *io );
+void EXPORT FS_SetSysIO( const fs_sysio_t *io )
+{
+	fs_sysio = io ? io : &fs_sysio_default;
+}
+
 int EXPORT GetFSAPI( int version, fs_api_t *api, fs_globals_t **globals, fs_interface_t *engfuncs );
 int EXPORT GetFSAPI( int version, fs_api_t *api, fs_globals_t **globals, fs_interface_t *engfuncs )
 {
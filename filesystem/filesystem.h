@@ -32,8 +32,8 @@ extern "C"
 {
 #endif // __cplusplus
 
-#define FS_API_VERSION 3 // not stable yet!
-#define FS_API_CREATEINTERFACE_TAG   "XashFileSystem002" // follow FS_API_VERSION!!!
+#define FS_API_VERSION 4 // not stable yet!
+#define FS_API_CREATEINTERFACE_TAG   "XashFileSystem003" // follow FS_API_VERSION!!!
 #define FILESYSTEM_INTERFACE_VERSION "VFileSystem009" // never change this!
 
 // search path flags
@@ -203,6 +203,14 @@ typedef struct fs_api_t
 
 	// queries supported archive formats
 	qboolean (*IsArchiveExtensionSupported)( const char *ext, uint flags );
+
+	// logs names of accessed files in order to given file in game directory, NULL stops
+	void (*SetAccessTrace)( const char *path );
+
+	// walks lump tables of mounted wads with given base name in search order, pfnLump can be NULL to count lumps
+	// wad handle is valid until searchpaths are changed
+	int (*EnumWadLumps)( const char *wadname, void (*pfnLump)( void *context, const void *wad, int index, const char *name, signed char type ), void *context );
+	byte *(*LoadWadLump)( const void *wad, int index, fs_offset_t *lumpsizeptr );
 } fs_api_t;
 
 typedef struct fs_interface_t
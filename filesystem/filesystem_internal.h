@@ -39,7 +39,10 @@ typedef struct pack_s pack_t;
 typedef struct wfile_s wfile_t;
 typedef struct android_assets_s android_assets_t;
 
-#define FILE_BUFF_SIZE (2048)
+#define FILE_BUFF_SIZE (2048)  // initial and minimal read-ahead window
+#define FILE_BUFF_MAX  (65536) // read-ahead window grows up to this size on sequential reads
+#define FILE_WBUFF_MIN (4096)  // initial write-behind buffer size
+#define FILE_WBUFF_MAX (65536) // write-behind buffer grows up to this size for heavily written files
 
 struct file_s
 {
@@ -51,10 +54,20 @@ struct file_s
 	fs_offset_t  position;    // current position in the file
 	fs_offset_t  offset;      // offset into the package (0 if external file)
 	
-	// contents buffer
-	fs_offset_t buff_ind; // buffer current index
-	fs_offset_t buff_len; // buffer current length
-	byte		buff[FILE_BUFF_SIZE]; // intermediate buffer
+	// read-ahead buffer, allocated with malloc on first read
+	byte        *buff;
+	fs_offset_t buff_ind;   // buffer current index
+	fs_offset_t buff_len;   // buffer current length
+	fs_offset_t buff_size;  // allocated size
+	fs_offset_t readahead;  // current read-ahead window
+	fs_offset_t ahead_end;  // position after last refill, reading from there is sequential
+
+	// write-behind buffer, pending data ends at current position
+	byte        *wbuff;
+	fs_offset_t wbuff_len;  // pending bytes
+	fs_offset_t wbuff_size; // allocated size, 0 until first write
+	qboolean    append;     // opened with O_APPEND, all writes go to the end
+	qboolean    resync;     // reads are positional, descriptor must be moved before next write
 
 #ifdef XASH_REDUCE_FD
 	const char *backup_path;
@@ -63,6 +76,25 @@ struct file_s
 #endif
 };
 
+typedef struct fs_iovec_s
+{
+	void   *base;
+	size_t len;
+} fs_iovec_t;
+
+// raw descriptor i/o used by file_t, can be replaced to count or fail syscalls in tests
+// reads are positional and don't touch descriptor offset, so archive handle can be shared
+typedef struct fs_sysio_s
+{
+	fs_offset_t (*pread)( int handle, void *buf, size_t count, fs_offset_t offset );
+	fs_offset_t (*preadv)( int handle, const fs_iovec_t *iov, int iovcnt, fs_offset_t offset );
+	fs_offset_t (*write)( int handle, const void *buf, size_t count );
+	fs_offset_t (*seek)( int handle, fs_offset_t offset, int whence );
+} fs_sysio_t;
+
+#define FS_SET_SYSIO "FS_SetSysIO"
+typedef void (*FSSETSYSIO)( const fs_sysio_t *io );
+
 typedef enum searchpathtype_e
 {
 	SEARCHPATH_PLAIN = 0,
@@ -163,6 +195,9 @@ search_t *FS_Search( const char *pattern, int caseinsensitive, int gamedironly )
 	MALLOC_LIKE( _Mem_Free, 1 ) WARN_UNUSED_RESULT;
 int FS_SetCurrentDirectory( const char *path );
 void FS_Path_f( void );
+void FS_SetAccessTrace( const char *path );
+int FS_EnumWadLumps( const char *wadname, void (*pfnLump)( void *context, const void *wad, int index, const char *name, signed char type ), void *context );
+byte *FS_LoadWadLump( const void *wad, int index, fs_offset_t *lumpsizeptr );
 
 // gameinfo utils
 void FS_LoadGameInfo( const char *rootfolder );
@@ -235,6 +270,8 @@ searchpath_t *FS_AddPak_Fullpath( const char *pakfile, int flags );
 // wad.c
 //
 searchpath_t *FS_AddWad_Fullpath( const char *wadfile, int flags );
+int W_EnumLumps( searchpath_t *search, void (*pfnLump)( void *context, const void *wad, int index, const char *name, signed char type ), void *context );
+byte *W_LoadLump( searchpath_t *search, int index, fs_offset_t *lumpsizeptr, void *( *pfnAlloc )( size_t ), void ( *pfnFree )( void * ));
 
 //
 // zip.c
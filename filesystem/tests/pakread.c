@@ -0,0 +1,421 @@
+#include "port.h"
+#include "build.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "filesystem.h"
+#include "filesystem_internal.h"
+#include "xash3d_mathlib.h"
+#if XASH_POSIX
+#include <dlfcn.h>
+#include <unistd.h>
+#include <pthread.h>
+#define LoadLibrary( x ) dlopen( x, RTLD_NOW )
+#define GetProcAddress( x, y ) dlsym( x, y )
+#define FreeLibrary( x ) dlclose( x )
+#elif XASH_WIN32
+#include <windows.h>
+#include <io.h>
+#endif
+
+#define PAK_NAME    "pakread.pak"
+#define NUM_FILES   16
+#define NUM_THREADS 4
+#define NUM_RANDOM  2000
+
+void *g_hModule;
+FSAPI g_pfnGetFSAPI;
+FSSETSYSIO g_pfnSetSysIO;
+fs_api_t g_fs;
+fs_globals_t *g_nullglobals;
+
+// same as in pak.c
+typedef struct
+{
+	int ident;
+	int dirofs;
+	int dirlen;
+} dpackheader_t;
+
+typedef struct
+{
+	char name[56];
+	int filepos;
+	int filelen;
+} dpackfile_t;
+
+static int g_numreads;
+static fs_offset_t g_filelen[NUM_FILES];
+
+static fs_offset_t CountPRead( int handle, void *buf, size_t count, fs_offset_t offset )
+{
+	g_numreads++;
+#if XASH_POSIX
+	return pread( handle, buf, count, offset );
+#else
+	lseek( handle, offset, SEEK_SET );
+	return read( handle, buf, count );
+#endif
+}
+
+static fs_offset_t CountPReadV( int handle, const fs_iovec_t *iov, int iovcnt, fs_offset_t offset )
+{
+	fs_offset_t total = 0, nb;
+	int i;
+
+	g_numreads++;
+
+	for( i = 0; i < iovcnt; i++ )
+	{
+#if XASH_POSIX
+		nb = pread( handle, iov[i].base, iov[i].len, offset + total );
+#else
+		lseek( handle, offset + total, SEEK_SET );
+		nb = read( handle, iov[i].base, iov[i].len );
+#endif
+		if( nb <= 0 )
+			break;
+		total += nb;
+	}
+
+	return total;
+}
+
+static fs_offset_t SysWrite( int handle, const void *buf, size_t count )
+{
+	return write( handle, buf, count );
+}
+
+static fs_offset_t SysSeek( int handle, fs_offset_t offset, int whence )
+{
+	return lseek( handle, offset, whence );
+}
+
+static const fs_sysio_t g_countio = { CountPRead, CountPReadV, SysWrite, SysSeek };
+
+static qboolean LoadFilesystem( void )
+{
+	g_hModule = LoadLibrary( "filesystem_stdio." OS_LIB_EXT );
+	if( !g_hModule )
+		return false;
+
+	g_pfnGetFSAPI = (void*)GetProcAddress( g_hModule, GET_FS_API );
+	if( !g_pfnGetFSAPI )
+		return false;
+
+	g_pfnSetSysIO = (void*)GetProcAddress( g_hModule, FS_SET_SYSIO );
+	if( !g_pfnSetSysIO )
+		return false;
+
+	if( !g_pfnGetFSAPI( FS_API_VERSION, &g_fs, &g_nullglobals, NULL ))
+		return false;
+
+	return true;
+}
+
+static double GetTime( void )
+{
+#if XASH_POSIX
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec + ts.tv_nsec * 0.000000001;
+#else
+	return clock() / (double)CLOCKS_PER_SEC;
+#endif
+}
+
+// contents can be checked at any offset without keeping a copy
+static byte ExpectedByte( int file, fs_offset_t offset )
+{
+	return (byte)( file * 131 + offset * 7 + ( offset >> 9 ));
+}
+
+static qboolean CheckBlock( int file, fs_offset_t offset, const byte *buf, fs_offset_t len )
+{
+	fs_offset_t i;
+
+	for( i = 0; i < len; i++ )
+	{
+		if( buf[i] != ExpectedByte( file, offset + i ))
+			return false;
+	}
+
+	return true;
+}
+
+static qboolean WritePak( void )
+{
+	dpackheader_t hdr;
+	dpackfile_t dir[NUM_FILES];
+	byte buf[4096];
+	FILE *f;
+	int i, pos;
+
+	f = fopen( PAK_NAME, "wb" );
+	if( !f )
+		return false;
+
+	memset( dir, 0, sizeof( dir ));
+	pos = sizeof( hdr );
+	fseek( f, pos, SEEK_SET );
+
+	for( i = 0; i < NUM_FILES; i++ )
+	{
+		fs_offset_t ofs, j;
+
+		// odd sizes, so reads don't always end on block boundaries
+		g_filelen[i] = 65536 + i * 37813;
+
+		snprintf( dir[i].name, sizeof( dir[i].name ), "data/file%02d.bin", i );
+		dir[i].filepos = pos;
+		dir[i].filelen = g_filelen[i];
+
+		for( ofs = 0; ofs < g_filelen[i]; ofs += sizeof( buf ))
+		{
+			fs_offset_t len = Q_min( (fs_offset_t)sizeof( buf ), g_filelen[i] - ofs );
+
+			for( j = 0; j < len; j++ )
+				buf[j] = ExpectedByte( i, ofs + j );
+
+			fwrite( buf, len, 1, f );
+		}
+
+		pos += g_filelen[i];
+	}
+
+	fwrite( dir, sizeof( dir ), 1, f );
+
+	memcpy( &hdr.ident, "PACK", 4 );
+	hdr.dirofs = pos;
+	hdr.dirlen = sizeof( dir );
+	fseek( f, 0, SEEK_SET );
+	fwrite( &hdr, sizeof( hdr ), 1, f );
+	fclose( f );
+
+	return true;
+}
+
+typedef struct
+{
+	file_t *files[NUM_FILES];
+	byte *buf;
+	uint seed;
+	qboolean ok;
+	fs_offset_t bytes;
+} worker_t;
+
+static uint NextRand( uint *seed )
+{
+	*seed = *seed * 1103515245 + 12345;
+	return *seed >> 8;
+}
+
+static qboolean ReadSequential( worker_t *w, int file, fs_offset_t chunk )
+{
+	file_t *f = w->files[file];
+	fs_offset_t ofs = 0, nb;
+
+	if( g_fs.Seek( f, 0, SEEK_SET ))
+		return false;
+
+	while(( nb = g_fs.Read( f, w->buf, chunk )) > 0 )
+	{
+		if( !CheckBlock( file, ofs, w->buf, nb ))
+			return false;
+		ofs += nb;
+	}
+
+	w->bytes += ofs;
+	return ofs == g_filelen[file] && g_fs.Eof( f );
+}
+
+static qboolean ReadRandom( worker_t *w )
+{
+	int i;
+
+	for( i = 0; i < NUM_RANDOM; i++ )
+	{
+		int file = NextRand( &w->seed ) % NUM_FILES;
+		fs_offset_t ofs = NextRand( &w->seed ) % g_filelen[file];
+		fs_offset_t len = 1 + NextRand( &w->seed ) % 16384;
+		fs_offset_t nb;
+
+		len = Q_min( len, g_filelen[file] - ofs );
+
+		if( g_fs.Seek( w->files[file], ofs, SEEK_SET ))
+			return false;
+
+		nb = g_fs.Read( w->files[file], w->buf, len );
+		if( nb != len || !CheckBlock( file, ofs, w->buf, nb ))
+			return false;
+
+		w->bytes += nb;
+	}
+
+	return true;
+}
+
+static void *Worker( void *arg )
+{
+	worker_t *w = arg;
+	int i;
+
+	w->ok = false;
+
+	// every thread walks files in its own order with own chunk size
+	for( i = 0; i < NUM_FILES; i++ )
+	{
+		int file = ( i + w->seed ) % NUM_FILES;
+
+		if( !ReadSequential( w, file, 512 << ( w->seed % 7 )))
+		{
+			printf( "sequential read fail (file %d)\n", file );
+			return NULL;
+		}
+	}
+
+	if( !ReadRandom( w ))
+	{
+		printf( "random read fail\n" );
+		return NULL;
+	}
+
+	w->ok = true;
+	return NULL;
+}
+
+static qboolean TestReadAhead( void )
+{
+	byte buf[512];
+	file_t *f;
+	fs_offset_t ofs = 0, nb;
+
+	f = g_fs.Open( "data/file00.bin", "rb", false );
+	if( !f )
+	{
+		printf( "Open fail\n" );
+		return false;
+	}
+
+	// small sequential reads must be served from a growing window
+	g_numreads = 0;
+	g_pfnSetSysIO( &g_countio );
+
+	while(( nb = g_fs.Read( f, buf, sizeof( buf ))) > 0 )
+	{
+		if( !CheckBlock( 0, ofs, buf, nb ))
+		{
+			printf( "read-ahead contents fail\n" );
+			return false;
+		}
+		ofs += nb;
+	}
+
+	g_pfnSetSysIO( NULL );
+	g_fs.Close( f );
+
+	if( ofs != g_filelen[0] || g_numreads > 8 )
+	{
+		printf( "read-ahead fail (%ld bytes, %d reads)\n", (long)ofs, g_numreads );
+		return false;
+	}
+
+	return true;
+}
+
+static qboolean TestThreads( void )
+{
+	worker_t workers[NUM_THREADS];
+	fs_offset_t total = 0;
+	double start, end;
+	int i, j;
+#if XASH_POSIX
+	pthread_t threads[NUM_THREADS];
+#endif
+
+	// opening files touches search paths, do it before threads are started
+	for( i = 0; i < NUM_THREADS; i++ )
+	{
+		memset( &workers[i], 0, sizeof( workers[i] ));
+		workers[i].seed = i + 1;
+		workers[i].buf = malloc( 65536 );
+
+		for( j = 0; j < NUM_FILES; j++ )
+		{
+			char name[64];
+
+			snprintf( name, sizeof( name ), "data/file%02d.bin", j );
+			workers[i].files[j] = g_fs.Open( name, "rb", false );
+
+			if( !workers[i].files[j] )
+			{
+				printf( "Open %s fail\n", name );
+				return false;
+			}
+		}
+	}
+
+	start = GetTime();
+
+#if XASH_POSIX
+	for( i = 0; i < NUM_THREADS; i++ )
+		pthread_create( &threads[i], NULL, Worker, &workers[i] );
+
+	for( i = 0; i < NUM_THREADS; i++ )
+		pthread_join( threads[i], NULL );
+#else
+	for( i = 0; i < NUM_THREADS; i++ )
+		Worker( &workers[i] );
+#endif
+
+	end = GetTime();
+
+	for( i = 0; i < NUM_THREADS; i++ )
+	{
+		if( !workers[i].ok )
+			return false;
+
+		for( j = 0; j < NUM_FILES; j++ )
+			g_fs.Close( workers[i].files[j] );
+
+		free( workers[i].buf );
+		total += workers[i].bytes;
+	}
+
+	printf( "%d threads read %.1f MB in %.3f sec (%.1f MB/s)\n", NUM_THREADS,
+		total / ( 1024.0 * 1024.0 ), end - start, total / ( 1024.0 * 1024.0 ) / Q_max( end - start, 0.000001 ));
+
+	return true;
+}
+
+int main( void )
+{
+	if( !LoadFilesystem() )
+		return EXIT_FAILURE;
+
+	if( !WritePak())
+	{
+		printf( "WritePak fail\n" );
+		return EXIT_FAILURE;
+	}
+
+	if( !g_fs.MountArchive_Fullpath( PAK_NAME, 0 ))
+	{
+		printf( "Mount fail\n" );
+		return EXIT_FAILURE;
+	}
+
+	if( !TestReadAhead())
+		return EXIT_FAILURE;
+
+	if( !TestThreads())
+		return EXIT_FAILURE;
+
+	remove( PAK_NAME );
+
+	printf( "success\n" );
+
+	return EXIT_SUCCESS;
+}
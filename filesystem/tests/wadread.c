@@ -0,0 +1,304 @@
+#include "port.h"
+#include "build.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "filesystem.h"
+#include "filesystem_internal.h"
+#include "wadfile.h"
+#include "crtlib.h"
+#if XASH_POSIX
+#include <dlfcn.h>
+#define LoadLibrary( x ) dlopen( x, RTLD_NOW )
+#define GetProcAddress( x, y ) dlsym( x, y )
+#define FreeLibrary( x ) dlclose( x )
+#elif XASH_WIN32
+#include <windows.h>
+#endif
+
+#define WAD_A       "wadread_a.wad"
+#define WAD_B       "wadread_b.wad"
+#define MAX_LUMPS   8
+
+void *g_hModule;
+FSAPI g_pfnGetFSAPI;
+fs_api_t g_fs;
+fs_globals_t *g_nullglobals;
+
+// same as in wad.c
+typedef struct
+{
+	int ident;
+	int numlumps;
+	int infotableofs;
+} dwadheader_t;
+
+typedef struct
+{
+	int filepos;
+	int disksize;
+	int size;
+	signed char type;
+	signed char attribs;
+	signed char pad0;
+	signed char pad1;
+	char name[16];
+} dwadlump_t;
+
+typedef struct
+{
+	const char *name;
+	signed char type;
+	int seed;
+	int size;
+} testlump_t;
+
+// brick is in both wads, type differs for logo
+static const testlump_t g_lumps_a[] =
+{
+{ "brick", TYP_MIPTEX, 1, 1000 },
+{ "Sky", TYP_MIPTEX, 2, 333 },
+{ "logo", TYP_GFXPIC, 3, 77 },
+};
+
+static const testlump_t g_lumps_b[] =
+{
+{ "brick", TYP_MIPTEX, 4, 1200 },
+{ "water", TYP_MIPTEX, 5, 64 },
+};
+
+typedef struct
+{
+	const void *wad[MAX_LUMPS];
+	int index[MAX_LUMPS];
+	char name[MAX_LUMPS][16];
+	signed char type[MAX_LUMPS];
+	int count;
+} enumresult_t;
+
+static qboolean LoadFilesystem( void )
+{
+	g_hModule = LoadLibrary( "filesystem_stdio." OS_LIB_EXT );
+	if( !g_hModule )
+		return false;
+
+	g_pfnGetFSAPI = (void*)GetProcAddress( g_hModule, GET_FS_API );
+	if( !g_pfnGetFSAPI )
+		return false;
+
+	if( !g_pfnGetFSAPI( FS_API_VERSION, &g_fs, &g_nullglobals, NULL ))
+		return false;
+
+	return true;
+}
+
+static byte ExpectedByte( int seed, int offset )
+{
+	return (byte)( seed * 151 + offset * 13 );
+}
+
+static qboolean WriteWad( const char *filename, const testlump_t *lumps, int numlumps )
+{
+	dwadlump_t dir[MAX_LUMPS];
+	dwadheader_t hdr;
+	FILE *f;
+	int i, j, pos;
+
+	f = fopen( filename, "wb" );
+	if( !f )
+		return false;
+
+	memset( dir, 0, sizeof( dir ));
+	pos = sizeof( hdr );
+	fseek( f, pos, SEEK_SET );
+
+	for( i = 0; i < numlumps; i++ )
+	{
+		for( j = 0; j < lumps[i].size; j++ )
+			fputc( ExpectedByte( lumps[i].seed, j ), f );
+
+		strncpy( dir[i].name, lumps[i].name, sizeof( dir[i].name ) - 1 );
+		dir[i].filepos = pos;
+		dir[i].disksize = dir[i].size = lumps[i].size;
+		dir[i].type = lumps[i].type;
+		pos += lumps[i].size;
+	}
+
+	fwrite( dir, sizeof( dir[0] ), numlumps, f );
+
+	hdr.ident = IDWAD3HEADER;
+	hdr.numlumps = numlumps;
+	hdr.infotableofs = pos;
+	fseek( f, 0, SEEK_SET );
+	fwrite( &hdr, sizeof( hdr ), 1, f );
+	fclose( f );
+
+	return true;
+}
+
+static void CollectLump( void *context, const void *wad, int index, const char *name, signed char type )
+{
+	enumresult_t *r = context;
+
+	if( r->count >= MAX_LUMPS )
+		return;
+
+	r->wad[r->count] = wad;
+	r->index[r->count] = index;
+	strncpy( r->name[r->count], name, sizeof( r->name[0] ) - 1 );
+	r->type[r->count] = type;
+	r->count++;
+}
+
+static qboolean CheckLump( const enumresult_t *r, const testlump_t *lump )
+{
+	fs_offset_t size;
+	byte *data;
+	int i, j;
+
+	for( i = 0; i < r->count; i++ )
+	{
+		if( !Q_stricmp( r->name[i], lump->name ))
+			break;
+	}
+
+	if( i == r->count )
+	{
+		printf( "%s wasn't enumerated\n", lump->name );
+		return false;
+	}
+
+	if( r->type[i] != lump->type )
+	{
+		printf( "%s type %d, expected %d\n", lump->name, r->type[i], lump->type );
+		return false;
+	}
+
+	data = g_fs.LoadWadLump( r->wad[i], r->index[i], &size );
+
+	if( !data || size != lump->size )
+	{
+		printf( "%s LoadWadLump fail\n", lump->name );
+		free( data );
+		return false;
+	}
+
+	for( j = 0; j < size; j++ )
+	{
+		if( data[j] != ExpectedByte( lump->seed, j ))
+		{
+			printf( "%s mismatch at %d\n", lump->name, j );
+			free( data );
+			return false;
+		}
+	}
+
+	free( data );
+	return true;
+}
+
+static qboolean TestEnum( void )
+{
+	enumresult_t a = { 0 }, b = { 0 };
+	fs_offset_t size, size2;
+	byte *data, *data2;
+	int i;
+
+	if( g_fs.EnumWadLumps( "wadread_a", NULL, NULL ) != 3 || g_fs.EnumWadLumps( "WADREAD_B", NULL, NULL ) != 2 )
+	{
+		printf( "lump count fail\n" );
+		return false;
+	}
+
+	if( g_fs.EnumWadLumps( "wadread_c", NULL, NULL ) != 0 )
+	{
+		printf( "unmounted wad enumerated\n" );
+		return false;
+	}
+
+	if( g_fs.EnumWadLumps( "wadread_a", CollectLump, &a ) != a.count || g_fs.EnumWadLumps( "wadread_b", CollectLump, &b ) != b.count )
+	{
+		printf( "enum count fail\n" );
+		return false;
+	}
+
+	// names are lowercased by wad loader
+	for( i = 0; i < a.count; i++ )
+	{
+		if( !strcmp( a.name[i], "Sky" ))
+		{
+			printf( "lump name isn't lowercased\n" );
+			return false;
+		}
+	}
+
+	for( i = 0; i < sizeof( g_lumps_a ) / sizeof( g_lumps_a[0] ); i++ )
+	{
+		if( !CheckLump( &a, &g_lumps_a[i] ))
+			return false;
+	}
+
+	for( i = 0; i < sizeof( g_lumps_b ) / sizeof( g_lumps_b[0] ); i++ )
+	{
+		if( !CheckLump( &b, &g_lumps_b[i] ))
+			return false;
+	}
+
+	// must be same lump as generic path lookup finds
+	data = g_fs.LoadFile( WAD_B "/brick.mip", &size, false );
+	data2 = g_fs.LoadWadLump( b.wad[0], b.index[0], &size2 );
+
+	if( !data || !data2 || size != size2 || memcmp( data, data2, size ))
+	{
+		printf( "LoadFile and LoadWadLump differ\n" );
+		free( data );
+		free( data2 );
+		return false;
+	}
+
+	free( data );
+	free( data2 );
+
+	if( g_fs.LoadWadLump( a.wad[0], 100, &size ) || size != 0 )
+	{
+		printf( "out of range lump loaded\n" );
+		return false;
+	}
+
+	if( g_fs.LoadWadLump( &a, 0, &size ))
+	{
+		printf( "bogus wad handle accepted\n" );
+		return false;
+	}
+
+	return true;
+}
+
+int main( void )
+{
+	if( !LoadFilesystem() )
+		return EXIT_FAILURE;
+
+	if( !WriteWad( WAD_A, g_lumps_a, sizeof( g_lumps_a ) / sizeof( g_lumps_a[0] ))
+		|| !WriteWad( WAD_B, g_lumps_b, sizeof( g_lumps_b ) / sizeof( g_lumps_b[0] )))
+	{
+		printf( "WriteWad fail\n" );
+		return EXIT_FAILURE;
+	}
+
+	if( !g_fs.MountArchive_Fullpath( WAD_A, 0 ) || !g_fs.MountArchive_Fullpath( WAD_B, 0 ))
+	{
+		printf( "Mount fail\n" );
+		return EXIT_FAILURE;
+	}
+
+	if( !TestEnum())
+		return EXIT_FAILURE;
+
+	remove( WAD_A );
+	remove( WAD_B );
+
+	printf( "success\n" );
+
+	return EXIT_SUCCESS;
+}
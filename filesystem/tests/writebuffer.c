@@ -0,0 +1,293 @@
+#include "port.h"
+#include "build.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "filesystem.h"
+#include "filesystem_internal.h"
+#if XASH_POSIX
+#include <dlfcn.h>
+#include <unistd.h>
+#define LoadLibrary( x ) dlopen( x, RTLD_NOW )
+#define GetProcAddress( x, y ) dlsym( x, y )
+#define FreeLibrary( x ) dlclose( x )
+#elif XASH_WIN32
+#include <windows.h>
+#include <io.h>
+#endif
+
+void *g_hModule;
+FSAPI g_pfnGetFSAPI;
+FSSETSYSIO g_pfnSetSysIO;
+fs_api_t g_fs;
+fs_globals_t *g_nullglobals;
+
+static int g_numreads, g_numwrites, g_numseeks;
+
+// emulate positional reads by moving descriptor, like win32 ReadFile does,
+// so writes after reads must put it back themselves
+static fs_offset_t CountPRead( int handle, void *buf, size_t count, fs_offset_t offset )
+{
+	g_numreads++;
+	lseek( handle, offset, SEEK_SET );
+	return read( handle, buf, count );
+}
+
+static fs_offset_t CountPReadV( int handle, const fs_iovec_t *iov, int iovcnt, fs_offset_t offset )
+{
+	fs_offset_t total = 0, nb;
+	int i;
+
+	g_numreads++;
+	lseek( handle, offset, SEEK_SET );
+
+	for( i = 0; i < iovcnt; i++ )
+	{
+		nb = read( handle, iov[i].base, iov[i].len );
+		if( nb <= 0 )
+			break;
+		total += nb;
+	}
+
+	return total;
+}
+
+static fs_offset_t CountWrite( int handle, const void *buf, size_t count )
+{
+	g_numwrites++;
+	return write( handle, buf, count );
+}
+
+static fs_offset_t CountSeek( int handle, fs_offset_t offset, int whence )
+{
+	g_numseeks++;
+	return lseek( handle, offset, whence );
+}
+
+static const fs_sysio_t g_countio = { CountPRead, CountPReadV, CountWrite, CountSeek };
+
+static void ResetCounters( void )
+{
+	g_numreads = g_numwrites = g_numseeks = 0;
+}
+
+static qboolean LoadFilesystem( void )
+{
+	g_hModule = LoadLibrary( "filesystem_stdio." OS_LIB_EXT );
+	if( !g_hModule )
+		return false;
+
+	g_pfnGetFSAPI = (void*)GetProcAddress( g_hModule, GET_FS_API );
+	if( !g_pfnGetFSAPI )
+		return false;
+
+	g_pfnSetSysIO = (void*)GetProcAddress( g_hModule, FS_SET_SYSIO );
+	if( !g_pfnSetSysIO )
+		return false;
+
+	if( !g_pfnGetFSAPI( FS_API_VERSION, &g_fs, &g_nullglobals, NULL ))
+		return false;
+
+	g_pfnSetSysIO( &g_countio );
+
+	return true;
+}
+
+static qboolean CheckFileContents( const char *path, const void *buf, fs_offset_t size )
+{
+	fs_offset_t len;
+	byte *data;
+
+	data = g_fs.LoadFile( path, &len, true );
+	if( !data )
+	{
+		printf( "LoadFile fail\n" );
+		return false;
+	}
+
+	if( len != size )
+	{
+		printf( "LoadFile size fail (%ld != %ld)\n", (long)len, (long)size );
+		free( data );
+		return false;
+	}
+
+	if( memcmp( data, buf, size ))
+	{
+		printf( "LoadFile contents fail\n" );
+		free( data );
+		return false;
+	}
+
+	free( data );
+	return true;
+}
+
+static qboolean TestPrintf( void )
+{
+	char *expected;
+	size_t len = 0, size = 1024 * 1024;
+	file_t *f;
+	FILE *ref;
+	int i;
+
+	// write same log through stdio, it's what unbuffered FS_Printf produced
+	ref = fopen( "writebuffer_ref.log", "wb" );
+	f = g_fs.Open( "writebuffer.log", "wb", true );
+
+	if( !ref || !f )
+	{
+		printf( "Open fail\n" );
+		return false;
+	}
+
+	ResetCounters();
+
+	for( i = 0; i < 10000; i++ )
+	{
+		fprintf( ref, "%05d: \"sv_cheats\" = \"%d\"\n", i, i & 1 );
+		g_fs.Printf( f, "%05d: \"sv_cheats\" = \"%d\"\n", i, i & 1 );
+
+		if( i % 100 == 0 )
+		{
+			fwrite( &i, sizeof( i ), 1, ref );
+			g_fs.Write( f, &i, sizeof( i ));
+		}
+	}
+
+	if( g_fs.Tell( f ) != ftell( ref ))
+	{
+		printf( "Tell fail (%ld != %ld)\n", (long)g_fs.Tell( f ), ftell( ref ));
+		return false;
+	}
+
+	g_fs.Close( f );
+	fclose( ref );
+
+	// 10100 calls and ~260KB of data must end up in a handful of syscalls
+	if( g_numwrites > 16 || g_numseeks != 0 )
+	{
+		printf( "syscall count fail (%d writes, %d seeks)\n", g_numwrites, g_numseeks );
+		return false;
+	}
+
+	expected = malloc( size );
+	ref = fopen( "writebuffer_ref.log", "rb" );
+	len = fread( expected, 1, size, ref );
+	fclose( ref );
+
+	if( !CheckFileContents( "writebuffer.log", expected, len ))
+		return false;
+
+	free( expected );
+	remove( "writebuffer_ref.log" );
+	g_fs.Delete( "writebuffer.log" );
+
+	return true;
+}
+
+static qboolean TestReadAfterWrite( void )
+{
+	byte expected[8192], buf[8192];
+	file_t *f;
+	int i;
+
+	for( i = 0; i < sizeof( expected ); i++ )
+		expected[i] = rand();
+
+	f = g_fs.Open( "writebuffer.bin", "w+b", true );
+	if( !f )
+	{
+		printf( "Open fail\n" );
+		return false;
+	}
+
+	// small writes, then read them back without closing
+	for( i = 0; i < 4096; i += 16 )
+		g_fs.Write( f, &expected[i], 16 );
+
+	if( g_fs.Seek( f, 1000, SEEK_SET ) || g_fs.Read( f, buf, 100 ) != 100 || memcmp( buf, &expected[1000], 100 ))
+	{
+		printf( "read after write fail\n" );
+		return false;
+	}
+
+	// overwrite in the middle, right after buffered read
+	memset( &expected[1100], 0xAA, 50 );
+	g_fs.Write( f, &expected[1100], 50 );
+
+	if( g_fs.Tell( f ) != 1150 )
+	{
+		printf( "Tell after overwrite fail\n" );
+		return false;
+	}
+
+	// big write goes to the end
+	g_fs.Seek( f, 0, SEEK_END );
+	g_fs.Write( f, &expected[4096], 4096 );
+
+	if( g_fs.FileLength( f ) != sizeof( expected ) || !g_fs.Eof( f ))
+	{
+		printf( "length after write fail\n" );
+		return false;
+	}
+
+	g_fs.Seek( f, 0, SEEK_SET );
+	if( g_fs.Read( f, buf, sizeof( buf )) != sizeof( buf ) || memcmp( buf, expected, sizeof( buf )))
+	{
+		printf( "read back fail\n" );
+		return false;
+	}
+
+	g_fs.Close( f );
+
+	if( !CheckFileContents( "writebuffer.bin", expected, sizeof( expected )))
+		return false;
+
+	// append mode always writes to the end, even after seek
+	f = g_fs.Open( "writebuffer.bin", "ab", true );
+	g_fs.Seek( f, 0, SEEK_SET );
+	g_fs.Write( f, "tail", 4 );
+
+	if( g_fs.Tell( f ) != sizeof( expected ) + 4 )
+	{
+		printf( "append Tell fail\n" );
+		return false;
+	}
+
+	g_fs.Close( f );
+
+	f = g_fs.Open( "writebuffer.bin", "rb", true );
+	g_fs.Seek( f, -4, SEEK_END );
+	if( g_fs.Read( f, buf, 4 ) != 4 || memcmp( buf, "tail", 4 ))
+	{
+		printf( "append fail\n" );
+		return false;
+	}
+	g_fs.Close( f );
+
+	g_fs.Delete( "writebuffer.bin" );
+
+	return true;
+}
+
+int main( void )
+{
+	if( !LoadFilesystem() )
+		return EXIT_FAILURE;
+
+	srand( time( NULL ));
+
+	g_fs.AddGameDirectory( "./", FS_GAMEDIR_PATH );
+
+	if( !TestPrintf())
+		return EXIT_FAILURE;
+
+	if( !TestReadAfterWrite())
+		return EXIT_FAILURE;
+
+	printf( "success\n" );
+
+	return EXIT_SUCCESS;
+}
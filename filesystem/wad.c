@@ -625,6 +625,45 @@ static byte *W_ReadLump( searchpath_t *search, const char *path, int pack_ind, f
 	return buf;
 }
 
+/*
+===========
+W_EnumLumps
+
+reports every lump in the sorted table, returns number of lumps
+===========
+*/
+int W_EnumLumps( searchpath_t *search, void (*pfnLump)( void *context, const void *wad, int index, const char *name, signed char type ), void *context )
+{
+	const wfile_t *wad = search->wad;
+	int i;
+
+	if( pfnLump )
+	{
+		for( i = 0; i < wad->numlumps; i++ )
+			pfnLump( context, search, i, wad->lumps[i].name, wad->lumps[i].type );
+	}
+
+	return wad->numlumps;
+}
+
+/*
+===========
+W_LoadLump
+
+reads lump by index from W_EnumLumps
+===========
+*/
+byte *W_LoadLump( searchpath_t *search, int index, fs_offset_t *lumpsizeptr, void *( *pfnAlloc )( size_t ), void ( *pfnFree )( void * ))
+{
+	if( index < 0 || index >= search->wad->numlumps )
+	{
+		if( lumpsizeptr ) *lumpsizeptr = 0;
+		return NULL;
+	}
+
+	return W_ReadLump( search, NULL, index, lumpsizeptr, pfnAlloc, pfnFree );
+}
+
 /*
 ====================
 FS_AddWad_Fullpath
@@ -471,6 +471,7 @@ static const ref_interface_t gReffuncs =
 	R_Set2DMode,
 	R_DrawStretchRaw,
 	R_DrawStretchPic,
+	R_DrawGlyphRun,
 	R_DrawTileClear,
 	CL_FillRGBA,
 	CL_FillRGBABlend,
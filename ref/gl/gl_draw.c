@@ -81,6 +81,92 @@ void R_DrawStretchPic( float x, float y, float w, float h, float s1, float t1, f
 	pglEnd();
 }
 
+#define GLYPH_BATCH	256
+
+/*
+=============
+R_DrawGlyphRun
+
+text glyphs share one texture, so whole
+string goes through a single vertex array,
+quads are split to triangles because gl2_shim
+and GLES can't draw quads from arrays
+=============
+*/
+void R_DrawGlyphRun( const ref_glyph_t *glyphs, int count, float x, float y, int texnum, int rendermode )
+{
+	static float	verts[GLYPH_BATCH * 4][2];
+	static float	coords[GLYPH_BATCH * 4][2];
+	static rgba_t	colors[GLYPH_BATCH * 4];
+	static unsigned short	elems[GLYPH_BATCH * 6];
+	int		i, j, k;
+
+	if( count <= 0 )
+		return;
+
+	// index pattern never changes, build it once
+	if( !elems[1] )
+	{
+		for( j = 0; j < GLYPH_BATCH; j++ )
+		{
+			elems[j*6+0] = j * 4 + 0;
+			elems[j*6+1] = j * 4 + 1;
+			elems[j*6+2] = j * 4 + 2;
+			elems[j*6+3] = j * 4 + 0;
+			elems[j*6+4] = j * 4 + 2;
+			elems[j*6+5] = j * 4 + 3;
+		}
+	}
+
+	if( rendermode >= 0 )
+		GL_SetRenderMode( rendermode );
+
+	GL_Bind( XASH_TEXTURE0, texnum );
+	GL_SetTexCoordArrayMode( GL_TEXTURE_COORD_ARRAY );
+	pglEnableClientState( GL_VERTEX_ARRAY );
+	pglEnableClientState( GL_COLOR_ARRAY );
+
+	pglVertexPointer( 2, GL_FLOAT, 0, verts );
+	pglTexCoordPointer( 2, GL_FLOAT, 0, coords );
+	pglColorPointer( 4, GL_UNSIGNED_BYTE, 0, colors );
+
+	for( i = 0; i < count; i += GLYPH_BATCH )
+	{
+		int	numglyphs = Q_min( count - i, GLYPH_BATCH );
+
+		for( j = 0; j < numglyphs; j++ )
+		{
+			const ref_glyph_t	*g = &glyphs[i + j];
+			float		x1 = x + g->x, y1 = y + g->y;
+			float		x2 = x1 + g->w, y2 = y1 + g->h;
+			int		v = j * 4;
+
+			verts[v+0][0] = x1; verts[v+0][1] = y1;
+			verts[v+1][0] = x2; verts[v+1][1] = y1;
+			verts[v+2][0] = x2; verts[v+2][1] = y2;
+			verts[v+3][0] = x1; verts[v+3][1] = y2;
+
+			coords[v+0][0] = g->s1; coords[v+0][1] = g->t1;
+			coords[v+1][0] = g->s2; coords[v+1][1] = g->t1;
+			coords[v+2][0] = g->s2; coords[v+2][1] = g->t2;
+			coords[v+3][0] = g->s1; coords[v+3][1] = g->t2;
+
+			for( k = 0; k < 4; k++ )
+				memcpy( colors[v+k], g->color, sizeof( rgba_t ));
+		}
+
+		pglDrawElements( GL_TRIANGLES, numglyphs * 6, GL_UNSIGNED_SHORT, elems );
+	}
+
+	pglDisableClientState( GL_COLOR_ARRAY );
+	pglDisableClientState( GL_VERTEX_ARRAY );
+	GL_SetTexCoordArrayMode( GL_NONE );
+
+	// color array leaves current color undefined, restore
+	// what per glyph drawing would leave after itself
+	pglColor4ub( glyphs[count-1].color[0], glyphs[count-1].color[1], glyphs[count-1].color[2], glyphs[count-1].color[3] );
+}
+
 /*
 =============
 Draw_TileClear
@@ -115,6 +115,11 @@ static void R_DrawStretchPic( float x, float y, float w, float h, float s1, floa
 	;
 }
 
+static void R_DrawGlyphRun( const ref_glyph_t *glyphs, int count, float x, float y, int texnum, int rendermode )
+{
+	;
+}
+
 static void R_DrawTileClear( int texnum, int x, int y, int w, int h )
 {
 	;
@@ -480,6 +485,7 @@ static const ref_interface_t gReffuncs =
 	.R_Set2DMode      = R_SimpleStubBool,
 	.R_DrawStretchRaw = R_DrawStretchRaw,
 	.R_DrawStretchPic = R_DrawStretchPic,
+	.R_DrawGlyphRun   = R_DrawGlyphRun,
 	.R_DrawTileClear  = R_DrawTileClear,
 	.FillRGBA         = FillRGBA,
 	.FillRGBABlend    = FillRGBA,
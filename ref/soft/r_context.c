@@ -85,7 +85,7 @@ static qboolean GAME_EXPORT Mod_ProcessRenderData( model_t *mod, qboolean create
 		switch( mod->type )
 		{
 			case mod_studio:
-				 //Mod_LoadStudioModel( mod, buf, loaded );
+				R_StudioProcessModel( mod, true );
 				break;
 			case mod_sprite:
 				Mod_LoadSpriteModel( mod, buf, &loaded, mod->numtexinfo );
@@ -105,7 +105,11 @@ static qboolean GAME_EXPORT Mod_ProcessRenderData( model_t *mod, qboolean create
 		gEngfuncs.drawFuncs->Mod_ProcessUserData( mod, create, buf );
 
 	if( !create )
+	{
+		if( mod->type == mod_studio )
+			R_StudioProcessModel( mod, false );
 		Mod_UnloadTextures( mod );
+	}
 
 	return loaded;
 }
@@ -466,6 +470,7 @@ static const ref_interface_t gReffuncs =
 	R_Set2DMode,
 	R_DrawStretchRaw,
 	R_DrawStretchPic,
+	R_DrawGlyphRun,
 	R_DrawTileClear,
 	CL_FillRGBA,
 	CL_FillRGBABlend,
@@ -186,6 +186,130 @@ void GAME_EXPORT R_DrawStretchPic( float x, float y, float w, float h, float s1,
 	R_DrawStretchPicImplementation(x,y,w,h, width * s1, height * t1, width * s2, height * t2, pic);
 }
 
+/*
+=============
+R_DrawGlyph
+
+glyphs are too small to be worth splitting between threads,
+so this is a serial version of R_DrawStretchPicImplementation
+=============
+*/
+static void R_DrawGlyph( int x, int y, int w, int h, int s1, int t1, int s2, int t2, const pixel_t *buffer, int pitch, qboolean transparent )
+{
+	const int	alpha1 = vid.alpha, mode = vid.rendermode;
+	const pixel_t	color = vid.color;
+	int		v, u, skip = 0;
+	uint		fstep, fstart = 0;
+
+	if( w <= 0 || h <= 0 || y <= -h || y >= vid.height || x <= -w || x >= vid.width )
+		return;
+
+	if( s1 >= s2 || t1 >= t2 )
+		return;
+
+	fstep = ((s2 - s1) << 16) / w;
+
+	// clip by screen, keeping texture step intact
+	if( x < 0 )
+	{
+		fstart = (-x) * fstep;
+		w += x;
+		x = 0;
+	}
+
+	if( x + w > vid.width )
+		w = vid.width - x;
+
+	if( y < 0 )
+		skip = -y;
+
+	for( v = skip; v < h && y + v < vid.height; v++ )
+	{
+		pixel_t		*dest = vid.buffer + (y + v) * vid.rowbytes + x;
+		const pixel_t	*source = buffer + ( v * (t2 - t1) / h + t1 ) * pitch + s1;
+		uint		f = fstart;
+
+		for( u = 0; u < w; u++, f += fstep )
+		{
+			pixel_t	src = source[f>>16];
+			int	alpha = alpha1;
+
+			if( transparent )
+			{
+				alpha &= src >> ( 16 - 3 );
+				src = src << 3;
+			}
+
+			if( alpha == 0 )
+				continue;
+
+			if( color != COLOR_WHITE )
+				src = vid.modmap[(src & 0xff00)|(color>>8)] << 8 | (src & color & 0xff) | ((src & 0xff) >> 3);
+
+			if( mode == kRenderTransAdd )
+			{
+				pixel_t screen = dest[u];
+				dest[u] = vid.addmap[(src & 0xff00)|(screen>>8)] << 8 | (screen & 0xff) | ((src & 0xff) >> 0);
+			}
+			else if( mode == kRenderScreenFadeModulate )
+			{
+				pixel_t screen = dest[u];
+				dest[u] = BLEND_COLOR( screen, color );
+			}
+			else if( alpha < 7 )
+			{
+				pixel_t screen = dest[u];
+				dest[u] = BLEND_ALPHA( alpha, src, screen );
+			}
+			else dest[u] = src;
+		}
+	}
+}
+
+/*
+=============
+R_DrawGlyphRun
+=============
+*/
+void GAME_EXPORT R_DrawGlyphRun( const ref_glyph_t *glyphs, int count, float x, float y, int texnum, int rendermode )
+{
+	image_t		*pic = R_GetTexture( texnum );
+	const pixel_t	*buffer;
+	qboolean	transparent;
+	const byte	*color = NULL;
+	int		i;
+
+	if( count <= 0 || !pic->pixels[0] )
+		return;
+
+	if( rendermode >= 0 )
+		GL_SetRenderMode( rendermode );
+
+	transparent = pic->alpha_pixels != NULL;
+	buffer = transparent ? pic->alpha_pixels : pic->pixels[0];
+
+	for( i = 0; i < count; i++ )
+	{
+		const ref_glyph_t *g = &glyphs[i];
+
+		if( g->s2 > 1.0f || g->t2 > 1.0f || g->s1 < 0.0f || g->t1 < 0.0f )
+			continue;
+
+		if( g->w < 1.0f || g->h < 1.0f )
+			continue;
+
+		// most of strings have few colors, don't rebuild color for every glyph
+		if( !color || memcmp( color, g->color, sizeof( rgba_t )))
+		{
+			color = g->color;
+			_TriColor4ub( color[0], color[1], color[2], color[3] );
+		}
+
+		R_DrawGlyph( x + g->x, y + g->y, g->w, g->h, pic->width * g->s1, pic->height * g->t1,
+			pic->width * g->s2, pic->height * g->t2, buffer, pic->width, transparent );
+	}
+}
+
 void Draw_Fill (int x, int y, int w, int h)
 {
 	unsigned int height;
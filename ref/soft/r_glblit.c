@@ -12,8 +12,18 @@ struct swblit_s
 	qboolean(*pCreateBuffer)( int width, int height, uint *stride, uint *bpp, uint *r, uint *g, uint *b );
 	uint rotate;
 	qboolean gl1;
+
+	// dirty rows tracking
+	qboolean keepframe;	// locked buffer keeps previous frame
+	void *lastbuffer;	// buffer of previous blit
+	pixel_t *prev;	// vid.buffer of previous blit
+	byte *dirty;	// rows changed since previous blit
 } swblit;
 
+CVAR_DEFINE_AUTO( r_blit_dirty, "1", FCVAR_ARCHIVE, "skip screen rows unchanged since previous frame, 2 forces it for backends that may not keep frame contents" );
+
+#define BLIT_TILE	32	// rotated blit tile size, in pixels
+
 
 qboolean R_SetDisplayTransform( ref_screen_rotation_t rotate, int offset_x, int offset_y, float scale_x, float scale_y )
 {
@@ -24,7 +34,10 @@ qboolean R_SetDisplayTransform( ref_screen_rotation_t rotate, int offset_x, int
 		ret = false;
 	}
 	else
+	{
 		swblit.rotate = rotate;
+		swblit.lastbuffer = NULL; // force full blit
+	}
 
 	if( offset_x || offset_y )
 	{
@@ -628,8 +641,13 @@ qboolean R_InitBlit( qboolean glblit )
 {
 	R_BuildBlendMaps();
 
+	// only plain GL1 blit writes into our own buffer every frame,
+	// GLES3 orphans its PBO and SDL streaming textures are write-only
+	swblit.keepframe = false;
+
 	if( glblit && swblit.gl1 )
 	{
+		swblit.keepframe = true;
 		swblit.pLockBuffer = R_Lock_GL1;
 		swblit.pUnlockBuffer = R_Unlock_GLES1;
 		swblit.pCreateBuffer = R_CreateBuffer_GLES1;
@@ -688,140 +706,233 @@ static qboolean R_AllocScreen( void )
 		free( vid.buffer );
 	vid.buffer = malloc( vid.width * vid.height*sizeof( pixel_t ) );
 
+	if( swblit.prev )
+		free( swblit.prev );
+	swblit.prev = malloc( vid.width * vid.height * sizeof( pixel_t ));
+
+	if( swblit.dirty )
+		free( swblit.dirty );
+	swblit.dirty = malloc( vid.height );
+	swblit.lastbuffer = NULL; // force full blit
+
 	return true;
 }
 
-void R_BlitScreen( void )
+/*
+=============
+R_BlitMarkDirty
+
+compares rows against previous blit, returns
+false when whole screen must be converted
+=============
+*/
+static qboolean R_BlitMarkDirty( void *buffer )
 {
-	int u, v;
-	void *buffer = swblit.pLockBuffer();
-//	gEngfuncs.Con_Printf("blit begin\n");
-	//memset( vid.buffer, 10, vid.width * vid.height );
+	size_t	rowsize = vid.width * sizeof( pixel_t );
+	qboolean	full;
+	int	v;
 
-	if( !buffer || gpGlobals->width != vid.width || gpGlobals->height != vid.height )
+	if( !r_blit_dirty.value || ( !swblit.keepframe && r_blit_dirty.value < 2.0f ))
 	{
-		gEngfuncs.Con_Printf("pre allocscrn\n");
-		R_AllocScreen();
-		gEngfuncs.Con_Printf("post allocscrn\n");
-		return;
+		// prev isn't updated while tracking is off, first tracked frame must be full
+		swblit.lastbuffer = NULL;
+		return false;
 	}
-	//return;
-	//byte *buf = vid.buffer;
 
-	//#pragma omp parallel for schedule(static)
-	//gEngfuncs.Con_Printf("swblit %d %d", swblit.bpp, vid.height );
-	if( swblit.rotate )
+	// backend moved the buffer, its contents are unknown
+	full = buffer != swblit.lastbuffer;
+	swblit.lastbuffer = buffer;
+
+	for( v = 0; v < vid.height; v++ )
 	{
-		if( swblit.bpp == 2 )
+		const pixel_t *src = vid.buffer + vid.rowbytes * v;
+		pixel_t *prev = swblit.prev + vid.width * v;
+
+		swblit.dirty[v] = full || memcmp( src, prev, rowsize );
+
+		if( swblit.dirty[v] )
+			memcpy( prev, src, rowsize );
+	}
+
+	return !full;
+}
+
+/*
+=============
+R_BlitRow
+
+converts one row, four pixels per step so
+table lookups don't wait for each other
+=============
+*/
+static void R_BlitRow( void *buffer, int v )
+{
+	const pixel_t *src = vid.buffer + vid.rowbytes * v;
+	int u = 0, width = vid.width;
+
+	if( swblit.bpp == 2 )
+	{
+		unsigned short *pbuf = (unsigned short *)buffer + swblit.stride * v;
+
+		for( ; u + 4 <= width; u += 4 )
 		{
-			unsigned short *pbuf = buffer;
-			for( v = 0; v < vid.height;v++)
-			{
-				uint start = vid.rowbytes * v;
-				uint d = swblit.stride - v - 1;
-
-				for( u = 0; u < vid.width; u++ )
-				{
-					unsigned int s = vid.screen[vid.buffer[start + u]];
-					pbuf[d] = s;
-					d += swblit.stride;
-				}
-			}
+			pbuf[u + 0] = vid.screen[src[u + 0]];
+			pbuf[u + 1] = vid.screen[src[u + 1]];
+			pbuf[u + 2] = vid.screen[src[u + 2]];
+			pbuf[u + 3] = vid.screen[src[u + 3]];
 		}
-		else if( swblit.bpp == 4 )
+
+		for( ; u < width; u++ )
+			pbuf[u] = vid.screen[src[u]];
+	}
+	else if( swblit.bpp == 4 )
+	{
+		unsigned int *pbuf = (unsigned int *)buffer + swblit.stride * v;
+
+		for( ; u + 4 <= width; u += 4 )
 		{
-			unsigned int *pbuf = buffer;
+			pbuf[u + 0] = vid.screen32[src[u + 0]];
+			pbuf[u + 1] = vid.screen32[src[u + 1]];
+			pbuf[u + 2] = vid.screen32[src[u + 2]];
+			pbuf[u + 3] = vid.screen32[src[u + 3]];
+		}
 
-			for( v = 0; v < vid.height;v++)
-			{
-				uint start = vid.rowbytes * v;
-				uint d = swblit.stride - v - 1;
-
-				for( u = 0; u < vid.width; u++ )
-				{
-					unsigned int s = vid.screen32[vid.buffer[start + u]];
-					pbuf[d] = s;
-					d += swblit.stride;
-				}
-			}
+		for( ; u < width; u++ )
+			pbuf[u] = vid.screen32[src[u]];
+	}
+	else if( swblit.bpp == 3 )
+	{
+		byte *pbuf = (byte *)buffer + swblit.stride * v * 3;
+
+#if XASH_LITTLE_ENDIAN
+		// four pixels are exactly three words
+		for( ; u + 4 <= width; u += 4 )
+		{
+			uint s0 = vid.screen32[src[u + 0]];
+			uint s1 = vid.screen32[src[u + 1]];
+			uint s2 = vid.screen32[src[u + 2]];
+			uint s3 = vid.screen32[src[u + 3]];
+			uint w[3];
+
+			w[0] = ( s0 & 0xffffff ) | ( s1 << 24 );
+			w[1] = (( s1 >> 8 ) & 0xffff ) | ( s2 << 16 );
+			w[2] = (( s2 >> 16 ) & 0xff ) | ( s3 << 8 );
+			memcpy( pbuf + u * 3, w, sizeof( w ));
 		}
-		else if( swblit.bpp == 3 )
+#endif
+
+		for( ; u < width; u++ )
 		{
-			byte *pbuf = buffer;
-			for( v = 0; v < vid.height;v++)
-			{
-				uint start = vid.rowbytes * v;
-				uint d = swblit.stride - v - 1;
-
-				for( u = 0; u < vid.width; u++ )
-				{
-					unsigned int s = vid.screen32[vid.buffer[start + u]];
-					pbuf[(d)*3] = s;
-					s = s >> 8;
-					pbuf[(d)*3+1] = s;
-					s = s >> 8;
-					pbuf[(d)*3+2] = s;
-					d += swblit.stride;
-				}
-			}
+			unsigned int s = vid.screen32[src[u]];
+
+			pbuf[u * 3 + 0] = s;
+			pbuf[u * 3 + 1] = s >> 8;
+			pbuf[u * 3 + 2] = s >> 16;
 		}
 	}
-	else
+}
+
+/*
+=============
+R_BlitTileRotated
+
+90 degrees rotated blit of one tile, every source column
+becomes contiguous run of destination row, so stores
+stay within BLIT_TILE rows instead of jumping a stride each
+=============
+*/
+static void R_BlitTileRotated( void *buffer, int u0, int v0, int u1, int v1 )
+{
+	int	u, v;
+
+	for( u = u0; u < u1; u++ )
 	{
+		const pixel_t *src = vid.buffer + u;
+		uint d = swblit.stride * u + swblit.stride - 1; // destination of v = 0
+
 		if( swblit.bpp == 2 )
 		{
-			unsigned short *pbuf = buffer;
-			for( v = 0; v < vid.height;v++)
-			{
-				uint start = vid.rowbytes * v;
-				uint dstart = swblit.stride * v;
-
-				for( u = 0; u < vid.width; u++ )
-				{
-					unsigned int s = vid.screen[vid.buffer[start + u]];
-					pbuf[dstart + u] = s;
-				}
-			}
+			unsigned short *pbuf = (unsigned short *)buffer + d;
+
+			for( v = v0; v < v1; v++ )
+				*( pbuf - v ) = vid.screen[src[vid.rowbytes * v]];
 		}
 		else if( swblit.bpp == 4 )
 		{
-			unsigned int *pbuf = buffer;
+			unsigned int *pbuf = (unsigned int *)buffer + d;
+
+			for( v = v0; v < v1; v++ )
+				*( pbuf - v ) = vid.screen32[src[vid.rowbytes * v]];
+		}
+		else if( swblit.bpp == 3 )
+		{
+			byte *pbuf = (byte *)buffer + d * 3;
 
-			for( v = 0; v < vid.height;v++)
+			for( v = v0; v < v1; v++ )
 			{
-				uint start = vid.rowbytes * v;
-				uint dstart = swblit.stride * v;
-
-				for( u = 0; u < vid.width; u++ )
-				{
-					unsigned int s = vid.screen32[vid.buffer[start + u]];
-					pbuf[dstart + u] = s;
-				}
+				unsigned int s = vid.screen32[src[vid.rowbytes * v]];
+				byte *p = pbuf - v * 3;
+
+				p[0] = s;
+				p[1] = s >> 8;
+				p[2] = s >> 16;
 			}
 		}
-		else if( swblit.bpp == 3 )
+	}
+}
+
+/*
+=============
+R_BlitScreen
+
+converts vid.buffer through screen tables into locked
+video buffer, rows unchanged since previous frame are
+skipped when backend keeps buffer contents
+=============
+*/
+void R_BlitScreen( void )
+{
+	void *buffer = swblit.pLockBuffer();
+	qboolean partial;
+	int u, v, i;
+
+	if( !buffer || gpGlobals->width != vid.width || gpGlobals->height != vid.height )
+	{
+		gEngfuncs.Con_Printf("pre allocscrn\n");
+		R_AllocScreen();
+		gEngfuncs.Con_Printf("post allocscrn\n");
+		return;
+	}
+
+	partial = R_BlitMarkDirty( buffer );
+
+	if( swblit.rotate )
+	{
+		for( v = 0; v < vid.height; v += BLIT_TILE )
 		{
-			byte *pbuf = buffer;
-			for( v = 0; v < vid.height;v++)
+			int v1 = Q_min( v + BLIT_TILE, vid.height );
+
+			if( partial )
 			{
-				uint start = vid.rowbytes * v;
-				uint dstart = swblit.stride * v;
-
-				for( u = 0; u < vid.width; u++ )
-				{
-					unsigned int s = vid.screen32[vid.buffer[start + u]];
-					pbuf[(dstart+u)*3] = s;
-					s = s >> 8;
-					pbuf[(dstart+u)*3+1] = s;
-					s = s >> 8;
-					pbuf[(dstart+u)*3+2] = s;
-				}
+				// convert whole tile band if any row in it changed
+				for( i = v; i < v1 && !swblit.dirty[i]; i++ );
+				if( i == v1 ) continue;
 			}
+
+			for( u = 0; u < vid.width; u += BLIT_TILE )
+				R_BlitTileRotated( buffer, u, v, Q_min( u + BLIT_TILE, vid.width ), v1 );
+		}
+	}
+	else
+	{
+		for( v = 0; v < vid.height; v++ )
+		{
+			if( !partial || swblit.dirty[v] )
+				R_BlitRow( buffer, v );
 		}
 	}
 
 	swblit.pUnlockBuffer();
-//	gEngfuncs.Con_Printf("blit end\n");
 }
 
 static uint32_t Get8888PixelAt( int u, int start )
@@ -531,6 +531,7 @@ void R_DrawSpriteModel( cl_entity_t *e );
 // gl_studio.c
 //
 void R_StudioInit( void );
+void R_StudioProcessModel( model_t *mod, qboolean create );
 void Mod_LoadStudioModel( model_t *mod, const void *buffer, qboolean *loaded );
 void R_StudioLerpMovement( cl_entity_t *e, double time, vec3_t origin, vec3_t angles );
 struct mstudiotex_s *R_StudioGetTexture( cl_entity_t *e );
@@ -608,6 +609,7 @@ void R_GetTextureParms( int *w, int *h, int texnum );
 void R_GetSpriteParms( int *frameWidth, int *frameHeight, int *numFrames, int curFrame, const struct model_s *pSprite );
 void R_DrawStretchRaw( float x, float y, float w, float h, int cols, int rows, const byte *data, qboolean dirty );
 void R_DrawStretchPic( float x, float y, float w, float h, float s1, float t1, float s2, float t2, int texnum );
+void R_DrawGlyphRun( const ref_glyph_t *glyphs, int count, float x, float y, int texnum, int rendermode );
 qboolean R_SpeedsMessage( char *out, size_t size );
 qboolean R_CullBox( const vec3_t mins, const vec3_t maxs );
 int R_WorldToScreen( const vec3_t point, vec3_t screen );
@@ -1117,6 +1119,8 @@ extern convar_t   sw_texfilt;
 extern convar_t   r_traceglow;
 extern convar_t   sw_noalphabrushes;
 extern convar_t   r_studio_sort_textures;
+extern convar_t   r_studio_batch;
+extern convar_t   r_blit_dirty;
 
 extern struct qfrustum_s {
 	mplane_t screenedge[4];
@@ -1874,6 +1874,8 @@ qboolean GAME_EXPORT R_Init( void )
 #endif
 	gEngfuncs.Cvar_RegisterVariable( &r_novis );
 	gEngfuncs.Cvar_RegisterVariable( &r_studio_sort_textures );
+	gEngfuncs.Cvar_RegisterVariable( &r_studio_batch );
+	gEngfuncs.Cvar_RegisterVariable( &r_blit_dirty );
 
 	r_temppool = Mem_AllocPool( "ref_soft zone" );
 
@@ -24,6 +24,56 @@ GNU General Public License for more details.
 
 #define EVENT_CLIENT	5000	// less than this value it's a server-side studio events
 #define MAX_LOCALLIGHTS	4
+#define STUDIO_ORDER_HASH	256	// must be power of two
+
+// four float lanes for batched vertex transform and lighting
+// plain mul and add only, so lanes match scalar code bit for bit
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+
+typedef __m128 vec4s_t;
+
+#define V4S_Set1( x )	_mm_set1_ps( x )
+#define V4S_Load( p )	_mm_loadu_ps( p )
+#define V4S_Store( p, v )	_mm_storeu_ps( p, v )
+#define V4S_Add( a, b )	_mm_add_ps( a, b )
+#define V4S_Sub( a, b )	_mm_sub_ps( a, b )
+#define V4S_Mul( a, b )	_mm_mul_ps( a, b )
+#define V4S_Div( a, b )	_mm_div_ps( a, b )
+#define V4S_Min( a, b )	_mm_min_ps( a, b )
+#define V4S_Max( a, b )	_mm_max_ps( a, b )
+#elif defined( __aarch64__ ) || defined( _M_ARM64 )
+#include <arm_neon.h>
+
+typedef float32x4_t vec4s_t;
+
+#define V4S_Set1( x )	vdupq_n_f32( x )
+#define V4S_Load( p )	vld1q_f32( p )
+#define V4S_Store( p, v )	vst1q_f32( p, v )
+#define V4S_Add( a, b )	vaddq_f32( a, b )
+#define V4S_Sub( a, b )	vsubq_f32( a, b )
+#define V4S_Mul( a, b )	vmulq_f32( a, b )
+#define V4S_Div( a, b )	vdivq_f32( a, b )
+#define V4S_Min( a, b )	vminq_f32( a, b )
+#define V4S_Max( a, b )	vmaxq_f32( a, b )
+#else
+typedef struct { float v[4]; } vec4s_t;
+
+#define V4S_OP( name, expr ) \
+	static inline vec4s_t V4S_##name( vec4s_t a, vec4s_t b ) \
+	{ vec4s_t r; int i; for( i = 0; i < 4; i++ ) r.v[i] = expr; return r; }
+
+V4S_OP( Add, a.v[i] + b.v[i] )
+V4S_OP( Sub, a.v[i] - b.v[i] )
+V4S_OP( Mul, a.v[i] * b.v[i] )
+V4S_OP( Div, a.v[i] / b.v[i] )
+V4S_OP( Min, Q_min( a.v[i], b.v[i] ))
+V4S_OP( Max, Q_max( a.v[i], b.v[i] ))
+
+static inline vec4s_t V4S_Set1( float x ) { vec4s_t r = {{ x, x, x, x }}; return r; }
+static inline vec4s_t V4S_Load( const float *p ) { vec4s_t r = {{ p[0], p[1], p[2], p[3] }}; return r; }
+#define V4S_Store( p, x ) memcpy( p, (x).v, sizeof( (x).v ))
+#endif
 
 typedef struct
 {
@@ -116,12 +166,30 @@ typedef struct
 	player_model_t  player_models[MAX_CLIENTS];
 } studio_draw_state_t;
 
+typedef struct
+{
+	word		bone;
+	word		count;
+} studio_bonerun_t;
+
+// submodel vertices grouped by bone, built once at model load
+typedef struct studio_vertorder_s
+{
+	const mstudiomodel_t	*submodel;
+	struct studio_vertorder_s	*next;		// hash chain
+	int			numruns;
+	studio_bonerun_t		*runs;
+	word			*verts;		// vertex indices in run order
+} studio_vertorder_t;
+
 // studio-related cvars
 CVAR_DEFINE_AUTO( r_studio_sort_textures, "0", FCVAR_GLCONFIG, "change draw order for additive meshes" );
+CVAR_DEFINE_AUTO( r_studio_batch, "1", 0, "transform and light studio vertices in bone grouped batches, 2 also compares them against scalar path" );
 static cvar_t			*cl_righthand = NULL;
 
 static r_studio_interface_t	*pStudioDraw;
 static studio_draw_state_t	g_studio;		// global studio state
+static studio_vertorder_t	*g_vertorder[STUDIO_ORDER_HASH];
 
 // global variables
 static qboolean		m_fDoRemap;
@@ -151,6 +219,130 @@ void R_StudioInit( void )
 	m_fDoRemap = false;
 }
 
+static int R_StudioOrderHash( const mstudiomodel_t *psubmodel )
+{
+	return ((size_t)psubmodel >> 4 ) & ( STUDIO_ORDER_HASH - 1 );
+}
+
+/*
+====================
+R_StudioBuildVertOrder
+
+counting sort of submodel vertices by bone,
+broken models are left to the scalar path
+====================
+*/
+static void R_StudioBuildVertOrder( model_t *mod, const studiohdr_t *phdr, const mstudiomodel_t *psubmodel )
+{
+	int		counts[MAXSTUDIOBONES], first[MAXSTUDIOBONES];
+	int		i, numverts, numruns, hash;
+	studio_vertorder_t	*order;
+	const byte	*pvertbone;
+
+	numverts = psubmodel->numverts;
+
+	if( numverts <= 0 || numverts > MAXSTUDIOVERTS || phdr->numbones > MAXSTUDIOBONES )
+		return;
+
+	if( psubmodel->vertinfoindex <= 0 || psubmodel->vertinfoindex + numverts > phdr->length )
+		return;
+
+	pvertbone = (const byte *)phdr + psubmodel->vertinfoindex;
+	memset( counts, 0, sizeof( counts ));
+
+	for( i = 0; i < numverts; i++ )
+	{
+		if( pvertbone[i] >= phdr->numbones )
+			return;
+		counts[pvertbone[i]]++;
+	}
+
+	for( i = numruns = 0; i < phdr->numbones; i++ )
+	{
+		if( counts[i] ) numruns++;
+	}
+
+	order = Mem_Calloc( mod->mempool, sizeof( *order ) + numruns * sizeof( studio_bonerun_t ) + numverts * sizeof( word ));
+	order->submodel = psubmodel;
+	order->runs = (studio_bonerun_t *)( order + 1 );
+	order->verts = (word *)( order->runs + numruns );
+
+	for( i = 0, first[0] = 0; i < phdr->numbones; i++ )
+	{
+		if( i > 0 ) first[i] = first[i - 1] + counts[i - 1];
+		if( !counts[i] ) continue;
+
+		order->runs[order->numruns].bone = i;
+		order->runs[order->numruns].count = counts[i];
+		order->numruns++;
+	}
+
+	for( i = 0; i < numverts; i++ )
+		order->verts[first[pvertbone[i]]++] = i;
+
+	hash = R_StudioOrderHash( psubmodel );
+	order->next = g_vertorder[hash];
+	g_vertorder[hash] = order;
+}
+
+/*
+====================
+R_StudioProcessModel
+
+builds or releases renderer data of studio
+model, memory itself lives in model mempool
+====================
+*/
+void R_StudioProcessModel( model_t *mod, qboolean create )
+{
+	const studiohdr_t	*phdr = mod->cache.data;
+	const mstudiobodyparts_t	*pbodypart;
+	int		i, j;
+
+	if( !phdr || phdr->bodypartindex <= 0 )
+		return;
+
+	pbodypart = (const mstudiobodyparts_t *)((const byte *)phdr + phdr->bodypartindex);
+
+	for( i = 0; i < phdr->numbodyparts; i++ )
+	{
+		const mstudiomodel_t *psubmodel = (const mstudiomodel_t *)((const byte *)phdr + pbodypart[i].modelindex);
+
+		for( j = 0; j < pbodypart[i].nummodels; j++ )
+		{
+			studio_vertorder_t **prev;
+
+			if( create )
+			{
+				R_StudioBuildVertOrder( mod, phdr, &psubmodel[j] );
+				continue;
+			}
+
+			for( prev = &g_vertorder[R_StudioOrderHash( &psubmodel[j] )]; *prev; prev = &(*prev)->next )
+			{
+				if( (*prev)->submodel == &psubmodel[j] )
+				{
+					*prev = (*prev)->next;
+					break;
+				}
+			}
+		}
+	}
+}
+
+static const studio_vertorder_t *R_StudioVertOrder( const mstudiomodel_t *psubmodel )
+{
+	const studio_vertorder_t *order;
+
+	for( order = g_vertorder[R_StudioOrderHash( psubmodel )]; order; order = order->next )
+	{
+		if( order->submodel == psubmodel )
+			return order;
+	}
+
+	return NULL;
+}
+
 /*
 ================
 R_StudioSetupTimings
@@ -2017,6 +2209,183 @@ static void R_StudioDrawChromeMesh( short *ptricmds, vec3_t *pstudionorms, float
 }
 
 
+/*
+===============
+R_StudioCheckBatch
+
+r_studio_batch 2 debugging aid
+===============
+*/
+static void R_StudioCheckBatch( const char *what, int index, const float *batched, const float *scalar )
+{
+	float	delta = 0.0f;
+	int	i;
+
+	for( i = 0; i < 3; i++ )
+		delta = Q_max( delta, fabs( batched[i] - scalar[i] ));
+
+	if( delta > 0.001f )
+	{
+		gEngfuncs.Con_Printf( S_WARN "%s: %s %s %d differs from scalar path by %g\n",
+			__func__, m_pStudioHeader->name, what, index, delta );
+	}
+}
+
+/*
+===============
+R_StudioTransformBatch
+
+rigid vertices, bone by bone, four at a time
+===============
+*/
+static void R_StudioTransformBatch( const studio_vertorder_t *order, const vec3_t *pstudioverts, qboolean check )
+{
+	const word	*pvert = order->verts;
+	int		i, j, k;
+
+	for( i = 0; i < order->numruns; i++ )
+	{
+		const studio_bonerun_t *run = &order->runs[i];
+		float		(*m)[4] = g_studio.bonestransform[run->bone];
+		vec4s_t		m00 = V4S_Set1( m[0][0] ), m01 = V4S_Set1( m[0][1] ), m02 = V4S_Set1( m[0][2] ), m03 = V4S_Set1( m[0][3] );
+		vec4s_t		m10 = V4S_Set1( m[1][0] ), m11 = V4S_Set1( m[1][1] ), m12 = V4S_Set1( m[1][2] ), m13 = V4S_Set1( m[1][3] );
+		vec4s_t		m20 = V4S_Set1( m[2][0] ), m21 = V4S_Set1( m[2][1] ), m22 = V4S_Set1( m[2][2] ), m23 = V4S_Set1( m[2][3] );
+
+		for( j = 0; j + 4 <= run->count; j += 4, pvert += 4 )
+		{
+			vec4_t	x, y, z;
+			vec4s_t	vx, vy, vz, out;
+
+			for( k = 0; k < 4; k++ )
+			{
+				x[k] = pstudioverts[pvert[k]][0];
+				y[k] = pstudioverts[pvert[k]][1];
+				z[k] = pstudioverts[pvert[k]][2];
+			}
+
+			vx = V4S_Load( x );
+			vy = V4S_Load( y );
+			vz = V4S_Load( z );
+
+			out = V4S_Add( V4S_Add( V4S_Add( V4S_Mul( vx, m00 ), V4S_Mul( vy, m01 )), V4S_Mul( vz, m02 )), m03 );
+			V4S_Store( x, out );
+			out = V4S_Add( V4S_Add( V4S_Add( V4S_Mul( vx, m10 ), V4S_Mul( vy, m11 )), V4S_Mul( vz, m12 )), m13 );
+			V4S_Store( y, out );
+			out = V4S_Add( V4S_Add( V4S_Add( V4S_Mul( vx, m20 ), V4S_Mul( vy, m21 )), V4S_Mul( vz, m22 )), m23 );
+			V4S_Store( z, out );
+
+			for( k = 0; k < 4; k++ )
+				VectorSet( g_studio.verts[pvert[k]], x[k], y[k], z[k] );
+		}
+
+		for( ; j < run->count; j++, pvert++ )
+			Matrix3x4_VectorTransform( m, pstudioverts[*pvert], g_studio.verts[*pvert] );
+	}
+
+	if( !check )
+		return;
+
+	for( i = 0; i < m_pSubModel->numverts; i++ )
+	{
+		const byte *pvertbone = (byte *)m_pStudioHeader + m_pSubModel->vertinfoindex;
+		vec3_t	v;
+
+		Matrix3x4_VectorTransform( g_studio.bonestransform[pvertbone[i]], pstudioverts[i], v );
+		R_StudioCheckBatch( "vertex", i, g_studio.verts[i], v );
+	}
+}
+
+/*
+===============
+R_StudioLightingBatch
+
+R_StudioLighting for plain lambert faces, four
+normals at a time, only the gamma lookup is per normal.
+pnormbone is NULL for skinned normals, those use lightvec
+===============
+*/
+static void R_StudioLightingBatch( const vec3_t *pnorms, const byte *pnormbone, int count, vec3_t *lightvalues, qboolean check )
+{
+	vec4s_t	zero = V4S_Set1( 0.0f ), one = V4S_Set1( 1.0f ), maxillum = V4S_Set1( 255.0f );
+	vec4s_t	shade = V4S_Set1( g_studio.shadelight ), base;
+	vec4s_t	vr, vbias;
+	qboolean	hemisphere;
+	float	r = SHADE_LAMBERT, bias, lv;
+	int	i, k;
+
+	// constants of modified hemispherical lighting, see R_StudioLighting
+	if(( hemisphere = ( r <= 1.0f )))
+	{
+		r += 1.0f;
+		bias = r - 1.0f;
+	}
+	else bias = r - 1.0f;
+
+	vr = V4S_Set1( r );
+	vbias = V4S_Set1( bias );
+	base = V4S_Set1( g_studio.ambientlight + g_studio.shadelight );
+
+	for( i = 0; i + 4 <= count; i += 4 )
+	{
+		vec4_t	nx, ny, nz, lx, ly, lz, illum;
+		vec4s_t	lightcos, vlv;
+
+		for( k = 0; k < 4; k++ )
+		{
+			const float *lightvec = pnormbone ? g_studio.blightvec[pnormbone[i + k]] : g_studio.lightvec;
+
+			nx[k] = pnorms[i + k][0];
+			ny[k] = pnorms[i + k][1];
+			nz[k] = pnorms[i + k][2];
+			lx[k] = lightvec[0];
+			ly[k] = lightvec[1];
+			lz[k] = lightvec[2];
+		}
+
+		lightcos = V4S_Add( V4S_Add( V4S_Mul( V4S_Load( nx ), V4S_Load( lx )), V4S_Mul( V4S_Load( ny ), V4S_Load( ly ))), V4S_Mul( V4S_Load( nz ), V4S_Load( lz )));
+		lightcos = V4S_Min( lightcos, one );
+
+		// adding zero for unlit lanes keeps the result exact
+		if( hemisphere )
+		{
+			lightcos = V4S_Max( V4S_Div( V4S_Sub( vbias, lightcos ), vr ), zero );
+			vlv = V4S_Add( base, V4S_Mul( shade, lightcos ));
+		}
+		else
+		{
+			lightcos = V4S_Max( V4S_Div( V4S_Add( lightcos, vbias ), vr ), zero );
+			vlv = V4S_Sub( base, V4S_Mul( shade, lightcos ));
+		}
+
+		vlv = V4S_Min( V4S_Max( vlv, zero ), maxillum );
+		V4S_Store( illum, vlv );
+
+		for( k = 0; k < 4; k++ )
+		{
+			lv = gEngfuncs.LightToTexGammaEx( illum[k] * 4 ) / 1023.0f;
+			VectorScale( g_studio.lightcolor, lv, lightvalues[i + k] );
+		}
+	}
+
+	for( ; i < count; i++ )
+	{
+		R_StudioLighting( &lv, pnormbone ? pnormbone[i] : -1, 0, (float *)pnorms[i] );
+		VectorScale( g_studio.lightcolor, lv, lightvalues[i] );
+	}
+
+	if( !check )
+		return;
+
+	for( i = 0; i < count; i++ )
+	{
+		vec3_t	v;
+
+		R_StudioLighting( &lv, pnormbone ? pnormbone[i] : -1, 0, (float *)pnorms[i] );
+		VectorScale( g_studio.lightcolor, lv, v );
+		R_StudioCheckBatch( "normal", i, lightvalues[i], v );
+	}
+}
+
 /*
 ===============
 R_StudioDrawPoints
@@ -2036,6 +2405,8 @@ static void R_StudioDrawPoints( void )
 	mstudiomesh_t	*pmesh;
 	short		*pskinref;
 	float		lv_tmp;
+	const studio_vertorder_t	*order = NULL;
+	qboolean		check = r_studio_batch.value >= 2.0f;
 
 	if( !m_pStudioHeader ) return;
 
@@ -2071,6 +2442,16 @@ static void R_StudioDrawPoints( void )
 			Matrix3x4_VectorRotate( skinMat, pstudionorms[i], g_studio.norms[i] );
 		}
 	}
+	else if( r_studio_batch.value && ( order = R_StudioVertOrder( m_pSubModel )) != NULL )
+	{
+		R_StudioTransformBatch( order, pstudioverts, check );
+
+		if( g_studio.numlocallights )
+		{
+			for( i = 0; i < m_pSubModel->numverts; i++ )
+				R_LightStrength( pvertbone[i], pstudioverts[i], g_studio.lightpos[i] );
+		}
+	}
 	else
 	{
 		for( i = 0; i < m_pSubModel->numverts; i++ )
@@ -2109,6 +2490,16 @@ static void R_StudioDrawPoints( void )
 				VectorSet( g_studio.lightvalues[k], tr.blend, tr.blend, tr.blend );
 			}
 		}
+		else if( r_studio_batch.value && !FBitSet( g_nFaceFlags, STUDIO_NF_FULLBRIGHT|STUDIO_NF_FLATSHADE|STUDIO_NF_CHROME ))
+		{
+			if( FBitSet( m_pStudioHeader->flags, STUDIO_HAS_BONEWEIGHTS ))
+				R_StudioLightingBatch( &g_studio.norms[k], NULL, pmesh[j].numnorms, &g_studio.lightvalues[k], check );
+			else R_StudioLightingBatch( pstudionorms, pnormbone, pmesh[j].numnorms, &g_studio.lightvalues[k], check );
+
+			k += pmesh[j].numnorms;
+			pstudionorms += pmesh[j].numnorms;
+			pnormbone += pmesh[j].numnorms;
+		}
 		else
 		{
 			for( i = 0; i < pmesh[j].numnorms; i++, k++, pstudionorms++, pnormbone++ )
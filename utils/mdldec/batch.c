@@ -0,0 +1,609 @@
+/*
+batch.c - parallel decompilation of many models
+Copyright (C) 2026 FWGS
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "xash3d_types.h"
+#include "port.h"
+#if XASH_WIN32
+#include <io.h>
+#else
+#include <dirent.h>
+#include <pthread.h>
+#endif
+#include "const.h"
+#include "com_model.h"
+#include "xash3d_mathlib.h"
+#include "crtlib.h"
+#include "studio.h"
+#include "mdldec.h"
+#include "batch.h"
+#include "qc.h"
+#include "smd.h"
+#include "texture.h"
+#include "utils.h"
+
+#if XASH_WIN32
+typedef HANDLE			thread_t;
+typedef CRITICAL_SECTION	mutex_t;
+typedef CONDITION_VARIABLE	cond_t;
+
+#define Mutex_Init( m )		InitializeCriticalSection( m )
+#define Mutex_Destroy( m )		DeleteCriticalSection( m )
+#define Mutex_Lock( m )		EnterCriticalSection( m )
+#define Mutex_Unlock( m )		LeaveCriticalSection( m )
+#define Cond_Init( c )		InitializeConditionVariable( c )
+#define Cond_Destroy( c )
+#define Cond_Wait( c, m )		SleepConditionVariableCS( c, m, INFINITE )
+#define Cond_Broadcast( c )		WakeAllConditionVariable( c )
+#else
+typedef pthread_t		thread_t;
+typedef pthread_mutex_t		mutex_t;
+typedef pthread_cond_t		cond_t;
+
+#define Mutex_Init( m )		pthread_mutex_init( m, NULL )
+#define Mutex_Destroy( m )		pthread_mutex_destroy( m )
+#define Mutex_Lock( m )		pthread_mutex_lock( m )
+#define Mutex_Unlock( m )		pthread_mutex_unlock( m )
+#define Cond_Init( c )		pthread_cond_init( c, NULL )
+#define Cond_Destroy( c )		pthread_cond_destroy( c )
+#define Cond_Wait( c, m )		pthread_cond_wait( c, m )
+#define Cond_Broadcast( c )		pthread_cond_broadcast( c )
+#endif
+
+struct batchmodel_s;
+
+typedef struct batchjob_s
+{
+	struct batchjob_s	*next;
+	struct batchmodel_s	*model;
+	int			 sequence;	// -1 loads model and writes everything except sequences
+} batchjob_t;
+
+typedef struct batchmodel_s
+{
+	mdldec_t	 ctx;
+	char		 path[MAX_SYSPATH];
+	batchjob_t	 job;
+	batchjob_t	*seqjobs;
+	int		 pending;	// unfinished jobs of this model
+	qboolean	 failed;
+	double		 starttime;
+} batchmodel_t;
+
+static struct
+{
+	mutex_t		  lock;
+	cond_t		  wake;
+	batchjob_t	 *head;
+	batchjob_t	 *tail;
+	int		  active;	// jobs taken by threads right now
+
+	batchmodel_t	**models;
+	int		  nummodels;
+	int		  failed;
+} batch;
+
+/*
+============
+PushJob
+
+lock must be held, sequence jobs go in front
+to finish already loaded models first
+============
+*/
+static void PushJob( batchjob_t *job, qboolean front )
+{
+	if( front || !batch.tail )
+	{
+		job->next = batch.head;
+		batch.head = job;
+
+		if( !batch.tail )
+			batch.tail = job;
+	}
+	else
+	{
+		job->next = NULL;
+		batch.tail->next = job;
+		batch.tail = job;
+	}
+}
+
+/*
+============
+RunModelJob
+============
+*/
+static qboolean RunModelJob( batchmodel_t *model )
+{
+	mdldec_t	*ctx = &model->ctx;
+	int		 i, numseq;
+
+	model->starttime = GetTime();
+
+	if( !LoadMDL( ctx, model->path ))
+		return false;
+
+	WriteQCScript( ctx );
+	WriteReferences( ctx );
+	WriteTextures( ctx );
+
+	numseq = ctx->model_hdr->numseq;
+
+	if( numseq <= 0 )
+		return true;
+
+	if( !CreateSequenceDirectory( ctx ))
+		return false;
+
+	model->seqjobs = calloc( numseq, sizeof( *model->seqjobs ));
+
+	if( !model->seqjobs )
+	{
+		fputs( "ERROR: Couldn't allocate memory for sequence jobs.\n", stderr );
+		return false;
+	}
+
+	Mutex_Lock( &batch.lock );
+
+	// push backwards, so sequences are taken in order
+	for( i = numseq - 1; i >= 0; i-- )
+	{
+		model->seqjobs[i].model = model;
+		model->seqjobs[i].sequence = i;
+		PushJob( &model->seqjobs[i], true );
+	}
+
+	model->pending += numseq;
+
+	Mutex_Unlock( &batch.lock );
+
+	return true;
+}
+
+/*
+============
+FinishModel
+
+lock must be held
+============
+*/
+static void FinishModel( batchmodel_t *model )
+{
+	if( model->failed )
+	{
+		fprintf( stderr, "ERROR: Failed to decompile %s\n", model->path );
+		batch.failed++;
+	}
+	else
+		printf( "Model: %s done in %.3f seconds.\n", model->path, GetTime() - model->starttime );
+
+	FreeMDL( &model->ctx );
+
+	free( model->seqjobs );
+	model->seqjobs = NULL;
+}
+
+/*
+============
+BatchWorker
+============
+*/
+static void BatchWorker( void )
+{
+	batchjob_t	*job;
+	qboolean	 success;
+
+	Mutex_Lock( &batch.lock );
+
+	for( ;; )
+	{
+		while( !batch.head && batch.active > 0 )
+			Cond_Wait( &batch.wake, &batch.lock );
+
+		// queue is empty and nobody is running, so no new jobs will appear
+		if( !batch.head )
+			break;
+
+		job = batch.head;
+		batch.head = job->next;
+
+		if( !batch.head )
+			batch.tail = NULL;
+
+		batch.active++;
+
+		Mutex_Unlock( &batch.lock );
+
+		if( job->sequence < 0 )
+			success = RunModelJob( job->model );
+		else
+			success = WriteSequence( &job->model->ctx, job->sequence );
+
+		Mutex_Lock( &batch.lock );
+
+		batch.active--;
+
+		if( !success )
+			job->model->failed = true;
+
+		if( --job->model->pending == 0 )
+			FinishModel( job->model );
+
+		if( batch.head || batch.active == 0 )
+			Cond_Broadcast( &batch.wake );
+	}
+
+	Mutex_Unlock( &batch.lock );
+}
+
+#if XASH_WIN32
+static DWORD WINAPI BatchThread( LPVOID arg )
+{
+	BatchWorker();
+	return 0;
+}
+
+static qboolean CreateBatchThread( thread_t *thread )
+{
+	*thread = CreateThread( NULL, 0, BatchThread, NULL, 0, NULL );
+	return *thread != NULL;
+}
+
+static void JoinBatchThread( thread_t thread )
+{
+	WaitForSingleObject( thread, INFINITE );
+	CloseHandle( thread );
+}
+
+static int GetProcessorCount( void )
+{
+	SYSTEM_INFO	info;
+
+	GetSystemInfo( &info );
+
+	return info.dwNumberOfProcessors;
+}
+#else
+static void *BatchThread( void *arg )
+{
+	BatchWorker();
+	return NULL;
+}
+
+static qboolean CreateBatchThread( thread_t *thread )
+{
+	return !pthread_create( thread, NULL, BatchThread, NULL );
+}
+
+static void JoinBatchThread( thread_t thread )
+{
+	pthread_join( thread, NULL );
+}
+
+static int GetProcessorCount( void )
+{
+	return sysconf( _SC_NPROCESSORS_ONLN );
+}
+#endif
+
+/*
+============
+IsDirectory
+============
+*/
+static qboolean IsDirectory( const char *path )
+{
+#if XASH_WIN32
+	DWORD	dwFlags = GetFileAttributes( path );
+
+	return ( dwFlags != -1 ) && ( dwFlags & FILE_ATTRIBUTE_DIRECTORY );
+#else
+	struct stat	buf;
+
+	return !stat( path, &buf ) && S_ISDIR( buf.st_mode );
+#endif
+}
+
+/*
+============
+IsMainModel
+
+skips external textures and sequence group files
+found in directory
+============
+*/
+static qboolean IsMainModel( const char *path )
+{
+	FILE		*fp;
+	studiohdr_t	 hdr;
+	size_t		 read;
+	const char	 id_mdlhdr[] = {'I', 'D', 'S', 'T'};
+
+	if( Q_stricmp( COM_FileExtension( path ), "mdl" ))
+		return false;
+
+	fp = fopen( path, "rb" );
+
+	if( !fp )
+		return false;
+
+	read = fread( &hdr, sizeof( hdr ), 1, fp );
+	fclose( fp );
+
+	return read == 1 && !memcmp( &hdr.ident, id_mdlhdr, sizeof( id_mdlhdr )) && hdr.numbodyparts > 0;
+}
+
+/*
+============
+AddBatchModel
+============
+*/
+static qboolean AddBatchModel( const char *path, const char *target )
+{
+	batchmodel_t	*model, **models;
+	char		 name[MAX_SYSPATH];
+
+	if( Q_strlen( path ) >= MAX_SYSPATH - 3 )
+	{
+		fprintf( stderr, "ERROR: Source path %s is too long.\n", path );
+		return false;
+	}
+
+	models = realloc( batch.models, sizeof( *batch.models ) * ( batch.nummodels + 1 ));
+
+	if( !models )
+	{
+		fputs( "ERROR: Couldn't allocate memory for model list.\n", stderr );
+		return false;
+	}
+
+	batch.models = models;
+
+	model = calloc( 1, sizeof( *model ));
+
+	if( !model )
+	{
+		fputs( "ERROR: Couldn't allocate memory for model list.\n", stderr );
+		return false;
+	}
+
+	Q_strncpy( model->path, path, sizeof( model->path ));
+
+	// each model gets its own directory, so equally named sequences won't clash
+	if( target )
+	{
+		COM_FileBase( path, name, sizeof( name ));
+
+		if( Q_snprintf( model->ctx.destdir, sizeof( model->ctx.destdir ), "%s/%s", target, name ) == -1
+		    || Q_strlen( model->ctx.destdir ) > MAX_SYSPATH - 2 )
+		{
+			fprintf( stderr, "ERROR: Destination path for %s is too long.\n", path );
+			free( model );
+			return false;
+		}
+	}
+
+	model->job.model = model;
+	model->job.sequence = -1;
+	model->pending = 1;
+
+	batch.models[batch.nummodels++] = model;
+
+	return true;
+}
+
+/*
+============
+CompareModels
+============
+*/
+static int CompareModels( const void *a, const void *b )
+{
+	return Q_strcmp( (*(batchmodel_t **)a)->path, (*(batchmodel_t **)b)->path );
+}
+
+/*
+============
+AddBatchDirectory
+============
+*/
+static qboolean AddBatchDirectory( const char *dir, const char *target )
+{
+	char	path[MAX_SYSPATH];
+	int	first = batch.nummodels;
+#if XASH_WIN32
+	struct _finddata_t	data;
+	intptr_t		handle;
+
+	if( Q_snprintf( path, sizeof( path ), "%s\\*.mdl", dir ) == -1 )
+		return false;
+
+	handle = _findfirst( path, &data );
+
+	if( handle == -1 )
+		return true;
+
+	do
+	{
+		if( Q_snprintf( path, sizeof( path ), "%s\\%s", dir, data.name ) == -1 )
+			continue;
+
+		if( IsMainModel( path ) && !AddBatchModel( path, target ))
+		{
+			_findclose( handle );
+			return false;
+		}
+	} while( !_findnext( handle, &data ));
+
+	_findclose( handle );
+#else
+	DIR		*d;
+	struct dirent	*entry;
+
+	d = opendir( dir );
+
+	if( !d )
+	{
+		fprintf( stderr, "ERROR: Couldn't open directory %s\n", dir );
+		return false;
+	}
+
+	while(( entry = readdir( d )))
+	{
+		if( Q_snprintf( path, sizeof( path ), "%s/%s", dir, entry->d_name ) == -1 )
+			continue;
+
+		if( IsMainModel( path ) && !AddBatchModel( path, target ))
+		{
+			closedir( d );
+			return false;
+		}
+	}
+
+	closedir( d );
+#endif
+
+	// directory order is random, keep output stable
+	qsort( &batch.models[first], batch.nummodels - first, sizeof( *batch.models ), CompareModels );
+
+	return true;
+}
+
+/*
+============
+AddBatchList
+
+one model path per line, empty lines and // comments are ignored
+============
+*/
+static qboolean AddBatchList( const char *listfile, const char *target )
+{
+	FILE	*fp;
+	char	 line[MAX_SYSPATH];
+	char	*p;
+	size_t	 len;
+
+	fp = fopen( listfile, "r" );
+
+	if( !fp )
+	{
+		fprintf( stderr, "ERROR: Couldn't open list file %s\n", listfile );
+		return false;
+	}
+
+	while( fgets( line, sizeof( line ), fp ))
+	{
+		p = line;
+
+		while( *p == ' ' || *p == '\t' )
+			p++;
+
+		len = Q_strlen( p );
+
+		while( len > 0 && ( p[len - 1] == '\n' || p[len - 1] == '\r' || p[len - 1] == ' ' || p[len - 1] == '\t' ))
+			p[--len] = '\0';
+
+		if( !len || !Q_strncmp( p, "//", 2 ))
+			continue;
+
+		if( !AddBatchModel( p, target ))
+		{
+			fclose( fp );
+			return false;
+		}
+	}
+
+	fclose( fp );
+
+	return true;
+}
+
+/*
+============
+DecompileBatch
+
+returns number of models that failed, or -1 on error
+============
+*/
+int DecompileBatch( const char *source, const char *target, int numthreads )
+{
+	thread_t	 threads[MAX_BATCH_THREADS];
+	int		 i, numstarted = 0;
+	double		 starttime = GetTime();
+	qboolean	 success;
+
+	if( IsDirectory( source ))
+		success = AddBatchDirectory( source, target );
+	else
+		success = AddBatchList( source, target );
+
+	if( !success )
+		return -1;
+
+	if( !batch.nummodels )
+	{
+		fprintf( stderr, "ERROR: No models found in %s\n", source );
+		return -1;
+	}
+
+	if( numthreads <= 0 )
+		numthreads = GetProcessorCount();
+
+	numthreads = bound( 1, numthreads, MAX_BATCH_THREADS );
+
+	printf( "Batch: %d model(s), %d thread(s)\n", batch.nummodels, numthreads );
+
+	Mutex_Init( &batch.lock );
+	Cond_Init( &batch.wake );
+
+	for( i = 0; i < batch.nummodels; i++ )
+		PushJob( &batch.models[i]->job, false );
+
+	// calling thread is a worker too
+	for( i = 0; i < numthreads - 1; i++ )
+	{
+		if( !CreateBatchThread( &threads[numstarted] ))
+		{
+			fputs( "WARNING: Couldn't create worker thread.\n", stderr );
+			break;
+		}
+
+		numstarted++;
+	}
+
+	BatchWorker();
+
+	for( i = 0; i < numstarted; i++ )
+		JoinBatchThread( threads[i] );
+
+	Cond_Destroy( &batch.wake );
+	Mutex_Destroy( &batch.lock );
+
+	printf( "Batch: %d of %d model(s) decompiled in %.3f seconds.\n",
+	    batch.nummodels - batch.failed, batch.nummodels, GetTime() - starttime );
+
+	for( i = 0; i < batch.nummodels; i++ )
+		free( batch.models[i] );
+
+	free( batch.models );
+	batch.models = NULL;
+	batch.nummodels = 0;
+
+	return batch.failed;
+}
@@ -0,0 +1,23 @@
+/*
+batch.h - parallel decompilation of many models
+Copyright (C) 2026 FWGS
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+*/
+#pragma once
+#ifndef BATCH_H
+#define BATCH_H
+
+#define MAX_BATCH_THREADS	64
+
+int	DecompileBatch( const char *source, const char *target, int numthreads );
+
+#endif // BATCH_H
@@ -21,18 +21,14 @@ GNU General Public License for more details.
 #include "com_model.h"
 #include "crtlib.h"
 #include "studio.h"
+#include "mdldec.h"
+#include "batch.h"
 #include "qc.h"
 #include "smd.h"
 #include "texture.h"
 #include "utils.h"
 #include "version.h"
 
-char		  destdir[MAX_SYSPATH];
-char		  modelfile[MAX_SYSPATH];
-studiohdr_t	 *model_hdr;
-studiohdr_t	 *texture_hdr;
-studiohdr_t	**anim_hdr;
-
 /*
 ============
 IsValidName
@@ -68,18 +64,18 @@ static qboolean IsValidName( char *name )
 TextureNameFix
 ============
 */
-static void TextureNameFix( void )
+static void TextureNameFix( mdldec_t *ctx )
 {
 	int			 i, j, len, counter, protected = 0;
 	qboolean		 hasduplicates = false;
-	mstudiotexture_t	*texture = (mstudiotexture_t *)( (byte *)texture_hdr + texture_hdr->textureindex ), *texture1;
+	mstudiotexture_t	*texture = (mstudiotexture_t *)( (byte *)ctx->texture_hdr + ctx->texture_hdr->textureindex ), *texture1;
 
-	for( i = 0; i < texture_hdr->numtextures; ++i, ++texture )
+	for( i = 0; i < ctx->texture_hdr->numtextures; ++i, ++texture )
 		ExtractFileName( texture->name, sizeof( texture->name ));
 
 	texture -= i;
 
-	for( i = 0; i < texture_hdr->numtextures; ++i, ++texture )
+	for( i = 0; i < ctx->texture_hdr->numtextures; ++i, ++texture )
 	{
 		if( !IsValidName( texture->name ))
 		{
@@ -89,9 +85,9 @@ static void TextureNameFix( void )
 
 		counter = 0;
 
-		texture1 = (mstudiotexture_t *)( (byte *)texture_hdr + texture_hdr->textureindex );
+		texture1 = (mstudiotexture_t *)( (byte *)ctx->texture_hdr + ctx->texture_hdr->textureindex );
 
-		for( j = 0; j < texture_hdr->numtextures; ++j, ++texture1 )
+		for( j = 0; j < ctx->texture_hdr->numtextures; ++j, ++texture1 )
 		{
 			if( j != i && !Q_strncmp( texture1->name, texture->name, sizeof( texture1->name)))
 			{
@@ -122,19 +118,19 @@ static void TextureNameFix( void )
 BodypartNameFix
 ============
 */
-static void BodypartNameFix( void )
+static void BodypartNameFix( mdldec_t *ctx )
 {
 	int			 i, j, k, len, counter, protected = 0, protected_models = 0;
 	qboolean		 hasduplicates = false;
-	mstudiobodyparts_t	*bodypart = (mstudiobodyparts_t *) ( (byte *)model_hdr + model_hdr->bodypartindex );
+	mstudiobodyparts_t	*bodypart = (mstudiobodyparts_t *) ( (byte *)ctx->model_hdr + ctx->model_hdr->bodypartindex );
 	mstudiomodel_t		*model, *model1;
 
-	for( i = 0; i < model_hdr->numbodyparts; ++i, ++bodypart )
+	for( i = 0; i < ctx->model_hdr->numbodyparts; ++i, ++bodypart )
 		ExtractFileName( bodypart->name, sizeof( bodypart->name ));
 
 	bodypart -= i;
 
-	for( i = 0; i < model_hdr->numbodyparts; ++i, ++bodypart )
+	for( i = 0; i < ctx->model_hdr->numbodyparts; ++i, ++bodypart )
 	{
 		if( !IsValidName( bodypart->name ))
 		{
@@ -142,7 +138,7 @@ static void BodypartNameFix( void )
 			continue;
 		}
 
-		model = (mstudiomodel_t *)( (byte *)model_hdr + bodypart->modelindex );
+		model = (mstudiomodel_t *)( (byte *)ctx->model_hdr + bodypart->modelindex );
 
 		for( j = 0; j < bodypart->nummodels; ++j, ++model )
 		{
@@ -162,7 +158,7 @@ static void BodypartNameFix( void )
 
 			counter = 0;
 
-			model1 = (mstudiomodel_t *)( (byte *)model_hdr + bodypart->modelindex );
+			model1 = (mstudiomodel_t *)( (byte *)ctx->model_hdr + bodypart->modelindex );
 
 			for( k = 0; k < bodypart->nummodels; ++k, ++model1 )
 			{
@@ -199,13 +195,13 @@ static void BodypartNameFix( void )
 SequenceNameFix
 ============
 */
-static void SequenceNameFix( void )
+static void SequenceNameFix( mdldec_t *ctx )
 {
 	int			 i, j, len, counter, protected = 0;
 	qboolean		 hasduplicates = false;
-	mstudioseqdesc_t	*seqdesc = (mstudioseqdesc_t *)( (byte *)model_hdr + model_hdr->seqindex ), *seqdesc1;
+	mstudioseqdesc_t	*seqdesc = (mstudioseqdesc_t *)( (byte *)ctx->model_hdr + ctx->model_hdr->seqindex ), *seqdesc1;
 
-	for( i = 0; i < model_hdr->numseq; ++i, ++seqdesc )
+	for( i = 0; i < ctx->model_hdr->numseq; ++i, ++seqdesc )
 	{
 		ExtractFileName( seqdesc->label, sizeof( seqdesc->label ));
 		COM_StripExtension( seqdesc->label );
@@ -213,7 +209,7 @@ static void SequenceNameFix( void )
 
 	seqdesc -= i;
 
-	for( i = 0; i < model_hdr->numseq; ++i, ++seqdesc )
+	for( i = 0; i < ctx->model_hdr->numseq; ++i, ++seqdesc )
 	{
 		if( !IsValidName( seqdesc->label ))
 		{
@@ -223,9 +219,9 @@ static void SequenceNameFix( void )
 
 		counter = 0;
 
-		seqdesc1 = (mstudioseqdesc_t *)( (byte *)model_hdr + model_hdr->seqindex );
+		seqdesc1 = (mstudioseqdesc_t *)( (byte *)ctx->model_hdr + ctx->model_hdr->seqindex );
 
-		for( j = 0; j < model_hdr->numseq; ++j, ++seqdesc1 )
+		for( j = 0; j < ctx->model_hdr->numseq; ++j, ++seqdesc1 )
 		{
 			if( j != i && !Q_strncmp( seqdesc1->label, seqdesc->label, sizeof( seqdesc1->label )))
 			{
@@ -256,12 +252,12 @@ static void SequenceNameFix( void )
 BoneNameFix
 ============
 */
-static void BoneNameFix( void )
+static void BoneNameFix( mdldec_t *ctx )
 {
 	int		 i, protected = 0;
-	mstudiobone_t	*bone = (mstudiobone_t *)( (byte *)model_hdr + model_hdr->boneindex );
+	mstudiobone_t	*bone = (mstudiobone_t *)( (byte *)ctx->model_hdr + ctx->model_hdr->boneindex );
 
-	for( i = 0; i < model_hdr->numbones; ++i, ++bone )
+	for( i = 0; i < ctx->model_hdr->numbones; ++i, ++bone )
 	{
 		bone->name[sizeof( bone->name ) - 1] = '\0';
 
@@ -278,7 +274,7 @@ static void BoneNameFix( void )
 LoadMDL
 ============
 */
-static qboolean LoadMDL( const char *modelname )
+qboolean LoadMDL( mdldec_t *ctx, const char *modelname )
 {
 	int		 i;
 	size_t		 len;
@@ -313,23 +309,23 @@ static qboolean LoadMDL( const char *modelname )
 		return false;
 	}
 
-	model_hdr = (studiohdr_t *)LoadFile( modelname, &filesize );
+	ctx->model_hdr = (studiohdr_t *)LoadFile( modelname, &filesize );
 
-	if( !model_hdr )
+	if( !ctx->model_hdr )
 	{
 		fprintf( stderr, "ERROR: Can't open %s\n", modelname );
 		return false;
 	}
 
-	if( filesize < sizeof( studiohdr_t ) || filesize != model_hdr->length )
+	if( filesize < sizeof( studiohdr_t ) || filesize != ctx->model_hdr->length )
 	{
 		fprintf( stderr, "ERROR: Wrong file size! File %s may be corrupted!\n", modelname );
 		return false;
 	}
 
-	if( memcmp( &model_hdr->ident, id_mdlhdr, sizeof( id_mdlhdr ) ) )
+	if( memcmp( &ctx->model_hdr->ident, id_mdlhdr, sizeof( id_mdlhdr ) ) )
 	{
-		if( !memcmp( &model_hdr->ident, id_seqhdr, sizeof( id_seqhdr ) ) )
+		if( !memcmp( &ctx->model_hdr->ident, id_seqhdr, sizeof( id_seqhdr ) ) )
 			fprintf( stderr, "ERROR: %s is not a main HL model file.\n", modelname );
 		else
 			fprintf( stderr, "ERROR: %s is not a valid HL model file.\n", modelname );
@@ -337,47 +333,47 @@ static qboolean LoadMDL( const char *modelname )
 		return false;
 	}
 
-	if( model_hdr->version != STUDIO_VERSION )
+	if( ctx->model_hdr->version != STUDIO_VERSION )
 	{
-		fprintf( stderr, "ERROR: %s has unknown Studio MDL format version %d.\n", modelname, model_hdr->version );
+		fprintf( stderr, "ERROR: %s has unknown Studio MDL format version %d.\n", modelname, ctx->model_hdr->version );
 		return false;
 	}
 
-	if( !model_hdr->numbodyparts )
+	if( !ctx->model_hdr->numbodyparts )
 	{
 		fprintf( stderr, "ERROR: %s is not a main HL model file.\n", modelname );
 		return false;
 	}
 
-	if( destdir[0] != '\0' )
+	if( ctx->destdir[0] != '\0' )
 	{
-		if( !MakeFullPath( destdir ))
+		if( !MakeFullPath( ctx->destdir ))
 			return false;
 	}
 	else
-		COM_ExtractFilePath( modelname, destdir );
+		COM_ExtractFilePath( modelname, ctx->destdir );
 
-	if( destdir[0] != '\0' )
-		COM_PathSlashFix( destdir );
+	if( ctx->destdir[0] != '\0' )
+		COM_PathSlashFix( ctx->destdir );
 
 	len -= ( sizeof( ".mdl" ) - 1 ); // path length without extension
 
-	if( !model_hdr->numtextures )
+	if( !ctx->model_hdr->numtextures )
 	{
 		Q_strncpy( texturename, modelname, sizeof( texturename ));
 		Q_strncpy( &texturename[len], "t.mdl", sizeof( texturename ) - len );
 
-		texture_hdr = (studiohdr_t *)LoadFile( texturename, &filesize );
+		ctx->texture_hdr = (studiohdr_t *)LoadFile( texturename, &filesize );
 
-		if( !texture_hdr )
+		if( !ctx->texture_hdr )
 		{
 #if !XASH_WIN32
 			// dirty hack for casesensetive filesystems
 			texturename[len] = 'T';
 
-			texture_hdr = (studiohdr_t *)LoadFile( texturename, &filesize );
+			ctx->texture_hdr = (studiohdr_t *)LoadFile( texturename, &filesize );
 
-			if( !texture_hdr )
+			if( !ctx->texture_hdr )
 #endif
 			{
 				fprintf( stderr, "ERROR: Can't open external textures file %s\n", texturename );
@@ -385,55 +381,55 @@ static qboolean LoadMDL( const char *modelname )
 			}
 		}
 
-		if( filesize < sizeof( studiohdr_t ) || filesize != texture_hdr->length )
+		if( filesize < sizeof( studiohdr_t ) || filesize != ctx->texture_hdr->length )
 		{
 			fprintf( stderr, "ERROR: Wrong file size! File %s may be corrupted!\n", texturename );
 			return false;
 		}
 
-		if( memcmp( &texture_hdr->ident, id_mdlhdr, sizeof( id_mdlhdr ) )
-		    || !texture_hdr->numtextures )
+		if( memcmp( &ctx->texture_hdr->ident, id_mdlhdr, sizeof( id_mdlhdr ) )
+		    || !ctx->texture_hdr->numtextures )
 		{
 			fprintf( stderr, "ERROR: %s is not a valid external textures file.\n", texturename );
 			return false;
 		}
 	}
 	else
-		texture_hdr = model_hdr;
+		ctx->texture_hdr = ctx->model_hdr;
 
-	anim_hdr = malloc( sizeof( studiohdr_t* ) * model_hdr->numseqgroups );
+	ctx->anim_hdr = calloc( ctx->model_hdr->numseqgroups, sizeof( studiohdr_t* ));
 
-	if( !anim_hdr )
+	if( !ctx->anim_hdr )
 	{
 		fputs( "ERROR: Couldn't allocate memory for sequences.\n", stderr );
 		return false;
 	}
 
-	anim_hdr[0] = model_hdr;
+	ctx->anim_hdr[0] = ctx->model_hdr;
 
-	if( model_hdr->numseqgroups > 1 )
+	if( ctx->model_hdr->numseqgroups > 1 )
 	{
 		Q_strncpy( seqgroupname, modelname, sizeof( seqgroupname ));
 
-		for( i = 1; i < model_hdr->numseqgroups; i++ )
+		for( i = 1; i < ctx->model_hdr->numseqgroups; i++ )
 		{
 			Q_snprintf( &seqgroupname[len], sizeof( seqgroupname ) - len, "%02d.mdl", i );
 
-			anim_hdr[i] = (studiohdr_t *)LoadFile( seqgroupname, &filesize );
+			ctx->anim_hdr[i] = (studiohdr_t *)LoadFile( seqgroupname, &filesize );
 
-			if( !anim_hdr[i] )
+			if( !ctx->anim_hdr[i] )
 			{
 				fprintf( stderr, "ERROR: Can't open sequence file %s\n", seqgroupname );
 				return false;
 			}
 
-			if( filesize < sizeof( studiohdr_t ) || filesize != anim_hdr[i]->length )
+			if( filesize < sizeof( studiohdr_t ) || filesize != ctx->anim_hdr[i]->length )
 			{
 				fprintf( stderr, "ERROR: Wrong file size! File %s may be corrupted!\n", seqgroupname );
 				return false;
 			}
 
-			if( memcmp( &anim_hdr[i]->ident, id_seqhdr, sizeof( id_seqhdr ) ) )
+			if( memcmp( &ctx->anim_hdr[i]->ident, id_seqhdr, sizeof( id_seqhdr ) ) )
 			{
 				fprintf( stderr, "ERROR: %s is not a valid sequence file.\n", seqgroupname );
 				return false;
@@ -441,31 +437,57 @@ static qboolean LoadMDL( const char *modelname )
 		}
 	}
 
-	COM_FileBase( modelname, modelfile, sizeof( modelfile ));
+	COM_FileBase( modelname, ctx->modelfile, sizeof( ctx->modelfile ));
 
 	// Some validation checks was found in mdldec-golang by Psycrow101
-	if( model_hdr->numhitboxes > model_hdr->numbones * ( MAXSTUDIOSRCBONES / MAXSTUDIOBONES ))
+	if( ctx->model_hdr->numhitboxes > ctx->model_hdr->numbones * ( MAXSTUDIOSRCBONES / MAXSTUDIOBONES ))
 	{
-		printf( "WARNING: Invalid hitboxes number %d.\n", model_hdr->numhitboxes );
-		model_hdr->numhitboxes = 0;
+		printf( "WARNING: Invalid hitboxes number %d.\n", ctx->model_hdr->numhitboxes );
+		ctx->model_hdr->numhitboxes = 0;
 	}
-	else if( model_hdr->hitboxindex + model_hdr->numhitboxes * ( sizeof( mstudiobbox_t ) + sizeof( mstudiohitboxset_t )) > model_hdr->length )
+	else if( ctx->model_hdr->hitboxindex + ctx->model_hdr->numhitboxes * ( sizeof( mstudiobbox_t ) + sizeof( mstudiohitboxset_t )) > ctx->model_hdr->length )
 	{
-		printf( "WARNING: Invalid hitboxes offset %d.\n", model_hdr->hitboxindex );
-		model_hdr->numhitboxes = 0;
+		printf( "WARNING: Invalid hitboxes offset %d.\n", ctx->model_hdr->hitboxindex );
+		ctx->model_hdr->numhitboxes = 0;
 	}
 
-	TextureNameFix();
+	TextureNameFix( ctx );
 
-	BodypartNameFix();
+	BodypartNameFix( ctx );
 
-	SequenceNameFix();
+	SequenceNameFix( ctx );
 
-	BoneNameFix();
+	BoneNameFix( ctx );
 
 	return true;
 }
 
+/*
+============
+FreeMDL
+============
+*/
+void FreeMDL( mdldec_t *ctx )
+{
+	int	i;
+
+	if( ctx->anim_hdr )
+	{
+		for( i = 1; i < ctx->model_hdr->numseqgroups; i++ )
+			free( ctx->anim_hdr[i] );
+
+		free( ctx->anim_hdr );
+	}
+
+	if( ctx->texture_hdr != ctx->model_hdr )
+		free( ctx->texture_hdr );
+
+	free( ctx->model_hdr );
+
+	ctx->model_hdr = ctx->texture_hdr = NULL;
+	ctx->anim_hdr = NULL;
+}
+
 /*
 ============
 ShowHelp
@@ -475,43 +497,76 @@ static void ShowHelp( const char *app_name )
 {
 	printf( "usage: %s source_file\n", app_name );
 	printf( "       %s source_file target_directory\n", app_name );
+	printf( "       %s [-j threads] -batch source_directory|list_file [target_directory]\n", app_name );
 }
 
 int main( int argc, char *argv[] )
 {
-	int ret = 0;
+	int		 i, ret = 0, numthreads = 0;
+	qboolean	 batch = false;
+	const char	*target = NULL;
+	mdldec_t	 ctx = { 0 };
 
 	puts( "\nHalf-Life Studio Model Decompiler " APP_VERSION );
 	puts( "Copyright Flying With Gauss 2020 (c) " );
 	puts( "--------------------------------------------------" );
 
-	if( argc == 1 )
+	for( i = 1; i < argc && argv[i][0] == '-'; i++ )
+	{
+		if( !Q_strcmp( argv[i], "-batch" ))
+			batch = true;
+		else if( !Q_strcmp( argv[i], "-j" ) && i + 1 < argc )
+			numthreads = Q_atoi( argv[++i] );
+		else
+			break;
+	}
+
+	if( i >= argc || argv[i][0] == '-' )
 	{
 		ShowHelp( argv[0] );
 		ret = 2;
 		goto end;
 	}
-	else if( argc == 3 )
+	else if( i + 1 < argc )
 	{
-		if( Q_strlen( argv[2] ) > MAX_SYSPATH - 2 )
+		if( Q_strlen( argv[i + 1] ) > MAX_SYSPATH - 2 )
 		{
 			fputs( "ERROR: Destination path is too long.\n", stderr );
 			ret = 1;
 			goto end;
 		}
 
-		Q_strncpy( destdir, argv[2], sizeof( destdir ));
+		target = argv[i + 1];
+	}
+
+	if( !LoadActivityList( argv[0] ))
+	{
+		ret = 1;
+		goto end;
+	}
+
+	if( batch )
+	{
+		if( DecompileBatch( argv[i], target, numthreads ) != 0 )
+			ret = 1;
+
+		goto end;
 	}
 
-	if( !LoadActivityList( argv[0] ) || !LoadMDL( argv[1] ) )
+	if( target )
+		Q_strncpy( ctx.destdir, target, sizeof( ctx.destdir ));
+
+	if( !LoadMDL( &ctx, argv[i] ))
 	{
 		ret = 1;
 		goto end;
 	}
 
-	WriteQCScript();
-	WriteSMD();
-	WriteTextures();
+	WriteQCScript( &ctx );
+	WriteSMD( &ctx );
+	WriteTextures( &ctx );
+
+	FreeMDL( &ctx );
 
 	puts( "Done." );
 
@@ -520,4 +575,3 @@ int main( int argc, char *argv[] )
 
 	return ret;
 }
-
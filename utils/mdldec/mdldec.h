@@ -16,11 +16,19 @@ GNU General Public License for more details.
 #ifndef MDLDEC_H
 #define MDLDEC_H
 
-extern char		  destdir[MAX_SYSPATH];
-extern char		  modelfile[MAX_SYSPATH];
-extern studiohdr_t	 *model_hdr;
-extern studiohdr_t	 *texture_hdr;
-extern studiohdr_t	**anim_hdr;
+// everything known about a single model being decompiled,
+// writers only read it, so one model can be shared between threads
+typedef struct mdldec_s
+{
+	char		  destdir[MAX_SYSPATH];
+	char		  modelfile[MAX_SYSPATH];
+	studiohdr_t	 *model_hdr;
+	studiohdr_t	 *texture_hdr;
+	studiohdr_t	**anim_hdr;
+} mdldec_t;
+
+qboolean	LoadMDL( mdldec_t *ctx, const char *modelname );
+void		FreeMDL( mdldec_t *ctx );
 
 #endif // MDLDEC_H
 
@@ -28,6 +28,7 @@ GNU General Public License for more details.
 
 static char	**activity_names;
 static int	  activity_count;
+static char	  copyright_year[16];
 
 /*
 ============
@@ -92,6 +93,9 @@ qboolean LoadActivityList( const char *appname )
 
 	fclose( fp );
 
+	// Q_timestamp uses static buffer, so query it once before batch workers start
+	Q_strncpy( copyright_year, Q_timestamp( TIME_YEAR_ONLY ), sizeof( copyright_year ));
+
 	return true;
 }
 
@@ -196,15 +200,15 @@ static void GetMotionTypeString( int type, char *str, size_t size, qboolean is_c
 WriteTextureRenderMode
 ============
 */
-static void WriteTextureRenderMode( FILE *fp )
+static void WriteTextureRenderMode( const mdldec_t *ctx, FILE *fp )
 {
 	int		  i;
 	mstudiotexture_t *texture;
 	long		  pos = ftell( fp );
 
-	for( i = 0; i < texture_hdr->numtextures; i++ )
+	for( i = 0; i < ctx->texture_hdr->numtextures; i++ )
 	{
-		texture = (mstudiotexture_t *)( (byte *)texture_hdr + texture_hdr->textureindex ) + i;
+		texture = (mstudiotexture_t *)( (byte *)ctx->texture_hdr + ctx->texture_hdr->textureindex ) + i;
 
 		if( texture->flags & STUDIO_NF_FLATSHADE )
 			fprintf( fp,"$texrendermode \"%s\" \"flatshade\" \n", texture->name ); // sven-coop extension
@@ -248,33 +252,33 @@ static void WriteTextureRenderMode( FILE *fp )
 WriteSkinFamilyInfo
 ============
 */
-static void WriteSkinFamilyInfo( FILE *fp )
+static void WriteSkinFamilyInfo( const mdldec_t *ctx, FILE *fp )
 {
 	int			 i, j, k;
 	short			*skinref, *index;
 	mstudiotexture_t	*texture;
 
-	if( texture_hdr->numskinfamilies < 2 )
+	if( ctx->texture_hdr->numskinfamilies < 2 )
 		return;
 
-	fprintf( fp, "// %i skin families\n", texture_hdr->numskinfamilies );
+	fprintf( fp, "// %i skin families\n", ctx->texture_hdr->numskinfamilies );
 
 	fputs( "$texturegroup \"skinfamilies\"\n{\n", fp );
 
-	skinref = (short *)( (byte *)texture_hdr + texture_hdr->skinindex );
-	texture = (mstudiotexture_t *)( (byte *)texture_hdr + texture_hdr->textureindex );
+	skinref = (short *)( (byte *)ctx->texture_hdr + ctx->texture_hdr->skinindex );
+	texture = (mstudiotexture_t *)( (byte *)ctx->texture_hdr + ctx->texture_hdr->textureindex );
 
-	for( i = 0; i < texture_hdr->numskinfamilies; ++i )
+	for( i = 0; i < ctx->texture_hdr->numskinfamilies; ++i )
 	{
 		fputs( "\t{\n", fp );
 
-		index = skinref + i * texture_hdr->numskinref;
+		index = skinref + i * ctx->texture_hdr->numskinref;
 
-		for( j = 0; j < texture_hdr->numskinref; ++j, ++index )
+		for( j = 0; j < ctx->texture_hdr->numskinref; ++j, ++index )
 		{
-			for( k = 0; k < texture_hdr->numskinfamilies; ++k )
+			for( k = 0; k < ctx->texture_hdr->numskinfamilies; ++k )
 			{
-				if( *index == *( skinref + k * texture_hdr->numskinref + j ) )
+				if( *index == *( skinref + k * ctx->texture_hdr->numskinref + j ) )
 					continue;
 
 				fprintf( fp, "\t\t\"%s\"\n", texture[*index].name );
@@ -293,21 +297,21 @@ static void WriteSkinFamilyInfo( FILE *fp )
 WriteAttachmentInfo
 ============
 */
-static void WriteAttachmentInfo( FILE *fp )
+static void WriteAttachmentInfo( const mdldec_t *ctx, FILE *fp )
 {
 	int			 i;
 	mstudioattachment_t	*attachment;
 	mstudiobone_t		*bone;
 
-	if( !model_hdr->numattachments )
+	if( !ctx->model_hdr->numattachments )
 		return;
 
-	attachment = (mstudioattachment_t *)( (byte *)model_hdr + model_hdr->attachmentindex );
-	bone = (mstudiobone_t *)( (byte *)model_hdr + model_hdr->boneindex );
+	attachment = (mstudioattachment_t *)( (byte *)ctx->model_hdr + ctx->model_hdr->attachmentindex );
+	bone = (mstudiobone_t *)( (byte *)ctx->model_hdr + ctx->model_hdr->boneindex );
 
-	fprintf( fp, "// %i attachment%s\n", model_hdr->numattachments, model_hdr->numattachments > 1 ? "s" : "" );
+	fprintf( fp, "// %i attachment%s\n", ctx->model_hdr->numattachments, ctx->model_hdr->numattachments > 1 ? "s" : "" );
 
-	for( i = 0; i < model_hdr->numattachments; ++i, ++attachment )
+	for( i = 0; i < ctx->model_hdr->numattachments; ++i, ++attachment )
 		fprintf( fp, "$attachment %i \"%s\" %f %f %f\n", i, bone[attachment->bone].name, attachment->org[0], attachment->org[1], attachment->org[2] );
 
 	fputs( "\n", fp );
@@ -318,17 +322,17 @@ static void WriteAttachmentInfo( FILE *fp )
 WriteBodyGroupInfo
 ============
 */
-static void WriteBodyGroupInfo( FILE *fp )
+static void WriteBodyGroupInfo( const mdldec_t *ctx, FILE *fp )
 {
 	int			 i, j;
-	mstudiobodyparts_t	*bodypart = (mstudiobodyparts_t *) ( (byte *)model_hdr + model_hdr->bodypartindex );
+	mstudiobodyparts_t	*bodypart = (mstudiobodyparts_t *) ( (byte *)ctx->model_hdr + ctx->model_hdr->bodypartindex );
 	mstudiomodel_t		*model;
 
-	fprintf( fp, "// %i reference mesh%s\n", model_hdr->numbodyparts, model_hdr->numbodyparts > 1 ? "es" : "" );
+	fprintf( fp, "// %i reference mesh%s\n", ctx->model_hdr->numbodyparts, ctx->model_hdr->numbodyparts > 1 ? "es" : "" );
 
-	for( i = 0; i < model_hdr->numbodyparts; ++i, ++bodypart )
+	for( i = 0; i < ctx->model_hdr->numbodyparts; ++i, ++bodypart )
 	{
-		model = (mstudiomodel_t *)( (byte *)model_hdr + bodypart->modelindex );
+		model = (mstudiomodel_t *)( (byte *)ctx->model_hdr + bodypart->modelindex );
 
 		if( bodypart->nummodels == 1 )
 		{
@@ -362,22 +366,22 @@ static void WriteBodyGroupInfo( FILE *fp )
 WriteControllerInfo
 ============
 */
-static void WriteControllerInfo( FILE *fp )
+static void WriteControllerInfo( const mdldec_t *ctx, FILE *fp )
 {
 	int			 i;
 	mstudiobonecontroller_t	*bonecontroller;
 	mstudiobone_t		*bone;
 	char			 motion_types[64];
 
-	if( !model_hdr->numbonecontrollers )
+	if( !ctx->model_hdr->numbonecontrollers )
 		return;
 
-	bonecontroller = (mstudiobonecontroller_t *)( (byte *)model_hdr + model_hdr->bonecontrollerindex );
-	bone = (mstudiobone_t *)( (byte *)model_hdr + model_hdr->boneindex );
+	bonecontroller = (mstudiobonecontroller_t *)( (byte *)ctx->model_hdr + ctx->model_hdr->bonecontrollerindex );
+	bone = (mstudiobone_t *)( (byte *)ctx->model_hdr + ctx->model_hdr->boneindex );
 
-	fprintf( fp, "// %i bone controller%s\n", model_hdr->numbonecontrollers, model_hdr->numbonecontrollers > 1 ? "s" : "" );
+	fprintf( fp, "// %i bone controller%s\n", ctx->model_hdr->numbonecontrollers, ctx->model_hdr->numbonecontrollers > 1 ? "s" : "" );
 
-	for( i = 0; i < model_hdr->numbonecontrollers; ++i, ++bonecontroller )
+	for( i = 0; i < ctx->model_hdr->numbonecontrollers; ++i, ++bonecontroller )
 	{
 		GetMotionTypeString( bonecontroller->type & ~STUDIO_RLOOP, motion_types, sizeof( motion_types ), false );
 
@@ -401,21 +405,21 @@ static void WriteControllerInfo( FILE *fp )
 WriteHitBoxInfo
 ============
 */
-static void WriteHitBoxInfo( FILE *fp )
+static void WriteHitBoxInfo( const mdldec_t *ctx, FILE *fp )
 {
 	int		 i;
 	mstudiobbox_t	*hitbox;
 	mstudiobone_t	*bone;
 
-	if( !model_hdr->numhitboxes )
+	if( !ctx->model_hdr->numhitboxes )
 		return;
 
-	hitbox = (mstudiobbox_t *)( (byte *)model_hdr + model_hdr->hitboxindex );
-	bone = (mstudiobone_t *)( (byte *)model_hdr + model_hdr->boneindex );
+	hitbox = (mstudiobbox_t *)( (byte *)ctx->model_hdr + ctx->model_hdr->hitboxindex );
+	bone = (mstudiobone_t *)( (byte *)ctx->model_hdr + ctx->model_hdr->boneindex );
 
-	fprintf( fp, "// %i hit box%s\n", model_hdr->numhitboxes, model_hdr->numhitboxes > 1 ? "es" : "" );
+	fprintf( fp, "// %i hit box%s\n", ctx->model_hdr->numhitboxes, ctx->model_hdr->numhitboxes > 1 ? "es" : "" );
 
-	for( i = 0; i < model_hdr->numhitboxes; ++i, ++hitbox )
+	for( i = 0; i < ctx->model_hdr->numhitboxes; ++i, ++hitbox )
 		fprintf( fp, "$hbox %i \"%s\" %f %f %f %f %f %f\n",
 		    hitbox->group, bone[hitbox->bone].name,
 		    hitbox->bbmin[0], hitbox->bbmin[1], hitbox->bbmin[2],
@@ -429,12 +433,12 @@ static void WriteHitBoxInfo( FILE *fp )
 CalcSequenceGroupSize
 ============
 */
-static int CalcSequenceGroupSize( void )
+static int CalcSequenceGroupSize( const mdldec_t *ctx )
 {
 	int			i, maxsize = 0, groupsize = DEFAULT_SEQGROUPSIZE;
 
-	for( i = 1; i < model_hdr->numseqgroups; i++ )
-		maxsize = Q_max( anim_hdr[i]->length, maxsize );
+	for( i = 1; i < ctx->model_hdr->numseqgroups; i++ )
+		maxsize = Q_max( ctx->anim_hdr[i]->length, maxsize );
 
 	if( maxsize > 0 )
 	{
@@ -452,7 +456,7 @@ static int CalcSequenceGroupSize( void )
 WriteSequenceInfo
 ============
 */
-static void WriteSequenceInfo( FILE *fp )
+static void WriteSequenceInfo( const mdldec_t *ctx, FILE *fp )
 {
 	int			 i, j;
 	const char		*activity;
@@ -460,16 +464,16 @@ static void WriteSequenceInfo( FILE *fp )
 	mstudioevent_t		*event;
 	mstudioseqdesc_t	*seqdesc;
 
-	if( model_hdr->numseqgroups > 1 )
-		fprintf( fp, "$sequencegroupsize %d\n\n", CalcSequenceGroupSize( ) );
+	if( ctx->model_hdr->numseqgroups > 1 )
+		fprintf( fp, "$sequencegroupsize %d\n\n", CalcSequenceGroupSize( ctx ));
 
-	if( model_hdr->numseq > 0 )
-		fprintf( fp, "// %i animation sequence%s\n", model_hdr->numseq, model_hdr->numseq > 1 ? "s" : "" );
+	if( ctx->model_hdr->numseq > 0 )
+		fprintf( fp, "// %i animation sequence%s\n", ctx->model_hdr->numseq, ctx->model_hdr->numseq > 1 ? "s" : "" );
 	else return;
 
-	seqdesc = (mstudioseqdesc_t *)( (byte *)model_hdr + model_hdr->seqindex );
+	seqdesc = (mstudioseqdesc_t *)( (byte *)ctx->model_hdr + ctx->model_hdr->seqindex );
 
-	for( i = 0; i < model_hdr->numseq; ++i, ++seqdesc )
+	for( i = 0; i < ctx->model_hdr->numseq; ++i, ++seqdesc )
 	{
 		fprintf( fp, "$sequence \"%s\" {\n", seqdesc->label );
 
@@ -511,7 +515,7 @@ static void WriteSequenceInfo( FILE *fp )
 				printf( "WARNING: Something wrong with blending type for sequence: %s\n", seqdesc->label );
 		}
 
-		event = (mstudioevent_t *)( (byte *)model_hdr + seqdesc->eventindex );
+		event = (mstudioevent_t *)( (byte *)ctx->model_hdr + seqdesc->eventindex );
 
 		for( j = 0; j < seqdesc->numevents; ++j, ++event )
 		{
@@ -557,17 +561,17 @@ static void WriteSequenceInfo( FILE *fp )
 WriteQCScript
 ============
 */
-void WriteQCScript( void )
+void WriteQCScript( const mdldec_t *ctx )
 {
 	FILE	*fp;
 	char	 filename[MAX_SYSPATH];
 	int	 len;
 
-	len = Q_snprintf( filename, MAX_SYSPATH, "%s%s.qc", destdir, modelfile );
+	len = Q_snprintf( filename, MAX_SYSPATH, "%s%s.qc", ctx->destdir, ctx->modelfile );
 
 	if( len == -1 )
 	{
-		fprintf( stderr, "ERROR: Destination path is too long. Couldn't write %s.qc\n", modelfile );
+		fprintf( stderr, "ERROR: Destination path is too long. Couldn't write %s.qc\n", ctx->modelfile );
 		return;
 	}
 
@@ -583,17 +587,17 @@ void WriteQCScript( void )
 	fputs( "==============================================================================\n\n", fp );
 	fputs( "QC script generated by Half-Life Studio Model Decompiler " APP_VERSION "\n", fp );
 
-	fprintf( fp, "Copyright Flying With Gauss %s (c) \n\n", Q_timestamp( TIME_YEAR_ONLY ) );
-	fprintf( fp, "%s.mdl\n\n", modelfile );
+	fprintf( fp, "Copyright Flying With Gauss %s (c) \n\n", copyright_year );
+	fprintf( fp, "%s.mdl\n\n", ctx->modelfile );
 
 	fputs( "Original internal name:\n", fp );
 
-	fprintf( fp, "\"%s\"\n\n", model_hdr->name );
+	fprintf( fp, "\"%s\"\n\n", ctx->model_hdr->name );
 
 	fputs( "==============================================================================\n", fp );
 	fputs( "*/\n\n", fp );
 
-	fprintf( fp, "$modelname \"%s.mdl\"\n", modelfile );
+	fprintf( fp, "$modelname \"%s.mdl\"\n", ctx->modelfile );
 
 	fputs( "$cd \".\"\n", fp );
 	fputs( "$cdtexture \"./" DEFAULT_TEXTUREPATH "\"\n", fp );
@@ -601,32 +605,32 @@ void WriteQCScript( void )
 	fputs( "$scale 1.0\n", fp );
 	fputs( "\n", fp );
 
-	if( model_hdr->flags & STUDIO_HAS_BONEINFO )
+	if( ctx->model_hdr->flags & STUDIO_HAS_BONEINFO )
 	{
-		if( model_hdr->flags & STUDIO_HAS_BONEWEIGHTS )
+		if( ctx->model_hdr->flags & STUDIO_HAS_BONEWEIGHTS )
 			fputs( "$boneweights\n\n", fp );
 	}
 
-	WriteBodyGroupInfo( fp );
+	WriteBodyGroupInfo( ctx, fp );
 
-	fprintf( fp, "$flags %u\n\n", model_hdr->flags &~( STUDIO_HAS_BONEINFO | STUDIO_HAS_BONEWEIGHTS ) );
-	fprintf( fp, "$eyeposition %f %f %f\n\n", model_hdr->eyeposition[0], model_hdr->eyeposition[1], model_hdr->eyeposition[2] );
+	fprintf( fp, "$flags %u\n\n", ctx->model_hdr->flags &~( STUDIO_HAS_BONEINFO | STUDIO_HAS_BONEWEIGHTS ) );
+	fprintf( fp, "$eyeposition %f %f %f\n\n", ctx->model_hdr->eyeposition[0], ctx->model_hdr->eyeposition[1], ctx->model_hdr->eyeposition[2] );
 
-	if( !model_hdr->numtextures )
+	if( !ctx->model_hdr->numtextures )
 		fputs( "$externaltextures\n\n", fp );
 
-	WriteSkinFamilyInfo( fp );
-	WriteTextureRenderMode( fp );
-	WriteAttachmentInfo( fp );
+	WriteSkinFamilyInfo( ctx, fp );
+	WriteTextureRenderMode( ctx, fp );
+	WriteAttachmentInfo( ctx, fp );
 
-	fprintf( fp, "$bbox %f %f %f", model_hdr->min[0], model_hdr->min[1], model_hdr->min[2] );
-	fprintf( fp, " %f %f %f\n\n", model_hdr->max[0], model_hdr->max[1], model_hdr->max[2] );
-	fprintf( fp, "$cbox %f %f %f", model_hdr->bbmin[0], model_hdr->bbmin[1], model_hdr->bbmin[2] );
-	fprintf( fp, " %f %f %f\n\n", model_hdr->bbmax[0], model_hdr->bbmax[1], model_hdr->bbmax[2] );
+	fprintf( fp, "$bbox %f %f %f", ctx->model_hdr->min[0], ctx->model_hdr->min[1], ctx->model_hdr->min[2] );
+	fprintf( fp, " %f %f %f\n\n", ctx->model_hdr->max[0], ctx->model_hdr->max[1], ctx->model_hdr->max[2] );
+	fprintf( fp, "$cbox %f %f %f", ctx->model_hdr->bbmin[0], ctx->model_hdr->bbmin[1], ctx->model_hdr->bbmin[2] );
+	fprintf( fp, " %f %f %f\n\n", ctx->model_hdr->bbmax[0], ctx->model_hdr->bbmax[1], ctx->model_hdr->bbmax[2] );
 
-	WriteHitBoxInfo( fp );
-	WriteControllerInfo( fp );
-	WriteSequenceInfo( fp );
+	WriteHitBoxInfo( ctx, fp );
+	WriteControllerInfo( ctx, fp );
+	WriteSequenceInfo( ctx, fp );
 
 	fputs( "// End of QC script.\n", fp );
 	fclose( fp );
@@ -20,7 +20,7 @@ GNU General Public License for more details.
 #define ACTIVITIES_FILE	"activities.txt"
 
 qboolean	LoadActivityList( const char *appname );
-void		WriteQCScript( void );
+void		WriteQCScript( const mdldec_t *ctx );
 
 #endif // QC_H
 
@@ -25,17 +25,24 @@ GNU General Public License for more details.
 #include "smd.h"
 #include "utils.h"
 
-static matrix3x4	*bonetransform;
-static matrix3x4	*worldtransform;
+#define SMD_BUFFER_SIZE	( 256 * 1024 )
+
+// reference mesh writer state
+typedef struct
+{
+	const mdldec_t	*ctx;
+	matrix3x4	*bonetransform;
+	matrix3x4	*worldtransform;
+} smdref_t;
 
 /*
 ============
 CreateBoneTransformMatrices
 ============
 */
-static qboolean CreateBoneTransformMatrices( matrix3x4 **matrix )
+static qboolean CreateBoneTransformMatrices( const mdldec_t *ctx, matrix3x4 **matrix )
 {
-	*matrix = calloc( model_hdr->numbones, sizeof( matrix3x4 ) );
+	*matrix = calloc( ctx->model_hdr->numbones, sizeof( matrix3x4 ) );
 
 	if( !*matrix )
 	{
@@ -51,14 +58,14 @@ static qboolean CreateBoneTransformMatrices( matrix3x4 **matrix )
 FillBoneTransformMatrices
 ============
 */
-static void FillBoneTransformMatrices( void )
+static void FillBoneTransformMatrices( const mdldec_t *ctx, matrix3x4 *bonetransform )
 {
 	int		 i;
-	mstudiobone_t	*bone = (mstudiobone_t *)( (byte *)model_hdr + model_hdr->boneindex );
+	mstudiobone_t	*bone = (mstudiobone_t *)( (byte *)ctx->model_hdr + ctx->model_hdr->boneindex );
 	matrix3x4	 bonematrix;
 	vec4_t		 q;
 
-	for( i = 0; i < model_hdr->numbones; ++i, ++bone )
+	for( i = 0; i < ctx->model_hdr->numbones; ++i, ++bone )
 	{
 		AngleQuaternion( &bone->value[3], q, true );
 		Matrix3x4_FromOriginQuat( bonematrix, q, bone->value );
@@ -78,12 +85,12 @@ static void FillBoneTransformMatrices( void )
 FillWorldTransformMatrices
 ============
 */
-static void FillWorldTransformMatrices( void )
+static void FillWorldTransformMatrices( const mdldec_t *ctx, matrix3x4 *bonetransform, matrix3x4 *worldtransform )
 {
 	int			 i;
-	mstudioboneinfo_t	*boneinfo = (mstudioboneinfo_t *)( (byte *)model_hdr + model_hdr->boneindex + model_hdr->numbones * sizeof( mstudiobone_t ) );
+	mstudioboneinfo_t	*boneinfo = (mstudioboneinfo_t *)( (byte *)ctx->model_hdr + ctx->model_hdr->boneindex + ctx->model_hdr->numbones * sizeof( mstudiobone_t ) );
 
-	for( i = 0; i < model_hdr->numbones; ++i, ++boneinfo )
+	for( i = 0; i < ctx->model_hdr->numbones; ++i, ++boneinfo )
 		Matrix3x4_ConcatTransforms( worldtransform[i], bonetransform[i], boneinfo->poseToBone );
 }
 
@@ -176,14 +183,14 @@ static void CalcBonePosition( mstudioanim_t *anim, mstudiobone_t *bone, vec_t *m
 WriteNodes
 ============
 */
-static void WriteNodes( FILE *fp )
+static void WriteNodes( const mdldec_t *ctx, FILE *fp )
 {
 	int		 i;
-	mstudiobone_t	*bone = (mstudiobone_t *)( (byte *)model_hdr + model_hdr->boneindex );
+	mstudiobone_t	*bone = (mstudiobone_t *)( (byte *)ctx->model_hdr + ctx->model_hdr->boneindex );
 
 	fputs( "nodes\n", fp );
 
-	for( i = 0; i < model_hdr->numbones; ++i, ++bone )
+	for( i = 0; i < ctx->model_hdr->numbones; ++i, ++bone )
 		fprintf( fp, "%3i \"%s\" %i\n", i, bone->name, bone->parent );
 
 	fputs( "end\n", fp );
@@ -194,22 +201,19 @@ static void WriteNodes( FILE *fp )
 WriteSkeleton
 ============
 */
-static void WriteSkeleton( FILE *fp )
+static void WriteSkeleton( const mdldec_t *ctx, FILE *fp )
 {
-	int		 i, j;
-	mstudiobone_t	*bone = (mstudiobone_t *)( (byte *)model_hdr + model_hdr->boneindex );
+	int		 i;
+	mstudiobone_t	*bone = (mstudiobone_t *)( (byte *)ctx->model_hdr + ctx->model_hdr->boneindex );
 
 	fputs( "skeleton\n", fp );
 	fputs( "time 0\n", fp );
 
-	for( i = 0; i < model_hdr->numbones; ++i, ++bone )
+	for( i = 0; i < ctx->model_hdr->numbones; ++i, ++bone )
 	{
-		fprintf( fp, "%3i", i );
-
-		for( j = 0; j < 6; j++ )
-			fprintf( fp, " %f", bone->value[j] );
-
-		fputs( "\n", fp );
+		fprintf( fp, "%3i %f %f %f %f %f %f\n", i,
+		    bone->value[0], bone->value[1], bone->value[2],
+		    bone->value[3], bone->value[4], bone->value[5] );
 	}
 
 	fputs( "end\n", fp );
@@ -220,8 +224,9 @@ static void WriteSkeleton( FILE *fp )
 WriteTriangleInfo
 ============
 */
-static void WriteTriangleInfo( FILE *fp, mstudiomodel_t *model, mstudiotexture_t *texture, mstudiotrivert_t **triverts, qboolean isevenstrip )
+static void WriteTriangleInfo( const smdref_t *ref, FILE *fp, mstudiomodel_t *model, mstudiotexture_t *texture, mstudiotrivert_t **triverts, qboolean isevenstrip )
 {
+	const mdldec_t		*ctx = ref->ctx;
 	int			 i, j, k, l, index;
 	int			 vert_index;
 	int			 norm_index;
@@ -236,10 +241,10 @@ static void WriteTriangleInfo( FILE *fp, mstudiomodel_t *model, mstudiotexture_t
 	matrix3x4		 bonematrix[MAXSTUDIOBONEWEIGHTS], skinmatrix, *pskinmatrix;
 	mstudioboneweight_t	*studioboneweights;
 
-	vertbone    = ( (byte *)model_hdr + model->vertinfoindex );
-	studioverts = (vec3_t *)( (byte *)model_hdr + model->vertindex );
-	studionorms = (vec3_t *)( (byte *)model_hdr + model->normindex );
-	studioboneweights = (mstudioboneweight_t *)( (byte *)model_hdr + model->blendvertinfoindex );
+	vertbone    = ( (byte *)ctx->model_hdr + model->vertinfoindex );
+	studioverts = (vec3_t *)( (byte *)ctx->model_hdr + model->vertindex );
+	studionorms = (vec3_t *)( (byte *)ctx->model_hdr + model->normindex );
+	studioboneweights = (mstudioboneweight_t *)( (byte *)ctx->model_hdr + model->blendvertinfoindex );
 
 	s = 1.0f / texture->width;
 	t = 1.0f / texture->height;
@@ -253,7 +258,7 @@ static void WriteTriangleInfo( FILE *fp, mstudiomodel_t *model, mstudiotexture_t
 		norm_index = triverts[index]->normindex;
 		bone_index = vertbone[vert_index];
 
-		if( model_hdr->flags & STUDIO_HAS_BONEWEIGHTS )
+		if( ctx->model_hdr->flags & STUDIO_HAS_BONEWEIGHTS )
 		{
 			valid_bones = 0, totalweight = 0;
 			memset( skinmatrix, 0, sizeof( matrix3x4 ) );
@@ -264,7 +269,7 @@ static void WriteTriangleInfo( FILE *fp, mstudiomodel_t *model, mstudiotexture_t
 
 			for( j = 0; j < valid_bones; ++j )
 			{
-				Matrix3x4_Copy( bonematrix[j], worldtransform[studioboneweights[vert_index].bone[j]] );
+				Matrix3x4_Copy( bonematrix[j], ref->worldtransform[studioboneweights[vert_index].bone[j]] );
 				weights[j] = studioboneweights[vert_index].weight[j] / 255.0f;
 				totalweight += weights[j];
 			}
@@ -282,7 +287,7 @@ static void WriteTriangleInfo( FILE *fp, mstudiomodel_t *model, mstudiotexture_t
 			pskinmatrix = &skinmatrix;
 		}
 		else
-			pskinmatrix = &bonetransform[bone_index];
+			pskinmatrix = &ref->bonetransform[bone_index];
 
 		Matrix3x4_VectorTransform( *pskinmatrix, studioverts[vert_index], vert );
 		Matrix3x4_VectorRotate( *pskinmatrix, studionorms[norm_index], norm );
@@ -305,7 +310,7 @@ static void WriteTriangleInfo( FILE *fp, mstudiomodel_t *model, mstudiotexture_t
 		    norm[0], norm[1], norm[2],
 		    u, v );
 
-		if( model_hdr->flags & STUDIO_HAS_BONEWEIGHTS )
+		if( ctx->model_hdr->flags & STUDIO_HAS_BONEWEIGHTS )
 		{
 			fprintf( fp, " %d", valid_bones );
 
@@ -326,10 +331,11 @@ static void WriteTriangleInfo( FILE *fp, mstudiomodel_t *model, mstudiotexture_t
 WriteTriangles
 ============
 */
-static void WriteTriangles( FILE *fp, mstudiomodel_t *model )
+static void WriteTriangles( const smdref_t *ref, FILE *fp, mstudiomodel_t *model )
 {
+	const mdldec_t		*ctx = ref->ctx;
 	int			 i, j, k;
-	mstudiomesh_t		*mesh = (mstudiomesh_t *)( (byte *)model_hdr + model->meshindex );
+	mstudiomesh_t		*mesh = (mstudiomesh_t *)( (byte *)ctx->model_hdr + model->meshindex );
 	mstudiotexture_t	*texture;
 	mstudiotrivert_t	*triverts[3];
 	short			*tricmds;
@@ -338,8 +344,8 @@ static void WriteTriangles( FILE *fp, mstudiomodel_t *model )
 
 	for( i = 0; i < model->nummesh; ++i, ++mesh )
 	{
-		tricmds = (short *)( (byte *)model_hdr + mesh->triindex );
-		texture = (mstudiotexture_t *)( (byte *)texture_hdr + texture_hdr->textureindex ) + mesh->skinref;
+		tricmds = (short *)( (byte *)ctx->model_hdr + mesh->triindex );
+		texture = (mstudiotexture_t *)( (byte *)ctx->texture_hdr + ctx->texture_hdr->textureindex ) + mesh->skinref;
 
 		while( ( j = *( tricmds++ ) ) )
 		{
@@ -360,21 +366,21 @@ static void WriteTriangles( FILE *fp, mstudiomodel_t *model )
 					{
 						triverts[1] = (mstudiotrivert_t *)tricmds;
 
-						WriteTriangleInfo( fp, model, texture, triverts, true );
+						WriteTriangleInfo( ref, fp, model, texture, triverts, true );
 					}
 					else if( k % 2 )
 					{
 						triverts[0] = triverts[2];
 						triverts[2] = (mstudiotrivert_t *)tricmds;
 
-						WriteTriangleInfo( fp, model, texture, triverts, false );
+						WriteTriangleInfo( ref, fp, model, texture, triverts, false );
 					}
 					else
 					{
 						triverts[0] = triverts[1];
 						triverts[1] = (mstudiotrivert_t *)tricmds;
 
-						WriteTriangleInfo( fp, model, texture, triverts, true );
+						WriteTriangleInfo( ref, fp, model, texture, triverts, true );
 					}
 				}
 			}
@@ -397,14 +403,14 @@ static void WriteTriangles( FILE *fp, mstudiomodel_t *model )
 					{
 						triverts[1] = (mstudiotrivert_t *)tricmds;
 
-						WriteTriangleInfo( fp, model, texture, triverts, false );
+						WriteTriangleInfo( ref, fp, model, texture, triverts, false );
 					}
 					else
 					{
 						triverts[2] = triverts[1];
 						triverts[1] = (mstudiotrivert_t *)tricmds;
 
-						WriteTriangleInfo( fp, model, texture, triverts, false );
+						WriteTriangleInfo( ref, fp, model, texture, triverts, false );
 					}
 				}
 			}
@@ -419,16 +425,16 @@ static void WriteTriangles( FILE *fp, mstudiomodel_t *model )
 WriteFrameInfo
 ============
 */
-static void WriteFrameInfo( FILE *fp, mstudioanim_t *anim, mstudioseqdesc_t *seqdesc, int frame )
+static void WriteFrameInfo( const mdldec_t *ctx, FILE *fp, mstudioanim_t *anim, mstudioseqdesc_t *seqdesc, int frame )
 {
-	int			 i, j;
+	int			 i;
 	float			 scale;
 	vec_t			 motion[6]; // x, y, z, xr, yr, zr
-	mstudiobone_t		*bone = (mstudiobone_t *)( (byte *)model_hdr + model_hdr->boneindex );
+	mstudiobone_t		*bone = (mstudiobone_t *)( (byte *)ctx->model_hdr + ctx->model_hdr->boneindex );
 
 	fprintf( fp, "time %i\n", frame );
 
-	for( i = 0; i < model_hdr->numbones; ++i, ++anim, ++bone )
+	for( i = 0; i < ctx->model_hdr->numbones; ++i, ++anim, ++bone )
 	{
 		CalcBonePosition( anim, bone, motion, frame );
 
@@ -446,12 +452,9 @@ static void WriteFrameInfo( FILE *fp, mstudioanim_t *anim, mstudioseqdesc_t *seq
 
 		ClipRotations( &motion[3] );
 
-		fprintf( fp, "%3i  ", i );
-
-		for( j = 0; j < 6; j++ )
-			fprintf( fp, " %f", motion[j] );
-
-		fputs( "\n", fp );
+		fprintf( fp, "%3i   %f %f %f %f %f %f\n", i,
+		    motion[0], motion[1], motion[2],
+		    motion[3], motion[4], motion[5] );
 	}
 }
 
@@ -460,28 +463,49 @@ static void WriteFrameInfo( FILE *fp, mstudioanim_t *anim, mstudioseqdesc_t *seq
 WriteAnimations
 ============
 */
-static void WriteAnimations( FILE *fp, mstudioseqdesc_t *seqdesc, int blend )
+static void WriteAnimations( const mdldec_t *ctx, FILE *fp, mstudioseqdesc_t *seqdesc, int blend )
 {
 	int		 i;
 	mstudioanim_t	*anim;
 
 	fputs( "skeleton\n", fp );
 
-	anim = (mstudioanim_t *)( (byte *)anim_hdr[seqdesc->seqgroup] + seqdesc->animindex );
-	anim += blend * model_hdr->numbones;
+	anim = (mstudioanim_t *)( (byte *)ctx->anim_hdr[seqdesc->seqgroup] + seqdesc->animindex );
+	anim += blend * ctx->model_hdr->numbones;
 
 	for( i = 0; i < seqdesc->numframes; i++ )
-		WriteFrameInfo( fp, anim, seqdesc, i );
+		WriteFrameInfo( ctx, fp, anim, seqdesc, i );
 
 	fputs( "end\n", fp );
 }
 
+/*
+============
+OpenSMD
+============
+*/
+static FILE *OpenSMD( const char *filename )
+{
+	FILE	*fp = fopen( filename, "w" );
+
+	if( !fp )
+	{
+		fprintf( stderr, "ERROR: Couldn't write %s\n", filename );
+		return NULL;
+	}
+
+	// frames are written line by line, don't let stdio flush every few lines
+	setvbuf( fp, NULL, _IOFBF, SMD_BUFFER_SIZE );
+
+	return fp;
+}
+
 /*
 ============
 WriteReferences
 ============
 */
-static void WriteReferences( void )
+void WriteReferences( const mdldec_t *ctx )
 {
 	int			 i, j;
 	int			 len;
@@ -489,32 +513,36 @@ static void WriteReferences( void )
 	mstudiomodel_t		*model;
 	mstudiobodyparts_t	*bodypart;
 	char			 filename[MAX_SYSPATH];
+	smdref_t		 ref;
 
-	if( !CreateBoneTransformMatrices( &bonetransform ) )
+	memset( &ref, 0, sizeof( ref ));
+	ref.ctx = ctx;
+
+	if( !CreateBoneTransformMatrices( ctx, &ref.bonetransform ) )
 		return;
 
-	FillBoneTransformMatrices();
+	FillBoneTransformMatrices( ctx, ref.bonetransform );
 
-	if( model_hdr->flags & STUDIO_HAS_BONEINFO )
+	if( ctx->model_hdr->flags & STUDIO_HAS_BONEINFO )
 	{
-		if( !CreateBoneTransformMatrices( &worldtransform ) )
-			return;
+		if( !CreateBoneTransformMatrices( ctx, &ref.worldtransform ) )
+			goto _fail;
 
-		FillWorldTransformMatrices();
+		FillWorldTransformMatrices( ctx, ref.bonetransform, ref.worldtransform );
 	}
 
-	bodypart = (mstudiobodyparts_t *)( (byte *)model_hdr + model_hdr->bodypartindex );
+	bodypart = (mstudiobodyparts_t *)( (byte *)ctx->model_hdr + ctx->model_hdr->bodypartindex );
 
-	for( i = 0; i < model_hdr->numbodyparts; ++i, ++bodypart )
+	for( i = 0; i < ctx->model_hdr->numbodyparts; ++i, ++bodypart )
 	{
-		model = (mstudiomodel_t *)( (byte *)model_hdr + bodypart->modelindex );
+		model = (mstudiomodel_t *)( (byte *)ctx->model_hdr + bodypart->modelindex );
 
 		for( j = 0; j < bodypart->nummodels; ++j, ++model )
 		{
 			if( !Q_strncmp( model->name, "blank", 5 ) )
 				continue;
 
-			len = Q_snprintf( filename, MAX_SYSPATH, "%s%s.smd", destdir, model->name );
+			len = Q_snprintf( filename, MAX_SYSPATH, "%s%s.smd", ctx->destdir, model->name );
 
 			if( len == -1 )
 			{
@@ -522,19 +550,16 @@ static void WriteReferences( void )
 				goto _fail;
 			}
 
-			fp = fopen( filename, "w" );
+			fp = OpenSMD( filename );
 
 			if( !fp )
-			{
-				fprintf( stderr, "ERROR: Couldn't write %s\n", filename );
 				goto _fail;
-			}
 
 			fputs( "version 1\n", fp );
 
-			WriteNodes( fp );
-			WriteSkeleton( fp );
-			WriteTriangles( fp, model );
+			WriteNodes( ctx, fp );
+			WriteSkeleton( ctx, fp );
+			WriteTriangles( &ref, fp, model );
 
 			fclose( fp );
 
@@ -543,73 +568,101 @@ static void WriteReferences( void )
 	}
 
 _fail:
-	RemoveBoneTransformMatrices( &bonetransform );
-
-	if( model_hdr->flags & STUDIO_HAS_BONEINFO )
-		RemoveBoneTransformMatrices( &worldtransform );
+	RemoveBoneTransformMatrices( &ref.bonetransform );
+	RemoveBoneTransformMatrices( &ref.worldtransform );
 }
 
 /*
 ============
-WriteSequences
+CreateSequenceDirectory
 ============
 */
-static void WriteSequences( void )
+qboolean CreateSequenceDirectory( const mdldec_t *ctx )
 {
-	int			 i, j;
-	int			 len, namelen, emptyplace;
-	FILE			*fp;
-	char			 path[MAX_SYSPATH];
-	mstudioseqdesc_t	*seqdesc = (mstudioseqdesc_t *)( (byte *)model_hdr + model_hdr->seqindex );
+	char	path[MAX_SYSPATH];
+	int	len;
 
-	len = Q_snprintf( path, MAX_SYSPATH, "%s" DEFAULT_SEQUENCEPATH, destdir );
+	len = Q_snprintf( path, MAX_SYSPATH, "%s" DEFAULT_SEQUENCEPATH, ctx->destdir );
 
 	if( len == -1 || !MakeDirectory( path ))
 	{
 		fputs( "ERROR: Destination path is too long or write permission denied. Couldn't create directory for sequences\n", stderr );
-		return;
+		return false;
 	}
 
+	return true;
+}
+
+/*
+============
+WriteSequence
+
+sequence directory must be created already
+============
+*/
+qboolean WriteSequence( const mdldec_t *ctx, int sequence )
+{
+	int			 i;
+	int			 len, namelen, emptyplace;
+	FILE			*fp;
+	char			 path[MAX_SYSPATH];
+	mstudioseqdesc_t	*seqdesc = (mstudioseqdesc_t *)( (byte *)ctx->model_hdr + ctx->model_hdr->seqindex ) + sequence;
+
+	len = Q_snprintf( path, MAX_SYSPATH, "%s" DEFAULT_SEQUENCEPATH, ctx->destdir );
 	emptyplace = MAX_SYSPATH - len;
 
-	for( i = 0; i < model_hdr->numseq; ++i, ++seqdesc )
+	for( i = 0; i < seqdesc->numblends; i++ )
 	{
-		for( j = 0; j < seqdesc->numblends; j++ )
-		{
-			if( seqdesc->numblends == 1 )
-				namelen = Q_snprintf( &path[len], emptyplace, "%s.smd", seqdesc->label );
-			else
-				namelen = Q_snprintf( &path[len], emptyplace, "%s_blend%02i.smd", seqdesc->label, j + 1 );
+		if( seqdesc->numblends == 1 )
+			namelen = Q_snprintf( &path[len], emptyplace, "%s.smd", seqdesc->label );
+		else
+			namelen = Q_snprintf( &path[len], emptyplace, "%s_blend%02i.smd", seqdesc->label, i + 1 );
 
-			if( namelen == -1 )
-			{
-				fprintf( stderr, "ERROR: Destination path is too long. Couldn't write %s.smd\n", seqdesc->label );
-				return;
-			}
+		if( namelen == -1 )
+		{
+			fprintf( stderr, "ERROR: Destination path is too long. Couldn't write %s.smd\n", seqdesc->label );
+			return false;
+		}
 
-			fp = fopen( path, "w" );
+		fp = OpenSMD( path );
 
-			if( !fp )
-			{
-				fprintf( stderr, "ERROR: Couldn't write %s\n", path );
-				return;
-			}
+		if( !fp )
+			return false;
 
-			fputs( "version 1\n", fp );
+		fputs( "version 1\n", fp );
 
-			WriteNodes( fp );
-			WriteAnimations( fp, seqdesc, j );
+		WriteNodes( ctx, fp );
+		WriteAnimations( ctx, fp, seqdesc, i );
 
-			fclose( fp );
+		fclose( fp );
 
-			printf( "Sequence: %s\n", path );
-		}
+		printf( "Sequence: %s\n", path );
 	}
+
+	return true;
 }
 
-void WriteSMD( void )
+/*
+============
+WriteSequences
+============
+*/
+static void WriteSequences( const mdldec_t *ctx )
 {
-	WriteReferences();
-	WriteSequences();
+	int	i;
+
+	if( !CreateSequenceDirectory( ctx ))
+		return;
+
+	for( i = 0; i < ctx->model_hdr->numseq; i++ )
+	{
+		if( !WriteSequence( ctx, i ))
+			return;
+	}
 }
 
+void WriteSMD( const mdldec_t *ctx )
+{
+	WriteReferences( ctx );
+	WriteSequences( ctx );
+}
@@ -18,7 +18,10 @@ GNU General Public License for more details.
 
 #define DEFAULT_SEQUENCEPATH	"anims/"
 
-void	WriteSMD( void );
+void		WriteReferences( const mdldec_t *ctx );
+qboolean	CreateSequenceDirectory( const mdldec_t *ctx );
+qboolean	WriteSequence( const mdldec_t *ctx, int sequence );
+void		WriteSMD( const mdldec_t *ctx );
 
 #endif // SMD_H
 
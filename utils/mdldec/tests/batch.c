@@ -0,0 +1,540 @@
+/*
+batch.c - batch and serial decompilation must give identical output
+Copyright (C) 2026 FWGS
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+*/
+
+// drive the real command line, so both modes go through the same code as users do
+#define main mdldec_main
+int mdldec_main( int argc, char *argv[] );
+#include "mdldec.c"
+#undef main
+
+#include "xash3d_mathlib.h"
+
+#define SRC_DIR		"mdldec_src"
+#define SERIAL_DIR	"mdldec_serial"
+#define NUM_MODELS	6
+#define NUM_BONES	3
+#define NUM_TEXTURES	2
+#define MAX_SEQUENCES	6
+#define MAX_MODEL_SIZE	( 256 * 1024 )
+
+static const int g_threads[] = { 1, 3, 16 };
+
+static const char *g_bonenames[NUM_BONES] = { "Bip01", "Bip01 Spine", "Bip01 Head" };
+
+typedef struct
+{
+	byte	*data;
+	int	 size;
+} modelbuf_t;
+
+/*
+============
+Alloc
+
+zero filled, offsets are kept 4-byte aligned like studiomdl does
+============
+*/
+static int Alloc( modelbuf_t *buf, int size )
+{
+	int	ofs = buf->size;
+
+	buf->size += ( size + 3 ) & ~3;
+
+	if( buf->size > MAX_MODEL_SIZE )
+	{
+		printf( "model buffer overflow\n" );
+		exit( EXIT_FAILURE );
+	}
+
+	return ofs;
+}
+
+#define PTR( buf, type, ofs ) ((type *)((buf)->data + (ofs)))
+
+static int NumSequences( int n )
+{
+	return 1 + n % MAX_SEQUENCES;
+}
+
+static int NumFrames( int n, int seq )
+{
+	return 1 + ( seq * 7 + n * 3 ) % 12;
+}
+
+static int NumBlends( int n, int seq )
+{
+	return seq == 1 ? 2 : 1;
+}
+
+/*
+============
+AddAnimations
+
+some channels are static, others have a couple of rle runs
+============
+*/
+static int AddAnimations( modelbuf_t *buf, int n, int seq )
+{
+	int			 animindex, ofs, frames, blend, bone, ch, j, run;
+	int			 numblends = NumBlends( n, seq );
+	mstudioanimvalue_t	*value;
+
+	frames = NumFrames( n, seq );
+	animindex = Alloc( buf, numblends * NUM_BONES * sizeof( mstudioanim_t ));
+
+	for( blend = 0; blend < numblends; blend++ )
+	{
+		for( bone = 0; bone < NUM_BONES; bone++ )
+		{
+			int	animofs = animindex + ( blend * NUM_BONES + bone ) * sizeof( mstudioanim_t );
+
+			for( ch = 0; ch < 6; ch++ )
+			{
+				if(( bone + ch + seq + blend ) % 3 == 0 )
+					continue;
+
+				run = Q_min( frames, 4 );
+
+				// first run has all values, second one repeats the last value
+				ofs = Alloc( buf, ( run + 3 ) * sizeof( mstudioanimvalue_t ));
+				value = PTR( buf, mstudioanimvalue_t, ofs );
+
+				value[0].num.valid = run;
+				value[0].num.total = run;
+
+				for( j = 0; j < run; j++ )
+					value[j + 1].value = ( n + 1 ) * 37 - ( bone * 11 + ch * 5 + j * 13 + blend * 17 );
+
+				value[run + 1].num.valid = 1;
+				value[run + 1].num.total = frames - run + 1;
+				value[run + 2].value = n * 3 - ch;
+
+				PTR( buf, mstudioanim_t, animofs )->offset[ch] = ofs - animofs;
+			}
+		}
+	}
+
+	return animindex;
+}
+
+/*
+============
+AddMesh
+
+one strip and one fan, covers both tricmd paths and the odd/even strip order
+============
+*/
+static int AddMesh( modelbuf_t *buf, int n, int m )
+{
+	static const short	strip[] = { 0, 1, 2, 3 };
+	static const short	fan[] = { 3, 2, 0 };
+	int			meshindex, triindex, i;
+	short			*cmd;
+	mstudiomesh_t		*mesh;
+
+	meshindex = Alloc( buf, sizeof( mstudiomesh_t ));
+	triindex = Alloc( buf, ( 1 + 4 * 4 + 1 + 3 * 4 + 1 ) * sizeof( short ));
+
+	cmd = PTR( buf, short, triindex );
+
+	*cmd++ = 4;
+
+	for( i = 0; i < 4; i++ )
+	{
+		*cmd++ = strip[i];
+		*cmd++ = strip[i];
+		*cmd++ = ( i & 1 ) * 7 + n;
+		*cmd++ = ( i >> 1 ) * 3 + m;
+	}
+
+	*cmd++ = -3;
+
+	for( i = 0; i < 3; i++ )
+	{
+		*cmd++ = fan[i];
+		*cmd++ = fan[i];
+		*cmd++ = i * 2;
+		*cmd++ = 3 - i;
+	}
+
+	*cmd = 0;
+
+	mesh = PTR( buf, mstudiomesh_t, meshindex );
+	mesh->numtris = 3;
+	mesh->triindex = triindex;
+	mesh->skinref = ( n + m ) % NUM_TEXTURES;
+	mesh->numnorms = 4;
+
+	return meshindex;
+}
+
+/*
+============
+AddModel
+============
+*/
+static void AddModel( modelbuf_t *buf, int modelindex, const char *name, int n, int m )
+{
+	int		vertinfoindex, vertindex, normindex, meshindex, i;
+	mstudiomodel_t	*model;
+	vec_t		*v;
+
+	vertinfoindex = Alloc( buf, 4 );
+	vertindex = Alloc( buf, 4 * sizeof( vec3_t ));
+	normindex = Alloc( buf, 4 * sizeof( vec3_t ));
+	meshindex = AddMesh( buf, n, m );
+
+	for( i = 0; i < 4; i++ )
+	{
+		PTR( buf, byte, vertinfoindex )[i] = ( i + m ) % NUM_BONES;
+
+		v = PTR( buf, vec_t, vertindex + i * sizeof( vec3_t ));
+		VectorSet( v, i * 4.0f + n, ( i & 1 ) * 8.0f - m, ( i >> 1 ) * 16.0f );
+
+		v = PTR( buf, vec_t, normindex + i * sizeof( vec3_t ));
+		VectorSet( v, i & 1, ( i >> 1 ) & 1, 1.0f );
+	}
+
+	model = PTR( buf, mstudiomodel_t, modelindex );
+	Q_strncpy( model->name, name, sizeof( model->name ));
+	model->nummesh = 1;
+	model->meshindex = meshindex;
+	model->numverts = 4;
+	model->vertinfoindex = vertinfoindex;
+	model->vertindex = vertindex;
+	model->numnorms = 4;
+	model->norminfoindex = vertinfoindex;
+	model->normindex = normindex;
+}
+
+/*
+============
+WriteModel
+============
+*/
+static qboolean WriteModel( const char *filename, int n )
+{
+	modelbuf_t		 buf;
+	studiohdr_t		*hdr;
+	mstudiobone_t		*bone;
+	mstudioseqdesc_t	*seqdesc;
+	mstudiobodyparts_t	*bodypart;
+	mstudiotexture_t	*texture;
+	int			 i, j, ofs, numseq = NumSequences( n );
+	char			 name[64];
+	FILE			*f;
+
+	buf.data = calloc( 1, MAX_MODEL_SIZE );
+	buf.size = 0;
+
+	if( !buf.data )
+		return false;
+
+	Alloc( &buf, sizeof( studiohdr_t ));
+
+	hdr = PTR( &buf, studiohdr_t, 0 );
+	hdr->ident = IDSTUDIOHEADER;
+	hdr->version = STUDIO_VERSION;
+	Q_snprintf( hdr->name, sizeof( hdr->name ), "models/test/model%d.mdl", n );
+	VectorSet( hdr->eyeposition, 0.0f, 0.0f, 28.0f + n );
+	VectorSet( hdr->min, -16.0f, -16.0f, 0.0f );
+	VectorSet( hdr->max, 16.0f, 16.0f, 72.0f );
+
+	hdr->numbones = NUM_BONES;
+	hdr->boneindex = Alloc( &buf, NUM_BONES * sizeof( mstudiobone_t ));
+
+	for( i = 0; i < NUM_BONES; i++ )
+	{
+		bone = PTR( &buf, mstudiobone_t, hdr->boneindex ) + i;
+		Q_strncpy( bone->name, g_bonenames[i], sizeof( bone->name ));
+		bone->parent = i - 1;
+
+		for( j = 0; j < 6; j++ )
+		{
+			bone->bonecontroller[j] = -1;
+			bone->value[j] = ( j < 3 ) ? ( i * 3 + j + n ) * 1.5f : ( i + j - n ) * 0.25f;
+			bone->scale[j] = ( j < 3 ) ? 0.01f * ( j + 1 ) : 0.0005f * ( j + n + 1 );
+		}
+	}
+
+	hdr->numseqgroups = 1;
+	hdr->seqgroupindex = Alloc( &buf, sizeof( mstudioseqgroup_t ));
+	Q_strncpy( PTR( &buf, mstudioseqgroup_t, hdr->seqgroupindex )->label, "default", MAXSTUDIONAME );
+
+	hdr->numseq = numseq;
+	hdr->seqindex = Alloc( &buf, numseq * sizeof( mstudioseqdesc_t ));
+
+	for( i = 0; i < numseq; i++ )
+	{
+		ofs = AddAnimations( &buf, n, i );
+
+		seqdesc = PTR( &buf, mstudioseqdesc_t, hdr->seqindex ) + i;
+
+		Q_snprintf( seqdesc->label, sizeof( seqdesc->label ), "seq%d", i );
+
+		seqdesc->fps = 10.0f + i * 5;
+		seqdesc->flags = i & 1;
+		seqdesc->activity = i % 4;
+		seqdesc->actweight = i;
+		seqdesc->numframes = NumFrames( n, i );
+		seqdesc->motiontype = ( i & 1 ) ? STUDIO_LX : 0;
+		VectorSet( seqdesc->linearmovement, i * 10.0f, 0.0f, 0.0f );
+		seqdesc->numblends = NumBlends( n, i );
+		seqdesc->animindex = ofs;
+		seqdesc->blendtype[0] = STUDIO_XR;
+		seqdesc->blendstart[0] = -45.0f;
+		seqdesc->blendend[0] = 45.0f;
+		seqdesc->entrynode = seqdesc->exitnode = i % 2;
+	}
+
+	hdr->numtextures = NUM_TEXTURES;
+	hdr->textureindex = Alloc( &buf, NUM_TEXTURES * sizeof( mstudiotexture_t ));
+
+	for( i = 0; i < NUM_TEXTURES; i++ )
+	{
+		int	width = 8 << i, height = 4;
+
+		ofs = Alloc( &buf, width * height + 768 );
+
+		for( j = 0; j < width * height + 768; j++ )
+			PTR( &buf, byte, ofs )[j] = (byte)( j * 7 + n * 31 + i );
+
+		texture = PTR( &buf, mstudiotexture_t, hdr->textureindex ) + i;
+		Q_snprintf( texture->name, sizeof( texture->name ), i ? "glow%d.tga" : "skin%d.bmp", n );
+		texture->flags = i ? STUDIO_NF_ADDITIVE : 0;
+		texture->width = width;
+		texture->height = height;
+		texture->index = ofs;
+	}
+
+	// two families with swapped textures
+	hdr->numskinref = NUM_TEXTURES;
+	hdr->numskinfamilies = 2;
+	hdr->skinindex = Alloc( &buf, 4 * sizeof( short ));
+	PTR( &buf, short, hdr->skinindex )[0] = 0;
+	PTR( &buf, short, hdr->skinindex )[1] = 1;
+	PTR( &buf, short, hdr->skinindex )[2] = 1;
+	PTR( &buf, short, hdr->skinindex )[3] = 0;
+
+	hdr->numbodyparts = 2;
+	hdr->bodypartindex = Alloc( &buf, 2 * sizeof( mstudiobodyparts_t ));
+
+	for( i = 0; i < 2; i++ )
+	{
+		ofs = Alloc( &buf, 2 * sizeof( mstudiomodel_t ));
+
+		bodypart = PTR( &buf, mstudiobodyparts_t, hdr->bodypartindex ) + i;
+		Q_strncpy( bodypart->name, i ? "head" : "studio", sizeof( bodypart->name ));
+		bodypart->nummodels = 2;
+		bodypart->base = i + 1;
+		bodypart->modelindex = ofs;
+
+		for( j = 0; j < 2; j++ )
+		{
+			if( i && j )
+				Q_strncpy( name, "blank", sizeof( name ));
+			else
+				Q_snprintf( name, sizeof( name ), "part%d_%d_ref", i, j );
+
+			AddModel( &buf, ofs + j * sizeof( mstudiomodel_t ), name, n, i * 2 + j );
+		}
+	}
+
+	hdr = PTR( &buf, studiohdr_t, 0 );
+	hdr->length = buf.size;
+
+	f = fopen( filename, "wb" );
+
+	if( !f )
+	{
+		free( buf.data );
+		return false;
+	}
+
+	fwrite( buf.data, buf.size, 1, f );
+	fclose( f );
+	free( buf.data );
+
+	return true;
+}
+
+/*
+============
+CompareFile
+============
+*/
+static qboolean CompareFile( const char *serialdir, const char *batchdir, const char *name )
+{
+	char	path1[MAX_SYSPATH], path2[MAX_SYSPATH];
+	byte	*data1, *data2;
+	off_t	size1, size2;
+	qboolean	ret;
+
+	Q_snprintf( path1, sizeof( path1 ), "%s/%s", serialdir, name );
+	Q_snprintf( path2, sizeof( path2 ), "%s/%s", batchdir, name );
+
+	data1 = LoadFile( path1, &size1 );
+	data2 = LoadFile( path2, &size2 );
+
+	ret = data1 && data2 && size1 > 0 && size1 == size2 && !memcmp( data1, data2, size1 );
+
+	if( !ret )
+		printf( "%s and %s differ\n", path1, path2 );
+
+	free( data1 );
+	free( data2 );
+
+	return ret;
+}
+
+/*
+============
+CompareModel
+
+every file serial run writes must exist in batch output and be equal
+============
+*/
+static qboolean CompareModel( int n, const char *batchroot )
+{
+	char	serialdir[MAX_SYSPATH], batchdir[MAX_SYSPATH], name[MAX_SYSPATH];
+	int	i, j, numseq = NumSequences( n );
+
+	Q_snprintf( serialdir, sizeof( serialdir ), SERIAL_DIR "/model%d", n );
+	Q_snprintf( batchdir, sizeof( batchdir ), "%s/model%d", batchroot, n );
+
+	Q_snprintf( name, sizeof( name ), "model%d.qc", n );
+
+	if( !CompareFile( serialdir, batchdir, name ))
+		return false;
+
+	// blank model gets no reference
+	if( !CompareFile( serialdir, batchdir, "part0_0_ref.smd" )
+		|| !CompareFile( serialdir, batchdir, "part0_1_ref.smd" )
+		|| !CompareFile( serialdir, batchdir, "part1_0_ref.smd" ))
+		return false;
+
+	Q_snprintf( name, sizeof( name ), DEFAULT_TEXTUREPATH "skin%d.bmp", n );
+
+	if( !CompareFile( serialdir, batchdir, name ))
+		return false;
+
+	Q_snprintf( name, sizeof( name ), DEFAULT_TEXTUREPATH "glow%d.tga", n );
+
+	if( !CompareFile( serialdir, batchdir, name ))
+		return false;
+
+	for( i = 0; i < numseq; i++ )
+	{
+		for( j = 0; j < NumBlends( n, i ); j++ )
+		{
+			if( NumBlends( n, i ) == 1 )
+				Q_snprintf( name, sizeof( name ), DEFAULT_SEQUENCEPATH "seq%d.smd", i );
+			else
+				Q_snprintf( name, sizeof( name ), DEFAULT_SEQUENCEPATH "seq%d_blend%02i.smd", i, j + 1 );
+
+			if( !CompareFile( serialdir, batchdir, name ))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+============
+WriteActivities
+============
+*/
+static qboolean WriteActivities( void )
+{
+	FILE	*f = fopen( ACTIVITIES_FILE, "w" );
+
+	if( !f )
+		return false;
+
+	fputs( "ACT_RESET\nACT_IDLE\nACT_GUARD\nACT_WALK\n", f );
+	fclose( f );
+
+	return true;
+}
+
+int main( void )
+{
+	char	path[MAX_SYSPATH], target[MAX_SYSPATH], threads[16];
+	char	app[] = "mdldec", jflag[] = "-j", batchflag[] = "-batch", srcdir[] = SRC_DIR;
+	char	*argv[6];
+	int	i, j;
+
+	if( !WriteActivities() || !MakeDirectory( SRC_DIR ))
+	{
+		printf( "couldn't prepare test directory\n" );
+		return EXIT_FAILURE;
+	}
+
+	for( i = 0; i < NUM_MODELS; i++ )
+	{
+		Q_snprintf( path, sizeof( path ), SRC_DIR "/model%d.mdl", i );
+
+		if( !WriteModel( path, i ))
+		{
+			printf( "WriteModel fail\n" );
+			return EXIT_FAILURE;
+		}
+
+		Q_snprintf( target, sizeof( target ), SERIAL_DIR "/model%d", i );
+
+		argv[0] = app;
+		argv[1] = path;
+		argv[2] = target;
+
+		if( mdldec_main( 3, argv ) != 0 )
+		{
+			printf( "serial decompile of %s fail\n", path );
+			return EXIT_FAILURE;
+		}
+	}
+
+	for( i = 0; i < sizeof( g_threads ) / sizeof( g_threads[0] ); i++ )
+	{
+		Q_snprintf( threads, sizeof( threads ), "%d", g_threads[i] );
+		Q_snprintf( target, sizeof( target ), "mdldec_batch%d", g_threads[i] );
+
+		argv[0] = app;
+		argv[1] = jflag;
+		argv[2] = threads;
+		argv[3] = batchflag;
+		argv[4] = srcdir;
+		argv[5] = target;
+
+		if( mdldec_main( 6, argv ) != 0 )
+		{
+			printf( "batch decompile with %d threads fail\n", g_threads[i] );
+			return EXIT_FAILURE;
+		}
+
+		for( j = 0; j < NUM_MODELS; j++ )
+		{
+			if( !CompareModel( j, target ))
+			{
+				printf( "batch output with %d threads differs from serial\n", g_threads[i] );
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	printf( "success\n" );
+
+	return EXIT_SUCCESS;
+}
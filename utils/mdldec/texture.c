@@ -30,7 +30,7 @@ GNU General Public License for more details.
 WriteBMP
 ============
 */
-static void WriteBMP( FILE *fp, mstudiotexture_t *texture )
+static void WriteBMP( const mdldec_t *ctx, FILE *fp, mstudiotexture_t *texture )
 {
 	int		 i;
 	const byte	*p;
@@ -51,7 +51,7 @@ static void WriteBMP( FILE *fp, mstudiotexture_t *texture )
 	bmp_hdr.bitmapDataOffset = sizeof( bmp_hdr ) + sizeof( rgba_palette );
 	bmp_hdr.bitmapHeaderSize = BI_SIZE;
 
-	pic = (byte *)texture_hdr + texture->index;
+	pic = (byte *)ctx->texture_hdr + texture->index;
 	palette = pic + bmp_hdr.bitmapDataSize;
 
 	fwrite( &bmp_hdr, sizeof( bmp_hdr ), 1, fp );
@@ -83,7 +83,7 @@ static void WriteBMP( FILE *fp, mstudiotexture_t *texture )
 WriteTGA
 ============
 */
-static void WriteTGA( FILE *fp, mstudiotexture_t *texture )
+static void WriteTGA( const mdldec_t *ctx, FILE *fp, mstudiotexture_t *texture )
 {
 	int              i;
 	const byte      *p;
@@ -98,7 +98,7 @@ static void WriteTGA( FILE *fp, mstudiotexture_t *texture )
 	tga_hdr.width = texture->width;
 	tga_hdr.height = texture->height;
 
-	pic = (byte *)texture_hdr + texture->index;
+	pic = (byte *)ctx->texture_hdr + texture->index;
 	palette = pic + tga_hdr.width * tga_hdr.height;
 
 	fwrite( &tga_hdr, sizeof( tga_hdr ), 1, fp );
@@ -129,14 +129,14 @@ static void WriteTGA( FILE *fp, mstudiotexture_t *texture )
 WriteTextures
 ============
 */
-void WriteTextures( void )
+void WriteTextures( const mdldec_t *ctx )
 {
 	int			 i, len, namelen, emptyplace;
 	FILE			*fp;
-	mstudiotexture_t	*texture = (mstudiotexture_t *)( (byte *)texture_hdr + texture_hdr->textureindex );
+	mstudiotexture_t	*texture = (mstudiotexture_t *)( (byte *)ctx->texture_hdr + ctx->texture_hdr->textureindex );
 	char			 path[MAX_SYSPATH];
 
-	len = Q_snprintf( path, MAX_SYSPATH, "%s" DEFAULT_TEXTUREPATH, destdir );
+	len = Q_snprintf( path, MAX_SYSPATH, "%s" DEFAULT_TEXTUREPATH, ctx->destdir );
 
 	if( len == -1 || !MakeDirectory( path ))
 	{
@@ -146,7 +146,7 @@ void WriteTextures( void )
 
 	emptyplace = MAX_SYSPATH - len;
 
-	for( i = 0; i < texture_hdr->numtextures; ++i, ++texture )
+	for( i = 0; i < ctx->texture_hdr->numtextures; ++i, ++texture )
 	{
 		namelen = Q_strncpy( &path[len], texture->name, emptyplace );
 
@@ -165,9 +165,9 @@ void WriteTextures( void )
 		}
 
 		if( !Q_stricmp( COM_FileExtension( texture->name ), "tga" ))
-			WriteTGA( fp, texture );
+			WriteTGA( ctx, fp, texture );
 		else
-			WriteBMP( fp, texture );
+			WriteBMP( ctx, fp, texture );
 
 		fclose( fp );
 
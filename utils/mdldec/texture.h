@@ -18,7 +18,7 @@ GNU General Public License for more details.
 
 #define DEFAULT_TEXTUREPATH	"textures/"
 
-void	WriteTextures( void );
+void	WriteTextures( const mdldec_t *ctx );
 
 #endif // TEXTURE_H
 
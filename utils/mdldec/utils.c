@@ -18,6 +18,7 @@ GNU General Public License for more details.
 #include <string.h>
 #include <sys/stat.h>
 #include <errno.h>
+#include <time.h>
 #include "xash3d_types.h"
 #include "port.h"
 #include "crtlib.h"
@@ -153,3 +154,30 @@ byte *LoadFile( const char *filename, off_t *size )
 	return buf;
 }
 
+/*
+============
+GetTime
+
+monotonic time in seconds
+============
+*/
+double GetTime( void )
+{
+#if XASH_WIN32
+	static LARGE_INTEGER	freq;
+	LARGE_INTEGER		count;
+
+	if( !freq.QuadPart )
+		QueryPerformanceFrequency( &freq );
+
+	QueryPerformanceCounter( &count );
+
+	return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+	struct timespec	ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return ts.tv_sec + ts.tv_nsec * 0.000000001;
+#endif
+}
@@ -21,6 +21,7 @@ qboolean	 MakeFullPath( const char *path );
 void		 ExtractFileName( char *name, size_t size );
 off_t		 GetSizeOfFile( FILE *fp );
 byte		*LoadFile( const char *filename, off_t *size );
+double		 GetTime( void );
 
 #endif // UTILS_H
 
@@ -0,0 +1,827 @@
+/*
+pack.c -- archive creation for XAR
+Copyright (C) 2026 FWGS
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+*/
+
+#include "port.h"
+#include "build.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/stat.h>
+#if XASH_WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+#include "xash3d_types.h"
+#include "crtlib.h"
+#include "xash3d_mathlib.h"
+#include "miniz.h"
+#include "pack.h"
+
+#define IDPACKV1HEADER      (('K'<<24)+('C'<<16)+('A'<<8)+'P')
+#define PAK_MAX_NAME        56
+#define PAK_MAX_SIZE        INT_MAX
+
+#define ZIP_HEADER_LF       (('K'<<8)+('P')+(0x03<<16)+(0x04<<24))
+#define ZIP_HEADER_CDF      ((0x02<<24)+(0x01<<16)+('K'<<8)+'P')
+#define ZIP_HEADER_EOCD     ((0x06<<24)+(0x05<<16)+('K'<<8)+'P')
+#define ZIP_METHOD_STORED   0
+#define ZIP_METHOD_DEFLATED 8
+#define ZIP_VERSION         20     // 2.0, deflate
+#define ZIP_ALIGN_EXTRA_ID  0xD935 // same as Android zipalign uses
+#define ZIP_MAX_SIZE        UINT32_MAX
+#define ZIP_MAX_FILES       UINT16_MAX
+
+#define PACK_COLD           INT_MAX
+
+typedef struct
+{
+	int  ident;
+	int  dirofs;
+	int  dirlen;
+} dpackheader_t;
+
+typedef struct
+{
+	char name[PAK_MAX_NAME];
+	int  filepos;
+	int  filelen;
+} dpackfile_t;
+
+#pragma pack( push, 1 )
+typedef struct
+{
+	uint32_t signature;
+	uint16_t version_need;
+	uint16_t flags;
+	uint16_t method;
+	uint16_t mod_time;
+	uint16_t mod_date;
+	uint32_t crc32;
+	uint32_t compressed_size;
+	uint32_t uncompressed_size;
+	uint16_t filename_len;
+	uint16_t extrafield_len;
+} zip_local_t;
+
+typedef struct
+{
+	uint32_t signature;
+	uint16_t version;
+	uint16_t version_need;
+	uint16_t flags;
+	uint16_t method;
+	uint16_t mod_time;
+	uint16_t mod_date;
+	uint32_t crc32;
+	uint32_t compressed_size;
+	uint32_t uncompressed_size;
+	uint16_t filename_len;
+	uint16_t extrafield_len;
+	uint16_t comment_len;
+	uint16_t disk_start;
+	uint16_t internal_attr;
+	uint32_t external_attr;
+	uint32_t local_header_offset;
+} zip_cdf_t;
+
+typedef struct
+{
+	uint32_t signature;
+	uint16_t disk_number;
+	uint16_t start_disk_number;
+	uint16_t number_central_directory_record;
+	uint16_t total_central_directory_record;
+	uint32_t size_of_central_directory;
+	uint32_t central_directory_offset;
+	uint16_t comment_len;
+} zip_eocd_t;
+
+typedef struct
+{
+	uint16_t id;
+	uint16_t size;
+	uint16_t alignment;
+} zip_align_extra_t;
+#pragma pack( pop )
+
+typedef struct pack_entry_s
+{
+	char     name[MAX_SYSPATH]; // relative to packed directory, forward slashes
+	uint64_t size;
+	time_t   mtime;
+	int      order; // position in access trace, PACK_COLD if never accessed
+
+	// filled when written
+	uint32_t offset; // PAK: data offset, ZIP: local header offset
+	uint32_t compressed_size;
+	uint32_t crc32;
+	uint16_t method;
+} pack_entry_t;
+
+typedef struct pack_s
+{
+	const pack_options_t *options;
+	char     directory[MAX_SYSPATH];
+	FILE     *f;
+	uint64_t pos;
+
+	pack_entry_t *entries;
+	int      numentries;
+	int      maxentries;
+
+	// statistics
+	int      numhot;
+	int      numaligned;
+	int      numdeflated;
+	uint64_t padding;
+} pack_t;
+
+/*
+============
+Pack_AddEntry
+============
+*/
+static qboolean Pack_AddEntry( pack_t *pack, const char *name, const struct stat *st )
+{
+	pack_entry_t *e;
+
+	if( pack->numentries == pack->maxentries )
+	{
+		pack_entry_t *entries;
+
+		pack->maxentries = pack->maxentries ? pack->maxentries * 2 : 256;
+		entries = realloc( pack->entries, sizeof( *entries ) * pack->maxentries );
+
+		if( !entries )
+		{
+			printf( "Out of memory\n" );
+			return false;
+		}
+
+		pack->entries = entries;
+	}
+
+	e = &pack->entries[pack->numentries++];
+	memset( e, 0, sizeof( *e ));
+	Q_strncpy( e->name, name, sizeof( e->name ));
+	e->size = st->st_size;
+	e->mtime = st->st_mtime;
+	e->order = PACK_COLD;
+
+	return true;
+}
+
+static qboolean Pack_ScanDirectory( pack_t *pack, const char *subdir );
+
+/*
+============
+Pack_ScanFile
+============
+*/
+static qboolean Pack_ScanFile( pack_t *pack, const char *subdir, const char *filename )
+{
+	char name[MAX_SYSPATH], path[MAX_SYSPATH];
+	struct stat st;
+
+	if( !Q_strcmp( filename, "." ) || !Q_strcmp( filename, ".." ))
+		return true;
+
+	if( subdir[0] )
+		Q_snprintf( name, sizeof( name ), "%s/%s", subdir, filename );
+	else Q_strncpy( name, filename, sizeof( name ));
+
+	Q_snprintf( path, sizeof( path ), "%s/%s", pack->directory, name );
+
+	if( stat( path, &st ) != 0 )
+	{
+		printf( "Can't stat %s: %s\n", path, strerror( errno ));
+		return false;
+	}
+
+	if( S_ISDIR( st.st_mode ))
+		return Pack_ScanDirectory( pack, name );
+
+	if( !S_ISREG( st.st_mode ))
+		return true;
+
+	return Pack_AddEntry( pack, name, &st );
+}
+
+/*
+============
+Pack_ScanDirectory
+
+recursively collects all regular files
+============
+*/
+static qboolean Pack_ScanDirectory( pack_t *pack, const char *subdir )
+{
+	char path[MAX_SYSPATH];
+	qboolean ok = true;
+#if XASH_WIN32
+	WIN32_FIND_DATAA fd;
+	HANDLE h;
+
+	Q_snprintf( path, sizeof( path ), "%s/%s/*", pack->directory, subdir );
+
+	if(( h = FindFirstFileA( path, &fd )) == INVALID_HANDLE_VALUE )
+	{
+		printf( "Can't open directory %s\n", path );
+		return false;
+	}
+
+	do
+	{
+		ok = Pack_ScanFile( pack, subdir, fd.cFileName );
+	} while( ok && FindNextFileA( h, &fd ));
+
+	FindClose( h );
+#else
+	struct dirent *entry;
+	DIR *dir;
+
+	Q_snprintf( path, sizeof( path ), "%s/%s", pack->directory, subdir );
+
+	if(( dir = opendir( path )) == NULL )
+	{
+		printf( "Can't open directory %s: %s\n", path, strerror( errno ));
+		return false;
+	}
+
+	while( ok && ( entry = readdir( dir )) != NULL )
+		ok = Pack_ScanFile( pack, subdir, entry->d_name );
+
+	closedir( dir );
+#endif
+	return ok;
+}
+
+static int Pack_CompareNames( const void *a, const void *b )
+{
+	return Q_stricmp( ((const pack_entry_t *)a)->name, ((const pack_entry_t *)b)->name );
+}
+
+static int Pack_CompareLayout( const void *a, const void *b )
+{
+	const pack_entry_t *ea = a, *eb = b;
+
+	// traced files go first in access order, the rest is sorted by name
+	if( ea->order != eb->order )
+		return ea->order < eb->order ? -1 : 1;
+
+	return Q_stricmp( ea->name, eb->name );
+}
+
+/*
+============
+Pack_ApplyTrace
+
+marks files from access trace as hot, in order of first access
+============
+*/
+static qboolean Pack_ApplyTrace( pack_t *pack, const char *tracefile )
+{
+	char line[MAX_SYSPATH];
+	pack_entry_t key, *e;
+	FILE *f;
+
+	if(( f = fopen( tracefile, "rb" )) == NULL )
+	{
+		printf( "Can't open trace %s: %s\n", tracefile, strerror( errno ));
+		return false;
+	}
+
+	qsort( pack->entries, pack->numentries, sizeof( *pack->entries ), Pack_CompareNames );
+
+	while( fgets( line, sizeof( line ), f ))
+	{
+		line[strcspn( line, "\r\n" )] = '\0';
+		COM_FixSlashes( line );
+
+		Q_strncpy( key.name, line, sizeof( key.name ));
+		e = bsearch( &key, pack->entries, pack->numentries, sizeof( *pack->entries ), Pack_CompareNames );
+
+		// files from other search paths or already seen
+		if( !e || e->order != PACK_COLD )
+			continue;
+
+		e->order = pack->numhot++;
+	}
+
+	fclose( f );
+	return true;
+}
+
+/*
+============
+Pack_LoadEntry
+============
+*/
+static byte *Pack_LoadEntry( pack_t *pack, const pack_entry_t *e )
+{
+	char path[MAX_SYSPATH];
+	byte *data;
+	FILE *f;
+
+	Q_snprintf( path, sizeof( path ), "%s/%s", pack->directory, e->name );
+
+	if(( f = fopen( path, "rb" )) == NULL )
+	{
+		printf( "Can't open %s: %s\n", path, strerror( errno ));
+		return NULL;
+	}
+
+	data = malloc( e->size ? e->size : 1 );
+
+	if( !data || fread( data, 1, e->size, f ) != e->size )
+	{
+		printf( "Can't read %s\n", path );
+		free( data );
+		fclose( f );
+		return NULL;
+	}
+
+	fclose( f );
+	return data;
+}
+
+/*
+============
+Pack_Write
+============
+*/
+static qboolean Pack_Write( pack_t *pack, const void *data, size_t size )
+{
+	if( size && fwrite( data, 1, size, pack->f ) != size )
+	{
+		printf( "Write error: %s\n", strerror( errno ));
+		return false;
+	}
+
+	pack->pos += size;
+	return true;
+}
+
+/*
+============
+Pack_WritePadding
+============
+*/
+static qboolean Pack_WritePadding( pack_t *pack, size_t size )
+{
+	static const byte zeroes[1024];
+
+	pack->padding += size;
+
+	while( size > 0 )
+	{
+		size_t len = Q_min( size, sizeof( zeroes ));
+
+		if( !Pack_Write( pack, zeroes, len ))
+			return false;
+
+		size -= len;
+	}
+
+	return true;
+}
+
+/*
+============
+Pack_ShouldAlign
+
+large stored entries are placed on page boundary, so they can be mapped
+============
+*/
+static qboolean Pack_ShouldAlign( const pack_t *pack, const pack_entry_t *e )
+{
+	return pack->options->align > 1 && e->size >= PACK_LARGE_ENTRY;
+}
+
+/*
+============
+Pack_PaddingFor
+
+returns padding needed to place data at aligned offset
+============
+*/
+static size_t Pack_PaddingFor( const pack_t *pack, uint64_t dataofs )
+{
+	int align = pack->options->align;
+
+	return ( align - dataofs % align ) % align;
+}
+
+/*
+============
+Pack_WritePAK
+============
+*/
+static qboolean Pack_WritePAK( pack_t *pack )
+{
+	dpackheader_t header;
+	dpackfile_t *dir;
+	int i;
+
+	// header is written again when directory offset is known
+	memset( &header, 0, sizeof( header ));
+
+	if( !Pack_Write( pack, &header, sizeof( header )))
+		return false;
+
+	dir = calloc( pack->numentries, sizeof( *dir ));
+
+	for( i = 0; i < pack->numentries; i++ )
+	{
+		pack_entry_t *e = &pack->entries[i];
+		size_t pad = 0;
+		byte *data;
+
+		if( Q_strlen( e->name ) >= PAK_MAX_NAME )
+		{
+			printf( "Name is too long for PAK: %s\n", e->name );
+			free( dir );
+			return false;
+		}
+
+		if( Pack_ShouldAlign( pack, e ))
+		{
+			pad = Pack_PaddingFor( pack, pack->pos );
+
+			if( !Pack_WritePadding( pack, pad ))
+			{
+				free( dir );
+				return false;
+			}
+			pack->numaligned++;
+		}
+
+		if( pack->pos + e->size > PAK_MAX_SIZE )
+		{
+			printf( "PAK can't be larger than 2GB\n" );
+			free( dir );
+			return false;
+		}
+
+		if(( data = Pack_LoadEntry( pack, e )) == NULL )
+		{
+			free( dir );
+			return false;
+		}
+
+		Q_strncpy( dir[i].name, e->name, sizeof( dir[i].name ));
+		dir[i].filepos = e->offset = pack->pos;
+		dir[i].filelen = e->compressed_size = e->size;
+
+		if( !Pack_Write( pack, data, e->size ))
+		{
+			free( data );
+			free( dir );
+			return false;
+		}
+
+		free( data );
+	}
+
+	header.ident = IDPACKV1HEADER;
+	header.dirofs = pack->pos;
+	header.dirlen = sizeof( *dir ) * pack->numentries;
+
+	if( !Pack_Write( pack, dir, header.dirlen ))
+	{
+		free( dir );
+		return false;
+	}
+
+	free( dir );
+	fseek( pack->f, 0, SEEK_SET );
+
+	return Pack_Write( pack, &header, sizeof( header ));
+}
+
+/*
+============
+Pack_Deflate
+
+raw deflate stream, as zip wants
+============
+*/
+static byte *Pack_Deflate( const byte *data, uint32_t size, uint32_t *outsize )
+{
+	mz_stream stream;
+	mz_ulong bound;
+	byte *out;
+
+	memset( &stream, 0, sizeof( stream ));
+
+	if( mz_deflateInit2( &stream, MZ_DEFAULT_LEVEL, MZ_DEFLATED, -MZ_DEFAULT_WINDOW_BITS, 9, MZ_DEFAULT_STRATEGY ) != MZ_OK )
+		return NULL;
+
+	bound = mz_deflateBound( &stream, size );
+
+	if(( out = malloc( bound )) == NULL )
+	{
+		mz_deflateEnd( &stream );
+		return NULL;
+	}
+
+	stream.next_in = data;
+	stream.avail_in = size;
+	stream.next_out = out;
+	stream.avail_out = bound;
+
+	if( mz_deflate( &stream, MZ_FINISH ) != MZ_STREAM_END )
+	{
+		mz_deflateEnd( &stream );
+		free( out );
+		return NULL;
+	}
+
+	*outsize = stream.total_out;
+	mz_deflateEnd( &stream );
+
+	return out;
+}
+
+/*
+============
+Pack_DosTime
+============
+*/
+static void Pack_DosTime( time_t t, uint16_t *dostime, uint16_t *dosdate )
+{
+	struct tm *tm = localtime( &t );
+
+	if( !tm || tm->tm_year < 80 )
+	{
+		// DOS epoch, 1980-01-01
+		*dostime = 0;
+		*dosdate = ( 1 << 5 ) | 1;
+		return;
+	}
+
+	*dostime = ( tm->tm_hour << 11 ) | ( tm->tm_min << 5 ) | ( tm->tm_sec >> 1 );
+	*dosdate = (( tm->tm_year - 80 ) << 9 ) | (( tm->tm_mon + 1 ) << 5 ) | tm->tm_mday;
+}
+
+/*
+============
+Pack_WriteZIPEntry
+============
+*/
+static qboolean Pack_WriteZIPEntry( pack_t *pack, pack_entry_t *e )
+{
+	zip_local_t local;
+	zip_align_extra_t extra;
+	const byte *payload;
+	byte *data, *deflated = NULL;
+	size_t namelen = Q_strlen( e->name ), pad = 0;
+	uint16_t mod_time, mod_date;
+	qboolean ok, aligned;
+
+	if(( data = Pack_LoadEntry( pack, e )) == NULL )
+		return false;
+
+	e->crc32 = mz_crc32( MZ_CRC32_INIT, data, e->size );
+	e->method = ZIP_METHOD_STORED;
+	e->compressed_size = e->size;
+	payload = data;
+
+	// hot files are read on level load, keep them cheap to open
+	// cold ones are compressed if it's worth it
+	if( e->order == PACK_COLD && !pack->options->store && e->size > 0 )
+	{
+		uint32_t size;
+
+		deflated = Pack_Deflate( data, e->size, &size );
+
+		if( deflated && size < e->size - e->size / 8 )
+		{
+			e->method = ZIP_METHOD_DEFLATED;
+			e->compressed_size = size;
+			payload = deflated;
+			pack->numdeflated++;
+		}
+	}
+
+	e->offset = pack->pos;
+
+	// stored data can be mapped directly, pad the extra field so it starts on page boundary
+	aligned = e->method == ZIP_METHOD_STORED && Pack_ShouldAlign( pack, e );
+
+	if( aligned )
+	{
+		pad = Pack_PaddingFor( pack, pack->pos + sizeof( local ) + namelen + sizeof( extra ));
+		pack->numaligned++;
+	}
+
+	if( pack->pos + sizeof( local ) + namelen + sizeof( extra ) + pad + e->compressed_size > ZIP_MAX_SIZE )
+	{
+		printf( "ZIP can't be larger than 4GB\n" );
+		free( deflated );
+		free( data );
+		return false;
+	}
+
+	Pack_DosTime( e->mtime, &mod_time, &mod_date );
+
+	memset( &local, 0, sizeof( local ));
+	local.signature = ZIP_HEADER_LF;
+	local.version_need = ZIP_VERSION;
+	local.method = e->method;
+	local.mod_time = mod_time;
+	local.mod_date = mod_date;
+	local.crc32 = e->crc32;
+	local.compressed_size = e->compressed_size;
+	local.uncompressed_size = e->size;
+	local.filename_len = namelen;
+
+	if( aligned )
+	{
+		local.extrafield_len = sizeof( extra ) + pad;
+		extra.id = ZIP_ALIGN_EXTRA_ID;
+		extra.size = sizeof( extra.alignment ) + pad;
+		extra.alignment = pack->options->align;
+	}
+
+	ok = Pack_Write( pack, &local, sizeof( local )) && Pack_Write( pack, e->name, namelen );
+
+	if( ok && local.extrafield_len )
+		ok = Pack_Write( pack, &extra, sizeof( extra )) && Pack_WritePadding( pack, pad );
+
+	if( ok )
+		ok = Pack_Write( pack, payload, e->compressed_size );
+
+	free( deflated );
+	free( data );
+
+	return ok;
+}
+
+/*
+============
+Pack_WriteZIP
+============
+*/
+static qboolean Pack_WriteZIP( pack_t *pack )
+{
+	zip_eocd_t eocd;
+	uint64_t cdfofs;
+	int i;
+
+	if( pack->numentries > ZIP_MAX_FILES )
+	{
+		printf( "ZIP can't have more than %d files\n", ZIP_MAX_FILES );
+		return false;
+	}
+
+	for( i = 0; i < pack->numentries; i++ )
+	{
+		if( !Pack_WriteZIPEntry( pack, &pack->entries[i] ))
+			return false;
+	}
+
+	cdfofs = pack->pos;
+
+	for( i = 0; i < pack->numentries; i++ )
+	{
+		pack_entry_t *e = &pack->entries[i];
+		zip_cdf_t cdf;
+
+		memset( &cdf, 0, sizeof( cdf ));
+		cdf.signature = ZIP_HEADER_CDF;
+		cdf.version = ZIP_VERSION;
+		cdf.version_need = ZIP_VERSION;
+		cdf.method = e->method;
+		Pack_DosTime( e->mtime, &cdf.mod_time, &cdf.mod_date );
+		cdf.crc32 = e->crc32;
+		cdf.compressed_size = e->compressed_size;
+		cdf.uncompressed_size = e->size;
+		cdf.filename_len = Q_strlen( e->name );
+		cdf.local_header_offset = e->offset;
+
+		if( !Pack_Write( pack, &cdf, sizeof( cdf )) || !Pack_Write( pack, e->name, cdf.filename_len ))
+			return false;
+	}
+
+	if( pack->pos > ZIP_MAX_SIZE )
+	{
+		printf( "ZIP can't be larger than 4GB\n" );
+		return false;
+	}
+
+	memset( &eocd, 0, sizeof( eocd ));
+	eocd.signature = ZIP_HEADER_EOCD;
+	eocd.number_central_directory_record = pack->numentries;
+	eocd.total_central_directory_record = pack->numentries;
+	eocd.size_of_central_directory = pack->pos - cdfofs;
+	eocd.central_directory_offset = cdfofs;
+
+	return Pack_Write( pack, &eocd, sizeof( eocd ));
+}
+
+/*
+============
+CreateArchive
+============
+*/
+qboolean CreateArchive( const char *archive, const char *directory, const pack_options_t *options )
+{
+	const char *ext = COM_FileExtension( archive );
+	qboolean zip, ok;
+	pack_t pack;
+	size_t len;
+	int i;
+
+	if( !Q_stricmp( ext, "pk3" ) || !Q_stricmp( ext, "zip" ))
+		zip = true;
+	else if( !Q_stricmp( ext, "pak" ))
+		zip = false;
+	else
+	{
+		printf( "Unknown archive type: %s, use .pak or .pk3\n", archive );
+		return false;
+	}
+
+	memset( &pack, 0, sizeof( pack ));
+	pack.options = options;
+	Q_strncpy( pack.directory, directory, sizeof( pack.directory ));
+	COM_FixSlashes( pack.directory );
+
+	len = Q_strlen( pack.directory );
+	if( len > 1 && pack.directory[len - 1] == '/' )
+		pack.directory[len - 1] = '\0';
+
+	if( !Pack_ScanDirectory( &pack, "" ))
+	{
+		free( pack.entries );
+		return false;
+	}
+
+	if( !pack.numentries )
+	{
+		printf( "No files in %s\n", directory );
+		return false;
+	}
+
+	if( options->trace && !Pack_ApplyTrace( &pack, options->trace ))
+	{
+		free( pack.entries );
+		return false;
+	}
+
+	// level load becomes one forward sweep over the archive
+	qsort( pack.entries, pack.numentries, sizeof( *pack.entries ), Pack_CompareLayout );
+
+	if(( pack.f = fopen( archive, "wb" )) == NULL )
+	{
+		printf( "Can't create %s: %s\n", archive, strerror( errno ));
+		free( pack.entries );
+		return false;
+	}
+
+	ok = zip ? Pack_WriteZIP( &pack ) : Pack_WritePAK( &pack );
+
+	if( fclose( pack.f ) != 0 )
+		ok = false;
+
+	if( !ok )
+	{
+		remove( archive );
+		free( pack.entries );
+		return false;
+	}
+
+	if( options->verbose )
+	{
+		for( i = 0; i < pack.numentries; i++ )
+		{
+			const pack_entry_t *e = &pack.entries[i];
+
+			printf( "%10u %s %s %s\n", e->offset, e->order != PACK_COLD ? "hot " : "cold",
+				e->method == ZIP_METHOD_DEFLATED ? "deflated" : "stored  ", e->name );
+		}
+	}
+
+	printf( "Packed %d files into %s: %d hot, %d deflated, %d aligned, %lu bytes of padding\n",
+		pack.numentries, archive, pack.numhot, pack.numdeflated, pack.numaligned, (unsigned long)pack.padding );
+
+	free( pack.entries );
+	return true;
+}
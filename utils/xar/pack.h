@@ -0,0 +1,33 @@
+/*
+pack.h -- archive creation for XAR
+Copyright (C) 2026 FWGS
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+*/
+
+#ifndef PACK_H
+#define PACK_H
+
+#define PACK_DEFAULT_ALIGN 4096   // page size on most systems
+#define PACK_LARGE_ENTRY   65536  // stored entries starting from this size are aligned
+
+typedef struct pack_options_s
+{
+	const char *trace;   // file access trace recorded with fs_trace, may be NULL
+	int        align;    // alignment for large stored entries, 0 or 1 disables it
+	qboolean   store;    // never compress, ZIP only
+	qboolean   verbose;
+} pack_options_t;
+
+// packs all files from directory into PAK or ZIP (PK3), type is chosen by extension
+qboolean CreateArchive( const char *archive, const char *directory, const pack_options_t *options );
+
+#endif // PACK_H
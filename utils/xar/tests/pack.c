@@ -0,0 +1,359 @@
+#include "port.h"
+#include "build.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "filesystem.h"
+#include "filesystem_internal.h"
+#include "crtlib.h"
+#include "pack.h"
+#if XASH_POSIX
+#include <sys/stat.h>
+#include <dlfcn.h>
+#define LoadLibrary( x ) dlopen( x, RTLD_NOW )
+#define GetProcAddress( x, y ) dlsym( x, y )
+#define FreeLibrary( x ) dlclose( x )
+#elif XASH_WIN32
+#include <windows.h>
+#endif
+
+#define TEST_DIR   "xar_pack_test"
+#define TEST_TRACE "xar_pack_test.txt"
+#define TEST_PAK   "xar_pack_test.pak"
+#define TEST_PK3   "xar_pack_test.pk3"
+
+void *g_hModule;
+FSAPI g_pfnGetFSAPI;
+fs_api_t g_fs;
+fs_globals_t *g_nullglobals;
+
+typedef struct
+{
+	const char *name;
+	int size;
+	qboolean compressible;
+} test_file_t;
+
+static const test_file_t g_files[] =
+{
+{ "maps/c1a0.bsp", 300000, false },
+{ "models/barney.mdl", 100000, true },
+{ "sound/ambience/wind.wav", 200000, true },
+{ "gfx/env/skybox.tga", 70000, false },
+{ "sprites/glow.spr", 1234, false },
+{ "scripts/weapon.txt", 777, true },
+{ "readme.txt", 500, true },
+};
+
+#define NUM_FILES (int)( sizeof( g_files ) / sizeof( g_files[0] ))
+
+// mixed case and slashes, missing file and a repeat
+static const char g_trace[] =
+	"sprites/glow.spr\n"
+	"maps\\C1A0.bsp\r\n"
+	"gfx/missing.tga\n"
+	"models/barney.mdl\n"
+	"sprites/glow.spr\n";
+
+// hot files in access order, then cold ones by name
+static const char *g_layout[] =
+{
+	"sprites/glow.spr",
+	"maps/c1a0.bsp",
+	"models/barney.mdl",
+	"gfx/env/skybox.tga",
+	"readme.txt",
+	"scripts/weapon.txt",
+	"sound/ambience/wind.wav",
+};
+
+static qboolean LoadFilesystem( void )
+{
+	g_hModule = LoadLibrary( "filesystem_stdio." OS_LIB_EXT );
+	if( !g_hModule )
+		return false;
+
+	g_pfnGetFSAPI = (void*)GetProcAddress( g_hModule, GET_FS_API );
+	if( !g_pfnGetFSAPI )
+		return false;
+
+	if( !g_pfnGetFSAPI( FS_API_VERSION, &g_fs, &g_nullglobals, NULL ))
+		return false;
+
+	return true;
+}
+
+static byte *GenerateFile( const test_file_t *file )
+{
+	byte *data = malloc( file->size );
+	uint seed = file->size;
+	int i;
+
+	for( i = 0; i < file->size; i++ )
+	{
+		seed = seed * 1103515245 + 12345;
+
+		if( file->compressible )
+			data[i] = "xash3d fwgs "[( i / 3 ) % 12];
+		else data[i] = seed >> 16;
+	}
+
+	return data;
+}
+
+static const test_file_t *FindFile( const char *name )
+{
+	int i;
+
+	for( i = 0; i < NUM_FILES; i++ )
+	{
+		if( !strcmp( g_files[i].name, name ))
+			return &g_files[i];
+	}
+
+	return NULL;
+}
+
+static qboolean WriteFiles( void )
+{
+	char path[MAX_SYSPATH], *p;
+	FILE *f;
+	int i;
+
+	for( i = 0; i < NUM_FILES; i++ )
+	{
+		byte *data = GenerateFile( &g_files[i] );
+
+		Q_snprintf( path, sizeof( path ), TEST_DIR "/%s", g_files[i].name );
+
+		for( p = path; ( p = strchr( p, '/' )) != NULL; p++ )
+		{
+			*p = '\0';
+			_mkdir( path );
+			*p = '/';
+		}
+
+		if(( f = fopen( path, "wb" )) == NULL )
+		{
+			free( data );
+			return false;
+		}
+
+		fwrite( data, 1, g_files[i].size, f );
+		fclose( f );
+		free( data );
+	}
+
+	if(( f = fopen( TEST_TRACE, "wb" )) == NULL )
+		return false;
+
+	fputs( g_trace, f );
+	fclose( f );
+
+	return true;
+}
+
+static byte *ReadArchive( const char *name, size_t *size )
+{
+	byte *data;
+	FILE *f;
+
+	if(( f = fopen( name, "rb" )) == NULL )
+		return NULL;
+
+	fseek( f, 0, SEEK_END );
+	*size = ftell( f );
+	fseek( f, 0, SEEK_SET );
+
+	data = malloc( *size );
+	if( fread( data, 1, *size, f ) != *size )
+	{
+		free( data );
+		data = NULL;
+	}
+
+	fclose( f );
+	return data;
+}
+
+static qboolean CheckPAKLayout( void )
+{
+	size_t size;
+	byte *data = ReadArchive( TEST_PAK, &size );
+	int i, dirofs, prev = 0;
+
+	if( !data )
+		return false;
+
+	memcpy( &dirofs, data + 4, sizeof( dirofs ));
+
+	for( i = 0; i < NUM_FILES; i++ )
+	{
+		const byte *entry = data + dirofs + i * 64;
+		const test_file_t *file = FindFile( g_layout[i] );
+		int filepos;
+
+		memcpy( &filepos, entry + 56, sizeof( filepos ));
+
+		if( strcmp( (const char *)entry, g_layout[i] ) || filepos < prev )
+		{
+			printf( "PAK entry %d is %s at %d, expected %s\n", i, entry, filepos, g_layout[i] );
+			free( data );
+			return false;
+		}
+
+		if( file->size >= PACK_LARGE_ENTRY && filepos % PACK_DEFAULT_ALIGN )
+		{
+			printf( "PAK entry %s isn't aligned\n", file->name );
+			free( data );
+			return false;
+		}
+
+		prev = filepos;
+	}
+
+	free( data );
+	return true;
+}
+
+static qboolean CheckPK3Layout( void )
+{
+	size_t size, pos = 0;
+	byte *data = ReadArchive( TEST_PK3, &size );
+	int i;
+
+	if( !data )
+		return false;
+
+	// walk local headers, they must follow the layout
+	for( i = 0; i < NUM_FILES; i++ )
+	{
+		const test_file_t *file = FindFile( g_layout[i] );
+		uint16_t method, namelen, extralen;
+		uint32_t compressed;
+		size_t dataofs;
+
+		memcpy( &method, data + pos + 8, sizeof( method ));
+		memcpy( &compressed, data + pos + 18, sizeof( compressed ));
+		memcpy( &namelen, data + pos + 26, sizeof( namelen ));
+		memcpy( &extralen, data + pos + 28, sizeof( extralen ));
+		dataofs = pos + 30 + namelen + extralen;
+
+		if( namelen != Q_strlen( g_layout[i] ) || memcmp( data + pos + 30, g_layout[i], namelen ))
+		{
+			printf( "PK3 entry %d isn't %s\n", i, g_layout[i] );
+			free( data );
+			return false;
+		}
+
+		// only cold compressible files get deflated
+		if(( method != 0 ) != ( i >= 3 && file->compressible ))
+		{
+			printf( "PK3 entry %s has wrong method %d\n", file->name, method );
+			free( data );
+			return false;
+		}
+
+		if( method == 0 && file->size >= PACK_LARGE_ENTRY && dataofs % PACK_DEFAULT_ALIGN )
+		{
+			printf( "PK3 entry %s isn't aligned\n", file->name );
+			free( data );
+			return false;
+		}
+
+		pos = dataofs + compressed;
+	}
+
+	free( data );
+	return true;
+}
+
+static qboolean CheckMountedFiles( const char *archive )
+{
+	int i;
+
+	if( !g_fs.MountArchive_Fullpath( archive, 0 ))
+	{
+		printf( "Can't mount %s\n", archive );
+		return false;
+	}
+
+	for( i = 0; i < NUM_FILES; i++ )
+	{
+		byte *expected = GenerateFile( &g_files[i] );
+		fs_offset_t len;
+		byte *data = g_fs.LoadFile( g_files[i].name, &len, false );
+
+		if( !data || len != g_files[i].size || memcmp( data, expected, len ))
+		{
+			printf( "%s: %s mismatch\n", archive, g_files[i].name );
+			return false;
+		}
+
+		free( expected );
+		free( data );
+	}
+
+	return true;
+}
+
+static qboolean CheckOpenFromArchive( const char *name, const char *archive )
+{
+	file_t *f = g_fs.Open( name, "rb", false );
+	qboolean ok;
+
+	if( !f )
+	{
+		printf( "Can't open %s\n", name );
+		return false;
+	}
+
+	ok = !Q_stricmp( COM_FileWithoutPath( f->searchpath->filename ), archive );
+
+	if( !ok )
+		printf( "%s opened from %s instead of %s\n", name, f->searchpath->filename, archive );
+
+	g_fs.Close( f );
+	return ok;
+}
+
+int main( void )
+{
+	pack_options_t options = { TEST_TRACE, PACK_DEFAULT_ALIGN };
+	int i;
+
+	if( !LoadFilesystem( ))
+		return EXIT_FAILURE;
+
+	if( !WriteFiles( ))
+		return EXIT_FAILURE;
+
+	if( !CreateArchive( TEST_PAK, TEST_DIR, &options ) || !CheckPAKLayout( ))
+		return EXIT_FAILURE;
+
+	if( !CreateArchive( TEST_PK3, TEST_DIR "/", &options ) || !CheckPK3Layout( ))
+		return EXIT_FAILURE;
+
+	// PK3 is mounted last and takes precedence
+	if( !CheckMountedFiles( TEST_PAK ) || !CheckOpenFromArchive( "maps/c1a0.bsp", TEST_PAK ))
+		return EXIT_FAILURE;
+
+	if( !CheckMountedFiles( TEST_PK3 ) || !CheckOpenFromArchive( "maps/c1a0.bsp", TEST_PK3 ))
+		return EXIT_FAILURE;
+
+	for( i = 0; i < NUM_FILES; i++ )
+	{
+		char path[MAX_SYSPATH];
+
+		Q_snprintf( path, sizeof( path ), TEST_DIR "/%s", g_files[i].name );
+		remove( path );
+	}
+
+	remove( TEST_TRACE );
+	remove( TEST_PAK );
+	remove( TEST_PK3 );
+
+	printf( "success\n" );
+
+	return EXIT_SUCCESS;
+}
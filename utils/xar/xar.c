@@ -20,6 +20,7 @@ GNU General Public License for more details.
 #include <time.h>
 #include <errno.h>
 #include "filesystem.h"
+#include "pack.h"
 #if XASH_POSIX
 #include <sys/stat.h>
 #include <dlfcn.h>
@@ -79,24 +80,68 @@ static void FS_CreatePath( char *path )
 	}
 }
 
-void usage( const char *arg0 )
+static void usage( const char *arg0 )
 {
 	printf( "%s: <action> [option...] <file>\n", arg0 );
+	printf( "%s: c [option...] <archive> <directory>\n", arg0 );
 	puts( "XAR is a simple frontend to Xash3D FWGS's filesystem_stdio library" );
 	puts( "that allows interacting with archive types supported by it" );
 	puts( "Options:" );
 	puts( "\tx\t\teXtract the archive" );
 	puts( "\tt\t\tlisT the archive" );
+	puts( "\tc\t\tCreate PAK or PK3 archive from directory, type is chosen by extension" );
 	// TODO: make an interface for modifying
-	// puts( "\tc\t\tCreate the archive" );
 	// puts( "\tu\t\tUpdate the archive" );
 	// puts( "\tr\t\tRemove from the archive" );
 
 	puts( "Extract and list options:" );
 	puts( "\t-wads\tauto-mount WADs inside archives" );
+
+	puts( "Create options:" );
+	puts( "\t-trace <file>\tput files in order of access trace, recorded by engine with fs_trace 1," );
+	puts( "\t\t\ttraced files are never compressed" );
+	puts( "\t-align <n>\talign large uncompressed files, power of two up to 32768, 4096 by default" );
+	puts( "\t-store\t\tdon't compress anything, compressed PK3 files can't be opened, only loaded" );
+	puts( "\t-v\t\tprint layout of the archive" );
 	exit( 1 );
 }
 
+static int CreateMain( int argc, char **argv )
+{
+	pack_options_t options = { NULL, PACK_DEFAULT_ALIGN };
+	int i;
+
+	if( argc < 4 )
+		usage( argv[0] );
+
+	for( i = 2; i < argc - 2; i++ )
+	{
+		if( !strcmp( argv[i], "-trace" ) && i + 1 < argc - 2 )
+			options.trace = argv[++i];
+		else if( !strcmp( argv[i], "-align" ) && i + 1 < argc - 2 )
+		{
+			options.align = atoi( argv[++i] );
+
+			if( options.align < 0 || options.align > 32768 || ( options.align & ( options.align - 1 )))
+			{
+				printf( "Bad alignment: %s\n", argv[i] );
+				usage( argv[0] );
+			}
+		}
+		else if( !strcmp( argv[i], "-store" ))
+			options.store = true;
+		else if( !strcmp( argv[i], "-v" ))
+			options.verbose = true;
+		else
+		{
+			printf( "Unknown option: %s\n", argv[i] );
+			usage( argv[0] );
+		}
+	}
+
+	return CreateArchive( argv[argc - 2], argv[argc - 1], &options ) ? 0 : 5;
+}
+
 int main( int argc, char **argv )
 {
 	const char *filename;
@@ -107,6 +152,10 @@ int main( int argc, char **argv )
 	if( argc < 3 )
 		usage( argv[0] );
 
+	// doesn't need filesystem library
+	if( argv[1][0] == 'c' )
+		return CreateMain( argc, argv );
+
 	if( !LoadFilesystem())
 	{
 		puts( "Can't load filesystem_stdio!" );